@@ -115,7 +115,7 @@ HRESULT BasicWindow::configure(void) {
 			height = BASICWINDOW_DEFAULT_HEIGHT;
 		}
 	} else {
-		logMessage(L"BasicWindow initialization from configuration data: No Config instance to use.");
+		LOGUSER_WARNING(L"BasicWindow initialization from configuration data: No Config instance to use.");
 		title = BASICWINDOW_DEFAULT_TITLE;
 		exitAble = BASICWINDOW_DEFAULT_EXITABLE;
 		width = BASICWINDOW_DEFAULT_WIDTH;
@@ -177,7 +177,7 @@ HRESULT BasicWindow::openWindow(void) {
 		// This window is reopening
 		(*s_winProcList)[m_id] = this;
 	} else {
-		logMessage(L"Attempt to open a window that is already open.");
+		LOGUSER_WARNING(L"Attempt to open a window that is already open.");
 		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WRONG_STATE);
 	}
 
@@ -199,7 +199,7 @@ HRESULT BasicWindow::openWindow(void) {
 
 	// Check if window creation failed
 	if( m_hwnd == 0 ) {
-		logMessage(L"Error - Window creation failed.");
+		LOGUSER_ERROR(L"Error - Window creation failed.");
 		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WINDOWS_CALL);
 	}
 
@@ -212,7 +212,7 @@ HRESULT BasicWindow::openWindow(void) {
 	setMsgPrefix(L"BasicWindow '" + m_title +
 		L"', id = " + std::to_wstring(m_id) + L":");
 
-	logMessage(L"Window opened.");
+	LOGUSER_INFO(L"Window opened.");
 
 	return ERROR_SUCCESS;
 }
@@ -221,7 +221,7 @@ HRESULT BasicWindow::shutdownWindow(const bool exitIfLast) {
 
 	// Check if this window has ever been opened
 	if (!m_opened) {
-		logMessage(L"Attempt to close a window that has never been opened.");
+		LOGUSER_WARNING(L"Attempt to close a window that has never been opened.");
 		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WRONG_STATE);
 	}
 
@@ -234,7 +234,7 @@ HRESULT BasicWindow::shutdownWindow(const bool exitIfLast) {
 
 		// Remove the reference to this object
 		(*s_winProcList)[m_id] = 0;
-		logMessage(L"window closed.");
+		LOGUSER_INFO(L"window closed.");
 
 		// Check if all windows are now closed
 		if (exitIfLast) {
@@ -247,11 +247,11 @@ HRESULT BasicWindow::shutdownWindow(const bool exitIfLast) {
 			}
 			if (allClosed) {
 				PostQuitMessage(0);
-				logMessage(L"Posted quit message because all windows are closed.");
+				LOGUSER_INFO(L"Posted quit message because all windows are closed.");
 			}
 		}
 	} else {
-		logMessage(L"Attempt to close a window that is already closed.");
+		LOGUSER_WARNING(L"Attempt to close a window that is already closed.");
 		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WRONG_STATE);
 	}
 
@@ -308,6 +308,15 @@ HRESULT BasicWindow::updateAll(bool& quit, WPARAM& msg_wParam) {
 		}
 	}
 
+	/* Apply modifications to configuration files, at a point
+	   where windows are not using their configuration data
+	 */
+	if( !quit && g_configWatcher != 0 ) {
+		if( FAILED(g_configWatcher->applyChanges()) ) {
+			return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+		}
+	}
+
 	return ERROR_SUCCESS;
 }
 
@@ -324,10 +333,10 @@ LRESULT CALLBACK BasicWindow::winProc(HWND hwnd, UINT umsg, WPARAM wparam, LPARA
 			   shortly. The quit message will be encountered by any update() function call.
 			 */
 			PostQuitMessage(0);
-			logMessage(L"Posted quit message because this 'exitAble' window received a message that will cause it to close. "
+			LOGUSER_INFO(L"Posted quit message because this 'exitAble' window received a message that will cause it to close. "
 				L"The message value is "+std::to_wstring(umsg));
 		} else {
-			logMessage(L"Non-'exitAble' window received a message that will cause it to close. "
+			LOGUSER_INFO(L"Non-'exitAble' window received a message that will cause it to close. "
 				L"The message value is " + std::to_wstring(umsg));
 			shutdownWindow(true); // Close only this window, unless it is the only open window
 		}
@@ -0,0 +1,512 @@
+/*
+BinaryLogger.cpp
+----------------
+
+Created for: Spring 2014 Direct3D 11 Learning
+By: Bernard Llanos
+August 19, 2014
+
+Primary basis: None
+Other references: None
+
+Development environment: Visual Studio 2013 running on Windows 7, 64-bit
+  -Note that the "Character Set" project property (Configuration Properties > General)
+   should be set to Unicode for all configurations, when using Visual Studio.
+
+Description
+  -Implementation of the BinaryLogger class
+*/
+
+#include "BinaryLogger.h"
+#include "Logger.h"
+#include "Timestamper.h"
+#include "fileUtil.h"
+#include "defs.h"
+#include <cstring>
+
+using std::wstring;
+
+/* Helper functions for decode(), which read values from the range [p, end),
+   advancing 'p' past the value.
+   They return false, without advancing 'p', if the range ends before the value.
+ */
+static bool readUnsigned(const char*& p, const char* const end, ULONGLONG& value) {
+	value = 0;
+	const char* q = p;
+	for( unsigned int shift = 0; q != end && shift < 64; shift += 7 ) {
+		const unsigned char byte = static_cast<unsigned char>(*q);
+		++q;
+		value |= static_cast<ULONGLONG>(byte & 0x7F) << shift;
+		if( (byte & 0x80) == 0 ) {
+			p = q;
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool readSigned(const char*& p, const char* const end, LONGLONG& value) {
+	ULONGLONG zigzag;
+	if( !readUnsigned(p, end, zigzag) ) {
+		return false;
+	}
+	value = static_cast<LONGLONG>(zigzag >> 1) ^ -static_cast<LONGLONG>(zigzag & 1);
+	return true;
+}
+
+static bool readBytes(const char*& p, const char* const end, void* const out, const size_t size) {
+	if( static_cast<size_t>(end - p) < size ) {
+		return false;
+	}
+	memcpy(out, p, size);
+	p += size;
+	return true;
+}
+
+static bool readString(const char*& p, const char* const end, wstring& str) {
+	const char* q = p;
+	ULONGLONG length;
+	if( !readUnsigned(q, end, length) ||
+		length > static_cast<ULONGLONG>(end - q) / sizeof(wchar_t) ) {
+		return false;
+	}
+	str.resize(static_cast<size_t>(length));
+	if( length > 0 ) {
+		memcpy(&str[0], q, static_cast<size_t>(length) * sizeof(wchar_t));
+	}
+	p = q + static_cast<size_t>(length) * sizeof(wchar_t);
+	return true;
+}
+
+// Returns the number of placeholders for arguments in a format string
+static size_t countPlaceholders(const wstring& format) {
+	size_t nPlaceholders = 0;
+	const size_t placeholderLength = wcslen(BINARYLOGGER_PLACEHOLDER);
+	for( size_t pos = format.find(BINARYLOGGER_PLACEHOLDER); pos != wstring::npos;
+		pos = format.find(BINARYLOGGER_PLACEHOLDER, pos + placeholderLength) ) {
+		++nPlaceholders;
+	}
+	return nPlaceholders;
+}
+
+/* Helper function for decode(), which reads the arguments of a message
+   from the range [p, end), and appends the message, with the arguments
+   substituted for the placeholders in the format string, to 'line'.
+   'complete' is set to false if the range ends before the arguments.
+   Returns a failure result if the arguments are invalid.
+   The format string must have one placeholder for each argument type
+   (as checked when FORMAT records are read).
+ */
+static HRESULT formatMessage(const char*& p, const char* const end, wstring& line,
+	const wstring& format, const std::vector<BinaryLogger::ArgType>& types,
+	std::vector<wstring>& staticStrings, bool& complete) {
+
+	const size_t placeholderLength = wcslen(BINARYLOGGER_PLACEHOLDER);
+	size_t formatPos = 0;
+	wstring str;
+	complete = true;
+	std::vector<BinaryLogger::ArgType>::const_iterator typeIt = types.cbegin();
+	for( ; complete && typeIt != types.cend(); ++typeIt ) {
+		const size_t placeholderPos = format.find(BINARYLOGGER_PLACEHOLDER, formatPos);
+		line.append(format, formatPos, placeholderPos - formatPos);
+		formatPos = placeholderPos + placeholderLength;
+
+		switch( *typeIt ) {
+		case BinaryLogger::ArgType::INT:
+		{
+			LONGLONG value;
+			complete = readSigned(p, end, value);
+			if( complete ) {
+				line += std::to_wstring(value);
+			}
+			break;
+		}
+		case BinaryLogger::ArgType::UINT:
+		{
+			ULONGLONG value;
+			complete = readUnsigned(p, end, value);
+			if( complete ) {
+				line += std::to_wstring(value);
+			}
+			break;
+		}
+		case BinaryLogger::ArgType::DOUBLE:
+		{
+			double value;
+			complete = readBytes(p, end, &value, sizeof(double));
+			if( complete ) {
+				line += std::to_wstring(value);
+			}
+			break;
+		}
+		case BinaryLogger::ArgType::BOOL:
+		{
+			char value;
+			complete = readBytes(p, end, &value, 1);
+			if( complete ) {
+				line += (value != 0) ? L"true" : L"false";
+			}
+			break;
+		}
+		case BinaryLogger::ArgType::WSTRING:
+		{
+			complete = readString(p, end, str);
+			if( complete ) {
+				line += str;
+			}
+			break;
+		}
+		case BinaryLogger::ArgType::STATIC_WSTRING:
+		{
+			ULONGLONG value;
+			complete = readUnsigned(p, end, value);
+			if( complete && (value & 1) != 0 ) {
+				// First occurrence of the string
+				complete = readString(p, end, str);
+				if( !complete ) {
+					break;
+				} else if( (value >> 1) != staticStrings.size() ) {
+					return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_DATA);
+				}
+				staticStrings.push_back(str);
+			} else if( complete && (value >> 1) >= staticStrings.size() ) {
+				return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_DATA);
+			}
+			if( complete ) {
+				line += staticStrings[static_cast<size_t>(value >> 1)];
+			}
+			break;
+		}
+		default:
+			return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_DATA);
+		}
+	}
+
+	if( complete ) {
+		line.append(format, formatPos, wstring::npos);
+	}
+	return ERROR_SUCCESS;
+}
+
+BinaryLogger::BinaryLogger(const wstring filename, bool timestampEnabled,
+	const size_t bufferSize, const DWORD flushInterval) :
+m_file(), m_buffer(), m_bufferSize(bufferSize), m_flushInterval(flushInterval),
+m_lastFlush(GetTickCount()), m_formats(), m_staticStrings(),
+m_timestampEnabled(timestampEnabled), m_frequency(1), m_anchorCounter(0), m_lastCounter(0)
+{
+	m_file.open(filename, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+	if( !m_file.is_open() ) {
+		// This is a Microsoft-specific constructor
+		throw std::exception("Failed to open the binary log file.");
+	}
+
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	m_frequency = frequency.QuadPart;
+
+	m_buffer.reserve(m_bufferSize + 1);
+
+	FileHeader header;
+	memset(&header, 0, sizeof(FileHeader));
+	header.magic = BINARYLOGGER_MAGIC;
+	header.version = BINARYLOGGER_VERSION;
+	header.charSize = sizeof(wchar_t);
+	header.timestampEnabled = (m_timestampEnabled) ? 1 : 0;
+	header.frequency = m_frequency;
+	m_buffer.append(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+
+	if( m_timestampEnabled ) {
+		writeAnchor();
+	}
+}
+
+BinaryLogger::~BinaryLogger(void) {
+	flush();
+	m_file.close();
+}
+
+HRESULT BinaryLogger::flush(void) {
+	m_lastFlush = GetTickCount();
+	if( m_buffer.empty() ) {
+		return ERROR_SUCCESS;
+	}
+	m_file.write(m_buffer.data(), m_buffer.size());
+	m_file.flush();
+	m_buffer.clear();
+	if( !m_file.good() ) {
+		m_file.clear();
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	return ERROR_SUCCESS;
+}
+
+HRESULT BinaryLogger::registerFormat(FormatID& id, const wstring& format,
+	const ArgType* const types, const size_t nArgs) {
+
+	if( countPlaceholders(format) != nArgs ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_INPUT);
+	}
+
+	id = static_cast<FormatID>(m_formats.size());
+	m_formats.push_back(std::vector<ArgType>(types, types + nArgs));
+
+	m_buffer += static_cast<char>(RecordType::FORMAT);
+	writeUnsigned(id);
+	writeUnsigned(nArgs);
+	for( size_t i = 0; i < nArgs; ++i ) {
+		m_buffer += static_cast<char>(types[i]);
+	}
+	writeString(format.c_str(), format.length());
+	return endMessage();
+}
+
+HRESULT BinaryLogger::beginMessage(const FormatID id, const ArgType* const types, const size_t nArgs) {
+	if( id >= m_formats.size() ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_INPUT);
+	}
+	const std::vector<ArgType>& formatTypes = m_formats[id];
+	if( formatTypes.size() != nArgs ||
+		(nArgs > 0 && memcmp(&formatTypes[0], types, nArgs * sizeof(ArgType)) != 0) ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_INPUT);
+	}
+
+	LONGLONG counter = 0;
+	if( m_timestampEnabled ) {
+		counter = Timestamper::now();
+		if( (counter - m_anchorCounter) > (m_frequency * BINARYLOGGER_ANCHOR_INTERVAL) ) {
+			writeAnchor();
+		}
+	}
+
+	m_buffer += static_cast<char>(RecordType::MESSAGE);
+	writeUnsigned(id);
+	writeSigned(counter - m_lastCounter);
+	m_lastCounter = counter;
+	return ERROR_SUCCESS;
+}
+
+HRESULT BinaryLogger::endMessage(void) {
+	if( m_buffer.size() >= m_bufferSize ||
+		(GetTickCount() - m_lastFlush) >= m_flushInterval ) {
+		return flush();
+	}
+	return ERROR_SUCCESS;
+}
+
+void BinaryLogger::writeAnchor(void) {
+	FILETIME systemTime;
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	GetSystemTimeAsFileTime(&systemTime);
+	const int64_t time = (static_cast<int64_t>(systemTime.dwHighDateTime) << 32) |
+		static_cast<int64_t>(systemTime.dwLowDateTime);
+	const int64_t anchorCounter = counter.QuadPart;
+
+	m_buffer += static_cast<char>(RecordType::ANCHOR);
+	m_buffer.append(reinterpret_cast<const char*>(&anchorCounter), sizeof(int64_t));
+	m_buffer.append(reinterpret_cast<const char*>(&time), sizeof(int64_t));
+	m_anchorCounter = anchorCounter;
+	m_lastCounter = anchorCounter;
+}
+
+void BinaryLogger::writeUnsigned(ULONGLONG value) {
+	while( value >= 0x80 ) {
+		m_buffer += static_cast<char>((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	m_buffer += static_cast<char>(value);
+}
+
+void BinaryLogger::writeSigned(const LONGLONG value) {
+	writeUnsigned((static_cast<ULONGLONG>(value) << 1) ^ static_cast<ULONGLONG>(value >> 63));
+}
+
+void BinaryLogger::writeString(const wchar_t* const str, const size_t length) {
+	writeUnsigned(length);
+	m_buffer.append(reinterpret_cast<const char*>(str), length * sizeof(wchar_t));
+}
+
+void BinaryLogger::encodeArg(const int value) {
+	writeSigned(value);
+}
+
+void BinaryLogger::encodeArg(const long value) {
+	writeSigned(value);
+}
+
+void BinaryLogger::encodeArg(const long long value) {
+	writeSigned(value);
+}
+
+void BinaryLogger::encodeArg(const unsigned int value) {
+	writeUnsigned(value);
+}
+
+void BinaryLogger::encodeArg(const unsigned long value) {
+	writeUnsigned(value);
+}
+
+void BinaryLogger::encodeArg(const unsigned long long value) {
+	writeUnsigned(value);
+}
+
+void BinaryLogger::encodeArg(const float value) {
+	encodeArg(static_cast<double>(value));
+}
+
+void BinaryLogger::encodeArg(const double value) {
+	m_buffer.append(reinterpret_cast<const char*>(&value), sizeof(double));
+}
+
+void BinaryLogger::encodeArg(const bool value) {
+	m_buffer += static_cast<char>((value) ? 1 : 0);
+}
+
+void BinaryLogger::encodeArg(const wstring& value) {
+	writeString(value.c_str(), value.length());
+}
+
+void BinaryLogger::encodeArg(const wchar_t* const value) {
+	if( value == 0 ) {
+		writeString(L"", 0);
+	} else {
+		writeString(value, wcslen(value));
+	}
+}
+
+void BinaryLogger::encodeArg(const StaticString& value) {
+	std::unordered_map<const wchar_t*, uint32_t>::const_iterator it = m_staticStrings.find(value.str);
+	if( it != m_staticStrings.end() ) {
+		writeUnsigned(static_cast<ULONGLONG>(it->second) << 1);
+	} else {
+		const uint32_t id = static_cast<uint32_t>(m_staticStrings.size());
+		m_staticStrings[value.str] = id;
+		writeUnsigned((static_cast<ULONGLONG>(id) << 1) | 1);
+		encodeArg(value.str);
+	}
+}
+
+HRESULT BinaryLogger::decode(const wstring& binaryFilename, const wstring& textFilename) {
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = 0;
+	const char* data = 0;
+	size_t size = 0;
+	HRESULT result = fileUtil::mapFile(binaryFilename, file, mapping, data, size);
+	if( FAILED(result) ) {
+		return result;
+	}
+
+	FileHeader header;
+	if( size < sizeof(FileHeader) ) {
+		fileUtil::unmapFile(file, mapping, data);
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_DATA);
+	}
+	memcpy(&header, data, sizeof(FileHeader));
+	if( header.magic != BINARYLOGGER_MAGIC || header.version != BINARYLOGGER_VERSION ||
+		header.charSize != sizeof(wchar_t) ) {
+		fileUtil::unmapFile(file, mapping, data);
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_DATA);
+	}
+
+	Logger* logger = 0;
+	try {
+		logger = new Logger(true, textFilename, true, false);
+	} catch( ... ) {
+		fileUtil::unmapFile(file, mapping, data);
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+	logger->toggleTimestamp(false);
+
+	Timestamper timestamper;
+	const bool timestampEnabled = (header.timestampEnabled != 0);
+	std::vector<std::vector<ArgType>> formatTypes;
+	std::vector<wstring> formats;
+	std::vector<wstring> staticStrings;
+	LONGLONG counter = 0;
+	wstring line;
+	wstring str;
+
+	result = ERROR_SUCCESS;
+	const char* p = data + sizeof(FileHeader);
+	const char* const end = data + size;
+	bool complete = true;
+	while( p != end && complete && SUCCEEDED(result) ) {
+		// Each record is parsed from 'q', and 'p' is only advanced past complete records
+		const char* q = p + 1;
+		const RecordType type = static_cast<RecordType>(*p);
+
+		if( type == RecordType::FORMAT ) {
+			ULONGLONG id, nArgs;
+			complete = readUnsigned(q, end, id) && readUnsigned(q, end, nArgs) &&
+				nArgs <= static_cast<ULONGLONG>(end - q);
+			if( complete ) {
+				if( id != formats.size() ) {
+					result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_DATA);
+					break;
+				}
+				std::vector<ArgType> types(static_cast<size_t>(nArgs));
+				complete = (nArgs == 0) || readBytes(q, end, &types[0], static_cast<size_t>(nArgs));
+				complete = complete && readString(q, end, str);
+				if( complete ) {
+					// Messages are formatted by substituting one argument for each placeholder
+					if( countPlaceholders(str) != types.size() ) {
+						result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_DATA);
+						break;
+					}
+					formatTypes.push_back(types);
+					formats.push_back(str);
+				}
+			}
+
+		} else if( type == RecordType::ANCHOR ) {
+			int64_t anchorCounter, time;
+			complete = readBytes(q, end, &anchorCounter, sizeof(int64_t)) &&
+				readBytes(q, end, &time, sizeof(int64_t));
+			if( complete ) {
+				if( FAILED(timestamper.setAnchor(header.frequency, anchorCounter, time)) ) {
+					result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_DATA);
+					break;
+				}
+				counter = anchorCounter;
+			}
+
+		} else if( type == RecordType::MESSAGE ) {
+			ULONGLONG id;
+			LONGLONG delta;
+			complete = readUnsigned(q, end, id) && readSigned(q, end, delta);
+			if( complete ) {
+				if( id >= formats.size() ) {
+					result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_DATA);
+					break;
+				}
+				line.clear();
+				if( timestampEnabled ) {
+					timestamper.append(line, counter + delta);
+					line += L" | ";
+				}
+				result = formatMessage(q, end, line, formats[static_cast<size_t>(id)],
+					formatTypes[static_cast<size_t>(id)], staticStrings, complete);
+				if( complete && SUCCEEDED(result) ) {
+					counter += delta;
+					result = logger->logMessage(line, false, true);
+				}
+			}
+
+		} else {
+			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_DATA);
+			break;
+		}
+
+		if( complete ) {
+			p = q;
+		}
+	}
+
+	delete logger;
+	fileUtil::unmapFile(file, mapping, data);
+
+	if( SUCCEEDED(result) && !complete ) {
+		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,416 @@
+/*
+CachedConfigIO.cpp
+------------------
+
+Created for: Spring 2014 Direct3D 11 Learning
+By: Bernard Llanos
+August 10, 2014
+
+Primary basis: None
+Other references: None
+
+Development environment: Visual Studio 2013 running on Windows 7, 64-bit
+  -Note that the "Character Set" project property (Configuration Properties > General)
+   should be set to Unicode for all configurations, when using Visual Studio.
+
+Description
+  -Implementation of the CachedConfigIO class
+*/
+
+#include "CachedConfigIO.h"
+#include "defs.h"
+#include "fileUtil.h"
+#include <fstream>
+#include <stdexcept>
+#include <DirectXMath.h>
+
+using std::wstring;
+
+CachedConfigIO::CachedConfigIO(IConfigIO* const textIO) :
+LogUser(true, L"CachedConfigIO >"), m_textIO(textIO), m_includedFiles()
+{
+	if( m_textIO == 0 ) {
+		throw std::invalid_argument("CachedConfigIO constructor passed a null pointer.");
+	}
+}
+
+CachedConfigIO::~CachedConfigIO(void) {}
+
+HRESULT CachedConfigIO::read(const wstring& filename, Config& config) {
+
+	setMsgPrefix(L"CachedConfigIO reading " + filename + L" >");
+	m_includedFiles.clear();
+
+	wstring cacheName;
+	if( FAILED(cacheFilename(cacheName, filename)) ) {
+		LOGUSER_ERROR(L"Failed to determine the name of the cache file.");
+		HRESULT result = m_textIO->read(filename, config);
+		m_textIO->getIncludedFiles(m_includedFiles);
+		return result;
+	}
+
+	// Try to load the cache
+	uint64_t sourceSize = 0;
+	uint64_t sourceWriteTime = 0;
+	HRESULT result = fileUtil::getFileStamp(filename, sourceSize, sourceWriteTime);
+	if( FAILED(result) ) {
+		// Let the text reader report the problem with the file
+		result = m_textIO->read(filename, config);
+		m_textIO->getIncludedFiles(m_includedFiles);
+		return result;
+	}
+	result = loadCache(cacheName, config, sourceSize, sourceWriteTime, m_includedFiles);
+	if( result == ERROR_SUCCESS ) {
+		LOGUSER_INFO(L"Loaded configuration data from the cache file.");
+		return result;
+	} else if( FAILED(result) ) {
+		LOGUSER_WARNING(L"The cache file is damaged and will be regenerated.");
+	}
+
+	// Parse the text file
+	Config parsed;
+	m_includedFiles.clear();
+	result = m_textIO->read(filename, parsed);
+	m_textIO->getIncludedFiles(m_includedFiles);
+	if( FAILED(result) ) {
+		return result;
+	}
+
+	// The text reader may have deferred the parsing of values
+	std::list<wstring> invalidMsgs;
+	HRESULT validationResult = parsed.validateAll(&invalidMsgs);
+	if( validationResult != ERROR_SUCCESS ) {
+		logMessage(LOG_LEVEL_WARNING, invalidMsgs.cbegin(), invalidMsgs.cend());
+	}
+	if( FAILED(config.insertCopies(parsed)) ) {
+		LOGUSER_ERROR(L"Failed to transfer configuration data to the output Config object.");
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+
+	/* Only cache files which were parsed without problems,
+	   such that parsing problems continue to be reported
+	   until they are corrected.
+
+	   The file stamp is retrieved again, because the text reader
+	   may have appended messages to the file.
+	 */
+	if( result == ERROR_SUCCESS && validationResult == ERROR_SUCCESS ) {
+		std::vector<IncludeStamp> includes(m_includedFiles.size());
+		for( std::vector<IncludeStamp>::size_type i = 0; i < includes.size(); ++i ) {
+			includes[i].filename = m_includedFiles[i];
+			if( FAILED(fileUtil::getFileStamp(includes[i].filename, includes[i].size, includes[i].writeTime)) ) {
+				LOGUSER_WARNING(L"The included file " + includes[i].filename + L" was not found, so the cache file will not be created.");
+				return result;
+			}
+		}
+		if( FAILED(fileUtil::getFileStamp(filename, sourceSize, sourceWriteTime)) ||
+			FAILED(saveCache(cacheName, parsed, sourceSize, sourceWriteTime, includes)) ) {
+			LOGUSER_ERROR(L"Failed to create the cache file: " + cacheName);
+		} else {
+			LOGUSER_INFO(L"Created the cache file: " + cacheName);
+		}
+	}
+	return result;
+}
+
+HRESULT CachedConfigIO::write(const wstring& filename,
+	const Config& config, const bool overwrite) {
+	return m_textIO->write(filename, config, overwrite);
+}
+
+bool CachedConfigIO::toggleContextOutput(const bool outputContext) {
+	return m_textIO->toggleContextOutput(outputContext);
+}
+
+void CachedConfigIO::getIncludedFiles(std::vector<wstring>& filenames) const {
+	filenames = m_includedFiles;
+}
+
+HRESULT CachedConfigIO::listIncludedFiles(const wstring& filename,
+	std::vector<wstring>& filenames) const {
+	return m_textIO->listIncludedFiles(filename, filenames);
+}
+
+bool CachedConfigIO::toggleReportOutput(const bool outputReports) {
+	return m_textIO->toggleReportOutput(outputReports);
+}
+
+HRESULT CachedConfigIO::cacheFilename(wstring& out, const wstring& filename) {
+	if( filename.empty() ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_INPUT);
+	}
+	size_t extensionStart = filename.find_last_of(L'.');
+	size_t nameStart = filename.find_last_of(W_PATH_SEP);
+	if( extensionStart == wstring::npos ||
+		(nameStart != wstring::npos && extensionStart < nameStart) ) {
+		out = filename + CACHEDCONFIGIO_CACHE_EXTENSION;
+	} else {
+		out = filename.substr(0, extensionStart) + CACHEDCONFIGIO_CACHE_EXTENSION;
+	}
+	return ERROR_SUCCESS;
+}
+
+HRESULT CachedConfigIO::loadCache(const wstring& filename, Config& config,
+	const uint64_t sourceSize, const uint64_t sourceWriteTime,
+	std::vector<wstring>& includedFiles) {
+
+	includedFiles.clear();
+
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = NULL;
+	const char* data = 0;
+	size_t size = 0;
+	HRESULT result = fileUtil::mapFile(filename, file, mapping, data, size);
+	if( FAILED(result) ) {
+		if( HRESULT_CODE(result) == ERROR_FILE_NOT_FOUND ) {
+			return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_NOT_FOUND);
+		}
+		return result;
+	}
+
+	// Validate the header
+	CacheHeader header;
+	memset(&header, 0, sizeof(CacheHeader));
+	if( size < sizeof(CacheHeader) ) {
+		result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	} else {
+		memcpy(&header, data, sizeof(CacheHeader));
+		if( header.magic != CACHEDCONFIGIO_MAGIC ) {
+			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		} else if( header.version != CACHEDCONFIGIO_VERSION ||
+			header.charSize != sizeof(wchar_t) ||
+			header.sourceSize != sourceSize ||
+			header.sourceWriteTime != sourceWriteTime ) {
+			result = MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_NOT_FOUND);
+		} else if( size != sizeof(CacheHeader) +
+			static_cast<size_t>(header.nEntries) * sizeof(CacheEntry) +
+			static_cast<size_t>(header.nIncludes) * sizeof(CacheInclude) +
+			(static_cast<size_t>(header.keyTableLength) + header.valueTableLength) * sizeof(wchar_t) ) {
+			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		} else if( header.checksum != checksum(data + sizeof(CacheHeader),
+			static_cast<size_t>(header.nEntries) * sizeof(CacheEntry) +
+			static_cast<size_t>(header.nIncludes) * sizeof(CacheInclude) +
+			static_cast<size_t>(header.keyTableLength) * sizeof(wchar_t)) ) {
+			// The value table is not covered by the checksum (see decodeValue())
+			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+	}
+
+	const char* const entries = data + sizeof(CacheHeader);
+	const char* const includes = entries + static_cast<size_t>(header.nEntries) * sizeof(CacheEntry);
+	const wchar_t* const keyTable = reinterpret_cast<const wchar_t*>(
+		includes + static_cast<size_t>(header.nIncludes) * sizeof(CacheInclude));
+	const wchar_t* const valueTable = keyTable + header.keyTableLength;
+	CacheEntry entry;
+
+	// The cache file is stale if any of the included files has changed
+	CacheInclude include;
+	uint64_t includeSize = 0;
+	uint64_t includeWriteTime = 0;
+	for( uint32_t i = 0; (result == ERROR_SUCCESS) && (i < header.nIncludes); ++i ) {
+		memcpy(&include, includes + i * sizeof(CacheInclude), sizeof(CacheInclude));
+		if( include.nameLength == 0 ||
+			static_cast<uint64_t>(include.nameOffset) + include.nameLength > header.keyTableLength ) {
+			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+			break;
+		}
+		includedFiles.emplace_back(keyTable + include.nameOffset, include.nameLength);
+		if( FAILED(fileUtil::getFileStamp(includedFiles.back(), includeSize, includeWriteTime)) ||
+			includeSize != include.size || includeWriteTime != include.writeTime ) {
+			result = MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_NOT_FOUND);
+		}
+	}
+	if( result != ERROR_SUCCESS ) {
+		includedFiles.clear();
+	}
+
+	// Validate the entry index, so that the Config object is not partially modified
+	for( uint32_t i = 0; (result == ERROR_SUCCESS) && (i < header.nEntries); ++i ) {
+		memcpy(&entry, entries + i * sizeof(CacheEntry), sizeof(CacheEntry));
+		Config::DataType type = static_cast<Config::DataType>(entry.dataType);
+		const Config::DataTypeInfo* const info = Config::getDataTypeInfo(type);
+		if( info == 0 || info->size > sizeof(entry.value) ||
+			static_cast<uint64_t>(entry.scopeOffset) + entry.scopeLength > header.keyTableLength ||
+			static_cast<uint64_t>(entry.fieldOffset) + entry.fieldLength > header.keyTableLength ||
+			entry.fieldLength == 0 ) {
+			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		} else if( info->isString &&
+			static_cast<uint64_t>(entry.value[0]) + entry.value[1] > header.valueTableLength ) {
+			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+	}
+
+	// Insert undecoded values, to be created when they are retrieved
+	std::string raw;
+	for( uint32_t i = 0; (result == ERROR_SUCCESS) && (i < header.nEntries); ++i ) {
+		memcpy(&entry, entries + i * sizeof(CacheEntry), sizeof(CacheEntry));
+		Config::DataType type = static_cast<Config::DataType>(entry.dataType);
+		const Config::DataTypeInfo* const info = Config::getDataTypeInfo(type);
+		if( info->isString ) {
+			raw.assign(reinterpret_cast<const char*>(&entry.value[2]), sizeof(uint32_t));
+			raw.append(reinterpret_cast<const char*>(valueTable + entry.value[0]), entry.value[1] * sizeof(wchar_t));
+		} else {
+			raw.assign(reinterpret_cast<const char*>(entry.value), info->size);
+		}
+
+		Config::Value* valueObj = new Config::Value(type, raw, &decodeValue);
+		if( config.insert(wstring(keyTable + entry.scopeOffset, entry.scopeLength),
+			wstring(keyTable + entry.fieldOffset, entry.fieldLength), valueObj) != ERROR_SUCCESS ) {
+			// Keys already present in the Config object are not overwritten
+			delete valueObj;
+		}
+	}
+
+	if( FAILED(fileUtil::unmapFile(file, mapping, data)) ) {
+		LOGUSER_ERROR(L"Failed to unmap the cache file from memory.");
+	}
+	return result;
+}
+
+HRESULT CachedConfigIO::saveCache(const wstring& filename, const Config& config,
+	const uint64_t sourceSize, const uint64_t sourceWriteTime,
+	const std::vector<IncludeStamp>& includes) {
+
+	std::vector<CacheEntry> entries;
+	std::vector<CacheInclude> includeTable(includes.size());
+	wstring keyTable;
+	wstring valueTable;
+	CacheEntry entry;
+
+	for( std::vector<IncludeStamp>::size_type i = 0; i < includes.size(); ++i ) {
+		includeTable[i].nameOffset = static_cast<uint32_t>(keyTable.length());
+		includeTable[i].nameLength = static_cast<uint32_t>(includes[i].filename.length());
+		includeTable[i].size = includes[i].size;
+		includeTable[i].writeTime = includes[i].writeTime;
+		keyTable += includes[i].filename;
+	}
+
+	std::map<Config::Key, Config::Value*>::const_iterator end = config.cend();
+	for( std::map<Config::Key, Config::Value*>::const_iterator it = config.cbegin(); it != end; ++it ) {
+		memset(&entry, 0, sizeof(CacheEntry));
+		entry.scopeOffset = static_cast<uint32_t>(keyTable.length());
+		entry.scopeLength = static_cast<uint32_t>(it->first.getScope().length());
+		keyTable += it->first.getScope();
+		entry.fieldOffset = static_cast<uint32_t>(keyTable.length());
+		entry.fieldLength = static_cast<uint32_t>(it->first.getField().length());
+		keyTable += it->first.getField();
+
+		Config::DataType type = it->second->getDataType();
+		entry.dataType = static_cast<uint32_t>(type);
+		const void* value = it->second->getValue(type);
+		if( value == 0 ) {
+			return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_DATA);
+		}
+		const Config::DataTypeInfo* const info = Config::getDataTypeInfo(type);
+		if( info == 0 || info->size > sizeof(entry.value) ) {
+			LOGUSER_ERROR(L"Unexpected data type encountered when creating the cache file. Code is broken.");
+			return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_BROKEN_CODE);
+		} else if( info->isString ) {
+			const wstring* stringValue = static_cast<const wstring*>(value);
+			entry.value[0] = static_cast<uint32_t>(valueTable.length());
+			entry.value[1] = static_cast<uint32_t>(stringValue->length());
+			entry.value[2] = checksum(reinterpret_cast<const char*>(stringValue->c_str()),
+				stringValue->length() * sizeof(wchar_t));
+			valueTable += *stringValue;
+		} else {
+			memcpy(entry.value, value, info->size);
+		}
+		entries.push_back(entry);
+	}
+
+	// Assemble the image
+	const size_t entriesSize = entries.size() * sizeof(CacheEntry);
+	const size_t includesSize = includeTable.size() * sizeof(CacheInclude);
+	const size_t keysSize = keyTable.length() * sizeof(wchar_t);
+	const size_t valuesSize = valueTable.length() * sizeof(wchar_t);
+	std::vector<char> image(sizeof(CacheHeader) + entriesSize + includesSize + keysSize + valuesSize);
+	if( entriesSize > 0 ) {
+		memcpy(&image[sizeof(CacheHeader)], &entries[0], entriesSize);
+	}
+	if( includesSize > 0 ) {
+		memcpy(&image[sizeof(CacheHeader) + entriesSize], &includeTable[0], includesSize);
+	}
+	if( keysSize > 0 ) {
+		memcpy(&image[sizeof(CacheHeader) + entriesSize + includesSize], keyTable.c_str(), keysSize);
+	}
+	if( valuesSize > 0 ) {
+		memcpy(&image[sizeof(CacheHeader) + entriesSize + includesSize + keysSize], valueTable.c_str(), valuesSize);
+	}
+
+	CacheHeader header;
+	memset(&header, 0, sizeof(CacheHeader));
+	header.magic = CACHEDCONFIGIO_MAGIC;
+	header.version = CACHEDCONFIGIO_VERSION;
+	header.charSize = sizeof(wchar_t);
+	header.nEntries = static_cast<uint32_t>(entries.size());
+	header.sourceSize = sourceSize;
+	header.sourceWriteTime = sourceWriteTime;
+	header.keyTableLength = static_cast<uint32_t>(keyTable.length());
+	header.nIncludes = static_cast<uint32_t>(includeTable.size());
+	header.valueTableLength = static_cast<uint32_t>(valueTable.length());
+	header.checksum = checksum(&image[0] + sizeof(CacheHeader), entriesSize + includesSize + keysSize);
+	memcpy(&image[0], &header, sizeof(CacheHeader));
+
+	// Write the image
+	std::ofstream file(filename, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+	if( !file.is_open() ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FILE_NOT_FOUND);
+	}
+	file.write(&image[0], image.size());
+	bool good = file.good();
+	file.close();
+	if( !good ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	return ERROR_SUCCESS;
+}
+
+HRESULT CachedConfigIO::decodeValue(const Config::DataType type, const std::string& raw,
+	const void*& value, wstring& msg) {
+
+	value = 0;
+	msg.clear();
+	const Config::DataTypeInfo* const info = Config::getDataTypeInfo(type);
+	if( info == 0 ) {
+		msg = L"unexpected data type in the cache file.";
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_BROKEN_CODE);
+	}
+
+	if( info->isString ) {
+		uint32_t stringChecksum = 0;
+		if( raw.length() < sizeof(uint32_t) || ((raw.length() - sizeof(uint32_t)) % sizeof(wchar_t)) != 0 ) {
+			msg = L"malformed string value in the cache file.";
+			return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_INVALID_DATA);
+		}
+		memcpy(&stringChecksum, raw.c_str(), sizeof(uint32_t));
+		const size_t nBytes = raw.length() - sizeof(uint32_t);
+		if( checksum(raw.c_str() + sizeof(uint32_t), nBytes) != stringChecksum ) {
+			msg = L"the string value in the cache file is damaged. Delete the cache file to regenerate it.";
+			return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_INVALID_DATA);
+		}
+		wstring* const stringValue = new wstring(nBytes / sizeof(wchar_t), L'\0');
+		if( nBytes > 0 ) {
+			memcpy(&(*stringValue)[0], raw.c_str() + sizeof(uint32_t), nBytes);
+		}
+		value = stringValue;
+	} else {
+		// Copy through an aligned buffer, as the bytes may not be aligned
+		uint64_t buffer[2]; // The size of CacheEntry::value
+		if( raw.length() != info->size || raw.length() > sizeof(buffer) ) {
+			msg = L"malformed value in the cache file.";
+			return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_INVALID_DATA);
+		}
+		memcpy(buffer, raw.c_str(), raw.length());
+		value = info->copy(buffer);
+	}
+	return ERROR_SUCCESS;
+}
+
+uint32_t CachedConfigIO::checksum(const char* const data, const size_t length) {
+	uint32_t hash = 2166136261U;
+	for( size_t i = 0; i < length; ++i ) {
+		hash ^= static_cast<unsigned char>(data[i]);
+		hash *= 16777619U;
+	}
+	return hash;
+}
\ No newline at end of file
@@ -22,107 +22,335 @@ Usage Notes: See Config.h
 #include "Config.h"
 #include "globals.h"
 #include "defs.h"
+#include "textProcessing.h"
+#include "higherLevelIO.h"
 #include <stdexcept>
 #include <sstream>
+#include <cstring>
+#include <cwchar>
 
 using std::map;
 using DirectX::XMFLOAT4;
+using namespace textProcessing;
+using namespace higherLevelIO;
+
+/* Number of slots in the data type name hash table (a power of two).
+   The hash function (see hashDataTypeName()) has been chosen
+   so that the current data type names occupy distinct slots.
+   If a new data type name collides with an existing name,
+   adjust the multipliers in the hash function, or the table size.
+ */
+#define CONFIG_DATATYPE_HASH_SIZE 16
+
+// Operations on data values, referenced by the data type descriptor table
+// -----------------------------------------------------------------------
+
+template<typename T> static void destroyValue(const void* const value) {
+	delete static_cast<const T*>(value);
+}
 
-const std::wstring Config::s_dataTypesNames[] = {
-	L"WSTRING",
-	L"BOOL",
-	L"INT",
-	L"DOUBLE",
-	L"FLOAT4",
-	L"COLOR",
-	L"FILENAME",
-	L"DIRECTORY"
-};
+template<typename T> static const void* copyValue(const void* const value) {
+	return new T(*static_cast<const T*>(value));
+}
+
+template<typename T> static bool equalValues(const void* const a, const void* const b) {
+	return *static_cast<const T*>(a) == *static_cast<const T*>(b);
+}
+
+template<> bool equalValues<XMFLOAT4>(const void* const a, const void* const b) {
+	const XMFLOAT4* const aVector = static_cast<const XMFLOAT4*>(a);
+	const XMFLOAT4* const bVector = static_cast<const XMFLOAT4*>(b);
+	return aVector->x == bVector->x && aVector->y == bVector->y &&
+		aVector->z == bVector->z && aVector->w == bVector->w;
+}
+
+template<typename T, HRESULT(*F)(T&, const char* const, size_t&)>
+static HRESULT parseText(const char* const str, const void*& value, size_t& index, std::wstring&) {
+	value = 0;
+	T* const typedValue = new T;
+	if( FAILED(F(*typedValue, str, index)) ) {
+		delete typedValue;
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	} else if( index == 0 ) {
+		delete typedValue;
+		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+	value = typedValue;
+	return ERROR_SUCCESS;
+}
+
+/* File and directory names/paths are subject to validation that tests
+   more than just their text representation, so the messages
+   from the parsing function are passed on to the caller.
+ */
+template<bool isFile>
+static HRESULT parseFileOrDirName(const char* const str, const void*& value, size_t& index, std::wstring& msg) {
+	value = 0;
+	std::wstring* const typedValue = new std::wstring;
+	if( FAILED(strToFileOrDirName(*typedValue, str, isFile, index, &msg)) ) {
+		delete typedValue;
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	} else if( index == 0 ) {
+		delete typedValue;
+		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+	value = typedValue;
+	return ERROR_SUCCESS;
+}
+
+template<typename T, HRESULT(*F)(T&, const char* const, size_t&)>
+static HRESULT checkText(const char* const str, size_t& index, std::wstring&, std::wstring&) {
+	T typedValue;
+	if( FAILED(F(typedValue, str, index)) ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	} else if( index == 0 ) {
+		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+	return ERROR_SUCCESS;
+}
+
+static HRESULT checkWString(const char* const str, size_t& index, std::wstring&, std::wstring& buffer) {
+	if( FAILED(wStrLiteralToWString(buffer, str, index)) ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	} else if( index == 0 ) {
+		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+	return ERROR_SUCCESS;
+}
+
+template<bool isFile>
+static HRESULT checkFileOrDirName(const char* const str, size_t& index, std::wstring& msg, std::wstring& buffer) {
+	if( FAILED(strToFileOrDirName(buffer, str, isFile, index, &msg)) ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	} else if( index == 0 ) {
+		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+	return ERROR_SUCCESS;
+}
+
+static HRESULT formatWString(std::wstring& out, const void* const value, std::wstring& buffer) {
+	HRESULT result = wstringToWStrLiteral(buffer, *static_cast<const std::wstring*>(value));
+	if( SUCCEEDED(result) ) {
+		out += buffer;
+	}
+	return result;
+}
+
+static HRESULT formatBool(std::wstring& out, const void* const value, std::wstring&) {
+	out += (*static_cast<const bool*>(value)) ? L"true" : L"false";
+	return ERROR_SUCCESS;
+}
+
+template<typename T> static HRESULT formatNumber(std::wstring& out, const void* const value, std::wstring&) {
+	return appendNumber(out, *static_cast<const T*>(value));
+}
+
+static HRESULT formatFloat4(std::wstring& out, const void* const value, std::wstring&) {
+	return appendXMFLOAT4(out, *static_cast<const XMFLOAT4*>(value));
+}
+
+static HRESULT formatColor(std::wstring& out, const void* const value, std::wstring&) {
+	return appendColorRGBA(out, *static_cast<const XMFLOAT4*>(value));
+}
+
+static HRESULT formatFileOrDirName(std::wstring& out, const void* const value, std::wstring& buffer) {
+	HRESULT result = fileOrDirNameToWString(buffer, *static_cast<const std::wstring*>(value));
+	if( SUCCEEDED(result) ) {
+		out += buffer;
+	}
+	return result;
+}
+
+/* Hash function for data type names, valid for names of at least one character.
+   Templated so that narrow and wide names hash to the same slots.
+ */
+template<typename C> static size_t hashDataTypeName(const C* const name, const size_t length) {
+	return (length * 2 + static_cast<size_t>(name[0]) + static_cast<size_t>(name[length - 1]) * 6) &
+		(CONFIG_DATATYPE_HASH_SIZE - 1);
+}
+
+static bool namesEqual(const char* const a, const char* const b, const size_t length) {
+	return strncmp(a, b, length) == 0;
+}
+
+static bool namesEqual(const wchar_t* const a, const wchar_t* const b, const size_t length) {
+	return wcsncmp(a, b, length) == 0;
+}
+
+static const char* getName(const Config::DataTypeInfo& info, const char* const) {
+	return info.name;
+}
+
+static const wchar_t* getName(const Config::DataTypeInfo& info, const wchar_t* const) {
+	return info.wName;
+}
 
-const Config::DataType Config::s_dataTypesInOrder[] = {
-	DataType::WSTRING,
-	DataType::BOOL,
-	DataType::INT,
-	DataType::DOUBLE,
-	DataType::FLOAT4,
-	DataType::COLOR,
-	DataType::FILENAME,
-	DataType::DIRECTORY
+// Expands to the 'name', 'wName' and 'nameLength' members of a DataTypeInfo structure
+#define DATATYPE_WIDEN(str) L ## str
+#define DATATYPE_NAME(D) #D, DATATYPE_WIDEN(#D), sizeof(#D) - 1
+
+const Config::DataTypeInfo Config::s_dataTypeInfo[] = {
+	{ DataType::WSTRING, DATATYPE_NAME(WSTRING), sizeof(std::wstring), true,
+		destroyValue<std::wstring>, copyValue<std::wstring>, equalValues<std::wstring>,
+		parseText<std::wstring, wStrLiteralToWString>, checkWString, formatWString },
+	{ DataType::BOOL, DATATYPE_NAME(BOOL), sizeof(bool), false,
+		destroyValue<bool>, copyValue<bool>, equalValues<bool>,
+		parseText<bool, strToBool>, checkText<bool, strToBool>, formatBool },
+	{ DataType::INT, DATATYPE_NAME(INT), sizeof(int), false,
+		destroyValue<int>, copyValue<int>, equalValues<int>,
+		parseText<int, strToNumber<int> >, checkText<int, strToNumber<int> >, formatNumber<int> },
+	{ DataType::DOUBLE, DATATYPE_NAME(DOUBLE), sizeof(double), false,
+		destroyValue<double>, copyValue<double>, equalValues<double>,
+		parseText<double, strToNumber<double> >, checkText<double, strToNumber<double> >, formatNumber<double> },
+	{ DataType::FLOAT4, DATATYPE_NAME(FLOAT4), sizeof(XMFLOAT4), false,
+		destroyValue<XMFLOAT4>, copyValue<XMFLOAT4>, equalValues<XMFLOAT4>,
+		parseText<XMFLOAT4, strToXMFLOAT4>, checkText<XMFLOAT4, strToXMFLOAT4>, formatFloat4 },
+	{ DataType::COLOR, DATATYPE_NAME(COLOR), sizeof(XMFLOAT4), false,
+		destroyValue<XMFLOAT4>, copyValue<XMFLOAT4>, equalValues<XMFLOAT4>,
+		parseText<XMFLOAT4, strToColorRGBA>, checkText<XMFLOAT4, strToColorRGBA>, formatColor },
+	{ DataType::FILENAME, DATATYPE_NAME(FILENAME), sizeof(std::wstring), true,
+		destroyValue<std::wstring>, copyValue<std::wstring>, equalValues<std::wstring>,
+		parseFileOrDirName<true>, checkFileOrDirName<true>, formatFileOrDirName },
+	{ DataType::DIRECTORY, DATATYPE_NAME(DIRECTORY), sizeof(std::wstring), true,
+		destroyValue<std::wstring>, copyValue<std::wstring>, equalValues<std::wstring>,
+		parseFileOrDirName<false>, checkFileOrDirName<false>, formatFileOrDirName }
 };
 
-const size_t Config::s_nDataTypes = sizeof(s_dataTypesInOrder) / sizeof(Config::DataType);
+#undef DATATYPE_NAME
+#undef DATATYPE_WIDEN
 
-HRESULT Config::wstringToDataType(DataType& out, const std::wstring& in) {
+const size_t Config::s_nDataTypes = sizeof(s_dataTypeInfo) / sizeof(Config::DataTypeInfo);
+
+unsigned char Config::s_dataTypeSlots[CONFIG_DATATYPE_HASH_SIZE] = { 0 };
+
+/* Visual Studio 2013 does not support constexpr functions,
+   so the hash table is filled during static initialization.
+   (The descriptor table above is constant-initialized,
+   so it is ready before this point.)
+ */
+const bool Config::s_dataTypeSlotsPerfect = Config::buildDataTypeSlots();
+
+bool Config::buildDataTypeSlots(void) {
+	bool perfect = true;
 	for( size_t i = 0; i < s_nDataTypes; ++i ) {
-		if( in == s_dataTypesNames[i] ) {
-			out = s_dataTypesInOrder[i];
-			return ERROR_SUCCESS;
+		const DataTypeInfo& info = s_dataTypeInfo[i];
+		unsigned char& slot = s_dataTypeSlots[hashDataTypeName(info.name, info.nameLength)];
+		if( slot != 0 ) {
+			perfect = false;
+		} else {
+			slot = static_cast<unsigned char>(i + 1);
 		}
 	}
-	return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_NOT_FOUND);
+	return perfect;
 }
 
-HRESULT Config::cstrToDataType(DataType& out, const char* const in) {
-	std::string str = in;
-	std::wstring wStr;
-	if( FAILED(toWString(wStr, str)) ) {
-		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+template<typename C> const Config::DataTypeInfo* Config::lookupDataTypeName(
+	const C* const name, const size_t length) {
+
+	if( name == 0 || length == 0 ) {
+		return 0;
+	}
+
+	if( s_dataTypeSlotsPerfect ) {
+		const unsigned char slot = s_dataTypeSlots[hashDataTypeName(name, length)];
+		if( slot != 0 ) {
+			const DataTypeInfo& info = s_dataTypeInfo[slot - 1];
+			if( info.nameLength == length && namesEqual(getName(info, name), name, length) ) {
+				return &info;
+			}
+		}
 	} else {
-		return wstringToDataType(out, wStr);
+		for( size_t i = 0; i < s_nDataTypes; ++i ) {
+			const DataTypeInfo& info = s_dataTypeInfo[i];
+			if( info.nameLength == length && namesEqual(getName(info, name), name, length) ) {
+				return &info;
+			}
+		}
+	}
+	return 0;
+}
+
+const Config::DataTypeInfo* Config::getDataTypeInfo(const DataType type) {
+	const size_t i = static_cast<size_t>(type);
+	if( i < s_nDataTypes && s_dataTypeInfo[i].type == type ) {
+		return s_dataTypeInfo + i;
+	}
+	return 0;
+}
+
+const Config::DataTypeInfo* Config::getDataTypeInfo(const char* const name, const size_t length) {
+	return lookupDataTypeName(name, length);
+}
+
+const Config::DataTypeInfo* Config::getDataTypeInfo(const wchar_t* const name, const size_t length) {
+	return lookupDataTypeName(name, length);
+}
+
+HRESULT Config::wstringToDataType(DataType& out, const std::wstring& in) {
+	const DataTypeInfo* info = getDataTypeInfo(in.c_str(), in.length());
+	if( info == 0 ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_NOT_FOUND);
+	}
+	out = info->type;
+	return ERROR_SUCCESS;
+}
+
+HRESULT Config::cstrToDataType(DataType& out, const char* const in) {
+	if( in == 0 ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NULL_INPUT);
+	}
+	const DataTypeInfo* info = getDataTypeInfo(in, strlen(in));
+	if( info == 0 ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_NOT_FOUND);
 	}
+	out = info->type;
+	return ERROR_SUCCESS;
 }
 
 
 HRESULT Config::dataTypeToWString(std::wstring& out, const DataType& in) {
-	for( size_t i = 0; i < s_nDataTypes; ++i ) {
-		if( in == s_dataTypesInOrder[i] ) {
-			out = s_dataTypesNames[i];
-			return ERROR_SUCCESS;
-		}
+	const DataTypeInfo* info = getDataTypeInfo(in);
+	if( info == 0 ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_NOT_FOUND);
 	}
-	return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_NOT_FOUND);
+	out = info->wName;
+	return ERROR_SUCCESS;
 }
 
 Config::Value::Value(const DataType type, const void* const value) :
-m_type(type), m_value(value)
+m_type(type), m_value(value), m_raw(0), m_decoder(0),
+m_decodeFailed(false), m_decodeMsg()
 {
 	if( m_value == 0 ) {
 		throw std::invalid_argument("Config::Value constructor passed a null pointer.");
 	}
 }
 
+Config::Value::Value(const DataType type, const std::string& raw, Decoder decoder) :
+m_type(type), m_value(0), m_raw(0), m_decoder(decoder),
+m_decodeFailed(false), m_decodeMsg()
+{
+	if( m_decoder == 0 ) {
+		throw std::invalid_argument("Config::Value constructor passed a null decoding function.");
+	}
+	m_raw = new std::string(raw);
+}
+
 Config::Value::~Value(void) {
-	switch( m_type ) {
-	case DataType::WSTRING:
-		delete static_cast<const std::wstring* const>(m_value);
-		break;
-	case DataType::BOOL:
-		delete static_cast<const bool* const>(m_value);
-		break;
-	case DataType::INT:
-		delete static_cast<const int* const>(m_value);
-		break;
-	case DataType::DOUBLE:
-		delete static_cast<const double* const>(m_value);
-		break;
-	case DataType::FLOAT4:
-		delete static_cast<const XMFLOAT4* const>(m_value);
-		break;
-	case DataType::COLOR:
-		delete static_cast<const XMFLOAT4* const>(m_value);
-		break;
-	case DataType::FILENAME:
-		delete static_cast<const std::wstring* const>(m_value);
-		break;
-	case DataType::DIRECTORY:
-		delete static_cast<const std::wstring* const>(m_value);
-		break;
-	default:
+	if( m_raw != 0 ) {
+		delete m_raw;
+		m_raw = 0;
+	}
+	if( m_value == 0 ) {
+		return;
+	}
+	const DataTypeInfo* info = getDataTypeInfo(m_type);
+	if( info == 0 ) {
 		// This is a Microsoft-specific constructor
 		throw std::exception("Config::Value class destructor is not designed to"
 			"delete this type of data.");
-		return;
 	}
+	info->destroy(m_value);
 }
 
 Config::DataType Config::Value::getDataType(void) const {
@@ -131,12 +359,37 @@ Config::DataType Config::Value::getDataType(void) const {
 
 const void* const Config::Value::getValue(const DataType type) const {
 	if( type == m_type ) {
+		decode();
 		return m_value;
 	} else {
 		return 0;
 	}
 }
 
+HRESULT Config::Value::decode(void) const {
+	if( m_raw != 0 ) {
+		const void* value = 0;
+		HRESULT result = m_decoder(m_type, *m_raw, value, m_decodeMsg);
+		if( result == ERROR_SUCCESS && value != 0 ) {
+			m_value = value;
+		} else {
+			m_decodeFailed = true;
+		}
+		delete m_raw;
+		m_raw = 0;
+	}
+
+	if( m_decodeFailed ) {
+		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_INVALID_DATA);
+	} else {
+		return ERROR_SUCCESS;
+	}
+}
+
+const std::wstring& Config::Value::getDecodeMessage(void) const {
+	return m_decodeMsg;
+}
+
 Config::Key::Key(const std::wstring& scope, const std::wstring& field) :
 m_scope(scope), m_field(field)
 {
@@ -206,8 +459,40 @@ HRESULT Config::insert(const std::wstring& scope, const std::wstring& field,
 	}
 }
 
+HRESULT Config::insert(const std::wstring& scope, const std::wstring& field,
+	Value* const value, std::wstring* locatorsOut) {
+
+	if( value == 0 ) {
+		return 	MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NULL_INPUT);
+	}
+
+	if( locatorsOut != 0 ) {
+		if( FAILED(locatorsToWString(*locatorsOut, scope, field, value->getDataType())) ) {
+			return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+		}
+	}
+
+	// Prevent exceptions from being thrown later
+	if( field.length() == 0 ) {
+		return 	MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_INPUT);
+	}
+
+	// Check for existing elements
+	Key key(scope, field);
+	if( m_map.count(key) != 0 ) {
+		return 	MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_ALREADY_ASSIGNED);
+	} else {
+		m_map[key] = value;
+		return ERROR_SUCCESS;
+	}
+}
+
 const void* Config::retrieve(const std::wstring& scope, const std::wstring& field,
-	const DataType type) const {
+	const DataType type, bool* const invalidOut) const {
+
+	if( invalidOut != 0 ) {
+		*invalidOut = false;
+	}
 
 	if( field.length() == 0 ) {
 		// Invalid input argument
@@ -221,7 +506,11 @@ const void* Config::retrieve(const std::wstring& scope, const std::wstring& fiel
 	if( mapping != m_map.cend() ) {
 		Value* value = mapping->second;
 		// This function checks for a wrong data type
-		return value->getValue(type);
+		const void* data = value->getValue(type);
+		if( data == 0 && invalidOut != 0 && value->getDataType() == type ) {
+			*invalidOut = true;
+		}
+		return data;
 	} else {
 		return 0;
 	}
@@ -244,6 +533,123 @@ HRESULT Config::locatorsToWString(std::wstring& out,
 	return ERROR_SUCCESS;
 }
 
+HRESULT Config::getDecodeMessage(std::wstring& out,
+	const std::wstring& scope, const std::wstring& field) const {
+
+	if( field.length() == 0 ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_INPUT);
+	}
+
+	map<Key, Value*>::const_iterator mapping = m_map.find(Key(scope, field));
+	if( mapping == m_map.cend() ) {
+		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_NOT_FOUND);
+	}
+	out = mapping->second->getDecodeMessage();
+	return ERROR_SUCCESS;
+}
+
+HRESULT Config::validateAll(std::list<std::wstring>* const msgs) const {
+
+	HRESULT result = ERROR_SUCCESS;
+	map<Key, Value*>::const_iterator end = m_map.cend();
+	for( map<Key, Value*>::const_iterator it = m_map.cbegin(); it != end; ++it ) {
+		const Value* value = it->second;
+		bool invalid = (value->decode() != ERROR_SUCCESS);
+		if( invalid ) {
+			result = MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+
+		if( msgs != 0 && (invalid || !value->getDecodeMessage().empty()) ) {
+			std::wstring msg;
+			if( FAILED(locatorsToWString(msg, it->first.getScope(), it->first.getField(), value->getDataType())) ) {
+				return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+			}
+			if( invalid ) {
+				msg += L" invalid value:";
+			}
+			msgs->emplace_back(msg + L" " + value->getDecodeMessage());
+		}
+	}
+	return result;
+}
+
+HRESULT Config::insertCopies(const Config& src, const std::wstring& scopePrefix) {
+
+	map<Key, Value*>::const_iterator end = src.m_map.cend();
+	for( map<Key, Value*>::const_iterator it = src.m_map.cbegin(); it != end; ++it ) {
+		DataType type = it->second->getDataType();
+		const void* value = it->second->getValue(type);
+		const void* copy = 0;
+		if( value == 0 ) {
+			// Values which could not be decoded are not copied
+			continue;
+		}
+		const DataTypeInfo* info = getDataTypeInfo(type);
+		if( info == 0 ) {
+			return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_BROKEN_CODE);
+		}
+		copy = info->copy(value);
+
+		Value* valueObj = new Value(type, copy);
+		HRESULT result = ERROR_SUCCESS;
+		if( scopePrefix.empty() ) {
+			result = insert(it->first.getScope(), it->first.getField(), valueObj);
+		} else {
+			result = insert(joinScopes(scopePrefix, it->first.getScope()), it->first.getField(), valueObj);
+		}
+		if( result != ERROR_SUCCESS ) {
+			// Keys already present in this object are not overwritten
+			delete valueObj;
+		}
+	}
+	return ERROR_SUCCESS;
+}
+
+HRESULT Config::assignChanges(const Config& src, std::list<Key>* const changed) {
+
+	map<Key, Value*>::const_iterator end = src.m_map.cend();
+	for( map<Key, Value*>::const_iterator it = src.m_map.cbegin(); it != end; ++it ) {
+		DataType type = it->second->getDataType();
+		const void* value = it->second->getValue(type);
+		if( value == 0 ) {
+			// Values which could not be decoded are not copied
+			continue;
+		}
+		const DataTypeInfo* info = getDataTypeInfo(type);
+		if( info == 0 ) {
+			return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_BROKEN_CODE);
+		}
+
+		map<Key, Value*>::iterator existing = m_map.find(it->first);
+		if( existing != m_map.end() ) {
+			if( existing->second->getDataType() == type ) {
+				const void* const oldValue = existing->second->getValue(type);
+				if( oldValue != 0 && info->equals(oldValue, value) ) {
+					continue;
+				}
+			}
+			delete existing->second;
+			existing->second = new Value(type, info->copy(value));
+		} else {
+			m_map[it->first] = new Value(type, info->copy(value));
+		}
+		if( changed != 0 ) {
+			changed->push_back(it->first);
+		}
+	}
+	return ERROR_SUCCESS;
+}
+
+std::wstring Config::joinScopes(const std::wstring& prefix, const std::wstring& scope) {
+	if( prefix.empty() ) {
+		return scope;
+	} else if( scope.empty() ) {
+		return prefix;
+	} else {
+		return prefix + CONFIG_SCOPE_PREFIX_SEP + scope;
+	}
+}
+
 map<Config::Key, Config::Value*>::const_iterator Config::cbegin(void) const {
 	return m_map.cbegin();
 }
@@ -0,0 +1,250 @@
+/*
+ConfigCache.cpp
+---------------
+
+Created for: Spring 2014 Direct3D 11 Learning
+By: Bernard Llanos
+August 14, 2014
+
+Primary basis: None
+Other references: None
+
+Development environment: Visual Studio 2013 running on Windows 7, 64-bit
+  -Note that the "Character Set" project property (Configuration Properties > General)
+   should be set to Unicode for all configurations, when using Visual Studio.
+
+Description
+  -Implementation of the ConfigCache class
+*/
+
+#include "ConfigCache.h"
+#include "defs.h"
+#include "fileUtil.h"
+#include <typeinfo>
+#include <algorithm>
+#include <cwctype>
+
+using std::wstring;
+
+std::map<ConfigCache::EntryKey, std::shared_ptr<ConfigCache::Entry> > ConfigCache::s_entries;
+std::mutex ConfigCache::s_mutex;
+std::condition_variable ConfigCache::s_readComplete;
+bool ConfigCache::s_enabled = false;
+bool ConfigCache::s_hashContents = false;
+
+ConfigCache::Entry::Entry(void) :
+identity(), includes(), config(0), result(ERROR_SUCCESS)
+{}
+
+ConfigCache::Entry::~Entry(void) {
+	if( config != 0 ) {
+		delete config;
+		config = 0;
+	}
+}
+
+bool ConfigCache::setEnabled(const bool enabled) {
+	bool previousState = false;
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		previousState = s_enabled;
+		s_enabled = enabled;
+	}
+	if( !enabled ) {
+		clear();
+	}
+	return previousState;
+}
+
+bool ConfigCache::setContentHashing(const bool hashContents) {
+	std::lock_guard<std::mutex> lock(s_mutex);
+	bool previousState = s_hashContents;
+	s_hashContents = hashContents;
+	return previousState;
+}
+
+HRESULT ConfigCache::read(IConfigIO& configIO, const wstring& filename,
+	Config& config) {
+
+	bool hashContents = false;
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		if( !s_enabled ) {
+			return configIO.read(filename, config);
+		}
+		hashContents = s_hashContents;
+	}
+
+	// Identify the file
+	EntryKey key;
+	FileIdentity identity;
+	if( FAILED(fileUtil::fullPath(key.second, filename)) ||
+		FAILED(getFileIdentity(filename, identity, hashContents)) ) {
+		// Let the IConfigIO object report the problem with the file
+		return configIO.read(filename, config);
+	}
+	std::transform(key.second.begin(), key.second.end(), key.second.begin(), towlower);
+	key.first = typeid(configIO).name();
+
+	/* Only the lookup is done under the lock. The entry is validated
+	   and copied after the lock is released, and is removed if it
+	   is still in the cache when it is found to be out of date.
+	 */
+	std::unique_lock<std::mutex> lock(s_mutex);
+	std::shared_ptr<Entry> stale;
+	std::map<EntryKey, std::shared_ptr<Entry> >::iterator it = s_entries.find(key);
+	while( it != s_entries.end() ) {
+		if( it->second->config == 0 ) {
+			// Another thread is reading the file
+			s_readComplete.wait(lock);
+		} else if( it->second == stale ) {
+			// The file has changed
+			s_entries.erase(it);
+			break;
+		} else {
+			std::shared_ptr<Entry> cached = it->second;
+			lock.unlock();
+			if( entryValid(*cached, identity, hashContents) ) {
+				if( FAILED(config.insertCopies(*(cached->config))) ) {
+					return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+				}
+				return cached->result;
+			}
+			stale = cached;
+			lock.lock();
+		}
+		it = s_entries.find(key);
+	}
+
+	// Reserve the entry, so that other threads wait for this thread to read the file
+	std::shared_ptr<Entry> entry(new Entry);
+	s_entries[key] = entry;
+	lock.unlock();
+
+	Config* parsed = new Config;
+	HRESULT result = configIO.read(filename, *parsed);
+	bool cache = SUCCEEDED(result) && SUCCEEDED(getFileIdentity(filename, identity, hashContents));
+
+	// Record the identities of the other files from which data was loaded
+	std::vector<std::pair<wstring, FileIdentity> > includes;
+	if( cache ) {
+		std::vector<wstring> includedFiles;
+		configIO.getIncludedFiles(includedFiles);
+		includes.resize(includedFiles.size());
+		for( std::vector<wstring>::size_type i = 0; i < includedFiles.size() && cache; ++i ) {
+			includes[i].first = includedFiles[i];
+			cache = SUCCEEDED(getFileIdentity(includedFiles[i], includes[i].second, hashContents));
+		}
+	}
+
+	/* Copy the data before the Config object is shared,
+	   as the copy operation decodes any undecoded values
+	 */
+	HRESULT copyResult = ERROR_SUCCESS;
+	if( SUCCEEDED(result) ) {
+		copyResult = config.insertCopies(*parsed);
+	}
+
+	lock.lock();
+	if( cache ) {
+		entry->identity = identity;
+		entry->includes.swap(includes);
+		entry->result = result;
+		entry->config = parsed;
+	} else {
+		delete parsed;
+		s_entries.erase(key);
+	}
+	lock.unlock();
+	s_readComplete.notify_all();
+
+	if( FAILED(result) ) {
+		return result;
+	} else if( FAILED(copyResult) ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	return result;
+}
+
+void ConfigCache::clear(void) {
+	std::lock_guard<std::mutex> lock(s_mutex);
+	std::map<EntryKey, std::shared_ptr<Entry> >::iterator it = s_entries.begin();
+	while( it != s_entries.end() ) {
+		if( it->second->config == 0 ) {
+			// The file is being read, and the entry will be completed by another thread
+			++it;
+		} else {
+			it = s_entries.erase(it);
+		}
+	}
+}
+
+HRESULT ConfigCache::getFileIdentity(const wstring& filename,
+	FileIdentity& out, const bool hashContents) {
+
+	// See http://msdn.microsoft.com/en-us/library/windows/desktop/aa364952%28v=vs.85%29.aspx
+	HANDLE file = CreateFile(filename.c_str(), FILE_READ_ATTRIBUTES,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if( file == INVALID_HANDLE_VALUE ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FILE_NOT_FOUND);
+	}
+	BY_HANDLE_FILE_INFORMATION information;
+	BOOL success = GetFileInformationByHandle(file, &information);
+	CloseHandle(file);
+	if( !success ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WINDOWS_CALL);
+	}
+
+	out.volumeSerial = information.dwVolumeSerialNumber;
+	out.fileIndex = (static_cast<uint64_t>(information.nFileIndexHigh) << 32) | information.nFileIndexLow;
+	out.size = (static_cast<uint64_t>(information.nFileSizeHigh) << 32) | information.nFileSizeLow;
+	out.writeTime = (static_cast<uint64_t>(information.ftLastWriteTime.dwHighDateTime) << 32) |
+		information.ftLastWriteTime.dwLowDateTime;
+	out.contentHash = 0;
+
+	if( hashContents ) {
+		HANDLE fileHandle = INVALID_HANDLE_VALUE;
+		HANDLE mappingHandle = NULL;
+		const char* data = 0;
+		size_t size = 0;
+		HRESULT result = fileUtil::mapFile(filename, fileHandle, mappingHandle, data, size);
+		if( FAILED(result) ) {
+			return result;
+		}
+		out.contentHash = hash(data, size);
+		fileUtil::unmapFile(fileHandle, mappingHandle, data);
+	}
+	return ERROR_SUCCESS;
+}
+
+bool ConfigCache::entryValid(const Entry& entry, const FileIdentity& fileIdentity,
+	const bool hashContents) {
+	const FileIdentity& cached = entry.identity;
+	if( cached.volumeSerial != fileIdentity.volumeSerial || cached.fileIndex != fileIdentity.fileIndex ||
+		cached.size != fileIdentity.size || cached.writeTime != fileIdentity.writeTime ||
+		cached.contentHash != fileIdentity.contentHash ) {
+		return false;
+	}
+
+	FileIdentity identity;
+	std::vector<std::pair<wstring, FileIdentity> >::const_iterator end = entry.includes.cend();
+	for( std::vector<std::pair<wstring, FileIdentity> >::const_iterator it = entry.includes.cbegin(); it != end; ++it ) {
+		if( FAILED(getFileIdentity(it->first, identity, hashContents)) ||
+			identity.volumeSerial != it->second.volumeSerial || identity.fileIndex != it->second.fileIndex ||
+			identity.size != it->second.size || identity.writeTime != it->second.writeTime ||
+			identity.contentHash != it->second.contentHash ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+uint64_t ConfigCache::hash(const char* const data, const size_t length) {
+	uint64_t hash = 14695981039346656037ULL;
+	for( size_t i = 0; i < length; ++i ) {
+		hash ^= static_cast<unsigned char>(data[i]);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
\ No newline at end of file
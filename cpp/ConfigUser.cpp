@@ -88,6 +88,9 @@ HRESULT ConfigUser::deletePrivateConfig(void) {
 		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WRONG_STATE);
 	}
 	if( m_config != 0 ) {
+		if( g_configWatcher != 0 ) {
+			g_configWatcher->unwatch(*m_config);
+		}
 		delete m_config;
 		m_config = 0;
 		CONFIGUSER_LOGMESSAGE(L"deletePrivateConfig(): Config instance was deleted.")
@@ -255,6 +258,16 @@ HRESULT ConfigUser::configureLogUserOnly(const wstring& scope) {
 			setMsgPrefix(*stringValue);
 		}
 
+		// Set the minimum severity level of messages logged with a level
+		unsigned int logLevel = LOGUSER_LOG_LEVEL;
+		if( retrieve<Config::DataType::WSTRING, wstring>(scope, LOGUSER_LOG_LEVEL_FIELD, stringValue) ) {
+			if( FAILED(logLevelFromString(logLevel, *stringValue)) ) {
+				LOGUSER_WARNING(L"ConfigUser::configureLogUserOnly() : Unrecognized log level name, \"" + *stringValue +
+					L"\". Expected \"debug\", \"info\", \"warning\" or \"error\".");
+			}
+		}
+		setLogLevel(logLevel);
+
 		// Set whether to use the global Logger
 		bool useGlobalLogger;
 		bool hasGlobalLoggerValue = retrieve<Config::DataType::BOOL, bool>(scope, LOGUSER_USEGLOBAL_LOGGER_FLAG_FIELD, boolValue);
@@ -300,7 +313,7 @@ HRESULT ConfigUser::configureLogUserOnly(const wstring& scope) {
 				// Primary log file path
 				if( retrieve<Config::DataType::DIRECTORY, wstring>(scope, LOGUSER_PRIMARYFILE_PATH_FIELD, stringValue) ) {
 					if( FAILED(fileUtil::combineAsPath(filename, *stringValue, filename)) ) {
-						logMessage(L"ConfigUser::configureLogUserOnly() : fileUtil::combineAsPath() failed to combine the primary log file name and path.");
+						LOGUSER_ERROR(L"ConfigUser::configureLogUserOnly() : fileUtil::combineAsPath() failed to combine the primary log file name and path.");
 						return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
 					}
 					hasAnySetLoggerValue = true;
@@ -346,18 +359,18 @@ HRESULT ConfigUser::configureLogUserOnly(const wstring& scope) {
 				useGlobalLogger = true;
 				if( !hasGlobalLoggerValue ) {
 					if( hasAnySetLoggerValue ) {
-						logMessage(L"ConfigUser::configureLogUserOnly() : Missing some configuration data needed to set up a custom Logger instance. Global Logger use is assumed.");
+						LOGUSER_WARNING(L"ConfigUser::configureLogUserOnly() : Missing some configuration data needed to set up a custom Logger instance. Global Logger use is assumed.");
 					} else {
-						logMessage(L"ConfigUser::configureLogUserOnly() : "
+						LOGUSER_INFO(L"ConfigUser::configureLogUserOnly() : "
 							L"No configuration data found relating to setting a custom Logger instance or using "
 							L"the global Logger instance. Global Logger use is assumed.");
 					}
 				} else {
 					if( hasAnySetLoggerValue ) {
-						logMessage(L"ConfigUser::configureLogUserOnly() : Missing some configuration data needed to set up a custom Logger instance. "
+						LOGUSER_WARNING(L"ConfigUser::configureLogUserOnly() : Missing some configuration data needed to set up a custom Logger instance. "
 							L"The global Logger will be used, even though the configuration data indicates to use a custom Logger.");
 					} else {
-						logMessage(L"ConfigUser::configureLogUserOnly() : "
+						LOGUSER_WARNING(L"ConfigUser::configureLogUserOnly() : "
 							L"No configuration data found relating to setting a custom Logger instance."
 							L"The global Logger will be used, even though the configuration data indicates to use a custom Logger.");
 					}
@@ -368,7 +381,7 @@ HRESULT ConfigUser::configureLogUserOnly(const wstring& scope) {
 		// Flag indicating whether or not to timestamp logging output
 		if( retrieve<Config::DataType::BOOL, bool>(scope, LOGUSER_TIMESTAMP_FLAG_FIELD, boolValue) ) {
 			if( useGlobalLogger ) {
-				logMessage(L"ConfigUser::configureLogUserOnly() : Changing the timestamping behaviour of the global Logger from configuration data is prohibited.");
+				LOGUSER_WARNING(L"ConfigUser::configureLogUserOnly() : Changing the timestamping behaviour of the global Logger from configuration data is prohibited.");
 			} else {
 				toggleTimestamp(*boolValue);
 			}
@@ -376,8 +389,63 @@ HRESULT ConfigUser::configureLogUserOnly(const wstring& scope) {
 			toggleTimestamp(LOGUSER_TIMESTAMP_FLAG);
 		}
 
+		// Rotation of the primary log file
+		const int* intValue = 0;
+		bool hasRotationValue = false;
+		int rotationSize = LOGUSER_ROTATION_SIZE;
+		int rotationInterval = LOGUSER_ROTATION_INTERVAL;
+		int rotationSegments = LOGUSER_ROTATION_SEGMENTS;
+		if( retrieve<Config::DataType::INT, int>(scope, LOGUSER_ROTATION_SIZE_FIELD, intValue) ) {
+			rotationSize = *intValue;
+			hasRotationValue = true;
+		}
+		if( retrieve<Config::DataType::INT, int>(scope, LOGUSER_ROTATION_INTERVAL_FIELD, intValue) ) {
+			rotationInterval = *intValue;
+			hasRotationValue = true;
+		}
+		if( retrieve<Config::DataType::INT, int>(scope, LOGUSER_ROTATION_SEGMENTS_FIELD, intValue) ) {
+			rotationSegments = *intValue;
+			hasRotationValue = true;
+		}
+		if( hasRotationValue ) {
+			if( useGlobalLogger ) {
+				LOGUSER_WARNING(L"ConfigUser::configureLogUserOnly() : Changing the rotation behaviour of the global Logger from configuration data is prohibited.");
+			} else if( rotationSize < 0 || rotationInterval < 0 || rotationSegments < 0 ) {
+				LOGUSER_WARNING(L"ConfigUser::configureLogUserOnly() : Log rotation sizes, intervals and numbers of segments cannot be negative.");
+			} else if( FAILED(setLogRotation(static_cast<ULONGLONG>(rotationSize) * 1024,
+				static_cast<DWORD>(rotationInterval) * 1000, static_cast<unsigned int>(rotationSegments))) ) {
+				LOGUSER_ERROR(L"ConfigUser::configureLogUserOnly() : Failed to enable rotation of the primary log file. "
+					L"Rotation requires a primary log file which is appended to, rather than overwritten.");
+			}
+		}
+
+		/* Suppression of repeated messages, and rate limiting (which apply to this object, not its Logger).
+		   Settings without configuration data are left unchanged.
+		 */
+		if( retrieve<Config::DataType::BOOL, bool>(scope, LOGUSER_SUPPRESS_REPEATS_FLAG_FIELD, boolValue) ) {
+			setRepeatSuppression(*boolValue);
+		}
+		unsigned int rateLimit = 0;
+		DWORD rateInterval = 0;
+		getRateLimit(rateLimit, rateInterval);
+		bool hasRateValue = false;
+		bool validRateValues = true;
+		if( retrieve<Config::DataType::INT, int>(scope, LOGUSER_RATE_LIMIT_FIELD, intValue) ) {
+			validRateValues = (*intValue >= 0);
+			rateLimit = static_cast<unsigned int>(*intValue);
+			hasRateValue = true;
+		}
+		if( retrieve<Config::DataType::INT, int>(scope, LOGUSER_RATE_INTERVAL_FIELD, intValue) ) {
+			validRateValues = validRateValues && (*intValue >= 0);
+			rateInterval = static_cast<DWORD>(*intValue);
+			hasRateValue = true;
+		}
+		if( hasRateValue && (!validRateValues || FAILED(setRateLimit(rateLimit, rateInterval))) ) {
+			LOGUSER_WARNING(L"ConfigUser::configureLogUserOnly() : Log rate limits must be non-negative, with a positive interval.");
+		}
+
 	} else {
-		logMessage(L"ConfigUser::configureLogUserOnly() : No Config instance to use.");
+		LOGUSER_ERROR(L"ConfigUser::configureLogUserOnly() : No Config instance to use.");
 		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_NOT_FOUND);
 	}
 	return ERROR_SUCCESS;
@@ -404,7 +472,7 @@ HRESULT ConfigUser::configureConfigUserOnly(const wstring& scope) {
 		}
 
 	} else {
-		logMessage(L"ConfigUser::configureConfigUserOnly() : No Config instance to use.");
+		LOGUSER_ERROR(L"ConfigUser::configureConfigUserOnly() : No Config instance to use.");
 		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_NOT_FOUND);
 	}
 	return ERROR_SUCCESS;
@@ -424,7 +492,7 @@ HRESULT ConfigUser::configureConfigUser(const wstring& logUserScope, const wstri
 			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
 		}
 	} else {
-		logMessage(L"ConfigUser::configureConfigUser() : No Config instance to use.");
+		LOGUSER_ERROR(L"ConfigUser::configureConfigUser() : No Config instance to use.");
 		result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_NOT_FOUND);
 	}
 	return result;
@@ -0,0 +1,538 @@
+/*
+ConfigWatcher.cpp
+-----------------
+
+Created for: Spring 2014 Direct3D 11 Learning
+By: Bernard Llanos
+August 15, 2014
+
+Primary basis: None
+Other references: None
+
+Development environment: Visual Studio 2013 running on Windows 7, 64-bit
+  -Note that the "Character Set" project property (Configuration Properties > General)
+   should be set to Unicode for all configurations, when using Visual Studio.
+
+Description
+  -Implementation of the ConfigWatcher class
+*/
+
+#include "ConfigWatcher.h"
+#include "defs.h"
+#include "globals.h"
+#include <exception>
+#include <algorithm>
+
+using std::wstring;
+
+ConfigWatcher::SourceFile::SourceFile(void) :
+filename(), directory(), size(0), writeTime(0)
+{}
+
+ConfigWatcher::WatchedFile::WatchedFile(void) :
+filename(), directory(), ioClassName(), configIO(0), targets(),
+size(0), writeTime(0), includes(), pending(false), changeTick(0)
+{}
+
+ConfigWatcher::WatchedFile::~WatchedFile(void) {
+	if( configIO != 0 ) {
+		delete configIO;
+		configIO = 0;
+	}
+}
+
+ConfigWatcher::Reload::Reload(void) :
+filename(), target(0), data(0), writeTime(0)
+{}
+
+ConfigWatcher::Reload::~Reload(void) {
+	if( data != 0 ) {
+		delete data;
+		data = 0;
+	}
+}
+
+ConfigWatcher::ConfigWatcher(void) :
+LogUser(true, L"ConfigWatcher >"), m_mutex(), m_files(), m_retired(),
+m_reloads(), m_threadMsgs(), m_filesChanged(false), m_quit(false),
+m_forcePolling(false), m_wakeEvent(NULL), m_thread(),
+m_lastLatency(0.0), m_maxLatency(0.0)
+{
+	// Auto-reset event
+	m_wakeEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	if( m_wakeEvent == NULL ) {
+		// This is a Microsoft-specific constructor
+		throw std::exception("ConfigWatcher constructor failed to create an event object.");
+	}
+	try {
+		m_thread = std::thread(&ConfigWatcher::watchFiles, this);
+	} catch( ... ) {
+		CloseHandle(m_wakeEvent);
+		m_wakeEvent = NULL;
+		throw;
+	}
+}
+
+ConfigWatcher::~ConfigWatcher(void) {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	SetEvent(m_wakeEvent);
+	if( m_thread.joinable() ) {
+		m_thread.join();
+	}
+	CloseHandle(m_wakeEvent);
+	m_wakeEvent = NULL;
+
+	if( !m_threadMsgs.empty() ) {
+		logMessage(m_threadMsgs.cbegin(), m_threadMsgs.cend());
+	}
+
+	std::list<WatchedFile*>::iterator fileEnd = m_files.end();
+	for( std::list<WatchedFile*>::iterator it = m_files.begin(); it != fileEnd; ++it ) {
+		delete *it;
+	}
+	fileEnd = m_retired.end();
+	for( std::list<WatchedFile*>::iterator it = m_retired.begin(); it != fileEnd; ++it ) {
+		delete *it;
+	}
+	std::list<Reload*>::iterator reloadEnd = m_reloads.end();
+	for( std::list<Reload*>::iterator it = m_reloads.begin(); it != reloadEnd; ++it ) {
+		delete *it;
+	}
+}
+
+HRESULT ConfigWatcher::watch(const wstring& filename, Config& config,
+	IConfigIO* const configIO, const std::string& ioClassName) {
+
+	wstring fullName;
+	wstring directory;
+	uint64_t size = 0;
+	uint64_t writeTime = 0;
+	if( FAILED(fileUtil::fullPath(fullName, filename)) ||
+		FAILED(fileUtil::extractPath(directory, fullName)) ) {
+		delete configIO;
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	} else if( FAILED(fileUtil::getFileStamp(fullName, size, writeTime)) ) {
+		delete configIO;
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FILE_NOT_FOUND);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// Add the Config object as a target of an existing file
+		std::list<WatchedFile*>::iterator end = m_files.end();
+		for( std::list<WatchedFile*>::iterator it = m_files.begin(); it != end; ++it ) {
+			WatchedFile* file = *it;
+			if( _wcsicmp(file->filename.c_str(), fullName.c_str()) == 0 &&
+				file->ioClassName == ioClassName ) {
+				if( std::find(file->targets.begin(), file->targets.end(), &config) == file->targets.end() ) {
+					file->targets.push_back(&config);
+				}
+				delete configIO;
+				return ERROR_SUCCESS;
+			}
+		}
+	}
+
+	/* The background thread must not modify the file while it may be
+	   being saved by another program, so problems found when reloading it
+	   are logged (by the IConfigIO object) rather than appended to it.
+	 */
+	configIO->toggleReportOutput(false);
+
+	// Find the included files, without parsing the data in the files
+	std::vector<SourceFile> includes;
+	{
+		std::vector<wstring> includedFiles;
+		configIO->listIncludedFiles(fullName, includedFiles);
+		stampIncludes(includes, includedFiles, std::vector<SourceFile>());
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		WatchedFile* file = new WatchedFile;
+		file->filename = fullName;
+		file->directory = directory;
+		file->ioClassName = ioClassName;
+		file->configIO = configIO;
+		file->targets.push_back(&config);
+		file->size = size;
+		file->writeTime = writeTime;
+		file->includes.swap(includes);
+		m_files.push_back(file);
+		m_filesChanged = true;
+	}
+	SetEvent(m_wakeEvent);
+	return ERROR_SUCCESS;
+}
+
+void ConfigWatcher::unwatch(const Config& config) {
+	bool filesChanged = false;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		std::list<WatchedFile*>::iterator it = m_files.begin();
+		while( it != m_files.end() ) {
+			WatchedFile* file = *it;
+			file->targets.remove(const_cast<Config*>(&config));
+			if( file->targets.empty() ) {
+				m_retired.push_back(file);
+				it = m_files.erase(it);
+				filesChanged = true;
+			} else {
+				++it;
+			}
+		}
+
+		std::list<Reload*>::iterator reload = m_reloads.begin();
+		while( reload != m_reloads.end() ) {
+			if( (*reload)->target == &config ) {
+				delete *reload;
+				reload = m_reloads.erase(reload);
+			} else {
+				++reload;
+			}
+		}
+
+		if( filesChanged ) {
+			m_filesChanged = true;
+		}
+	}
+	if( filesChanged ) {
+		SetEvent(m_wakeEvent);
+	}
+}
+
+HRESULT ConfigWatcher::applyChanges(unsigned int* const nApplied) {
+
+	if( nApplied != 0 ) {
+		*nApplied = 0;
+	}
+
+	std::list<Reload*> reloads;
+	std::list<wstring> msgs;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		reloads.swap(m_reloads);
+		msgs.swap(m_threadMsgs);
+	}
+
+	if( !msgs.empty() ) {
+		logMessage(msgs.cbegin(), msgs.cend());
+	}
+	if( reloads.empty() ) {
+		return ERROR_SUCCESS;
+	}
+
+	FILETIME nowFileTime;
+	GetSystemTimeAsFileTime(&nowFileTime);
+	const uint64_t now = (static_cast<uint64_t>(nowFileTime.dwHighDateTime) << 32) | nowFileTime.dwLowDateTime;
+
+	HRESULT result = ERROR_SUCCESS;
+	std::list<Reload*>::iterator end = reloads.end();
+	for( std::list<Reload*>::iterator it = reloads.begin(); it != end; ++it ) {
+		Reload* reload = *it;
+		std::list<Config::Key> changed;
+		if( FAILED(reload->target->assignChanges(*(reload->data), &changed)) ) {
+			LOGUSER_ERROR(L"Failed to apply changes from the configuration file: " + reload->filename);
+			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+		} else {
+			// FILETIME values are in units of 100 nanoseconds
+			m_lastLatency = (now > reload->writeTime) ? static_cast<double>(now - reload->writeTime) / 10000.0 : 0.0;
+			if( m_lastLatency > m_maxLatency ) {
+				m_maxLatency = m_lastLatency;
+			}
+			LOGUSER_INFO(L"Applied " + std::to_wstring(changed.size()) + L" changed value(s) from the configuration file: " +
+				reload->filename + L" (" + std::to_wstring(m_lastLatency) + L" ms after modification)");
+			if( m_lastLatency > CONFIGWATCHER_LATENCY_TARGET_MS ) {
+				LOGUSER_WARNING(L"The reload latency exceeded the target of " +
+					std::to_wstring(CONFIGWATCHER_LATENCY_TARGET_MS) + L" ms.");
+			}
+			if( nApplied != 0 ) {
+				++(*nApplied);
+			}
+		}
+		delete reload;
+	}
+	return result;
+}
+
+void ConfigWatcher::getLatency(double& last, double& max) const {
+	last = m_lastLatency;
+	max = m_maxLatency;
+}
+
+bool ConfigWatcher::forcePolling(const bool poll) {
+	bool previousState = false;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		previousState = m_forcePolling;
+		m_forcePolling = poll;
+		m_filesChanged = true;
+	}
+	SetEvent(m_wakeEvent);
+	return previousState;
+}
+
+void ConfigWatcher::watchFiles(void) {
+
+	// The first handle is the wake event. The others are directory change notification handles.
+	std::vector<HANDLE> handles(1, m_wakeEvent);
+	std::vector<wstring> directories;
+	bool poll = false;
+	DWORD timeout = INFINITE;
+
+	while( true ) {
+		bool rebuild = false;
+		bool forcePolling = false;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if( m_quit ) {
+				break;
+			}
+
+			// This thread is no longer using the retired files
+			std::list<WatchedFile*>::iterator end = m_retired.end();
+			for( std::list<WatchedFile*>::iterator it = m_retired.begin(); it != end; ++it ) {
+				delete *it;
+			}
+			m_retired.clear();
+
+			rebuild = m_filesChanged;
+			m_filesChanged = false;
+			forcePolling = m_forcePolling;
+			if( rebuild ) {
+				directories.clear();
+				std::vector<const wstring*> fileDirectories;
+				end = m_files.end();
+				for( std::list<WatchedFile*>::iterator it = m_files.begin(); it != end; ++it ) {
+					fileDirectories.clear();
+					fileDirectories.push_back(&((*it)->directory));
+					for( std::vector<SourceFile>::size_type i = 0; i < (*it)->includes.size(); ++i ) {
+						fileDirectories.push_back(&((*it)->includes[i].directory));
+					}
+					for( std::vector<const wstring*>::size_type j = 0; j < fileDirectories.size(); ++j ) {
+						bool found = false;
+						for( std::vector<wstring>::size_type i = 0; i < directories.size() && !found; ++i ) {
+							found = (_wcsicmp(directories[i].c_str(), fileDirectories[j]->c_str()) == 0);
+						}
+						if( !found ) {
+							directories.push_back(*fileDirectories[j]);
+						}
+					}
+				}
+			}
+		}
+
+		// Request change notifications for the directories containing the files
+		if( rebuild ) {
+			for( std::vector<HANDLE>::size_type i = 1; i < handles.size(); ++i ) {
+				FindCloseChangeNotification(handles[i]);
+			}
+			handles.resize(1);
+
+			poll = forcePolling || (directories.size() >= MAXIMUM_WAIT_OBJECTS);
+			for( std::vector<wstring>::size_type i = 0; i < directories.size() && !poll; ++i ) {
+				HANDLE handle = FindFirstChangeNotification(directories[i].c_str(), FALSE,
+					FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_FILE_NAME);
+				if( handle == INVALID_HANDLE_VALUE ) {
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_threadMsgs.emplace_back(L"Change notifications are not available for the directory: " +
+						directories[i] + L" Files will be polled.");
+					poll = true;
+				} else {
+					handles.push_back(handle);
+				}
+			}
+			if( poll ) {
+				for( std::vector<HANDLE>::size_type i = 1; i < handles.size(); ++i ) {
+					FindCloseChangeNotification(handles[i]);
+				}
+				handles.resize(1);
+			}
+		}
+
+		checkFiles(timeout);
+		if( poll && timeout > CONFIGWATCHER_POLL_MS ) {
+			timeout = CONFIGWATCHER_POLL_MS;
+		}
+
+		DWORD wait = WaitForMultipleObjects(static_cast<DWORD>(handles.size()), &handles[0], FALSE, timeout);
+		if( wait > WAIT_OBJECT_0 && wait < WAIT_OBJECT_0 + handles.size() ) {
+			if( !FindNextChangeNotification(handles[wait - WAIT_OBJECT_0]) ) {
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_threadMsgs.emplace_back(L"Failed to renew a change notification. Files will be polled.");
+				m_filesChanged = true;
+				m_forcePolling = true;
+			}
+		} else if( wait == WAIT_FAILED ) {
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_threadMsgs.emplace_back(L"Failed to wait for change notifications. Files will be polled.");
+				m_filesChanged = true;
+				m_forcePolling = true;
+			}
+			Sleep(CONFIGWATCHER_POLL_MS);
+		}
+	}
+
+	for( std::vector<HANDLE>::size_type i = 1; i < handles.size(); ++i ) {
+		FindCloseChangeNotification(handles[i]);
+	}
+}
+
+void ConfigWatcher::checkFiles(DWORD& timeout) {
+
+	timeout = INFINITE;
+
+	/* Files are only deleted by this thread,
+	   so the pointers remain valid without holding the lock
+	 */
+	std::vector<WatchedFile*> files;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		files.assign(m_files.begin(), m_files.end());
+	}
+
+	const DWORD now = GetTickCount();
+	uint64_t size = 0;
+	uint64_t writeTime = 0;
+	for( std::vector<WatchedFile*>::size_type i = 0; i < files.size(); ++i ) {
+		WatchedFile& file = *files[i];
+		if( SUCCEEDED(fileUtil::getFileStamp(file.filename, size, writeTime)) &&
+			(size != file.size || writeTime != file.writeTime) ) {
+			file.size = size;
+			file.writeTime = writeTime;
+			file.pending = true;
+			file.changeTick = now;
+		}
+
+		// A file which has been deleted is given a zero size and modification time
+		for( std::vector<SourceFile>::size_type j = 0; j < file.includes.size(); ++j ) {
+			SourceFile& include = file.includes[j];
+			if( FAILED(fileUtil::getFileStamp(include.filename, size, writeTime)) ) {
+				size = 0;
+				writeTime = 0;
+			}
+			if( size != include.size || writeTime != include.writeTime ) {
+				include.size = size;
+				include.writeTime = writeTime;
+				file.pending = true;
+				file.changeTick = now;
+			}
+		}
+
+		if( file.pending ) {
+			const DWORD elapsed = now - file.changeTick;
+			if( elapsed >= CONFIGWATCHER_DEBOUNCE_MS ) {
+				reloadFile(file);
+			} else if( timeout == INFINITE || (CONFIGWATCHER_DEBOUNCE_MS - elapsed) < timeout ) {
+				timeout = CONFIGWATCHER_DEBOUNCE_MS - elapsed;
+			}
+		}
+	}
+}
+
+void ConfigWatcher::reloadFile(WatchedFile& file) {
+
+	file.pending = false;
+
+	// The latency is measured from the most recent modification
+	uint64_t writeTime = file.writeTime;
+	for( std::vector<SourceFile>::size_type i = 0; i < file.includes.size(); ++i ) {
+		if( file.includes[i].writeTime > writeTime ) {
+			writeTime = file.includes[i].writeTime;
+		}
+	}
+
+	/* The file is stamped before it is read, so that a modification
+	   made while it is being read causes it to be reloaded again
+	 */
+	uint64_t size = 0;
+	uint64_t newWriteTime = 0;
+	if( SUCCEEDED(fileUtil::getFileStamp(file.filename, size, newWriteTime)) ) {
+		file.size = size;
+		file.writeTime = newWriteTime;
+	}
+
+	Config* data = new Config;
+	HRESULT result = file.configIO->read(file.filename, *data);
+
+	// The file may now include a different set of files
+	std::vector<wstring> includedFiles;
+	file.configIO->getIncludedFiles(includedFiles);
+	std::vector<SourceFile> includes;
+	const bool includesChanged = stampIncludes(includes, includedFiles, file.includes);
+	file.includes.swap(includes);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if( includesChanged ) {
+		m_filesChanged = true;
+	}
+	if( FAILED(result) ) {
+		wstring errorStr;
+		if( FAILED(prettyPrintHRESULT(errorStr, result)) ) {
+			errorStr = std::to_wstring(result);
+		}
+		m_threadMsgs.emplace_back(L"Failed to reload the configuration file: " + file.filename +
+			L" Error: " + errorStr);
+		delete data;
+		return;
+	} else if( HRESULT_CODE(result) == ERROR_DATA_INCOMPLETE ) {
+		m_threadMsgs.emplace_back(L"The reloaded configuration file is incomplete: " + file.filename +
+			L" Only the values which were read successfully will be applied.");
+	}
+
+	// Each Config object receives its own copy of the data
+	std::list<Config*>::iterator last = file.targets.end();
+	if( file.targets.empty() ) {
+		delete data;
+		return;
+	}
+	--last;
+	for( std::list<Config*>::iterator it = file.targets.begin(); it != file.targets.end(); ++it ) {
+		Reload* reload = new Reload;
+		reload->filename = file.filename;
+		reload->target = *it;
+		reload->writeTime = writeTime;
+		if( it == last ) {
+			reload->data = data;
+		} else {
+			reload->data = new Config;
+			reload->data->insertCopies(*data);
+		}
+		m_reloads.push_back(reload);
+	}
+}
+
+bool ConfigWatcher::stampIncludes(std::vector<SourceFile>& includes,
+	const std::vector<wstring>& filenames, const std::vector<SourceFile>& previous) {
+
+	includes.clear();
+	for( std::vector<wstring>::size_type i = 0; i < filenames.size(); ++i ) {
+		SourceFile include;
+		if( FAILED(fileUtil::fullPath(include.filename, filenames[i])) ||
+			FAILED(fileUtil::extractPath(include.directory, include.filename)) ) {
+			continue;
+		}
+		if( FAILED(fileUtil::getFileStamp(include.filename, include.size, include.writeTime)) ) {
+			include.size = 0;
+			include.writeTime = 0;
+		}
+		includes.push_back(include);
+	}
+
+	if( includes.size() != previous.size() ) {
+		return true;
+	}
+	for( std::vector<SourceFile>::size_type i = 0; i < includes.size(); ++i ) {
+		if( _wcsicmp(includes[i].filename.c_str(), previous[i].filename.c_str()) != 0 ) {
+			return true;
+		}
+	}
+	return false;
+}
\ No newline at end of file
@@ -22,7 +22,13 @@ Description
 #include "higherLevelIO.h"
 #include "defs.h"
 #include "globals.h"
+#include "fileUtil.h"
 #include <fstream>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <unordered_set>
+#include <cwctype>
 #include <DirectXMath.h>
 
 using std::to_wstring;
@@ -54,8 +60,16 @@ bool FlatAtomicConfigIO::isSupportedDataType(Config::DataType type) {
 }
 
 FlatAtomicConfigIO::FlatAtomicConfigIO(void) :
-LogUser(true, L"FlatAtomicConfigIO >"), m_outputContext(true)
-{}
+LogUser(true, L"FlatAtomicConfigIO >"), m_outputContext(true), m_outputReports(true), m_nReadThreads(1), m_lazyParsing(false),
+m_lineIndexing(false), m_lineIndex(), m_lineIndexFilename(), m_lineIndexFileSize(0), m_lineIndexWriteTime(0),
+m_includes(), m_includedFiles(),
+m_includingFilename(), m_fileIncludes(), m_includedKeys(),
+m_valueBuffer(),
+m_parseConfig(0), m_parseLength(0), m_parseLineNumber(0),
+m_parseResult(ERROR_SUCCESS), m_parseStopped(false)
+{
+	m_parseLine[0] = '\0';
+}
 
 FlatAtomicConfigIO::~FlatAtomicConfigIO(void) {}
 
@@ -65,18 +79,156 @@ bool FlatAtomicConfigIO::toggleContextOutput(const bool outputContext) {
 	return previousState;
 }
 
-void FlatAtomicConfigIO::enableLogging() {}
+bool FlatAtomicConfigIO::toggleReportOutput(const bool outputReports) {
+	bool previousState = m_outputReports;
+	m_outputReports = outputReports;
+	return previousState;
+}
+
+void FlatAtomicConfigIO::enableLogging() {
+	LogUser::enableLogging();
+}
+
+void FlatAtomicConfigIO::disableLogging() {
+	LogUser::disableLogging();
+}
 
-void FlatAtomicConfigIO::disableLogging() {}
+bool FlatAtomicConfigIO::toggleLazyParsing(const bool lazyParsing) {
+	bool temp = m_lazyParsing;
+	m_lazyParsing = lazyParsing;
+	return temp;
+}
+
+bool FlatAtomicConfigIO::toggleLineIndexing(const bool lineIndexing) {
+	bool temp = m_lineIndexing;
+	m_lineIndexing = lineIndexing;
+	return temp;
+}
+
+unsigned int FlatAtomicConfigIO::setReadThreads(const unsigned int nThreads) {
+	unsigned int previousValue = m_nReadThreads;
+	m_nReadThreads = nThreads;
+	return previousValue;
+}
+
+FlatAtomicConfigIO::ParsedLine::ParsedLine(void) :
+lineNumber(0), scope(), field(), value(0), partialValue(false),
+location(), include(false), includeFilename(), parseMsg(), msgs(),
+lint(false), key(), lintBuffer()
+{
+	location.offset = 0;
+	location.length = 0;
+}
+
+FlatAtomicConfigIO::ParsedLine::~ParsedLine(void) {
+	if( value != 0 ) {
+		delete value;
+		value = 0;
+	}
+}
+
+FlatAtomicConfigIO::IncludedFile::IncludedFile(void) :
+filename(), config(), includes(), msgs(), result(ERROR_SUCCESS)
+{}
+
+FlatAtomicConfigIO::ReadChunk::ReadChunk(void) :
+start(0), end(0), firstLineNumber(0), startOffset(0), lines(),
+result(ERROR_SUCCESS), tooLongLine(0)
+{}
+
+void FlatAtomicConfigIO::getIncludedFiles(std::vector<wstring>& filenames) const {
+	filenames = m_includedFiles;
+}
 
 HRESULT FlatAtomicConfigIO::read(const wstring& filename, Config& config) {
 
 	setMsgPrefix(L"FlatAtomicConfigIO reading " + filename + L" >");
 
+	bool fail = false;
+	HRESULT result = ERROR_SUCCESS;
+	m_includes.clear();
+	m_includedFiles.clear();
+	m_includingFilename.clear();
+	m_fileIncludes.clear();
+	m_includedKeys.clear();
+	unsigned int nThreads = m_nReadThreads;
+	if( nThreads == 0 ) {
+		nThreads = std::thread::hardware_concurrency();
+		if( nThreads == 0 ) {
+			nThreads = 1;
+		}
+	}
+	/* An index from an earlier read is discarded even when indexing is disabled,
+	   as it would otherwise be stamped below as an index of this file.
+	   (Set by readParallel() if indexing is enabled and the entire file is indexed)
+	 */
+	m_lineIndex.clear();
+	m_lineIndexFilename.clear();
+	if( nThreads > 1 || m_lineIndexing ) {
+		result = readParallel(filename, config, fail);
+	} else {
+		result = readSequential(filename, config, fail);
+	}
+
+	// The file could not be opened
+	if( FAILED(result) && HRESULT_CODE(result) == ERROR_FILE_NOT_FOUND ) {
+		m_includes.clear();
+		return result;
+	}
+
+	// Load included files
+	if( !m_includes.empty() ) {
+		m_includingFilename = filename;
+		m_fileIncludes = m_includes;
+		if( !FAILED(result) && !fail ) {
+			HRESULT includeResult = readIncludes(filename, config);
+			if( FAILED(includeResult) ) {
+				LOGUSER_ERROR(L"readIncludes() returned a failure code.");
+				result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+			} else if( HRESULT_CODE(includeResult) == ERROR_DATA_INCOMPLETE ) {
+				result = includeResult;
+			}
+		}
+		m_includes.clear();
+	}
+
+	// Write any parsing problems back to the file
+	if( m_msgStore.empty() && !fail ) {
+		LOGUSER_INFO(L"File parsing complete - No invalid data.");
+	} else {
+		LOGUSER_WARNING(L"File parsing complete - Problems encountered.");
+		
+		if( !fail ) {
+			if( FAILED(appendReport(filename, L"parsing report")) ) {
+				LOGUSER_ERROR(L"Problem appending parsing error messages to the file.");
+				result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+			} else {
+				LOGUSER_DEBUG(L"Parsing error messages reported without problems.");
+			}
+		}
+	}
+
+	/* The index built by this read, if any, remains valid
+	   until the file is modified (other than by update())
+	 */
+	if( !m_lineIndexFilename.empty() ) {
+		if( FAILED(fileUtil::getFileStamp(filename, m_lineIndexFileSize, m_lineIndexWriteTime)) ) {
+			LOGUSER_WARNING(L"Failed to retrieve the size and modification time of the file - Discarding the line index.");
+			m_lineIndex.clear();
+			m_lineIndexFilename.clear();
+		}
+	}
+	return result;
+}
+
+HRESULT FlatAtomicConfigIO::readSequential(const wstring& filename, Config& config, bool& fail) {
+
+	fail = false;
+
 	// Open the configuration file
 	std::ifstream file(filename, std::ifstream::in);
 	if( !file.is_open() ) {
-		logMessage(L"Unable to open the file.");
+		LOGUSER_ERROR(L"Unable to open the file.");
 		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FILE_NOT_FOUND);
 	}
 
@@ -88,7 +240,6 @@ HRESULT FlatAtomicConfigIO::read(const wstring& filename, Config& config) {
 
 	// Process each line
 	size_t lineNumber = 0;
-	bool fail = false;
 	do {
 		++lineNumber; // Line numbers start at 1
 
@@ -104,7 +255,7 @@ HRESULT FlatAtomicConfigIO::read(const wstring& filename, Config& config) {
 		*/
 		if( file.fail() && !file.eof() ) {
 			fail = true;
-			logMessage(L"File stream bad bit or fail bit was set - To be determined if this is due to line length.");
+			LOGUSER_DEBUG(L"File stream bad bit or fail bit was set - To be determined if this is due to line length.");
 			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
 		}
 		if( line[FLATATOMICCONFIGIO_MAX_LINE_LENGTH - 1] != '\0' ) {
@@ -113,7 +264,7 @@ HRESULT FlatAtomicConfigIO::read(const wstring& filename, Config& config) {
 			   so I set 'fail' to false
 			 */
 			fail = false;
-			logMessage(L"Allowed line length of " + to_wstring(FLATATOMICCONFIGIO_MAX_LINE_LENGTH) +
+			LOGUSER_WARNING(L"Allowed line length of " + to_wstring(FLATATOMICCONFIGIO_MAX_LINE_LENGTH) +
 				L" exceeded - Aborting read operation.");
 			m_msgStore.emplace_back(L"Line " + to_wstring(lineNumber) + L": Allowed line length of " +
 				to_wstring(FLATATOMICCONFIGIO_MAX_LINE_LENGTH) +
@@ -130,7 +281,7 @@ HRESULT FlatAtomicConfigIO::read(const wstring& filename, Config& config) {
 		lineResult = readDataLine(config, line, lineNumber);
 		if( FAILED(lineResult) ) {
 			// The readDataLine() function should already have logged an error to the message queue
-			logMessage(L"readDataLine() returned a failure code - Aborting read operation.");
+			LOGUSER_ERROR(L"readDataLine() returned a failure code - Aborting read operation.");
 			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
 			break;
 		} else if( HRESULT_CODE(lineResult) == ERROR_DATA_INCOMPLETE) {
@@ -139,263 +290,1527 @@ HRESULT FlatAtomicConfigIO::read(const wstring& filename, Config& config) {
 	} while( file.good() );
 
 	file.close();
+	return result;
+}
 
-	// Write any parsing problems back to the file
-	if( m_msgStore.empty() && !fail ) {
-		logMessage(L"File parsing complete - No invalid data.");
+HRESULT FlatAtomicConfigIO::readParallel(const wstring& filename, Config& config, bool& fail) {
+
+	fail = false;
+
+	// Map the configuration file into memory
+	HANDLE fileHandle = INVALID_HANDLE_VALUE;
+	HANDLE mappingHandle = NULL;
+	const char* data = 0;
+	size_t size = 0;
+	HRESULT result = fileUtil::mapFile(filename, fileHandle, mappingHandle, data, size);
+	if( FAILED(result) ) {
+		if( HRESULT_CODE(result) == ERROR_FILE_NOT_FOUND ) {
+			LOGUSER_ERROR(L"Unable to open the file.");
+		} else {
+			LOGUSER_ERROR(L"Unable to map the file into memory.");
+			fail = true;
+		}
+		return result;
+	}
+
+	// Determine the number of chunks
+	unsigned int nThreads = m_nReadThreads;
+	if( nThreads == 0 ) {
+		nThreads = std::thread::hardware_concurrency();
+		if( nThreads == 0 ) {
+			nThreads = 1;
+		}
+	}
+	size_t nChunks = static_cast<size_t>(nThreads) * FLATATOMICCONFIGIO_CHUNKS_PER_THREAD;
+	if( nChunks > (size / FLATATOMICCONFIGIO_MIN_CHUNK_SIZE) ) {
+		nChunks = (size / FLATATOMICCONFIGIO_MIN_CHUNK_SIZE) + 1;
+	}
+
+	/* Divide the file into chunks which begin at the starts of lines,
+	   and determine the line number at the start of each chunk.
+	   (Counting line separators is much faster than parsing lines,
+	    and so is done by this thread.)
+	 */
+	ReadChunk* chunks = new ReadChunk[nChunks];
+	const char* const dataEnd = data + size;
+	const char* chunkStart = data;
+	size_t lineNumber = 1; // Line numbers start at 1
+	for( size_t i = 0; i < nChunks; ++i ) {
+		const char* chunkEnd = dataEnd;
+		if( i < (nChunks - 1) ) {
+			chunkEnd = data + ((i + 1) * size) / nChunks;
+			if( chunkEnd < chunkStart ) {
+				chunkEnd = chunkStart;
+			}
+			chunkEnd = static_cast<const char*>(memchr(chunkEnd, FLATATOMICCONFIGIO_LINE_SEP, dataEnd - chunkEnd));
+			chunkEnd = (chunkEnd == 0) ? dataEnd : (chunkEnd + 1);
+		}
+		chunks[i].start = chunkStart;
+		chunks[i].end = chunkEnd;
+		chunks[i].firstLineNumber = lineNumber;
+		chunks[i].startOffset = static_cast<uint64_t>(chunkStart - data);
+		lineNumber += static_cast<size_t>(std::count(chunkStart, chunkEnd, FLATATOMICCONFIGIO_LINE_SEP));
+		chunkStart = chunkEnd;
+	}
+
+	// Parse the chunks concurrently
+	std::atomic<size_t> nextChunk(0);
+	if( nThreads > nChunks ) {
+		nThreads = static_cast<unsigned int>(nChunks);
+	}
+	std::thread* threads = new std::thread[nThreads - 1];
+	for( unsigned int i = 0; i < (nThreads - 1); ++i ) {
+		threads[i] = std::thread(&FlatAtomicConfigIO::readChunks, this, chunks, nChunks, &nextChunk);
+	}
+	readChunks(chunks, nChunks, &nextChunk); // This thread also participates
+	for( unsigned int i = 0; i < (nThreads - 1); ++i ) {
+		threads[i].join();
+	}
+	delete[] threads;
+
+	/* Merge the results in order, such that the first line in the file
+	   for a given key determines the final value for that key,
+	   and such that parsing problems are reported in order of line number.
+	 */
+	HRESULT lineResult = ERROR_SUCCESS;
+	bool stop = false;
+	for( size_t i = 0; (i < nChunks) && !stop; ++i ) {
+		std::list<ParsedLine>::iterator end = chunks[i].lines.end();
+		for( std::list<ParsedLine>::iterator line = chunks[i].lines.begin(); line != end; ++line ) {
+			if( line->value == 0 && !line->msgs.empty() ) {
+				// Messages without a value are produced only for improperly formatted data
+				result = MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+			}
+			m_msgStore.splice(m_msgStore.end(), line->msgs);
+			if( line->include ) {
+				addInclude(m_includes, *line);
+			}
+			if( line->value != 0 ) {
+				if( m_lineIndexing ) {
+					// Only the first line for each key is recorded
+					m_lineIndex.emplace(Config::Key(line->scope, line->field), line->location);
+				}
+				lineResult = insertParsedLine(config, *line, m_msgStore);
+				if( FAILED(lineResult) ) {
+					LOGUSER_ERROR(L"insertParsedLine() returned a failure code - Aborting read operation.");
+					result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+					stop = true;
+					break;
+				} else if( HRESULT_CODE(lineResult) == ERROR_DATA_INCOMPLETE ) {
+					result = lineResult;
+				}
+			}
+		}
+		if( stop ) {
+			break;
+		}
+
+		if( FAILED(chunks[i].result) ) {
+			// parseDataLine() should already have logged an error to the message queue
+			LOGUSER_ERROR(L"parseDataLine() returned a failure code - Aborting read operation.");
+			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+			stop = true;
+		} else if( chunks[i].tooLongLine != 0 ) {
+			LOGUSER_WARNING(L"Allowed line length of " + to_wstring(FLATATOMICCONFIGIO_MAX_LINE_LENGTH) +
+				L" exceeded - Aborting read operation.");
+			m_msgStore.emplace_back(L"Line " + to_wstring(chunks[i].tooLongLine) + L": Allowed line length of " +
+				to_wstring(FLATATOMICCONFIGIO_MAX_LINE_LENGTH) +
+				L" exceeded - Aborting read operation.");
+			result = MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+			stop = true;
+		}
+	}
+
+	// The index is incomplete if parsing stopped early
+	if( m_lineIndexing ) {
+		if( stop ) {
+			m_lineIndex.clear();
+		} else {
+			m_lineIndexFilename = filename;
+		}
+	}
+
+	delete[] chunks;
+	if( FAILED(fileUtil::unmapFile(fileHandle, mappingHandle, data)) ) {
+		LOGUSER_ERROR(L"Failed to unmap the file from memory.");
+	}
+	return result;
+}
+
+void FlatAtomicConfigIO::readChunks(ReadChunk* const chunks, const size_t nChunks,
+	std::atomic<size_t>* const nextChunk) const {
+
+	// Set up a line buffer
+	char line[FLATATOMICCONFIGIO_LINE_BUFFER_LENGTH] = { '\0' };
+
+	for( size_t i = (*nextChunk)++; i < nChunks; i = (*nextChunk)++ ) {
+		ReadChunk& chunk = chunks[i];
+		const char* lineStart = chunk.start;
+		size_t lineNumber = chunk.firstLineNumber;
+
+		while( lineStart < chunk.end ) {
+			const char* lineEnd = static_cast<const char*>(memchr(
+				lineStart, FLATATOMICCONFIGIO_LINE_SEP, chunk.end - lineStart));
+			const char* nextLineStart = (lineEnd == 0) ? chunk.end : (lineEnd + 1);
+			if( lineEnd == 0 ) {
+				lineEnd = chunk.end;
+			}
+
+			/* The file is not opened in text mode,
+			   so Windows line endings must be handled here.
+			 */
+			size_t length = static_cast<size_t>(lineEnd - lineStart);
+			if( length > 0 && lineStart[length - 1] == '\r' ) {
+				--length;
+			}
+
+			// Matches the line length check in readSequential()
+			if( length >= (FLATATOMICCONFIGIO_MAX_LINE_LENGTH) ) {
+				chunk.tooLongLine = lineNumber;
+				break;
+			}
+
+			if( length > 0 ) {
+				memcpy(line, lineStart, length);
+				line[length] = '\0';
+
+				chunk.lines.emplace_back();
+				ParsedLine& parsedLine = chunk.lines.back();
+				parsedLine.lineNumber = lineNumber;
+				parsedLine.location.offset = chunk.startOffset + static_cast<uint64_t>(lineStart - chunk.start);
+				parsedLine.location.length = length;
+				chunk.result = parseDataLine(line, parsedLine);
+				if( FAILED(chunk.result) ) {
+					break;
+				} else if( parsedLine.value == 0 && parsedLine.msgs.empty() && !parsedLine.include ) {
+					// Blank or comment line
+					chunk.lines.pop_back();
+				}
+			}
+
+			lineStart = nextLineStart;
+			++lineNumber;
+		}
+	}
+}
+
+HRESULT FlatAtomicConfigIO::lint(const std::vector<wstring>& filenames, LintSink& sink,
+	std::vector<HRESULT>* const results) const {
+
+	const size_t nFiles = filenames.size();
+	std::vector<HRESULT> fileResults(nFiles, ERROR_SUCCESS);
+
+	if( nFiles > 0 ) {
+		unsigned int nThreads = m_nReadThreads;
+		if( nThreads == 0 ) {
+			nThreads = std::thread::hardware_concurrency();
+			if( nThreads == 0 ) {
+				nThreads = 1;
+			}
+		}
+		if( nThreads > nFiles ) {
+			nThreads = static_cast<unsigned int>(nFiles);
+		}
+
+		std::mutex sinkMutex;
+		std::atomic<size_t> nextFile(0);
+		std::thread* threads = new std::thread[nThreads - 1];
+		for( unsigned int i = 0; i < (nThreads - 1); ++i ) {
+			threads[i] = std::thread(&FlatAtomicConfigIO::lintFiles, this, &filenames[0], &fileResults[0],
+				nFiles, &nextFile, &sink, &sinkMutex);
+		}
+		lintFiles(&filenames[0], &fileResults[0], nFiles, &nextFile, &sink, &sinkMutex); // This thread also participates
+		for( unsigned int i = 0; i < (nThreads - 1); ++i ) {
+			threads[i].join();
+		}
+		delete[] threads;
+	}
+
+	HRESULT result = ERROR_SUCCESS;
+	for( size_t i = 0; i < nFiles; ++i ) {
+		if( FAILED(fileResults[i]) ) {
+			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+		} else if( fileResults[i] != ERROR_SUCCESS && SUCCEEDED(result) ) {
+			result = MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+	}
+
+	if( results != 0 ) {
+		results->swap(fileResults);
+	}
+	return result;
+}
+
+void FlatAtomicConfigIO::lintFiles(const wstring* const filenames, HRESULT* const results,
+	const size_t nFiles, std::atomic<size_t>* const nextFile,
+	LintSink* const sink, std::mutex* const sinkMutex) const {
+
+	for( size_t i = (*nextFile)++; i < nFiles; i = (*nextFile)++ ) {
+		results[i] = lintFile(filenames[i], *sink, *sinkMutex);
+	}
+}
+
+HRESULT FlatAtomicConfigIO::lintFile(const wstring& filename, LintSink& sink,
+	std::mutex& sinkMutex) const {
+
+	HANDLE fileHandle = INVALID_HANDLE_VALUE;
+	HANDLE mappingHandle = NULL;
+	const char* data = 0;
+	size_t size = 0;
+	HRESULT result = fileUtil::mapFile(filename, fileHandle, mappingHandle, data, size);
+	if( FAILED(result) ) {
+		std::lock_guard<std::mutex> lock(sinkMutex);
+		sink.report(filename, 0, L"Unable to open the file.");
+		return result;
+	}
+
+	// Keys found so far, to detect repeated keys
+	std::unordered_set<string> keys;
+
+	char line[FLATATOMICCONFIGIO_LINE_BUFFER_LENGTH] = { '\0' };
+	ParsedLine parsedLine;
+	parsedLine.lint = true;
+	HRESULT lineResult = ERROR_SUCCESS;
+	const char* lineStart = data;
+	const char* const dataEnd = data + size;
+	size_t lineNumber = 1; // Line numbers start at 1
+
+	while( lineStart < dataEnd ) {
+		const char* lineEnd = static_cast<const char*>(memchr(
+			lineStart, FLATATOMICCONFIGIO_LINE_SEP, dataEnd - lineStart));
+		const char* nextLineStart = (lineEnd == 0) ? dataEnd : (lineEnd + 1);
+		if( lineEnd == 0 ) {
+			lineEnd = dataEnd;
+		}
+
+		// As in readChunks()
+		size_t length = static_cast<size_t>(lineEnd - lineStart);
+		if( length > 0 && lineStart[length - 1] == '\r' ) {
+			--length;
+		}
+
+		if( length >= (FLATATOMICCONFIGIO_MAX_LINE_LENGTH) ) {
+			std::lock_guard<std::mutex> lock(sinkMutex);
+			sink.report(filename, lineNumber, L"Line " + to_wstring(lineNumber) + L": Allowed line length of " +
+				to_wstring(FLATATOMICCONFIGIO_MAX_LINE_LENGTH) +
+				L" exceeded - Aborting lint operation.");
+			result = MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+			break;
+		}
+
+		if( length > 0 ) {
+			memcpy(line, lineStart, length);
+			line[length] = '\0';
+
+			parsedLine.lineNumber = lineNumber;
+			parsedLine.partialValue = false;
+			parsedLine.include = false;
+			parsedLine.key.clear();
+			parsedLine.parseMsg.clear();
+			parsedLine.msgs.clear();
+			lineResult = parseDataLine(line, parsedLine);
+
+			// Checks otherwise made by insertParsedLine()
+			if( lineResult == ERROR_SUCCESS && !parsedLine.key.empty() ) {
+				if( !parsedLine.parseMsg.empty() ) {
+					parsedLine.msgs.emplace_back(L"Line " + to_wstring(lineNumber) +
+						L": the function for parsing the data value reported \"" + parsedLine.parseMsg + L"\"");
+				}
+				if( !keys.insert(parsedLine.key).second ) {
+					parsedLine.msgs.emplace_back(L"Line " + to_wstring(lineNumber) +
+						L": this key was repeated in the file.");
+					lineResult = MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+				} else if( parsedLine.partialValue ) {
+					parsedLine.msgs.emplace_back(L"Line " + to_wstring(lineNumber) +
+						L": the function for parsing the data value section of the line did not convert the entire rest of the line into a data value.");
+					lineResult = MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+				}
+			}
+
+			if( !parsedLine.msgs.empty() ) {
+				std::lock_guard<std::mutex> lock(sinkMutex);
+				std::list<wstring>::const_iterator end = parsedLine.msgs.cend();
+				for( std::list<wstring>::const_iterator it = parsedLine.msgs.cbegin(); it != end; ++it ) {
+					sink.report(filename, lineNumber, *it);
+				}
+			}
+
+			if( FAILED(lineResult) ) {
+				result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+				break;
+			} else if( HRESULT_CODE(lineResult) == ERROR_DATA_INCOMPLETE ) {
+				result = lineResult;
+			}
+		}
+
+		lineStart = nextLineStart;
+		++lineNumber;
+	}
+
+	fileUtil::unmapFile(fileHandle, mappingHandle, data);
+	return result;
+}
+
+HRESULT FlatAtomicConfigIO::beginParse(Config& config) {
+	if( m_parseConfig != 0 ) {
+		LOGUSER_ERROR(L"beginParse() called while a parsing operation is already in progress.");
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WRONG_STATE);
+	}
+
+	setMsgPrefix(L"FlatAtomicConfigIO parsing >");
+	m_includes.clear();
+	m_parseConfig = &config;
+	m_parseLength = 0;
+	m_parseLineNumber = 1; // Line numbers start at 1
+	m_parseResult = ERROR_SUCCESS;
+	m_parseStopped = false;
+	return ERROR_SUCCESS;
+}
+
+HRESULT FlatAtomicConfigIO::parse(const char* const data, const size_t length) {
+	if( m_parseConfig == 0 ) {
+		LOGUSER_ERROR(L"parse() called without a prior call to beginParse().");
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WRONG_STATE);
+	} else if( data == 0 && length > 0 ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NULL_INPUT);
+	}
+
+	const char* current = data;
+	const char* const end = data + length;
+	while( current < end && !m_parseStopped ) {
+		const char* lineEnd = static_cast<const char*>(memchr(
+			current, FLATATOMICCONFIGIO_LINE_SEP, end - current));
+		const char* segmentEnd = (lineEnd == 0) ? end : lineEnd;
+		size_t segmentLength = static_cast<size_t>(segmentEnd - current);
+
+		/* Leave room for a carriage return (which may be part of a Windows line ending)
+		   and for the null terminator. Anything longer is too long to be a valid line.
+		 */
+		if( m_parseLength + segmentLength > (FLATATOMICCONFIGIO_LINE_BUFFER_LENGTH - 1) ) {
+			m_parseLength = FLATATOMICCONFIGIO_LINE_BUFFER_LENGTH - 1;
+			parseStoredLine();
+			break;
+		}
+		memcpy(m_parseLine + m_parseLength, current, segmentLength);
+		m_parseLength += segmentLength;
+
+		if( lineEnd == 0 ) {
+			// The rest of the line will arrive in a later block of data
+			break;
+		}
+		parseStoredLine();
+		current = lineEnd + 1;
+	}
+	return m_parseResult;
+}
+
+HRESULT FlatAtomicConfigIO::endParse(void) {
+	if( m_parseConfig == 0 ) {
+		LOGUSER_ERROR(L"endParse() called without a prior call to beginParse().");
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WRONG_STATE);
+	}
+
+	// The data may not have ended with a line separator
+	if( !m_parseStopped && m_parseLength > 0 ) {
+		parseStoredLine();
+	}
+
+	// There is no file relative to which included files could be located
+	std::list<Include>::const_iterator includeEnd = m_includes.cend();
+	for( std::list<Include>::const_iterator it = m_includes.cbegin(); it != includeEnd; ++it ) {
+		m_msgStore.emplace_back(L"Line " + to_wstring(it->lineNumber) +
+			L": include directives are only supported when reading files - Ignored.");
+		if( SUCCEEDED(m_parseResult) ) {
+			m_parseResult = MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+	}
+	m_includes.clear();
+
+	HRESULT result = m_parseResult;
+	if( m_msgStore.empty() ) {
+		LOGUSER_INFO(L"Parsing complete - No invalid data.");
 	} else {
-		logMessage(L"File parsing complete - Problems encountered.");
-		
-		if( !fail ) {
-			wstring time;
-			if( FAILED(Logger::getDateAndTime(time)) ) {
-				time = L"Failed to get time ";
+		LOGUSER_WARNING(L"Parsing complete - Problems encountered:");
+		if( FAILED(logMsgStore(LOG_LEVEL_WARNING)) ) {
+			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+		}
+	}
+
+	m_parseConfig = 0;
+	m_parseLength = 0;
+	return result;
+}
+
+void FlatAtomicConfigIO::parseStoredLine(void) {
+
+	// Windows line endings
+	if( m_parseLength > 0 && m_parseLine[m_parseLength - 1] == '\r' ) {
+		--m_parseLength;
+	}
+
+	// Matches the line length check in readSequential()
+	if( m_parseLength >= FLATATOMICCONFIGIO_MAX_LINE_LENGTH ) {
+		LOGUSER_WARNING(L"Allowed line length of " + to_wstring(FLATATOMICCONFIGIO_MAX_LINE_LENGTH) +
+			L" exceeded - Aborting parsing operation.");
+		m_msgStore.emplace_back(L"Line " + to_wstring(m_parseLineNumber) + L": Allowed line length of " +
+			to_wstring(FLATATOMICCONFIGIO_MAX_LINE_LENGTH) +
+			L" exceeded - Aborting parsing operation.");
+		m_parseResult = MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		m_parseStopped = true;
+		return;
+	}
+
+	m_parseLine[m_parseLength] = '\0';
+	HRESULT lineResult = readDataLine(*m_parseConfig, m_parseLine, m_parseLineNumber);
+	if( FAILED(lineResult) ) {
+		// The readDataLine() function should already have logged an error to the message queue
+		LOGUSER_ERROR(L"readDataLine() returned a failure code - Aborting parsing operation.");
+		m_parseResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+		m_parseStopped = true;
+	} else if( HRESULT_CODE(lineResult) == ERROR_DATA_INCOMPLETE ) {
+		m_parseResult = lineResult;
+	}
+
+	m_parseLength = 0;
+	++m_parseLineNumber;
+}
+
+HRESULT FlatAtomicConfigIO::readStream(std::istream& stream, Config& config) {
+	HRESULT result = beginParse(config);
+	if( FAILED(result) ) {
+		return result;
+	}
+
+	char buffer[FLATATOMICCONFIGIO_STREAM_BUFFER_LENGTH];
+	bool fail = false;
+	do {
+		stream.read(buffer, FLATATOMICCONFIGIO_STREAM_BUFFER_LENGTH);
+		if( stream.bad() ) {
+			LOGUSER_ERROR(L"Stream bad bit was set - Aborting parsing operation.");
+			fail = true;
+			break;
+		}
+		parse(buffer, static_cast<size_t>(stream.gcount()));
+	} while( stream.good() && !m_parseStopped );
+
+	result = endParse();
+	if( fail ) {
+		result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	return result;
+}
+
+HRESULT FlatAtomicConfigIO::readHandle(HANDLE handle, Config& config) {
+	if( handle == 0 || handle == INVALID_HANDLE_VALUE ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_INPUT);
+	}
+	HRESULT result = beginParse(config);
+	if( FAILED(result) ) {
+		return result;
+	}
+
+	char buffer[FLATATOMICCONFIGIO_STREAM_BUFFER_LENGTH];
+	DWORD nBytesRead = 0;
+	bool fail = false;
+	do {
+		if( !ReadFile(handle, buffer, FLATATOMICCONFIGIO_STREAM_BUFFER_LENGTH, &nBytesRead, NULL) ) {
+			// The write end of a pipe was closed
+			if( GetLastError() != ERROR_BROKEN_PIPE ) {
+				LOGUSER_ERROR(L"ReadFile() failed - Aborting parsing operation.");
+				fail = true;
 			}
-			m_msgStore.emplace_front(L"<<-- FlatAtomicConfigIO instance parsing report ( "+time+L") begins --");
-			m_msgStore.emplace_back(L"-- FlatAtomicConfigIO instance parsing report ends -->>");
+			break;
+		}
+		parse(buffer, static_cast<size_t>(nBytesRead));
+	} while( nBytesRead > 0 && !m_parseStopped );
+
+	result = endParse();
+	if( fail ) {
+		result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WINDOWS_CALL);
+	}
+	return result;
+}
+
+HRESULT FlatAtomicConfigIO::readBuffer(const char* const buffer, const size_t length, Config& config) {
+	if( buffer == 0 && length > 0 ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NULL_INPUT);
+	}
+	HRESULT result = beginParse(config);
+	if( FAILED(result) ) {
+		return result;
+	}
+	parse(buffer, length);
+	return endParse();
+}
+
+HRESULT FlatAtomicConfigIO::write(const wstring& filename, const Config& config, const bool overwrite) {
+	return writeFile(filename, config, overwrite, 0, 0);
+}
+
+HRESULT FlatAtomicConfigIO::writeFile(const wstring& filename, const Config& config, const bool overwrite,
+	const std::list<Include>* const includes, const std::set<Config::Key>* const excludedKeys) {
+
+	setMsgPrefix(L"FlatAtomicConfigIO writing to " + filename + L" >");
+
+	// Initialization of the data stream
+	std::map<Config::Key, Config::Value*>::const_iterator currentPair = config.cbegin();
+	std::map<Config::Key, Config::Value*>::const_iterator end = config.cend();
+	if( currentPair == end && (includes == 0 || includes->empty()) ) {
+		LOGUSER_WARNING(L"Config object is empty - Nothing to write.");
+		return ERROR_SUCCESS;
+	}
+
+	/* Open the output file
+	   Output is encoded as UTF-8 by this object, so a narrow character
+	   stream is used (in text mode, as before, for consistent line endings).
+	 */
+	std::ofstream file;
+	if( overwrite ) {
+		file.open(filename, std::ofstream::out);
+	} else {
+		file.open(filename, std::ofstream::app);
+	}
+	if( !file.is_open() ) {
+		LOGUSER_ERROR(L"Unable to open the file.");
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FILE_NOT_FOUND);
+	}
+
+	/* Lines are formatted into 'line', and then encoded into 'buffer',
+	   which is written to the file when it becomes full.
+	   Both strings are reused for all lines, to avoid repeated allocation.
+	 */
+	wstring line;
+	line.reserve(FLATATOMICCONFIGIO_LINE_BUFFER_LENGTH);
+	std::string buffer;
+	buffer.reserve(FLATATOMICCONFIGIO_WRITE_BUFFER_LENGTH + FLATATOMICCONFIGIO_LINE_BUFFER_LENGTH * 4);
+
+	// Begin output
+	wstring time;
+	if( FAILED(Logger::getDateAndTime(time)) ) {
+		time = L"Failed to get time ";
+	}
+	line = FLATATOMICCONFIGIO_COMMENT_SEP_WSTR L" " FLATATOMICCONFIGIO_START_OUTPUT
+		L" FlatAtomicConfigIO instance Config output ( ";
+	line += time;
+	line += L")" FLATATOMICCONFIGIO_LINE_SEP_WSTR;
+	textProcessing::appendUTF8(buffer, line.c_str(), line.length());
+
+	// Include directives precede the data, although their position does not affect precedence
+	if( includes != 0 ) {
+		std::list<Include>::const_iterator includeEnd = includes->cend();
+		for( std::list<Include>::const_iterator it = includes->cbegin(); it != includeEnd; ++it ) {
+			line = FLATATOMICCONFIGIO_INCLUDE_WSTR FLATATOMICCONFIGIO_SEP_1_WSTR;
+			line += it->scopePrefix;
+			line += FLATATOMICCONFIGIO_SEP_2_WSTR L"\"";
+			line += it->filename;
+			line += L"\"" FLATATOMICCONFIGIO_LINE_SEP_WSTR;
+			textProcessing::appendUTF8(buffer, line.c_str(), line.length());
+		}
+	}
+
+	// Initialization of loop variables
+	HRESULT result = ERROR_SUCCESS;
+	HRESULT lineResult = ERROR_SUCCESS;
+	// Used to remember whether the operation ended due to a problem with the file output stream
+	bool notGood = false;
 
-			/* Get an "empty" Logger for easy output to the file,
-			   such that this object has complete control over the
-			   Logger's timestamping behaviour.
+	// Process each key-value pair in the Config object
+	while( currentPair != end ) {
+		if( excludedKeys != 0 && excludedKeys->find(currentPair->first) != excludedKeys->end() ) {
+			++currentPair;
+			continue;
+		}
+		lineResult = writeDataLine(line, currentPair);
+		if( FAILED(lineResult) ) {
+			/* A severe error.
+			The writeDataLine() function should already have logged an error to the message queue
 			*/
-			if( FAILED(setLogger(false, L"", false, false)) ) {
-				logMessage(L"Error getting a Logger to output parsing report to the file.");
+			LOGUSER_ERROR(L"writeDataLine() returned a failure code - Aborting write operation.");
+			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+			break;
+		} else if( HRESULT_CODE(lineResult) == ERROR_DATA_INCOMPLETE ) {
+			/* A non-severe error.
+			In this case, the line writing function has encountered
+			unsupported or invalid data, and will have put an error
+			message in the queue.
+			*/
+			result = lineResult;
+		} else {
+			// Buffer valid data for output to the file
+			textProcessing::appendUTF8(buffer, line.c_str(), line.length());
+			buffer += FLATATOMICCONFIGIO_LINE_SEP;
+		}
+		++currentPair;
+
+		if( buffer.length() >= FLATATOMICCONFIGIO_WRITE_BUFFER_LENGTH ) {
+			file.write(buffer.c_str(), buffer.length());
+			buffer.clear();
+			if( !file.good() ) {
+				notGood = true;
+				LOGUSER_ERROR(L"File stream good() function returned false - Aborting write operation.");
+				result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+				break;
+			}
+		}
+	}
+
+	if( !notGood ) {
+		// Write the configuration format to the file for reference
+		if( m_outputContext ) {
+			buffer += FLATATOMICCONFIGIO_LINE_SEP;
+			line = FLATATOMICCONFIGIO_DATA_FORMATSPEC;
+			textProcessing::appendUTF8(buffer, line.c_str(), line.length());
+			buffer += FLATATOMICCONFIGIO_LINE_SEP;
+		}
+
+		// End the output
+		line = FLATATOMICCONFIGIO_COMMENT_SEP_WSTR L" " FLATATOMICCONFIGIO_END_OUTPUT
+			L" FlatAtomicConfigIO instance Config output ( ";
+		line += time;
+		line += L")";
+		textProcessing::appendUTF8(buffer, line.c_str(), line.length());
+
+		file.write(buffer.c_str(), buffer.length());
+		if( !file.good() ) {
+			notGood = true;
+			LOGUSER_ERROR(L"File stream good() function returned false when ending the configuration output.");
+			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+		}
+	}
+
+	file.close();
+
+	// Write any serialization problems back to the file
+	if( m_msgStore.empty() && !notGood ) {
+		LOGUSER_INFO(L"Config object writing complete - No invalid or unsupported data.");
+	} else {
+		LOGUSER_WARNING(L"Config object writing complete - Problems encountered.");
+
+		if( !notGood ) {
+			if( FAILED(appendReport(filename, L"Config writing report")) ) {
+				LOGUSER_ERROR(L"Problem appending Config writing error messages to the file.");
 				result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
 			} else {
-				toggleTimestamp(false); // Lines need to start with the comment symbol, not a timestamp
-
-				// First insert a blank line
-				setMsgPrefix(L"");
-				HRESULT tempResult = logMessage(FLATATOMICCONFIGIO_LINE_SEP_WSTR, false, true, filename);
-				if( SUCCEEDED(tempResult) ) {
-					// Now log the parsing report
-					setMsgPrefix(FLATATOMICCONFIGIO_COMMENT_SEP_WSTR);
-					tempResult = logMsgStore(true, false, true, filename);
+				LOGUSER_DEBUG(L"Config writing error messages reported without problems.");
+			}
+		}
+	}
+	return result;
+}
+
+HRESULT FlatAtomicConfigIO::appendReport(const wstring& filename, const wstring& title) {
+
+	if( !m_outputReports ) {
+		LOGUSER_WARNING(L"Report output is disabled - Logging the " + title + L" instead:");
+		return logMsgStore(LOG_LEVEL_WARNING, true);
+	}
+
+	wstring time;
+	if( FAILED(Logger::getDateAndTime(time)) ) {
+		time = L"Failed to get time ";
+	}
+	const wstring header = L" <<-- FlatAtomicConfigIO instance " + title + L" ( " + time + L") begins --";
+	const wstring footer = L" -- FlatAtomicConfigIO instance " + title + L" ends -->>";
+	const size_t commentSepLength = wcslen(FLATATOMICCONFIGIO_COMMENT_SEP_WSTR);
+
+	// Determine the size of the report, to avoid reallocation
+	size_t length = 2 + (commentSepLength + 1) * 2 + header.length() + footer.length();
+	std::list<wstring>::const_iterator end = m_msgStore.cend();
+	for( std::list<wstring>::const_iterator it = m_msgStore.cbegin(); it != end; ++it ) {
+		length += commentSepLength + it->length() + 2;
+	}
+
+	/* Format the report, separated from the preceding
+	   contents of the file by a blank line
+	 */
+	wstring report;
+	report.reserve(length);
+	report += FLATATOMICCONFIGIO_LINE_SEP_WSTR FLATATOMICCONFIGIO_LINE_SEP_WSTR;
+	report += FLATATOMICCONFIGIO_COMMENT_SEP_WSTR;
+	report += header;
+	report += FLATATOMICCONFIGIO_LINE_SEP_WSTR;
+	for( std::list<wstring>::const_iterator it = m_msgStore.cbegin(); it != end; ++it ) {
+		report += FLATATOMICCONFIGIO_COMMENT_SEP_WSTR L" ";
+		report += *it;
+		report += FLATATOMICCONFIGIO_LINE_SEP_WSTR;
+	}
+	report += FLATATOMICCONFIGIO_COMMENT_SEP_WSTR;
+	report += footer;
+	report += FLATATOMICCONFIGIO_LINE_SEP_WSTR;
+	m_msgStore.clear();
+
+	// Output the report
+	std::basic_ofstream<wchar_t> file(filename, std::ofstream::app);
+	if( !file.is_open() ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FILE_NOT_FOUND);
+	}
+	file.write(report.c_str(), report.length());
+	bool good = file.good();
+	file.close();
+	if( !good ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	return ERROR_SUCCESS;
+}
+
+HRESULT FlatAtomicConfigIO::readIncludes(const wstring& filename, Config& config) {
+
+	HRESULT result = ERROR_SUCCESS;
+
+	/* The file which was originally read is at index zero.
+	   Its data is already in the Config object.
+	 */
+	std::vector<IncludedFile*> files;
+	files.push_back(new IncludedFile);
+	if( FAILED(fileUtil::fullPath(files[0]->filename, filename)) ) {
+		files[0]->filename = filename;
+	}
+	files[0]->includes.swap(m_includes);
+
+	// Indices of files in the 'files' list, by full path, in lowercase
+	std::map<wstring, size_t> fileIndices;
+	wstring fileKey = files[0]->filename;
+	std::transform(fileKey.begin(), fileKey.end(), fileKey.begin(), towlower);
+	fileIndices[fileKey] = 0;
+
+	// Indicates an include directive whose file could not be located
+	const size_t noTarget = static_cast<size_t>(-1);
+
+	unsigned int nThreads = m_nReadThreads;
+	if( nThreads < 2 ) {
+		nThreads = std::thread::hardware_concurrency();
+		if( nThreads == 0 ) {
+			nThreads = 1;
+		}
+	}
+
+	// Load the files in waves, starting with the files included by the original file
+	size_t waveStart = 0;
+	size_t waveEnd = 1;
+	wstring directory;
+	wstring includedFilename;
+	while( waveStart < waveEnd ) {
+
+		// Identify the files included by the files in the current wave
+		for( size_t i = waveStart; i < waveEnd; ++i ) {
+			if( FAILED(fileUtil::extractPath(directory, files[i]->filename)) ) {
+				directory.clear();
+			}
+			std::list<Include>::iterator end = files[i]->includes.end();
+			for( std::list<Include>::iterator it = files[i]->includes.begin(); it != end; ++it ) {
+				if( FAILED(fileUtil::fullPath(includedFilename, it->filename, directory)) ) {
+					files[i]->msgs.emplace_back(L"Line " + to_wstring(it->lineNumber) +
+						L": unable to locate the included file " + it->filename + L" - Ignored.");
+					it->target = noTarget;
+					continue;
 				}
-				setMsgPrefix(L"FlatAtomicConfigIO reading " + filename + L" >");
-				revertLogger();
+				fileKey = includedFilename;
+				std::transform(fileKey.begin(), fileKey.end(), fileKey.begin(), towlower);
+				std::map<wstring, size_t>::const_iterator index = fileIndices.find(fileKey);
+				if( index == fileIndices.cend() ) {
+					it->target = files.size();
+					fileIndices[fileKey] = it->target;
+					files.push_back(new IncludedFile);
+					files.back()->filename = includedFilename;
+				} else {
+					it->target = index->second;
+				}
+			}
+		}
+
+		// Load the newly-identified files concurrently
+		const size_t nFiles = files.size() - waveEnd;
+		if( nFiles > 0 ) {
+			std::atomic<size_t> nextFile(0);
+			unsigned int nWaveThreads = nThreads;
+			if( nWaveThreads > nFiles ) {
+				nWaveThreads = static_cast<unsigned int>(nFiles);
+			}
+			std::thread* threads = new std::thread[nWaveThreads - 1];
+			for( unsigned int i = 0; i < (nWaveThreads - 1); ++i ) {
+				threads[i] = std::thread(&FlatAtomicConfigIO::readIncludedFiles, this, &files[waveEnd], nFiles, &nextFile);
+			}
+			readIncludedFiles(&files[waveEnd], nFiles, &nextFile); // This thread also participates
+			for( unsigned int i = 0; i < (nWaveThreads - 1); ++i ) {
+				threads[i].join();
+			}
+			delete[] threads;
+		}
+
+		waveStart = waveEnd;
+		waveEnd = files.size();
+	}
+
+	// Report problems, in the order in which the files were identified
+	m_msgStore.splice(m_msgStore.end(), files[0]->msgs);
+	for( size_t i = 1; i < files.size(); ++i ) {
+		m_includedFiles.push_back(files[i]->filename);
+		std::list<wstring>::const_iterator end = files[i]->msgs.cend();
+		for( std::list<wstring>::const_iterator it = files[i]->msgs.cbegin(); it != end; ++it ) {
+			m_msgStore.emplace_back(L"Included file " + files[i]->filename + L", " + *it);
+		}
+		if( FAILED(files[i]->result) ) {
+			LOGUSER_ERROR(L"Failed to read the included file " + files[i]->filename + L".");
+			result = MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		} else if( HRESULT_CODE(files[i]->result) == ERROR_DATA_INCOMPLETE ) {
+			result = files[i]->result;
+		}
+	}
+
+	// Keys already present (not loaded from included files)
+	std::set<Config::Key> ownKeys;
+	std::map<Config::Key, Config::Value*>::const_iterator configEnd = config.cend();
+	for( std::map<Config::Key, Config::Value*>::const_iterator it = config.cbegin(); it != configEnd; ++it ) {
+		ownKeys.insert(ownKeys.end(), it->first);
+	}
+
+	// Insert the data in order of precedence
+	std::vector<bool> onPath(files.size(), false);
+	onPath[0] = true;
+	HRESULT mergeResult = mergeIncludes(config, files, 0, L"", onPath);
+
+	// Record the keys which were loaded from included files (see update())
+	configEnd = config.cend();
+	for( std::map<Config::Key, Config::Value*>::const_iterator it = config.cbegin(); it != configEnd; ++it ) {
+		if( ownKeys.find(it->first) == ownKeys.end() ) {
+			m_includedKeys.insert(m_includedKeys.end(), it->first);
+		}
+	}
+	if( FAILED(mergeResult) ) {
+		result = mergeResult;
+	} else if( HRESULT_CODE(mergeResult) == ERROR_DATA_INCOMPLETE && SUCCEEDED(result) ) {
+		result = mergeResult;
+	}
+
+	for( size_t i = 0; i < files.size(); ++i ) {
+		delete files[i];
+		files[i] = 0;
+	}
+	return result;
+}
+
+void FlatAtomicConfigIO::readIncludedFiles(IncludedFile** const files, const size_t nFiles,
+	std::atomic<size_t>* const nextFile) const {
+
+	for( size_t i = (*nextFile)++; i < nFiles; i = (*nextFile)++ ) {
+		readIncludedFile(*(files[i]));
+	}
+}
+
+void FlatAtomicConfigIO::readIncludedFile(IncludedFile& file) const {
+
+	HANDLE fileHandle = INVALID_HANDLE_VALUE;
+	HANDLE mappingHandle = NULL;
+	const char* data = 0;
+	size_t size = 0;
+	file.result = fileUtil::mapFile(file.filename, fileHandle, mappingHandle, data, size);
+	if( FAILED(file.result) ) {
+		file.msgs.emplace_back(L"unable to open or map the file into memory.");
+		return;
+	}
+
+	// The whole file is parsed as a single chunk, by this thread
+	ReadChunk chunk;
+	chunk.start = data;
+	chunk.end = data + size;
+	chunk.firstLineNumber = 1; // Line numbers start at 1
+	std::atomic<size_t> nextChunk(0);
+	readChunks(&chunk, 1, &nextChunk);
+
+	HRESULT lineResult = ERROR_SUCCESS;
+	std::list<ParsedLine>::iterator end = chunk.lines.end();
+	for( std::list<ParsedLine>::iterator line = chunk.lines.begin(); line != end; ++line ) {
+		if( line->value == 0 && !line->msgs.empty() ) {
+			file.result = MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+		file.msgs.splice(file.msgs.end(), line->msgs);
+		if( line->include ) {
+			addInclude(file.includes, *line);
+		}
+		if( line->value != 0 ) {
+			lineResult = insertParsedLine(file.config, *line, file.msgs);
+			if( FAILED(lineResult) ) {
+				file.result = lineResult;
+				break;
+			} else if( HRESULT_CODE(lineResult) == ERROR_DATA_INCOMPLETE ) {
+				file.result = lineResult;
+			}
+		}
+	}
+
+	if( SUCCEEDED(file.result) ) {
+		if( FAILED(chunk.result) ) {
+			file.result = chunk.result;
+		} else if( chunk.tooLongLine != 0 ) {
+			file.msgs.emplace_back(L"Line " + to_wstring(chunk.tooLongLine) + L": Allowed line length of " +
+				to_wstring(FLATATOMICCONFIGIO_MAX_LINE_LENGTH) +
+				L" exceeded - Aborting read operation.");
+			file.result = MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+	}
+
+	fileUtil::unmapFile(fileHandle, mappingHandle, data);
+}
+
+HRESULT FlatAtomicConfigIO::listIncludedFiles(const wstring& filename,
+	std::vector<wstring>& filenames) const {
+
+	filenames.clear();
+
+	// The file passed in is at index zero, followed by the included files in the order read() loads them
+	std::vector<wstring> files(1);
+	if( FAILED(fileUtil::fullPath(files[0], filename)) ) {
+		files[0] = filename;
+	}
+
+	// Full paths of the files in the 'files' list, in lowercase
+	std::set<wstring> fileKeys;
+	wstring fileKey = files[0];
+	std::transform(fileKey.begin(), fileKey.end(), fileKey.begin(), towlower);
+	fileKeys.insert(fileKey);
+
+	std::list<wstring> includes;
+	wstring directory;
+	wstring includedFilename;
+	for( std::vector<wstring>::size_type i = 0; i < files.size(); ++i ) {
+		includes.clear();
+		HRESULT result = scanIncludes(files[i], includes);
+		if( FAILED(result) ) {
+			if( i == 0 ) {
+				return result;
+			}
+			continue;
+		}
+		if( FAILED(fileUtil::extractPath(directory, files[i])) ) {
+			directory.clear();
+		}
+		std::list<wstring>::const_iterator end = includes.cend();
+		for( std::list<wstring>::const_iterator it = includes.cbegin(); it != end; ++it ) {
+			if( FAILED(fileUtil::fullPath(includedFilename, *it, directory)) ) {
+				continue;
+			}
+			fileKey = includedFilename;
+			std::transform(fileKey.begin(), fileKey.end(), fileKey.begin(), towlower);
+			if( fileKeys.insert(fileKey).second ) {
+				files.push_back(includedFilename);
+			}
+		}
+	}
+
+	filenames.assign(files.begin() + 1, files.end());
+	return ERROR_SUCCESS;
+}
+
+HRESULT FlatAtomicConfigIO::scanIncludes(const wstring& filename, std::list<wstring>& includes) const {
+
+	HANDLE fileHandle = INVALID_HANDLE_VALUE;
+	HANDLE mappingHandle = NULL;
+	const char* data = 0;
+	size_t size = 0;
+	HRESULT result = fileUtil::mapFile(filename, fileHandle, mappingHandle, data, size);
+	if( FAILED(result) ) {
+		return result;
+	}
+
+	char line[FLATATOMICCONFIGIO_LINE_BUFFER_LENGTH] = { '\0' };
+	const size_t keywordLength = strlen(FLATATOMICCONFIGIO_INCLUDE);
+	const char* const dataEnd = data + size;
+	const char* lineStart = data;
+	while( lineStart < dataEnd ) {
+		const char* lineEnd = static_cast<const char*>(memchr(
+			lineStart, FLATATOMICCONFIGIO_LINE_SEP, dataEnd - lineStart));
+		const char* nextLineStart = (lineEnd == 0) ? dataEnd : (lineEnd + 1);
+		if( lineEnd == 0 ) {
+			lineEnd = dataEnd;
+		}
+		size_t length = static_cast<size_t>(lineEnd - lineStart);
+		if( length > 0 && lineStart[length - 1] == '\r' ) {
+			--length;
+		}
+
+		// read() stops at the first line which is too long (see readChunks())
+		if( length >= (FLATATOMICCONFIGIO_MAX_LINE_LENGTH) ) {
+			break;
+		}
+
+		/* Only lines starting with the include keyword are parsed,
+		   so that no data values are constructed
+		 */
+		const char* keyword = lineStart;
+		while( keyword < (lineStart + length) && isspace(static_cast<unsigned char>(*keyword)) ) {
+			++keyword;
+		}
+		if( static_cast<size_t>(lineStart + length - keyword) > keywordLength &&
+			memcmp(keyword, FLATATOMICCONFIGIO_INCLUDE, keywordLength) == 0 ) {
+			memcpy(line, lineStart, length);
+			line[length] = '\0';
+			ParsedLine parsedLine;
+			if( SUCCEEDED(parseDataLine(line, parsedLine)) && parsedLine.include ) {
+				includes.push_back(parsedLine.includeFilename);
+			}
+		}
+
+		lineStart = nextLineStart;
+	}
+
+	fileUtil::unmapFile(fileHandle, mappingHandle, data);
+	return ERROR_SUCCESS;
+}
+
+HRESULT FlatAtomicConfigIO::mergeIncludes(Config& config, const std::vector<IncludedFile*>& files,
+	const size_t fileIndex, const wstring& scopePrefix,
+	std::vector<bool>& onPath) {
+
+	HRESULT result = ERROR_SUCCESS;
+	const IncludedFile& file = *(files[fileIndex]);
+	std::list<Include>::const_iterator end = file.includes.cend();
+	for( std::list<Include>::const_iterator it = file.includes.cbegin(); it != end; ++it ) {
+		if( it->target >= files.size() ) {
+			// Already reported
+			continue;
+		}
+
+		wstring location = (fileIndex == 0) ? L"" : (L"Included file " + file.filename + L", ");
+		location += L"Line " + to_wstring(it->lineNumber) + L": ";
+		if( onPath[it->target] ) {
+			m_msgStore.emplace_back(location + L"circular inclusion of the file " +
+				files[it->target]->filename + L" - Ignored.");
+			result = MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+			continue;
+		}
+
+		// The included file's own data precedes the data from the files it includes
+		const wstring includedPrefix = Config::joinScopes(scopePrefix, it->scopePrefix);
+		if( FAILED(config.insertCopies(files[it->target]->config, includedPrefix)) ) {
+			m_msgStore.emplace_back(location + L"failed to insert the data from the included file " +
+				files[it->target]->filename + L" into the Config object.");
+			return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+		}
 
-				if( FAILED(tempResult) ) {
-					logMessage(L"Problem appending parsing error messages to the file.");
-					result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
-				} else {
-					logMessage(L"Parsing error messages appended to the file without problems.");
-				}
-			}
+		onPath[it->target] = true;
+		HRESULT includeResult = mergeIncludes(config, files, it->target, includedPrefix, onPath);
+		onPath[it->target] = false;
+		if( FAILED(includeResult) ) {
+			return includeResult;
+		} else if( HRESULT_CODE(includeResult) == ERROR_DATA_INCOMPLETE ) {
+			result = includeResult;
 		}
 	}
 	return result;
 }
 
-HRESULT FlatAtomicConfigIO::write(const wstring& filename, const Config& config, const bool overwrite) {
+void FlatAtomicConfigIO::addInclude(std::list<Include>& includes, const ParsedLine& line) {
+	Include include;
+	include.filename = line.includeFilename;
+	include.scopePrefix = line.scope;
+	include.lineNumber = line.lineNumber;
+	include.target = 0;
+	includes.push_back(include);
+}
 
-	setMsgPrefix(L"FlatAtomicConfigIO writing to " + filename + L" >");
+HRESULT FlatAtomicConfigIO::update(const wstring& filename, const Config& config) {
 
-	// Initialization of the data stream
-	std::map<Config::Key, Config::Value*>::const_iterator currentPair = config.cbegin();
-	std::map<Config::Key, Config::Value*>::const_iterator end = config.cend();
-	if( currentPair == end ) {
-		logMessage(L"Config object is empty - Nothing to write.");
-		return ERROR_SUCCESS;
+	setMsgPrefix(L"FlatAtomicConfigIO updating " + filename + L" >");
+
+	// Check that the line index is up to date
+	bool rewrite = (filename != m_lineIndexFilename);
+	if( rewrite ) {
+		LOGUSER_INFO(L"The file has not been indexed - Rewriting the entire file.");
+	} else {
+		uint64_t size = 0;
+		uint64_t writeTime = 0;
+		if( FAILED(fileUtil::getFileStamp(filename, size, writeTime)) ||
+			size != m_lineIndexFileSize || writeTime != m_lineIndexWriteTime ) {
+			LOGUSER_INFO(L"The file has been modified since it was indexed - Rewriting the entire file.");
+			rewrite = true;
+		}
 	}
 
-	// Open the output file
-	std::basic_ofstream<wchar_t> file;
-	if( overwrite ) {
-		file.open(filename, std::ofstream::out);
+	HRESULT result = ERROR_SUCCESS;
+	if( !rewrite ) {
+		result = patchFile(filename, config, rewrite);
+		if( !rewrite ) {
+			return result;
+		}
+	}
+
+	/* Rewrite and re-index the file, preserving its include directives,
+	   and leaving out the data loaded from the included files
+	 */
+	m_lineIndex.clear();
+	m_lineIndexFilename.clear();
+	if( filename == m_includingFilename ) {
+		result = writeFile(filename, config, true, &m_fileIncludes, &m_includedKeys);
 	} else {
-		file.open(filename, std::ofstream::app);
+		result = write(filename, config, true);
 	}
-	if( !file.is_open() ) {
-		logMessage(L"Unable to open the file.");
-		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FILE_NOT_FOUND);
+	if( FAILED(result) ) {
+		return result;
 	}
+	if( FAILED(indexFile(filename)) ) {
+		LOGUSER_ERROR(L"Failed to index the rewritten file.");
+	}
+	return result;
+}
 
-	// Begin output
+HRESULT FlatAtomicConfigIO::patchFile(const wstring& filename, const Config& config, bool& rewrite) {
+
+	rewrite = false;
+
+	// The file is mapped into memory so that existing values can be compared with new values
+	HANDLE fileHandle = INVALID_HANDLE_VALUE;
+	HANDLE mappingHandle = NULL;
+	const char* data = 0;
+	size_t size = 0;
+	if( FAILED(fileUtil::mapFile(filename, fileHandle, mappingHandle, data, size)) ) {
+		LOGUSER_WARNING(L"Unable to map the file into memory - Rewriting the entire file.");
+		rewrite = true;
+		return ERROR_SUCCESS;
+	}
+
+	// Match the line separators already used in the file
+	string lineSep(1, FLATATOMICCONFIGIO_LINE_SEP);
+	const char* firstSep = (data == 0) ? 0 : static_cast<const char*>(memchr(data, FLATATOMICCONFIGIO_LINE_SEP, size));
+	if( firstSep != 0 && firstSep != data && *(firstSep - 1) == '\r' ) {
+		lineSep = "\r\n";
+	}
+
+	/* Lines to be appended to the file, following a header line.
+	   The offsets of the new locations of keys are relative to
+	   the start of this string.
+	 */
+	wstring line;
+	line.reserve(FLATATOMICCONFIGIO_LINE_BUFFER_LENGTH);
+	string appended;
+	if( size > 0 && data[size - 1] != FLATATOMICCONFIGIO_LINE_SEP ) {
+		appended += lineSep;
+	}
 	wstring time;
 	if( FAILED(Logger::getDateAndTime(time)) ) {
 		time = L"Failed to get time ";
 	}
-	file << FLATATOMICCONFIGIO_COMMENT_SEP_WSTR << L' ' << FLATATOMICCONFIGIO_START_OUTPUT
-		<< L" FlatAtomicConfigIO instance Config output ( " + time + L")";
-	file << FLATATOMICCONFIGIO_LINE_SEP_WSTR;
-	if( !file.good() ) {
-		logMessage(L"File stream good() function returned false when starting to write.");
-		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
-	}
+	line = FLATATOMICCONFIGIO_COMMENT_SEP_WSTR L" FlatAtomicConfigIO instance Config update ( ";
+	line += time;
+	line += L")";
+	textProcessing::appendUTF8(appended, line.c_str(), line.length());
+	appended += lineSep;
+	const size_t appendedHeaderLength = appended.length();
+
+	std::list<std::pair<uint64_t, string> > patches; // Replacement lines, by offset
+	std::list<std::map<Config::Key, LineLocation>::iterator> disabled; // Lines to be commented out
+	std::map<Config::Key, LineLocation> moved; // Keys to be appended to the file
+	uint64_t nPatchBytes = 0; // Total amount of data to be written
 
-	// Initialization of loop variables
 	HRESULT result = ERROR_SUCCESS;
 	HRESULT lineResult = ERROR_SUCCESS;
-	wstring line;
-	// Used to remember whether the operation ended due to a problem with the file output stream
-	bool notGood = false;
+	string encoded;
+
+	// Data loaded from included files is not written to the including file
+	const std::set<Config::Key>* const includedKeys = (filename == m_includingFilename) ? &m_includedKeys : 0;
+
+	/* Both the index and the Config object are sorted by key,
+	   so they can be compared in a single pass
+	 */
+	std::map<Config::Key, LineLocation>::iterator indexed = m_lineIndex.begin();
+	std::map<Config::Key, LineLocation>::iterator indexEnd = m_lineIndex.end();
+	std::map<Config::Key, Config::Value*>::const_iterator currentPair = config.cbegin();
+	std::map<Config::Key, Config::Value*>::const_iterator end = config.cend();
+	while( currentPair != end || indexed != indexEnd ) {
+
+		if( indexed != indexEnd && (indexed->second.offset + indexed->second.length) > size ) {
+			LOGUSER_WARNING(L"The line index does not match the file - Rewriting the entire file.");
+			rewrite = true;
+			break;
+		}
+
+		// Keys which are no longer present in the Config object
+		if( currentPair == end || (indexed != indexEnd && indexed->first < currentPair->first) ) {
+			disabled.push_back(indexed);
+			nPatchBytes += indexed->second.length;
+			++indexed;
+			continue;
+		}
+		const bool isIndexed = (indexed != indexEnd && indexed->first == currentPair->first);
+		if( !isIndexed && includedKeys != 0 && includedKeys->find(currentPair->first) != includedKeys->end() ) {
+			++currentPair;
+			continue;
+		}
 
-	// Process each key-value pair in the Config object
-	while( currentPair != end ) {
 		lineResult = writeDataLine(line, currentPair);
 		if( FAILED(lineResult) ) {
-			/* A severe error.
-			The writeDataLine() function should already have logged an error to the message queue
-			*/
-			logMessage(L"writeDataLine() returned a failure code - Aborting write operation.");
+			// The writeDataLine() function should already have logged an error to the message queue
+			LOGUSER_ERROR(L"writeDataLine() returned a failure code - Aborting update operation.");
 			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
 			break;
 		} else if( HRESULT_CODE(lineResult) == ERROR_DATA_INCOMPLETE ) {
-			/* A non-severe error.
-			In this case, the line writing function has encountered
-			unsupported or invalid data, and will have put an error
-			message in the queue.
-			*/
+			// The existing line in the file, if any, is left unchanged
 			result = lineResult;
-		} else {
-			// Write valid data to the file
-			file << line << FLATATOMICCONFIGIO_LINE_SEP_WSTR;
+		} else if( !isIndexed ) {
+			LineLocation location = { appended.length(), 0 };
+			textProcessing::appendUTF8(appended, line.c_str(), line.length());
+			location.length = appended.length() - static_cast<size_t>(location.offset);
+			appended += lineSep;
+			moved.emplace(currentPair->first, location);
+		} else if( !lineHasValue(data + indexed->second.offset, indexed->second.length, *(currentPair->second)) ) {
+			encoded.clear();
+			textProcessing::appendUTF8(encoded, line.c_str(), line.length());
+			if( encoded.length() <= indexed->second.length ) {
+				// Overwrite the line in place
+				encoded.append(indexed->second.length - encoded.length(), ' ');
+				nPatchBytes += encoded.length();
+				patches.emplace_back(indexed->second.offset, encoded);
+			} else {
+				// Move the key to the end of the file
+				disabled.push_back(indexed);
+				nPatchBytes += indexed->second.length;
+				LineLocation location = { appended.length(), encoded.length() };
+				appended += encoded;
+				appended += lineSep;
+				moved.emplace(currentPair->first, location);
+			}
 		}
-		++currentPair;
-		if( !file.good() ) {
-			notGood = true;
-			logMessage(L"File stream good() function returned false - Aborting write operation.");
-			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
-			break;
+
+		if( isIndexed ) {
+			++indexed;
 		}
+		++currentPair;
 	}
 
-	// Write the configuration format to the file for reference
-	if( !notGood && m_outputContext ) {
-		file << FLATATOMICCONFIGIO_LINE_SEP_WSTR;
-		file << FLATATOMICCONFIGIO_DATA_FORMATSPEC;
-		if( !file.good() ) {
-			notGood = true;
-			logMessage(L"File stream good() function returned false when writing the configuration data formatting guidelines.");
-			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
-		}
+	if( FAILED(fileUtil::unmapFile(fileHandle, mappingHandle, data)) ) {
+		LOGUSER_ERROR(L"Failed to unmap the file from memory.");
+	}
+	if( FAILED(result) ) {
+		return result;
 	}
 
-	// End the output
-	if( !notGood ) {
-		if( m_outputContext ) {
-			file << FLATATOMICCONFIGIO_LINE_SEP_WSTR;
+	if( moved.empty() ) {
+		appended.clear();
+	}
+	nPatchBytes += appended.length();
+	if( !rewrite && nPatchBytes * 100 > static_cast<uint64_t>(size) * FLATATOMICCONFIGIO_MAX_PATCH_PERCENT ) {
+		LOGUSER_INFO(L"Too much of the file would be modified - Rewriting the entire file.");
+		rewrite = true;
+	}
+	if( rewrite ) {
+		// Serialization problems will be reported again by write()
+		m_msgStore.clear();
+		return ERROR_SUCCESS;
+	}
+
+	if( nPatchBytes == 0 ) {
+		LOGUSER_INFO(L"No values have changed - Nothing to write.");
+	} else {
+		// Apply the changes
+		std::fstream file(filename, std::fstream::in | std::fstream::out | std::fstream::binary);
+		if( !file.is_open() ) {
+			LOGUSER_ERROR(L"Unable to open the file.");
+			return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FILE_NOT_FOUND);
 		}
-		file << FLATATOMICCONFIGIO_COMMENT_SEP_WSTR << L' ' << FLATATOMICCONFIGIO_END_OUTPUT
-			<< L" FlatAtomicConfigIO instance Config output ( " + time + L")";
-		if( !file.good() ) {
-			notGood = true;
-			logMessage(L"File stream good() function returned false when ending the configuration output.");
-			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+
+		std::list<std::pair<uint64_t, string> >::const_iterator patchEnd = patches.cend();
+		for( std::list<std::pair<uint64_t, string> >::const_iterator it = patches.cbegin(); it != patchEnd; ++it ) {
+			file.seekp(static_cast<std::streamoff>(it->first));
+			file.write(it->second.c_str(), it->second.length());
 		}
-	}
 
-	file.close();
+		const size_t disabledLineLength = strlen(FLATATOMICCONFIGIO_DISABLED_LINE);
+		std::list<std::map<Config::Key, LineLocation>::iterator>::const_iterator disabledEnd = disabled.cend();
+		for( std::list<std::map<Config::Key, LineLocation>::iterator>::const_iterator it = disabled.cbegin(); it != disabledEnd; ++it ) {
+			encoded.assign(FLATATOMICCONFIGIO_DISABLED_LINE, std::min(disabledLineLength, (*it)->second.length));
+			encoded.append((*it)->second.length - encoded.length(), ' ');
+			file.seekp(static_cast<std::streamoff>((*it)->second.offset));
+			file.write(encoded.c_str(), encoded.length());
+			m_lineIndex.erase(*it);
+		}
 
-	// Write any serialization problems back to the file
-	if( m_msgStore.empty() && !notGood ) {
-		logMessage(L"Config object writing complete - No invalid or unsupported data.");
-	} else {
-		logMessage(L"Config object writing complete - Problems encountered.");
+		if( !appended.empty() ) {
+			file.seekp(0, std::fstream::end);
+			file.write(appended.c_str(), appended.length());
+		}
 
-		if( !notGood ) {
-			if( FAILED(Logger::getDateAndTime(time)) ) {
-				time = L"Failed to get time ";
-			}
-			m_msgStore.emplace_front(L"<<-- FlatAtomicConfigIO instance Config writing report ( " + time + L") begins --");
-			m_msgStore.emplace_back(L"-- FlatAtomicConfigIO instance Config writing report ends -->>");
+		const bool good = file.good();
+		file.close();
+		if( !good ) {
+			LOGUSER_ERROR(L"File stream good() function returned false - The file may be partially updated.");
+			m_lineIndex.clear();
+			m_lineIndexFilename.clear();
+			return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+		}
 
-			/* Get an "empty" Logger for easy output to the file,
-			such that this object has complete control over the
-			Logger's timestamping behaviour.
-			*/
-			if( FAILED(setLogger(false, L"", false, false)) ) {
-				logMessage(L"Error getting a Logger to output Config object writing report to the file.");
-				result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
-			} else {
-				toggleTimestamp(false); // Lines need to start with the comment symbol, not a timestamp
-
-				// First insert a blank line
-				setMsgPrefix(L"");
-				HRESULT tempResult = logMessage(FLATATOMICCONFIGIO_LINE_SEP_WSTR, false, true, filename);
-				if( SUCCEEDED(tempResult) ) {
-					// Now log the serialization report
-					setMsgPrefix(FLATATOMICCONFIGIO_COMMENT_SEP_WSTR);
-					tempResult = logMsgStore(true, false, true, filename);
-				}
-				setMsgPrefix(L"FlatAtomicConfigIO writing " + filename + L" >");
-				revertLogger();
+		// Record the locations of the appended keys
+		std::map<Config::Key, LineLocation>::iterator movedEnd = moved.end();
+		for( std::map<Config::Key, LineLocation>::iterator it = moved.begin(); it != movedEnd; ++it ) {
+			it->second.offset += static_cast<uint64_t>(size);
+			m_lineIndex[it->first] = it->second;
+		}
 
-				if( FAILED(tempResult) ) {
-					logMessage(L"Problem appending Config writing error messages to the file.");
-					result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
-				} else {
-					logMessage(L"Config writing error messages appended to the file without problems.");
-				}
-			}
+		LOGUSER_INFO(L"Updated " + to_wstring(patches.size()) + L" line(s) in place, disabled " +
+			to_wstring(disabled.size()) + L" line(s), and appended " + to_wstring(moved.size()) + L" line(s).");
+	}
+
+	// Write any serialization problems back to the file
+	if( m_msgStore.empty() ) {
+		LOGUSER_INFO(L"Config object update complete - No invalid or unsupported data.");
+	} else {
+		LOGUSER_WARNING(L"Config object update complete - Problems encountered.");
+		if( FAILED(appendReport(filename, L"Config update report")) ) {
+			LOGUSER_ERROR(L"Problem appending Config update error messages to the file.");
+			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+		} else {
+			LOGUSER_DEBUG(L"Config update error messages reported without problems.");
 		}
 	}
+
+	// The index reflects the modified file
+	if( FAILED(fileUtil::getFileStamp(filename, m_lineIndexFileSize, m_lineIndexWriteTime)) ) {
+		LOGUSER_WARNING(L"Failed to retrieve the size and modification time of the file - Discarding the line index.");
+		m_lineIndex.clear();
+		m_lineIndexFilename.clear();
+	}
 	return result;
 }
 
-// A macro for use only within readDataLine() for parsing most data types
-#define PARSE_DATA_VALUE(enumConstant, type, parseFunction) \
-	type* const value = new type; \
-	if( FAILED(parseFunction(*value, str, tempIndex)) ) { \
-		failedParse = true; \
-			delete value; \
-		} else if( tempIndex == index ) { \
-			garbageData = true; \
-			delete value; \
-		} else { \
-			insertResult = config.insert<Config::DataType::enumConstant, type>( \
-							scope, field, value, &prefix); \
-			prefix += L" "; \
-		if( FAILED(insertResult) ) { \
-			delete value; \
-		} else if( HRESULT_CODE(insertResult) == ERROR_ALREADY_ASSIGNED ) { \
-			duplicateKey = true; \
-			delete value; \
-		} \
-	} \
-	break;
-
-// A macro for use only within readDataLine() for parsing the filename and directory data types
-/* This case gets unique handling, because file and directory names/paths
-   are subject to validation that tests more than just their text representation.
-   Therefore, as problems with a filename may not be obvious,
-   the user gets shown the messages that are made
-   available by this particular parsing function.
- */
-#define PARSE_FILENAME_OR_DIRECTORY(enumConstant, type, parseFunction, isFile) \
-	type* const value = new type; \
-	wstring parseMsg; \
-	if( FAILED(parseFunction(*value, str, isFile, tempIndex, &parseMsg)) ) { \
-		failedParse = true; \
-		delete value; \
-	} else if( tempIndex == index ) { \
-		garbageData = true; \
-		delete value; \
-	} else { \
-		insertResult = config.insert<Config::DataType::enumConstant, type>( \
-						scope, field, value, &prefix); \
-		prefix += L" "; \
-		if( FAILED(insertResult) ) { \
-			delete value; \
-		} else if( HRESULT_CODE(insertResult) == ERROR_ALREADY_ASSIGNED ) { \
-			duplicateKey = true; \
-			delete value; \
-		} \
-	} \
-	if( !parseMsg.empty() ) { \
-		m_msgStore.emplace_back(prefix + \
-			L"the function for parsing the " LCHAR_STRINGIFY(enumConstant) L" data value reported \"" + \
-			parseMsg + L"\""); \
-	} \
-	break;
-/* Note that the presence of a message ( "!parseMsg.empty()" )
-   is not assumed to indicate an error has occurred.
-   (The other output parameters are used to test for problems.)
- */
+HRESULT FlatAtomicConfigIO::indexFile(const wstring& filename) {
+
+	// Values do not need to be parsed, as they are discarded
+	const bool lineIndexing = m_lineIndexing;
+	const bool lazyParsing = m_lazyParsing;
+	m_lineIndexing = true;
+	m_lazyParsing = true;
+	m_lineIndex.clear();
+	m_lineIndexFilename.clear();
+
+	Config config;
+	bool fail = false;
+	HRESULT result = readParallel(filename, config, fail);
+	m_msgStore.clear();
+	m_includes.clear(); // The include directives recorded by read() are unchanged
+
+	m_lineIndexing = lineIndexing;
+	m_lazyParsing = lazyParsing;
+
+	if( FAILED(result) || m_lineIndexFilename.empty() ||
+		FAILED(fileUtil::getFileStamp(filename, m_lineIndexFileSize, m_lineIndexWriteTime)) ) {
+		m_lineIndex.clear();
+		m_lineIndexFilename.clear();
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	return ERROR_SUCCESS;
+}
+
+bool FlatAtomicConfigIO::lineHasValue(const char* const line, const size_t length,
+	const Config::Value& value) const {
+
+	if( length >= FLATATOMICCONFIGIO_LINE_BUFFER_LENGTH ) {
+		return false;
+	}
+	char buffer[FLATATOMICCONFIGIO_LINE_BUFFER_LENGTH];
+	memcpy(buffer, line, length);
+	buffer[length] = '\0';
+
+	ParsedLine parsedLine;
+	if( FAILED(parseDataLine(buffer, parsedLine)) || parsedLine.value == 0 ||
+		parsedLine.value->getDataType() != value.getDataType() ) {
+		return false;
+	}
+
+	const Config::DataType type = value.getDataType();
+	const void* const oldValue = parsedLine.value->getValue(type);
+	const void* const newValue = value.getValue(type);
+	if( oldValue == 0 || newValue == 0 ) {
+		return false;
+	}
+
+	const Config::DataTypeInfo* const info = Config::getDataTypeInfo(type);
+	return (info != 0) && info->equals(oldValue, newValue);
+}
+
+HRESULT FlatAtomicConfigIO::parseValue(const Config::DataType type, const char* const str,
+	const void*& value, bool& partialValue, wstring& parseMsg) {
+
+	value = 0;
+	size_t index = 0;
+
+	const Config::DataTypeInfo* const info = Config::getDataTypeInfo(type);
+	if( info == 0 ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_BROKEN_CODE);
+	}
+
+	/* Note that the parsing function does not check if the value actually
+	   occupied the entire rest of the line, or only part of it.
+
+	   Messages are only produced for filenames and directories,
+	   as problems with them may not be obvious from their text representation.
+	   The presence of a message is not assumed to indicate an error has occurred.
+	 */
+	HRESULT result = info->parse(str, value, index, parseMsg);
+	if( result != ERROR_SUCCESS ) {
+		return result;
+	}
+
+	partialValue = (str[index] != '\0');
+	return ERROR_SUCCESS;
+}
+
+HRESULT FlatAtomicConfigIO::checkValue(const Config::DataType type, const char* const str,
+	bool& partialValue, wstring& parseMsg, wstring& buffer) {
+
+	size_t index = 0;
+
+	const Config::DataTypeInfo* const info = Config::getDataTypeInfo(type);
+	if( info == 0 ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_BROKEN_CODE);
+	}
+
+	// See the corresponding comment in parseValue()
+	HRESULT result = info->check(str, index, parseMsg, buffer);
+	if( result != ERROR_SUCCESS ) {
+		return result;
+	}
+
+	partialValue = (str[index] != '\0');
+	return ERROR_SUCCESS;
+}
+
+HRESULT FlatAtomicConfigIO::decodeValue(const Config::DataType type, const std::string& raw,
+	const void*& value, wstring& msg) {
+
+	bool partialValue = false;
+	wstring parseMsg;
+	HRESULT result = parseValue(type, raw.c_str(), value, partialValue, parseMsg);
+
+	msg.clear();
+	if( !parseMsg.empty() ) {
+		msg = L"the function for parsing the data value reported \"" + parseMsg + L"\" ";
+	}
+	if( FAILED(result) ) {
+		msg += L"the function for parsing the data value returned a failure result.";
+	} else if( result != ERROR_SUCCESS ) {
+		msg += L"the function for parsing the data value did not find a valid data value.";
+	} else if( partialValue ) {
+		msg += L"the function for parsing the data value did not convert the entire value text into a data value.";
+	}
+	return result;
+}
 
 HRESULT FlatAtomicConfigIO::readDataLine(Config& config, char* const str, const size_t& lineNumber) {
 
+	ParsedLine line;
+	line.lineNumber = lineNumber;
+	HRESULT result = parseDataLine(str, line);
+	m_msgStore.splice(m_msgStore.end(), line.msgs);
+	if( line.include ) {
+		addInclude(m_includes, line);
+	}
+
+	if( FAILED(result) || line.value == 0 ) {
+		return result;
+	}
+	return insertParsedLine(config, line, m_msgStore);
+}
+
+HRESULT FlatAtomicConfigIO::parseDataLine(char* const str, ParsedLine& out) const {
+
 	// Error checking
 	if( str == 0 ) {
 		return 	MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NULL_INPUT);
@@ -404,12 +1819,12 @@ HRESULT FlatAtomicConfigIO::readDataLine(Config& config, char* const str, const
 	/* This prefix will be part of error/warning messages that are stored in the message list
 	   to be appended to the configuration file by the read() function.
 	   */
-	wstring prefix = L"Line " + to_wstring(lineNumber) + L": ";
+	wstring prefix = L"Line " + to_wstring(out.lineNumber) + L": ";
 
 	// Strip whitespace and control characters
 	char ignoreInStrLiteral[] = { ' ' }; // Characters to be preserved between matching double quotes
 	if( FAILED(remove_ASCII_controlAndWhitespace(str, 0, 0, QUOTES, ignoreInStrLiteral, sizeof(ignoreInStrLiteral) / sizeof(char))) ) {
-		m_msgStore.emplace_back(prefix + L"remove_ASCII_controlAndWhitespace() failed.");
+		out.msgs.emplace_back(prefix + L"remove_ASCII_controlAndWhitespace() failed.");
 		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
 	}
 
@@ -429,146 +1844,207 @@ HRESULT FlatAtomicConfigIO::readDataLine(Config& config, char* const str, const
 	size_t tempIndex = 0;
 	char tempChar = '\0';
 
+	// Parse an include directive
+	if( hasPrefix(str, FLATATOMICCONFIGIO_INCLUDE FLATATOMICCONFIGIO_SEP_1) ) {
+		index = strlen(FLATATOMICCONFIGIO_INCLUDE FLATATOMICCONFIGIO_SEP_1);
+		if( !hasSubstr(str, FLATATOMICCONFIGIO_SEP_2, tempIndex, index) ) {
+			out.msgs.emplace_back(prefix +
+				L"no separator found to mark the end of the scope prefix of the include directive (needed even if the prefix is empty).");
+			return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+		tempChar = str[tempIndex]; // Hide the rest of the string
+		str[tempIndex] = '\0';
+		toWString(out.scope, str + index);
+		str[tempIndex] = tempChar; // Unhide the rest of the string
+		index = tempIndex + strlen(FLATATOMICCONFIGIO_SEP_2);
+
+		wstring parseMsg;
+		if( FAILED(strToFileOrDirName(out.includeFilename, str + index, true, tempIndex, &parseMsg)) ) {
+			out.msgs.emplace_back(prefix + L"the function for parsing the filename of the include directive returned a failure result.");
+			return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+		} else if( tempIndex == 0 ) {
+			out.msgs.emplace_back(prefix + L"no valid filename found in the include directive. The parsing function reported \"" +
+				parseMsg + L"\"");
+			return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+		out.include = true;
+		if( str[index + tempIndex] != '\0' ) {
+			out.msgs.emplace_back(prefix + L"the include directive continues past the end of the filename.");
+			return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+		return ERROR_SUCCESS;
+	}
+
 	// Parse the data type specification
 	Config::DataType dataType;
 	if( !hasSubstr(str, FLATATOMICCONFIGIO_SEP_1, index) ) {
-		m_msgStore.emplace_back(prefix + L"no separator found to mark the end of the datatype specifier.");
+		out.msgs.emplace_back(prefix + L"no separator found to mark the end of the datatype specifier.");
 		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
 
 	} else {
-		// Retrieve the datatype
-		tempChar = str[index]; // Hide the rest of the string
-		str[index] = '\0';
-		if( FAILED(Config::cstrToDataType(dataType, str)) ) {
-			m_msgStore.emplace_back(prefix + L"no datatype found that corresponds to the datatype specifier.");
+		// Retrieve the datatype (without copying the specifier)
+		const Config::DataTypeInfo* const info = Config::getDataTypeInfo(str, index);
+		if( info == 0 ) {
+			out.msgs.emplace_back(prefix + L"no datatype found that corresponds to the datatype specifier.");
 			return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
 		}
-		str[index] = tempChar; // Unhide the rest of the string
+		dataType = info->type;
 
 		// Check if the datatype is supported
 		if( !isSupportedDataType(dataType) ) {
-			m_msgStore.emplace_back(prefix + L"unsupported datatype found.");
+			out.msgs.emplace_back(prefix + L"unsupported datatype found.");
 			return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
 		}
 	}
 	index += strlen(FLATATOMICCONFIGIO_SEP_1);
+	const size_t keyStart = index;
 
 	// Parse a key scope name
-	wstring scope;
 	if( !hasSubstr(str, FLATATOMICCONFIGIO_SEP_2, tempIndex, index) ) {
-		m_msgStore.emplace_back(prefix +
+		out.msgs.emplace_back(prefix +
 			L"no separator found to mark the end of the key scope (needed even if the scope is empty).");
 		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
-	} else {
+	} else if( !out.lint ) {
 		tempChar = str[tempIndex]; // Hide the rest of the string
 		str[tempIndex] = '\0';
-		toWString(scope, str + index); // Assign just the scope name to the string
+		toWString(out.scope, str + index); // Assign just the scope name to the string
 		str[tempIndex] = tempChar; // Unhide the rest of the string
 	}
 	index = tempIndex + strlen(FLATATOMICCONFIGIO_SEP_2);
 
 	// Parse a key field name
-	wstring field;
 	if( !hasSubstr(str, FLATATOMICCONFIGIO_SEP_3, tempIndex, index) ) {
-		m_msgStore.emplace_back(prefix +
+		out.msgs.emplace_back(prefix +
 			L"no separator found to mark the end of the key field.");
 		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
 	} else if( index >= tempIndex ) {
-		m_msgStore.emplace_back(prefix +
+		out.msgs.emplace_back(prefix +
 			L"found empty key field specifier (not allowed).");
 		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	} else if( out.lint ) {
+		// Only needed to detect repeated keys
+		out.key.assign(str + keyStart, str + tempIndex);
 	} else {
 		tempChar = str[tempIndex]; // Hide the rest of the string
 		str[tempIndex] = '\0';
-		toWString(field, str + index);
+		toWString(out.field, str + index);
 		str[tempIndex] = tempChar;
 	}
-	tempIndex += strlen(FLATATOMICCONFIGIO_SEP_3);
-	// The two must match in order to check for the success of data value parsing later
-	index = tempIndex;
-
-	// Parse and store the value
-	// -------------------------
+	// The value occupies the rest of the line
+	index = tempIndex + strlen(FLATATOMICCONFIGIO_SEP_3);
 
-	// Error handling variables
-	bool failedParse = false; // The parsing function failed
-	bool garbageData = false; // The parsing function could not find valid data
-	bool duplicateKey = false; // The Config object already has a value under this key
-	HRESULT insertResult = ERROR_SUCCESS; // Result of attempting to insert the key-value pair into the Config object
+	// Parse the value
+	// ---------------
 
-	/* Note that the following statements do not check if the value actually
-	   occupied the entire rest of the line, or only part of it.
-	 */
-	switch( dataType ) {
-	case Config::DataType::WSTRING:
-	{
-		PARSE_DATA_VALUE(WSTRING, wstring, wStrLiteralToWString)
-	}
-	case Config::DataType::BOOL:
-	{
-		PARSE_DATA_VALUE(BOOL, bool, strToBool)
-	}
-	case Config::DataType::INT:
-	{
-		PARSE_DATA_VALUE(INT, int, strToNumber)
-	}
-	case Config::DataType::DOUBLE:
-	{
-		PARSE_DATA_VALUE(DOUBLE, double, strToNumber)
-	}
-	case Config::DataType::FLOAT4:
-	{
-		PARSE_DATA_VALUE(FLOAT4, DirectX::XMFLOAT4, strToXMFLOAT4)
+	// Defer parsing until the value is retrieved
+	if( m_lazyParsing && !out.lint ) {
+		out.value = new Config::Value(dataType, std::string(str + index), &decodeValue);
+		return ERROR_SUCCESS;
 	}
-	case Config::DataType::COLOR:
-	{
-		PARSE_DATA_VALUE(COLOR, DirectX::XMFLOAT4, strToColorRGBA)
+
+	const void* value = 0;
+	wstring parseMsg;
+	HRESULT parseResult = ERROR_SUCCESS;
+	if( out.lint ) {
+		// The value is only checked, without being created
+		parseResult = checkValue(dataType, str + index, out.partialValue, parseMsg, out.lintBuffer);
+	} else {
+		parseResult = parseValue(dataType, str + index, value, out.partialValue, parseMsg);
 	}
-	case Config::DataType::FILENAME:
-	{
-		PARSE_FILENAME_OR_DIRECTORY(FILENAME, wstring, strToFileOrDirName, true)
+
+	if( parseResult == ERROR_SUCCESS && out.lint ) {
+		out.parseMsg = parseMsg;
+		return ERROR_SUCCESS;
+	} else if( parseResult == ERROR_SUCCESS ) {
+		out.value = new Config::Value(dataType, value);
+
+		/* If a value is parsed, the message is reported when the value
+		   is inserted into a Config object (by insertParsedLine()),
+		   so that it can be labelled with the key.
+		 */
+		out.parseMsg = parseMsg;
+		return ERROR_SUCCESS;
 	}
-	case Config::DataType::DIRECTORY:
-	{
-		PARSE_FILENAME_OR_DIRECTORY(DIRECTORY, wstring, strToFileOrDirName, false)
+
+	if( !parseMsg.empty() ) {
+		wstring dataTypeName;
+		Config::dataTypeToWString(dataTypeName, dataType);
+		out.msgs.emplace_back(prefix +
+			L"the function for parsing the " + dataTypeName + L" data value reported \"" +
+			parseMsg + L"\"");
 	}
-	default:
-	{
+
+	// Handle errors resulting from parsing
+	if( HRESULT_CODE(parseResult) == ERROR_BROKEN_CODE ) {
 		/* This case should never because of the earlier check to see
 		   if the datatype was supported.
 		   If this case is encountered, either the list of supported
-		   data types, or this switch statement must be corrected.
+		   data types, or the switch statement in parseValue() must be corrected.
 		 */
-		wstring msg = prefix +
-			L"value parsing switch statement encountered default case. Code is broken.";
-		m_msgStore.emplace_back(msg);
-		logMessage(msg);
-		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_BROKEN_CODE);
+		out.msgs.emplace_back(prefix +
+			L"value parsing switch statement encountered default case. Code is broken.");
+		return parseResult;
+	} else if( FAILED(parseResult) ) {
+		out.msgs.emplace_back(prefix + L"the function for parsing the data value section of the line returned a failure result.");
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	} else {
+		out.msgs.emplace_back(prefix +
+			L"the function for parsing the data value section of the line did not find a valid data value.");
+		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
 	}
+}
+
+HRESULT FlatAtomicConfigIO::insertParsedLine(Config& config, ParsedLine& line,
+	std::list<wstring>& msgStore) const {
+
+	// Error checking
+	if( line.value == 0 ) {
+		return 	MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NULL_INPUT);
 	}
 
-	// Handle errors resulting from parsing
-	if( failedParse ) {
-		m_msgStore.emplace_back(prefix + L"the function for parsing the data value section of the line returned a failure result.");
+	// See the corresponding comment in parseDataLine()
+	wstring prefix = L"Line " + to_wstring(line.lineNumber) + L": ";
+
+	// Needed for reporting, as the value may be transferred to the Config object
+	wstring dataTypeName;
+	if( FAILED(Config::dataTypeToWString(dataTypeName, line.value->getDataType())) ) {
+		msgStore.emplace_back(prefix +
+			L"failed to convert the data type enumeration constant to a name (in string form).");
 		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
-	} else if( garbageData ) {
-		m_msgStore.emplace_back(prefix +
-			L"the function for parsing the data value section of the line did not find a valid data value.");
-		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
-	} else if( duplicateKey ) {
-		m_msgStore.emplace_back(prefix +
+	}
+
+	// Result of attempting to insert the key-value pair into the Config object
+	HRESULT insertResult = config.insert(line.scope, line.field, line.value, &prefix);
+	prefix += L" ";
+	bool duplicateKey = false; // The Config object already has a value under this key
+	if( SUCCEEDED(insertResult) ) {
+		if( HRESULT_CODE(insertResult) == ERROR_ALREADY_ASSIGNED ) {
+			duplicateKey = true;
+		} else {
+			line.value = 0; // Now owned by the Config object
+		}
+	}
+
+	if( !line.parseMsg.empty() ) {
+		msgStore.emplace_back(prefix +
+			L"the function for parsing the " + dataTypeName + L" data value reported \"" +
+			line.parseMsg + L"\"");
+	}
+
+	if( duplicateKey ) {
+		msgStore.emplace_back(prefix +
 			L"There is already a value stored in the Config object under the given key scope and field."
 			L" Either this key was repeated in the file,"
 			L" or was already present in the Config object before this file was read.");
 		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
 	} else if( FAILED(insertResult) ) {
-		m_msgStore.emplace_back(prefix +
+		msgStore.emplace_back(prefix +
 			L"a serious error occured when attempting to insert the key-data value pair into the Config object.");
 		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
 
 		// Check if the entire line was parsed
-	} else if( str[tempIndex] != '\0' ) {
-		m_msgStore.emplace_back(prefix +
+	} else if( line.partialValue ) {
+		msgStore.emplace_back(prefix +
 			L"the function for parsing the data value section of the line did not convert the entire rest of the line into a data value.");
 		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
 	}
@@ -576,11 +2052,6 @@ HRESULT FlatAtomicConfigIO::readDataLine(Config& config, char* const str, const
 	return ERROR_SUCCESS;
 }
 
-// A macro for use only within writeDataLine()
-#define SERIALIZE_DATA_VALUE(type, serializeFunction) \
-	serializationResult = serializeFunction(valueWStr, *(static_cast<const type*>(value))); \
-	break;
-
 HRESULT FlatAtomicConfigIO::writeDataLine(wstring& str, const std::map<Config::Key, Config::Value*>::const_iterator& data) {
 
 	// An empty string will be output in case of errors
@@ -588,105 +2059,72 @@ HRESULT FlatAtomicConfigIO::writeDataLine(wstring& str, const std::map<Config::K
 
 	// Split the data into its components
 	const Config::DataType dataType = data->second->getDataType();
-	wstring scope = data->first.getScope();
-	wstring field = data->first.getField();
+	const wstring& scope = data->first.getScope();
+	const wstring& field = data->first.getField();
 	const void* const value = data->second->getValue(dataType);
 
 	/* This prefix will be part of error/warning messages that are stored in the message list
 	to be appended to the configuration file by the write() function.
+	(It is only created when needed, as most lines are written without problems.)
 	*/
-	wstring prefix = L"Key (scope, field) = (" + scope + L", " + field + L"): ";
+#define WRITEDATALINE_PREFIX (L"Key (scope, field) = (" + scope + L", " + field + L"): ")
 
 	// Check if the datatype is supported
 	if( !isSupportedDataType(dataType) ) {
-		m_msgStore.emplace_back(prefix + L"unsupported datatype found.");
+		m_msgStore.emplace_back(WRITEDATALINE_PREFIX + L"unsupported datatype found.");
 		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
 	}
 
-	// Try to serialize the data value to a string
-	// -------------------------------------------
-
-	HRESULT serializationResult = ERROR_SUCCESS;
-	wstring valueWStr;
-	switch( dataType ) {
-	case Config::DataType::WSTRING:
-	{
-		SERIALIZE_DATA_VALUE(wstring, wstringToWStrLiteral)
-	}
-	case Config::DataType::BOOL:
-	{
-		SERIALIZE_DATA_VALUE(bool, boolToWString)
-	}
-	case Config::DataType::INT:
-	{
-		SERIALIZE_DATA_VALUE(int, numberToWString)
-	}
-	case Config::DataType::DOUBLE:
-	{
-		SERIALIZE_DATA_VALUE(double, numberToWString)
-	}
-	case Config::DataType::FLOAT4:
-	{
-		SERIALIZE_DATA_VALUE(DirectX::XMFLOAT4, XMFLOAT4ToWString)
-	}
-	case Config::DataType::COLOR:
-	{
-		SERIALIZE_DATA_VALUE(DirectX::XMFLOAT4, colorRGBAToWString)
-	}
-	case Config::DataType::FILENAME:
-	{
-		SERIALIZE_DATA_VALUE(wstring, fileOrDirNameToWString)
+	// Check for values which could not be decoded (see Config::Value)
+	if( value == 0 ) {
+		m_msgStore.emplace_back(WRITEDATALINE_PREFIX + L"invalid data value: " + data->second->getDecodeMessage());
+		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
 	}
-	case Config::DataType::DIRECTORY:
-	{
-		SERIALIZE_DATA_VALUE(wstring, fileOrDirNameToWString)
+
+	// Output the key in the correct format
+	if( FAILED(Config::dataTypeToWString(str, dataType)) ) {
+		m_msgStore.emplace_back(WRITEDATALINE_PREFIX +
+			L"failed to convert the data type enumeration constant to a name (in string form).");
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
 	}
-	default:
-	{
-		/* This case should never because of the earlier check to see
+	str += FLATATOMICCONFIGIO_WHITESPACE_SEP FLATATOMICCONFIGIO_SEP_1_WSTR FLATATOMICCONFIGIO_WHITESPACE_SEP;
+	str += scope;
+	str += FLATATOMICCONFIGIO_SEP_2_WSTR;
+	str += field;
+	str += FLATATOMICCONFIGIO_WHITESPACE_SEP FLATATOMICCONFIGIO_SEP_3_WSTR FLATATOMICCONFIGIO_WHITESPACE_SEP;
+
+	// Serialize the data value directly into the output string, where possible
+	// ------------------------------------------------------------------------
+
+	const Config::DataTypeInfo* const info = Config::getDataTypeInfo(dataType);
+	if( info == 0 ) {
+		/* This case should never occur because of the earlier check to see
 		if the datatype was supported.
-		If this case is encountered, then either the list of supported
-		data types, or this switch statement must be corrected.
 		*/
-		wstring msg = prefix +
-			L"value serialization switch statement encountered default case. Code is broken.";
+		str.clear();
+		wstring msg = WRITEDATALINE_PREFIX +
+			L"no descriptor was found for the data type. Code is broken.";
 		m_msgStore.emplace_back(msg);
-		logMessage(msg);
+		LOGUSER_ERROR(msg);
 		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_BROKEN_CODE);
 	}
-	}
+	HRESULT serializationResult = info->format(str, value, m_valueBuffer);
 
 	// Handle serialization errors
 	if( FAILED(serializationResult) ) {
-		m_msgStore.emplace_back(prefix +
+		str.clear();
+		m_msgStore.emplace_back(WRITEDATALINE_PREFIX +
 			L"the function for serializing the data value to a string returned a failure result.");
 		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
 	}
 
-	// Output the results in the correct format
-	if( FAILED(Config::dataTypeToWString(str, dataType)) ) {
-		m_msgStore.emplace_back(prefix +
-			L"failed to convert the data type enumeration constant to a name (in string form).");
-		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
-
-	} else {
-		str += FLATATOMICCONFIGIO_WHITESPACE_SEP;
-		str += FLATATOMICCONFIGIO_SEP_1_WSTR;
-		str += FLATATOMICCONFIGIO_WHITESPACE_SEP;
-		str += scope;
-		str += FLATATOMICCONFIGIO_SEP_2_WSTR;
-		str += field;
-		str += FLATATOMICCONFIGIO_WHITESPACE_SEP;
-		str += FLATATOMICCONFIGIO_SEP_3_WSTR;
-		str += FLATATOMICCONFIGIO_WHITESPACE_SEP;
-		str += valueWStr;
-	}
-
 	// Catch line length violations
 	if( str.length() > FLATATOMICCONFIGIO_MAX_LINE_LENGTH ) {
-		m_msgStore.emplace_back(prefix + L"line length is too long to be read by this class's file parser.");
+		m_msgStore.emplace_back(WRITEDATALINE_PREFIX + L"line length is too long to be read by this class's file parser.");
 		str.clear();
 		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
 	}
 	return ERROR_SUCCESS;
+
+#undef WRITEDATALINE_PREFIX
 }
\ No newline at end of file
@@ -0,0 +1,355 @@
+/*
+FlightRecorder.cpp
+------------------
+
+Created for: Spring 2014 Direct3D 11 Learning
+By: Bernard Llanos
+August 21, 2014
+
+Primary basis: None
+Other references: None
+
+Development environment: Visual Studio 2013 running on Windows 7, 64-bit
+  -Note that the "Character Set" project property (Configuration Properties > General)
+   should be set to Unicode for all configurations, when using Visual Studio.
+
+Description
+  -Implementation of the FlightRecorder class
+*/
+
+#include "FlightRecorder.h"
+#include "Logger.h"
+#include "Timestamper.h"
+#include "defs.h"
+#include <cstring>
+#include <algorithm>
+
+using std::wstring;
+
+// Smallest capacity of the ring, in bytes
+#define FLIGHTRECORDER_MIN_CAPACITY 4096
+
+// Number of 100-nanosecond intervals (FILETIME units) per second
+#define FLIGHTRECORDER_TICKS_PER_SECOND 10000000LL
+
+// Parameters of the FNV-1a hash function, used for record checksums
+#define FLIGHTRECORDER_CHECKSUM_BASIS 2166136261U
+#define FLIGHTRECORDER_CHECKSUM_PRIME 16777619U
+
+// Largest number of bytes read from a ring file by decode() in one call to ReadFile()
+#define FLIGHTRECORDER_MAX_READ (1 << 24)
+
+// Updates a checksum with the values in the array (rather than byte by byte, for speed)
+template<typename T>
+static uint32_t checksum(uint32_t hash, const T* const data, const size_t n) {
+	for( size_t i = 0; i < n; ++i ) {
+		hash ^= static_cast<uint32_t>(data[i]);
+		hash *= FLIGHTRECORDER_CHECKSUM_PRIME;
+	}
+	return hash;
+}
+
+// Copies data out of the ring, wrapping around from the end to the start
+static void copyOut(void* const out, const char* const ring, const uint64_t capacity,
+	const uint64_t position, const size_t size) {
+	const size_t offset = static_cast<size_t>(position & (capacity - 1));
+	const size_t first = std::min(size, static_cast<size_t>(capacity) - offset);
+	memcpy(out, ring + offset, first);
+	if( first < size ) {
+		memcpy(static_cast<char*>(out) + first, ring, size - first);
+	}
+}
+
+FlightRecorder::FlightRecorder(const wstring filename, const size_t capacity) :
+m_file(INVALID_HANDLE_VALUE), m_mapping(0), m_view(0), m_ring(0), m_mask(0), m_maxLength(0),
+m_writePos(0), m_anchorCounter(0), m_anchorTime(0), m_timeScale(0.0)
+{
+	uint64_t ringSize = FLIGHTRECORDER_MIN_CAPACITY;
+	while( ringSize < capacity ) {
+		ringSize <<= 1;
+	}
+	m_mask = ringSize - 1;
+	m_maxLength = static_cast<uint32_t>((ringSize / 4 - sizeof(RecordHeader)) / sizeof(wchar_t));
+	const uint64_t fileSize = sizeof(FileHeader) + ringSize;
+
+	// Write sharing allows decode() to open the file while it is in use
+	m_file = CreateFile(filename.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+		NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if( m_file == INVALID_HANDLE_VALUE ) {
+		// This is a Microsoft-specific constructor
+		throw std::exception("Failed to open the ring file.");
+	}
+
+	// Check if the file is a ring file with the same capacity, which can be added to
+	FileHeader header;
+	LARGE_INTEGER size;
+	DWORD nRead = 0;
+	bool reuse = false;
+	if( GetFileSizeEx(m_file, &size) && static_cast<uint64_t>(size.QuadPart) == fileSize &&
+		ReadFile(m_file, &header, sizeof(FileHeader), &nRead, NULL) && nRead == sizeof(FileHeader) ) {
+		reuse = (header.magic == FLIGHTRECORDER_MAGIC && header.version == FLIGHTRECORDER_VERSION &&
+			header.charSize == sizeof(wchar_t) && header.capacity == ringSize);
+	}
+
+	if( !reuse ) {
+		// Truncating and then extending the file fills it with zeros
+		LARGE_INTEGER position;
+		position.QuadPart = 0;
+		bool resized = SetFilePointerEx(m_file, position, NULL, FILE_BEGIN) && SetEndOfFile(m_file);
+		position.QuadPart = static_cast<LONGLONG>(fileSize);
+		resized = resized && SetFilePointerEx(m_file, position, NULL, FILE_BEGIN) && SetEndOfFile(m_file);
+		if( !resized ) {
+			CloseHandle(m_file);
+			// This is a Microsoft-specific constructor
+			throw std::exception("Failed to resize the ring file.");
+		}
+	}
+
+	m_mapping = CreateFileMapping(m_file, NULL, PAGE_READWRITE, 0, 0, NULL);
+	if( m_mapping == NULL ) {
+		CloseHandle(m_file);
+		// This is a Microsoft-specific constructor
+		throw std::exception("Failed to create a file mapping object for the ring file.");
+	}
+	m_view = static_cast<char*>(MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, 0));
+	if( m_view == NULL ) {
+		CloseHandle(m_mapping);
+		CloseHandle(m_file);
+		// This is a Microsoft-specific constructor
+		throw std::exception("Failed to map the ring file.");
+	}
+	m_ring = m_view + sizeof(FileHeader);
+
+	if( reuse ) {
+		// Continue after the newest record
+		std::vector<RecordHeader> records;
+		m_writePos.store(scan(records, m_ring, ringSize));
+	} else {
+		memset(&header, 0, sizeof(FileHeader));
+		header.magic = FLIGHTRECORDER_MAGIC;
+		header.version = FLIGHTRECORDER_VERSION;
+		header.charSize = sizeof(wchar_t);
+		header.capacity = ringSize;
+		memcpy(m_view, &header, sizeof(FileHeader));
+	}
+
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+	FILETIME systemTime;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	GetSystemTimeAsFileTime(&systemTime);
+	m_anchorCounter = counter.QuadPart;
+	m_anchorTime = (static_cast<LONGLONG>(systemTime.dwHighDateTime) << 32) |
+		static_cast<LONGLONG>(systemTime.dwLowDateTime);
+	m_timeScale = static_cast<double>(FLIGHTRECORDER_TICKS_PER_SECOND) /
+		static_cast<double>(frequency.QuadPart);
+}
+
+FlightRecorder::~FlightRecorder(void) {
+	UnmapViewOfFile(m_view);
+	CloseHandle(m_mapping);
+	CloseHandle(m_file);
+}
+
+void FlightRecorder::record(const LONGLONG counter, const wstring* const prefix, const wstring& msg) {
+	size_t length = msg.length();
+	if( prefix != 0 ) {
+		length += prefix->length() + 1;
+	}
+	if( length > m_maxLength ) {
+		length = m_maxLength;
+	}
+
+	// Reserve space for the record
+	RecordHeader header;
+	header.size = static_cast<uint32_t>((sizeof(RecordHeader) + length * sizeof(wchar_t) + 7) & ~static_cast<size_t>(7));
+	header.position = m_writePos.fetch_add(header.size, std::memory_order_relaxed);
+	header.time = m_anchorTime + static_cast<LONGLONG>(static_cast<double>(counter - m_anchorCounter) * m_timeScale);
+	header.length = static_cast<uint32_t>(length);
+	header.checksum = 0;
+	header.reserved = 0;
+	uint32_t hash = checksum(FLIGHTRECORDER_CHECKSUM_BASIS,
+		reinterpret_cast<const uint32_t*>(&header), sizeof(RecordHeader) / sizeof(uint32_t));
+
+	// Copy the message, truncated to 'length' characters
+	uint64_t position = header.position + sizeof(RecordHeader);
+	if( prefix != 0 ) {
+		const size_t prefixLength = std::min(prefix->length(), length);
+		writeText(position, hash, prefix->c_str(), prefixLength);
+		length -= prefixLength;
+		if( length > 0 ) {
+			writeText(position, hash, L" ", 1);
+			--length;
+		}
+	}
+	writeText(position, hash, msg.c_str(), length);
+
+	// Write the rest of the header, and then commit the record by writing its position
+	header.checksum = hash;
+	copyIn(header.position + sizeof(uint64_t), &header.time, sizeof(RecordHeader) - sizeof(uint64_t));
+	std::atomic_thread_fence(std::memory_order_release);
+	*reinterpret_cast<volatile uint64_t*>(m_ring + (header.position & m_mask)) = header.position;
+}
+
+HRESULT FlightRecorder::flush(void) {
+	if( !FlushViewOfFile(m_view, 0) || !FlushFileBuffers(m_file) ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WINDOWS_CALL);
+	}
+	return ERROR_SUCCESS;
+}
+
+void FlightRecorder::copyIn(const uint64_t position, const void* const data, const size_t size) {
+	const size_t offset = static_cast<size_t>(position & m_mask);
+	const size_t first = std::min(size, static_cast<size_t>(m_mask + 1) - offset);
+	memcpy(m_ring + offset, data, first);
+	if( first < size ) {
+		memcpy(m_ring, static_cast<const char*>(data) + first, size - first);
+	}
+}
+
+void FlightRecorder::writeText(uint64_t& position, uint32_t& hash, const wchar_t* const text, const size_t length) {
+	copyIn(position, text, length * sizeof(wchar_t));
+	hash = checksum(hash, text, length);
+	position += length * sizeof(wchar_t);
+}
+
+bool FlightRecorder::readRecord(RecordHeader& header, wstring& text,
+	const char* const ring, const uint64_t capacity, const uint64_t offset) {
+
+	copyOut(&header, ring, capacity, offset, sizeof(RecordHeader));
+	const uint64_t maxSize = capacity / 4 + 8;
+	if( (header.position & (capacity - 1)) != offset || header.size < sizeof(RecordHeader) ||
+		header.size > maxSize || (header.size % 8) != 0 ||
+		(sizeof(RecordHeader) + static_cast<uint64_t>(header.length) * sizeof(wchar_t)) > header.size ) {
+		return false;
+	}
+
+	text.resize(header.length);
+	if( header.length > 0 ) {
+		copyOut(&text[0], ring, capacity, header.position + sizeof(RecordHeader), header.length * sizeof(wchar_t));
+	}
+	RecordHeader unchecked = header;
+	unchecked.checksum = 0;
+	uint32_t hash = checksum(FLIGHTRECORDER_CHECKSUM_BASIS,
+		reinterpret_cast<const uint32_t*>(&unchecked), sizeof(RecordHeader) / sizeof(uint32_t));
+	hash = checksum(hash, text.c_str(), text.length());
+	return hash == header.checksum;
+}
+
+uint64_t FlightRecorder::scan(std::vector<RecordHeader>& records, const char* const ring, const uint64_t capacity) {
+	records.clear();
+	RecordHeader header;
+	wstring text;
+	uint64_t end = 0;
+	for( uint64_t offset = 0; offset < capacity; offset += 8 ) {
+		if( readRecord(header, text, ring, capacity, offset) ) {
+			records.push_back(header);
+			end = std::max(end, header.position + header.size);
+		}
+	}
+	std::sort(records.begin(), records.end(), [](const RecordHeader& a, const RecordHeader& b) {
+		return a.position < b.position;
+	});
+
+	/* Keep records which are within the last 'capacity' bytes before the end,
+	   and which do not overlap newer records. (Older records may be intact
+	   if the space reserved for newer records was not written.)
+	 */
+	uint64_t limit = end;
+	size_t nKept = 0;
+	for( size_t i = records.size(); i > 0; --i ) {
+		const RecordHeader& record = records[i - 1];
+		if( (record.position + capacity) >= end && (record.position + record.size) <= limit ) {
+			limit = record.position;
+			records[records.size() - 1 - nKept] = record;
+			++nKept;
+		}
+	}
+	records.erase(records.begin(), records.end() - nKept);
+	return end;
+}
+
+HRESULT FlightRecorder::decode(const wstring& ringFilename, const wstring& textFilename,
+	const size_t nRecords) {
+	/* The file may be in use by a FlightRecorder, which has write access,
+	   so it must be opened with write sharing. (fileUtil::mapFile() does not
+	   allow write sharing.) The contents are copied before they are decoded,
+	   so that records cannot change between being checked and being output.
+	 */
+	HANDLE file = CreateFile(ringFilename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+		NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if( file == INVALID_HANDLE_VALUE ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FILE_NOT_FOUND);
+	}
+
+	FileHeader header;
+	LARGE_INTEGER size;
+	DWORD nRead = 0;
+	if( !GetFileSizeEx(file, &size) || !ReadFile(file, &header, sizeof(FileHeader), &nRead, NULL) ) {
+		CloseHandle(file);
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WINDOWS_CALL);
+	}
+	if( nRead != sizeof(FileHeader) ||
+		header.magic != FLIGHTRECORDER_MAGIC || header.version != FLIGHTRECORDER_VERSION ||
+		header.charSize != sizeof(wchar_t) || header.capacity < FLIGHTRECORDER_MIN_CAPACITY ||
+		(header.capacity & (header.capacity - 1)) != 0 ||
+		(static_cast<uint64_t>(size.QuadPart) - sizeof(FileHeader)) != header.capacity ) {
+		CloseHandle(file);
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_DATA);
+	}
+
+	std::vector<char> ringCopy(static_cast<size_t>(header.capacity));
+	uint64_t nCopied = 0;
+	while( nCopied < header.capacity ) {
+		DWORD nToRead = FLIGHTRECORDER_MAX_READ;
+		if( (header.capacity - nCopied) < nToRead ) {
+			nToRead = static_cast<DWORD>(header.capacity - nCopied);
+		}
+		if( !ReadFile(file, &ringCopy[static_cast<size_t>(nCopied)], nToRead, &nRead, NULL) || nRead == 0 ) {
+			CloseHandle(file);
+			return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WINDOWS_CALL);
+		}
+		nCopied += nRead;
+	}
+	CloseHandle(file);
+
+	Logger* logger = 0;
+	try {
+		logger = new Logger(true, textFilename, true, false);
+	} catch( ... ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+	logger->toggleTimestamp(false);
+
+	const char* const ring = &ringCopy[0];
+	std::vector<RecordHeader> records;
+	scan(records, ring, header.capacity);
+
+	// Record times are FILETIME values, so the clock "frequency" is the number of FILETIME units per second
+	Timestamper timestamper;
+	timestamper.setAnchor(FLIGHTRECORDER_TICKS_PER_SECOND, 0, 0);
+
+	const size_t first = (nRecords == 0 || nRecords >= records.size()) ? 0 : (records.size() - nRecords);
+	HRESULT result = ERROR_SUCCESS;
+	bool complete = true;
+	wstring line;
+	wstring text;
+	for( size_t i = first; i < records.size() && SUCCEEDED(result); ++i ) {
+		if( i > first && (records[i - 1].position + records[i - 1].size) != records[i].position ) {
+			complete = false;
+		}
+		readRecord(records[i], text, ring, header.capacity, records[i].position & (header.capacity - 1));
+		line.clear();
+		timestamper.append(line, records[i].time);
+		line += L" | ";
+		line += text;
+		result = logger->logMessage(line);
+	}
+
+	delete logger;
+	if( SUCCEEDED(result) && !complete ) {
+		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+	return result;
+}
\ No newline at end of file
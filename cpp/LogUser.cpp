@@ -20,13 +20,49 @@ Description
 #include "defs.h"
 #include "globals.h"
 #include "LogUser.h"
+#include <cstring>
+
+// Multiplier for hashing call site identifiers (2^64 divided by the golden ratio)
+#define LOGUSER_CALL_SITE_HASH 0x9E3779B97F4A7C15ULL
+
+// Offset basis and prime of the 64-bit FNV-1a hash, used to detect repeated messages
+#define LOGUSER_MSG_HASH_BASIS 0xCBF29CE484222325ULL
+#define LOGUSER_MSG_HASH_PRIME 0x100000001B3ULL
+
+// Returns the index of the first slot probed for the call site's rate limiting state
+static size_t callSiteSlot(const ULONGLONG site) {
+	return static_cast<size_t>((site * LOGUSER_CALL_SITE_HASH) >> 32) % LOGUSER_N_CALL_SITES;
+}
+
+// Returns the FNV-1a hash of the characters of a message
+static ULONGLONG hashMessage(const std::wstring& msg) {
+	ULONGLONG hash = LOGUSER_MSG_HASH_BASIS;
+	const wchar_t* const end = msg.data() + msg.length();
+	for( const wchar_t* c = msg.data(); c != end; ++c ) {
+		hash ^= static_cast<ULONGLONG>(*c);
+		hash *= LOGUSER_MSG_HASH_PRIME;
+	}
+	return hash;
+}
+
+LogUser::SuppressionStats::SuppressionStats(void) :
+nRepeats(0), nRateLimited(0), nSummaries(0)
+{}
 
 LogUser::LogUser(bool enableLogging, std::wstring msgPrefix) :
 m_loggingEnabled(enableLogging), m_logger(0), m_pastLogger(0),
-m_msgPrefix(msgPrefix)
-{}
+m_msgPrefix(msgPrefix), m_logLevel(LOGUSER_LOG_LEVEL),
+m_suppressRepeats(LOGUSER_SUPPRESS_REPEATS_FLAG), m_repeatSummaryInterval(LOGUSER_REPEAT_SUMMARY_INTERVAL),
+m_lastSite(0), m_lastMsgHash(0), m_lastMsg(), m_nRepeats(0), m_repeatStart(0),
+m_rateLimit(LOGUSER_RATE_LIMIT), m_rateInterval(LOGUSER_RATE_INTERVAL),
+m_nPendingSites(0), m_suppressionStats()
+{
+	memset(m_callSites, 0, sizeof(m_callSites));
+}
 
 LogUser::~LogUser(void) {
+	logRepeatSummary();
+	logRateLimitSummaries(GetTickCount(), true);
 	if (m_logger != 0) {
 		delete m_logger;
 		m_logger = 0;
@@ -69,6 +105,83 @@ void LogUser::disableLogging() {
 	m_loggingEnabled = false;
 }
 
+HRESULT LogUser::setLogLevel(const unsigned int level) {
+	if( level < LOG_LEVEL_DEBUG || level > LOG_LEVEL_ERROR ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_INPUT);
+	}
+	m_logLevel = level;
+	return ERROR_SUCCESS;
+}
+
+unsigned int LogUser::getLogLevel(void) const {
+	return m_logLevel;
+}
+
+HRESULT LogUser::logLevelFromString(unsigned int& level, const std::wstring& str) {
+	if( _wcsicmp(str.c_str(), L"debug") == 0 ) {
+		level = LOG_LEVEL_DEBUG;
+	} else if( _wcsicmp(str.c_str(), L"info") == 0 ) {
+		level = LOG_LEVEL_INFO;
+	} else if( _wcsicmp(str.c_str(), L"warning") == 0 ) {
+		level = LOG_LEVEL_WARNING;
+	} else if( _wcsicmp(str.c_str(), L"error") == 0 ) {
+		level = LOG_LEVEL_ERROR;
+	} else {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_INPUT);
+	}
+	return ERROR_SUCCESS;
+}
+
+HRESULT LogUser::setRepeatSuppression(const bool enable, const DWORD summaryInterval) {
+	HRESULT result = ERROR_SUCCESS;
+	if( !enable ) {
+		result = logRepeatSummary();
+		m_lastSite = 0;
+		m_lastMsgHash = 0;
+		m_lastMsg.clear();
+	}
+	m_suppressRepeats = enable;
+	m_repeatSummaryInterval = summaryInterval;
+	return result;
+}
+
+HRESULT LogUser::setRateLimit(const unsigned int maxMessages, const DWORD interval) {
+	if( maxMessages != 0 && interval == 0 ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_INPUT);
+	}
+	// Report messages discarded under the previous settings
+	HRESULT result = logRateLimitSummaries(GetTickCount(), true);
+	m_rateLimit = maxMessages;
+	m_rateInterval = interval;
+	memset(m_callSites, 0, sizeof(m_callSites));
+	m_nPendingSites = 0;
+	return FAILED(result) ? result : ERROR_SUCCESS;
+}
+
+void LogUser::getRateLimit(unsigned int& maxMessages, DWORD& interval) const {
+	maxMessages = m_rateLimit;
+	interval = m_rateInterval;
+}
+
+HRESULT LogUser::flushSuppressionSummaries(void) {
+	const DWORD now = GetTickCount();
+	HRESULT result = ERROR_SUCCESS;
+	if( m_nRepeats > 0 && m_repeatSummaryInterval != 0 && (now - m_repeatStart) >= m_repeatSummaryInterval ) {
+		result = logRepeatSummary();
+		m_repeatStart = now;
+	}
+	HRESULT rateResult = logRateLimitSummaries(now, false);
+	return FAILED(rateResult) ? rateResult : result;
+}
+
+void LogUser::getSuppressionStats(SuppressionStats& stats) const {
+	stats = m_suppressionStats;
+}
+
+void LogUser::resetSuppressionStats(void) {
+	m_suppressionStats = SuppressionStats();
+}
+
 void LogUser::setMsgPrefix(const std::wstring& prefix) {
 	m_msgPrefix = prefix;
 }
@@ -83,15 +196,25 @@ bool LogUser::toggleTimestamp(bool newState) {
 	}
 }
 
+HRESULT LogUser::setLogRotation(const ULONGLONG maxSize, const DWORD interval,
+	const unsigned int nSegments) {
+	if( m_logger != 0 ) {
+		return m_logger->setRotation(maxSize, interval, nSegments);
+	} else if( g_defaultLogger != 0 ) {
+		return g_defaultLogger->setRotation(maxSize, interval, nSegments);
+	} else {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_DATA);
+	}
+}
+
 HRESULT LogUser::logMessage(const std::wstring& msg,
 	bool toConsole, bool toFile, const std::wstring filename) {
 	if (m_loggingEnabled) {
-		std::wstring fullMsg = m_msgPrefix + L" " + msg;
 		if (m_logger != 0) {
-			return m_logger->logMessage(fullMsg, toConsole, toFile, filename);
+			return m_logger->logPrefixedMessage(m_msgPrefix, msg, toConsole, toFile, filename);
 		}
 		else if (g_defaultLogger != 0){
-			return g_defaultLogger->logMessage(fullMsg, toConsole, toFile, filename);
+			return g_defaultLogger->logPrefixedMessage(m_msgPrefix, msg, toConsole, toFile, filename);
 		}
 		else {
 			return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_DATA);
@@ -101,6 +224,141 @@ HRESULT LogUser::logMessage(const std::wstring& msg,
 	}
 }
 
+HRESULT LogUser::logMessage(const unsigned int level, const std::wstring& msg,
+	bool toConsole, bool toFile, const std::wstring filename) {
+	if( level < m_logLevel ) {
+		return ERROR_SUCCESS;
+	}
+	return logMessage(msg, toConsole, toFile, filename);
+}
+
+HRESULT LogUser::logSiteMessage(const unsigned int level, const ULONGLONG site, const std::wstring& msg) {
+	if( !m_loggingEnabled || level < m_logLevel ) {
+		return ERROR_SUCCESS;
+	}
+	const DWORD now = GetTickCount();
+	HRESULT result = logRateLimitSummaries(now, false);
+
+	/* Repeats are discarded without counting towards the rate limit.
+	   They are detected using the call site, and the hash and length of the message,
+	   so the text is only compared when it is likely to be the same.
+	 */
+	ULONGLONG msgHash = 0;
+	if( m_suppressRepeats ) {
+		msgHash = hashMessage(msg);
+	}
+	if( m_suppressRepeats && site == m_lastSite && msgHash == m_lastMsgHash &&
+		msg.length() == m_lastMsg.length() && msg.compare(m_lastMsg) == 0 ) {
+		++m_nRepeats;
+		++m_suppressionStats.nRepeats;
+		if( m_repeatSummaryInterval != 0 && (now - m_repeatStart) >= m_repeatSummaryInterval ) {
+			HRESULT summaryResult = logRepeatSummary();
+			if( SUCCEEDED(result) ) {
+				result = summaryResult;
+			}
+			m_repeatStart = now;
+		}
+		return result;
+	}
+
+	if( m_rateLimit != 0 ) {
+		// Any discarded messages from the previous interval were reported above
+		CallSite& callSite = findCallSite(site, now);
+		if( (now - callSite.windowStart) >= m_rateInterval ) {
+			callSite.windowStart = now;
+			callSite.nInWindow = 0;
+		}
+		if( callSite.nInWindow >= m_rateLimit ) {
+			if( callSite.nSuppressed == 0 ) {
+				++m_nPendingSites;
+			}
+			++callSite.nSuppressed;
+			++m_suppressionStats.nRateLimited;
+			return result;
+		}
+		++callSite.nInWindow;
+	}
+
+	if( m_suppressRepeats ) {
+		HRESULT summaryResult = logRepeatSummary();
+		if( SUCCEEDED(result) ) {
+			result = summaryResult;
+		}
+		m_lastSite = site;
+		m_lastMsgHash = msgHash;
+		// Reuses the memory of the previous text, which is only reallocated for a longer message
+		m_lastMsg.assign(msg);
+		m_repeatStart = now;
+	}
+
+	HRESULT msgResult = logMessage(msg);
+	return FAILED(msgResult) ? msgResult : result;
+}
+
+HRESULT LogUser::logRepeatSummary(void) {
+	if( m_nRepeats == 0 ) {
+		return ERROR_SUCCESS;
+	}
+	const size_t nRepeats = m_nRepeats;
+	m_nRepeats = 0;
+	++m_suppressionStats.nSummaries;
+	return logMessage(L"Last message repeated " + std::to_wstring(nRepeats) + L" times.");
+}
+
+HRESULT LogUser::logRateLimitSummaries(const DWORD now, const bool all) {
+	HRESULT result = ERROR_SUCCESS;
+	for( size_t i = 0; (m_nPendingSites > 0) && (i < LOGUSER_N_CALL_SITES); ++i ) {
+		CallSite& callSite = m_callSites[i];
+		if( callSite.nSuppressed > 0 && (all || (now - callSite.windowStart) >= m_rateInterval) ) {
+			++m_suppressionStats.nSummaries;
+			HRESULT summaryResult = logMessage(L"Rate limit: " + std::to_wstring(callSite.nSuppressed) +
+				L" messages from one call site were discarded.");
+			if( SUCCEEDED(result) ) {
+				result = summaryResult;
+			}
+			callSite.nSuppressed = 0;
+			--m_nPendingSites;
+		}
+	}
+	return result;
+}
+
+LogUser::CallSite& LogUser::findCallSite(const ULONGLONG site, const DWORD now) {
+	/* Slots are never emptied (except by setRateLimit()),
+	   so an empty slot ends the probe sequence
+	 */
+	const size_t start = callSiteSlot(site);
+	size_t oldest = start;
+	for( size_t i = 0; i < LOGUSER_N_CALL_SITES; ++i ) {
+		CallSite& callSite = m_callSites[(start + i) % LOGUSER_N_CALL_SITES];
+		if( callSite.id == site ) {
+			return callSite;
+		} else if( callSite.id == 0 ) {
+			callSite.id = site;
+			callSite.windowStart = now;
+			callSite.nInWindow = 0;
+			callSite.nSuppressed = 0;
+			return callSite;
+		} else if( (now - callSite.windowStart) > (now - m_callSites[oldest].windowStart) ) {
+			oldest = (start + i) % LOGUSER_N_CALL_SITES;
+		}
+	}
+
+	// All slots are in use: Replace the call site whose interval started first, after reporting it
+	CallSite& callSite = m_callSites[oldest];
+	if( callSite.nSuppressed > 0 ) {
+		++m_suppressionStats.nSummaries;
+		logMessage(L"Rate limit: " + std::to_wstring(callSite.nSuppressed) +
+			L" messages from one call site were discarded.");
+		--m_nPendingSites;
+	}
+	callSite.id = site;
+	callSite.windowStart = now;
+	callSite.nInWindow = 0;
+	callSite.nSuppressed = 0;
+	return callSite;
+}
+
 HRESULT LogUser::logMessage(std::list<std::wstring>::const_iterator start,
 	std::list<std::wstring>::const_iterator end,
 	bool toConsole, bool toFile, const std::wstring filename) {
@@ -118,10 +376,20 @@ HRESULT LogUser::logMessage(std::list<std::wstring>::const_iterator start,
 	}
 }
 
-HRESULT LogUser::logMsgStore(bool alwaysClearStore, bool toConsole, bool toFile,
-	const std::wstring filename) {
+HRESULT LogUser::logMessage(const unsigned int level,
+	std::list<std::wstring>::const_iterator start,
+	std::list<std::wstring>::const_iterator end,
+	bool toConsole, bool toFile, const std::wstring filename) {
+	if( level >= LOG_MIN_LEVEL && isLoggable(level) ) {
+		return logMessage(start, end, toConsole, toFile, filename);
+	}
+	return ERROR_SUCCESS;
+}
+
+HRESULT LogUser::logMsgStore(const unsigned int level, bool alwaysClearStore,
+	bool toConsole, bool toFile, const std::wstring filename) {
 
-	HRESULT result = logMessage(m_msgStore.cbegin(), m_msgStore.cend(),
+	HRESULT result = logMessage(level, m_msgStore.cbegin(), m_msgStore.cend(),
 		toConsole, toFile, filename);
 
 	if( SUCCEEDED(result) || alwaysClearStore ) {
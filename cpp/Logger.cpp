@@ -18,28 +18,123 @@ Description
 */
 
 #include "Logger.h"
+#include "FlightRecorder.h"
 #include "defs.h"
 #include "globals.h"
 #include "fileUtil.h"
 #include <ctime>
 #include <exception>
+#include <chrono>
+#include <locale>
+#include <algorithm>
+#include <cwctype>
 
 // Using declarations
 using std::wstring;
 using std::basic_ofstream;
 
+/* Maximum time, in milliseconds, for which the background thread
+   waits for records before checking the queue again, in asynchronous mode
+ */
+#define LOGGER_ASYNC_WAIT_MS 100
+
+/* Interval, in milliseconds, at which the shared background thread checks
+   whether buffered messages are due to be written, in synchronous mode
+ */
+#define LOGGER_FLUSH_CHECK_MS 100
+
+/* Time, in milliseconds, after which the rotation background thread
+   tries again to prepare the next primary log file, after a failure
+ */
+#define LOGGER_ROTATION_RETRY_MS 1000
+
+/* Inserts a suffix before the extension of a filename,
+   e.g. "log.txt" and "1" give "log.1.txt"
+ */
+static wstring segmentFilename(const wstring& filename, const wstring& suffix) {
+	const size_t separator = filename.find_last_of(L"\\/");
+	const size_t dot = filename.rfind(L'.');
+	if( dot == wstring::npos || (separator != wstring::npos && dot < separator) ) {
+		return filename + L"." + suffix;
+	}
+	return filename.substr(0, dot) + L"." + suffix + filename.substr(dot);
+}
+
+/* Converts text to the bytes which a file stream with the given locale
+   would write, replacing characters which cannot be converted with '?'
+ */
+static void narrowForFile(std::string& out, const wstring& in, const std::locale& loc) {
+	out.clear();
+	if( in.empty() ) {
+		return;
+	}
+	typedef std::codecvt<wchar_t, char, std::mbstate_t> Converter;
+	const Converter& converter = std::use_facet<Converter>(loc);
+	std::mbstate_t state = std::mbstate_t();
+	const wchar_t* from = in.data();
+	const wchar_t* fromEnd = in.data() + in.size();
+	const wchar_t* fromNext = from;
+	char buffer[256];
+	char* toNext = buffer;
+	out.reserve(in.size());
+	while( from != fromEnd ) {
+		const std::codecvt_base::result status = converter.out(state, from, fromEnd, fromNext,
+			buffer, buffer + sizeof(buffer), toNext);
+		out.append(buffer, toNext);
+		if( status == std::codecvt_base::error ||
+			(status == std::codecvt_base::partial && fromNext == from && toNext == buffer) ) {
+			// An unconvertible (or incomplete) character
+			out += '?';
+			++fromNext;
+			state = std::mbstate_t();
+		} else if( status == std::codecvt_base::noconv ) {
+			// Not expected for a wide character stream, but keeps the loop finite
+			for( ; fromNext != fromEnd; ++fromNext ) {
+				out += static_cast<char>(*fromNext);
+			}
+		}
+		from = fromNext;
+	}
+}
+
 // Initialization of static members
-unsigned int Logger::s_nConsoleWriters = 0;
+std::atomic<unsigned int> Logger::s_nConsoleWriters(0);
+std::mutex Logger::s_consoleMutex;
+std::list<Logger*> Logger::s_flushLoggers;
+std::mutex Logger::s_flushMutex;
+std::condition_variable Logger::s_flushWork;
+bool Logger::s_flushStop = false;
+std::thread* Logger::s_flushThread = 0;
+std::mutex Logger::s_flushThreadMutex;
+std::map<wstring, std::list<Logger*> > Logger::s_fileUsers;
+std::mutex Logger::s_fileUsersMutex;
 
 Logger::Logger(bool allocLogFile, wstring filename,
 bool holdAndReplaceFile, bool allocLogConsole) :
 m_consoleOpen(allocLogConsole), m_defaultLogFileOpen(allocLogFile),
 m_holdAndReplaceFile(holdAndReplaceFile),
 m_console(INVALID_HANDLE_VALUE), m_filename(filename), m_logfile(),
-m_timestampEnabled(true)
+m_timestampEnabled(true), m_staging(), m_outputMutex(),
+m_appendMode(AppendMode::BUFFERED), m_fileBuffer(),
+m_fileBufferSize(LOGGER_FILE_BUFFER_SIZE), m_fileFlushInterval(LOGGER_FILE_FLUSH_INTERVAL_MS),
+m_lastFileFlush(GetTickCount()), m_secondaryFiles(),
+m_flushRegistered(false), m_fileKey(), m_fileShared(false),
+m_rotationSize(0), m_rotationInterval(0), m_nRotationSegments(LOGGER_ROTATION_N_SEGMENTS),
+m_segmentSize(0), m_segmentStart(0), m_segmentHandle(INVALID_HANDLE_VALUE), m_narrowBuffer(),
+m_spareFilename(), m_rotationThread(0), m_rotationMutex(), m_rotationWork(),
+m_retiredHandle(INVALID_HANDLE_VALUE), m_archivePending(false), m_spareNeeded(false), m_spareHandle(INVALID_HANDLE_VALUE),
+m_rotationStop(false), m_rotationResult(ERROR_SUCCESS), m_flightRecorder(0),
+m_queue(0), m_queueMask(0), m_overflowPolicy(OverflowPolicy::BLOCK),
+m_thread(0), m_enqueuePos(0), m_dequeuePos(0),
+m_nDropped(0), m_nDroppedUnreported(0), m_asyncResult(ERROR_SUCCESS),
+m_stopRequested(false), m_flushRequested(false), m_flushedPos(0), m_consumerWaiting(false),
+m_asyncMutex(), m_wakeConsumer(), m_batchDone(), m_batch()
 {
 	if (m_consoleOpen) {
 
+		// Prevent other Loggers from allocating or freeing the console concurrently
+		std::lock_guard<std::mutex> lock(s_consoleMutex);
+
 		// Try to access the console output stream
 		m_console = GetStdHandle(STD_OUTPUT_HANDLE);
 
@@ -101,14 +196,25 @@ m_timestampEnabled(true)
 				throw std::exception(("fileUtil::inspectFileOrDirNameAndPath() reported: "+errorMsg).c_str());
 			}
 		}
+		addFileUser();
 	}
 }
 
 Logger::~Logger(void) {
+	// Output any queued records
+	stopAsync();
+	removeFromFlushThread();
+	flushFile();
+	closeSecondaryFiles();
+	stopRotation();
+	removeFileUser();
+
 	// Dissociate this process from the console, if it is no longer being used
-	--s_nConsoleWriters;
-	if (s_nConsoleWriters == 0) {
-		FreeConsole();
+	if (m_consoleOpen) {
+		std::lock_guard<std::mutex> lock(s_consoleMutex);
+		if (--s_nConsoleWriters == 0) {
+			FreeConsole();
+		}
 	}
 	/* Note that the primary logging output file will be closed automatically
 	by the basic_ofstream<wchar_t> class destructor.
@@ -116,64 +222,169 @@ Logger::~Logger(void) {
 }
 
 HRESULT Logger::logMessage(const wstring& msg, bool toConsole, bool toFile, const wstring filename) {
-	wstring fullMessage;
+	return logSingleMessage(0, msg, toConsole, toFile, filename);
+}
 
-	if( m_timestampEnabled ) {
-		if( FAILED(getDateAndTime(fullMessage)) ) {
-			fullMessage = L"[Cannot get time]";
+HRESULT Logger::logPrefixedMessage(const wstring& prefix, const wstring& msg,
+	bool toConsole, bool toFile, const wstring filename) {
+	return logSingleMessage(&prefix, msg, toConsole, toFile, filename);
+}
+
+HRESULT Logger::logSingleMessage(const wstring* const prefix, const wstring& msg,
+	bool toConsole, bool toFile, const wstring& filename) {
+	const LONGLONG time = Timestamper::now();
+	if( m_flightRecorder != 0 ) {
+		m_flightRecorder->record(time, prefix, msg);
+	}
+
+	if( m_queue != 0 ) {
+		Record record;
+		record.time = time;
+		record.timestampEnabled = m_timestampEnabled;
+		record.bulk = false;
+		record.toConsole = toConsole;
+		record.toFile = toFile;
+		if( prefix != 0 ) {
+			record.msg.reserve(prefix->length() + 1 + msg.length());
+			record.msg += *prefix;
+			record.msg += L' ';
 		}
+		record.msg += msg;
+		record.filename = filename;
+		return enqueue(record);
+	}
+	if( toFile && m_appendMode == AppendMode::BUFFERED && !m_flushRegistered.load() ) {
+		addToFlushThread();
+	}
+	return formatAndOutput(time, m_timestampEnabled, prefix, msg, toConsole, toFile, filename);
+}
 
-		// Format the message
-		fullMessage.back() = L' '; // Remove the newline character
-		fullMessage += L"| ";
+HRESULT Logger::logMessage(std::list<wstring>::const_iterator start,
+	std::list<wstring>::const_iterator end, const std::wstring& prefix,
+	bool toConsole, bool toFile, const wstring filename) {
+	const LONGLONG time = Timestamper::now();
+	if( m_flightRecorder != 0 ) {
+		for( std::list<wstring>::const_iterator it = start; it != end; ++it ) {
+			m_flightRecorder->record(time, &prefix, *it);
+		}
 	}
-	fullMessage += msg;
-	fullMessage += L"\n";
 
-	HRESULT result = ERROR_SUCCESS;
+	if( m_queue != 0 ) {
+		Record record;
+		record.time = time;
+		record.timestampEnabled = m_timestampEnabled;
+		record.bulk = true;
+		record.toConsole = toConsole;
+		record.toFile = toFile;
+		record.msg = prefix;
+		record.msgs.assign(start, end);
+		record.filename = filename;
+		return enqueue(record);
+	}
+	if( toFile && m_appendMode == AppendMode::BUFFERED && !m_flushRegistered.load() ) {
+		addToFlushThread();
+	}
+	return formatAndOutput(time, m_timestampEnabled, start, end, prefix, toConsole, toFile, filename);
+}
 
-	if (toConsole) {
-		result = logMsgToConsole(fullMessage);
+Logger::Staging& Logger::getStaging(void) {
+	/* Visual Studio 2013 does not support thread-local variables with constructors,
+	   so staging buffers are shared by threads whose IDs map to the same buffer.
+	   Thread IDs are multiples of four, so the low bits are discarded,
+	   and the rest are mixed (Knuth's multiplicative hash)
+	   before selecting a buffer.
+	 */
+	const DWORD hash = (GetCurrentThreadId() >> 2) * 2654435761U;
+	return m_staging[(hash >> 16) % LOGGER_N_STAGING_BUFFERS];
+}
+
+void Logger::returnStagingLine(Staging& staging, wstring& line) {
+	std::lock_guard<std::mutex> stagingLock(staging.mutex);
+	if( line.capacity() > staging.line.capacity() ) {
+		staging.line.swap(line);
 	}
-	if (toFile) {
-		HRESULT tempResult = logMsgToFile(fullMessage, filename);
-		if ( FAILED(tempResult) && SUCCEEDED(result) ){
-			result = tempResult;
+}
+
+HRESULT Logger::formatAndOutput(const LONGLONG time, const bool timestampEnabled,
+	const wstring* const prefix, const wstring& msg,
+	bool toConsole, bool toFile, const wstring& filename) {
+
+	/* Format the message, reusing the buffer's memory. The line is moved out
+	   of the staging buffer, so that the staging lock is not held
+	   while waiting for the output lock.
+	 */
+	Staging& staging = getStaging();
+	wstring line;
+	{
+		std::lock_guard<std::mutex> stagingLock(staging.mutex);
+		line.swap(staging.line);
+		line.clear();
+		if( timestampEnabled ) {
+			staging.timestamper.append(line, time);
+			line += L" | ";
+		}
+	}
+	if( prefix != 0 ) {
+		line += *prefix;
+		line += L' ';
+	}
+	line += msg;
+	line += L"\n";
+
+	HRESULT result = ERROR_SUCCESS;
+	{
+		std::lock_guard<std::mutex> outputLock(m_outputMutex);
+
+		if (toConsole) {
+			result = logMsgToConsole(line);
+		}
+		if (toFile) {
+			HRESULT tempResult = logMsgToFile(line, filename);
+			if ( FAILED(tempResult) && SUCCEEDED(result) ){
+				result = tempResult;
+			}
 		}
 	}
+	returnStagingLine(staging, line);
 	return result;
 }
 
-HRESULT Logger::logMessage(std::list<wstring>::const_iterator start,
+HRESULT Logger::formatAndOutput(const LONGLONG time, const bool timestampEnabled,
+	std::list<wstring>::const_iterator start,
 	std::list<wstring>::const_iterator end, const std::wstring& prefix,
-	bool toConsole, bool toFile, const wstring filename) {
+	bool toConsole, bool toFile, const wstring& filename) {
 
-	wstring fullPrefix;
-	if( m_timestampEnabled ) {
-		if( FAILED(getDateAndTime(fullPrefix)) ) {
-			fullPrefix = L"[Cannot get time]";
+	Staging& staging = getStaging();
+	wstring line;
+	{
+		std::lock_guard<std::mutex> stagingLock(staging.mutex);
+		line.swap(staging.line);
+		line.clear();
+		if( timestampEnabled ) {
+			staging.timestamper.append(line, time);
+			line += L" | ";
 		}
-
-		// Format the message
-		fullPrefix += L"| ";
 	}
-	fullPrefix += prefix;
+	line += prefix;
 
 	HRESULT result = ERROR_SUCCESS;
+	{
+		std::lock_guard<std::mutex> outputLock(m_outputMutex);
 
-	if( toConsole ) {
-		result = logMsgToConsole(start, end, fullPrefix);
-	}
-	if( toFile ) {
-		HRESULT tempResult = logMsgToFile(start, end, fullPrefix, filename);
-		if( FAILED(tempResult) && SUCCEEDED(result) ) {
-			result = tempResult;
+		if( toConsole ) {
+			result = logMsgToConsole(start, end, line);
+		}
+		if( toFile ) {
+			HRESULT tempResult = logMsgToFile(start, end, line, filename);
+			if( FAILED(tempResult) && SUCCEEDED(result) ) {
+				result = tempResult;
+			}
 		}
 	}
+	returnStagingLine(staging, line);
 	return result;
 }
 
-
 bool Logger::toggleTimestamp(const bool newState) {
 	bool result = m_timestampEnabled;
 	m_timestampEnabled = newState;
@@ -181,6 +392,22 @@ bool Logger::toggleTimestamp(const bool newState) {
 }
 
 
+HRESULT Logger::setTimestampFormat(const Timestamper::Format format,
+	const unsigned int subsecondDigits) {
+	if( m_queue != 0 ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WRONG_STATE);
+	}
+	HRESULT result = ERROR_SUCCESS;
+	for( size_t i = 0; i < LOGGER_N_STAGING_BUFFERS; ++i ) {
+		result = m_staging[i].timestamper.setFormat(format, subsecondDigits);
+		if( FAILED(result) ) {
+			// All Timestampers reject the same (invalid) input
+			break;
+		}
+	}
+	return result;
+}
+
 HRESULT Logger::getDateAndTime(wstring& timeStr) {
 	std::time_t timeVal;
 	std::time(&timeVal); // Get the current timestamp
@@ -212,7 +439,22 @@ HRESULT Logger::getDateAndTime(wstring& timeStr) {
 }
 
 HRESULT Logger::logMsgToFile(const wstring& msg, wstring filename) {
-	if (filename.length() > 0 && filename != m_filename) {
+	if( filename.length() > 0 && filename != m_filename && m_appendMode == AppendMode::BUFFERED ) {
+		wstring* buffer = 0;
+		HRESULT result = getSecondaryFileBuffer(buffer, filename);
+		if( FAILED(result) ) {
+			return result;
+		}
+		*buffer += msg;
+		if( buffer->size() >= m_fileBufferSize ) {
+			result = flushSecondaryFile(m_secondaryFiles.front());
+			if( FAILED(result) ) {
+				return result;
+			}
+		}
+		return flushFileIfDue();
+
+	} else if (filename.length() > 0 && filename != m_filename) {
 		// Open a custom logging file
 		basic_ofstream<wchar_t> newFile(filename, std::ios::app);
 		if (!newFile.is_open()) {
@@ -221,8 +463,18 @@ HRESULT Logger::logMsgToFile(const wstring& msg, wstring filename) {
 		newFile << msg;
 	} else if (m_defaultLogFileOpen) {
 
-		if( m_holdAndReplaceFile ) {
+		if( !m_holdAndReplaceFile && m_appendMode == AppendMode::BUFFERED ) {
+			m_fileBuffer += msg;
+			return flushFileIfDue();
+
+		/* The file is open in "hold and replace" mode, or while
+		   the background thread outputs a batch of records
+		 */
+		} else if( m_logfile.is_open() ) {
 			m_logfile << msg;
+			if( m_fileShared.load() ) {
+				m_logfile.flush();
+			}
 
 		} else {
 			m_logfile.open(m_filename, std::ios::app);
@@ -242,7 +494,27 @@ HRESULT Logger::logMsgToFile(std::list<wstring>::const_iterator start,
 	const wstring& prefix,
 	const wstring filename) {
 
-	if( filename.length() > 0 && filename != m_filename ) {
+	if( filename.length() > 0 && filename != m_filename && m_appendMode == AppendMode::BUFFERED ) {
+		wstring* buffer = 0;
+		HRESULT result = getSecondaryFileBuffer(buffer, filename);
+		if( FAILED(result) ) {
+			return result;
+		}
+		while( start != end ) {
+			*buffer += prefix;
+			*buffer += *start;
+			*buffer += L"\n";
+			++start;
+		}
+		if( buffer->size() >= m_fileBufferSize ) {
+			result = flushSecondaryFile(m_secondaryFiles.front());
+			if( FAILED(result) ) {
+				return result;
+			}
+		}
+		return flushFileIfDue();
+
+	} else if( filename.length() > 0 && filename != m_filename ) {
 		// Open a custom logging file
 		basic_ofstream<wchar_t> newFile(filename, std::ios::app);
 		if( !newFile.is_open() ) {
@@ -256,11 +528,24 @@ HRESULT Logger::logMsgToFile(std::list<wstring>::const_iterator start,
 
 	} else if( m_defaultLogFileOpen ) {
 
-		if( !m_holdAndReplaceFile ) {
+		if( !m_holdAndReplaceFile && m_appendMode == AppendMode::BUFFERED ) {
+			while( start != end ) {
+				m_fileBuffer += prefix;
+				m_fileBuffer += *start;
+				m_fileBuffer += L"\n";
+				++start;
+			}
+			return flushFileIfDue();
+		}
+
+		// See the comments in the single-message version of this function
+		bool opened = false;
+		if( !m_logfile.is_open() ) {
 			m_logfile.open(m_filename, std::ios::app);
 			if( !m_logfile.is_open() ) {
 				return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FILE_NOT_FOUND);
 			}
+			opened = true;
 		}
 
 		while( start != end ) {
@@ -268,8 +553,10 @@ HRESULT Logger::logMsgToFile(std::list<wstring>::const_iterator start,
 			++start;
 		}
 
-		if( !m_holdAndReplaceFile ) {
+		if( opened ) {
 			m_logfile.close();
+		} else if( m_fileShared.load() ) {
+			m_logfile.flush();
 		}
 	}
 	return ERROR_SUCCESS;
@@ -278,6 +565,7 @@ HRESULT Logger::logMsgToFile(std::list<wstring>::const_iterator start,
 HRESULT Logger::logMsgToConsole(const wstring& msg) {
 	const wchar_t* cStr = msg.c_str();
 	if (m_consoleOpen) {
+		std::lock_guard<std::mutex> lock(s_consoleMutex);
 		WriteConsole(m_console, cStr, wcslen(cStr), NULL, NULL);
 	}
 	return ERROR_SUCCESS;
@@ -290,6 +578,8 @@ HRESULT Logger::logMsgToConsole(std::list<wstring>::const_iterator start,
 	const wchar_t* prefixCStr = prefix.c_str();
 	const wchar_t* msgCStr = 0;
 	if( m_consoleOpen ) {
+		// Other Loggers' lines must not be interleaved with the list
+		std::lock_guard<std::mutex> lock(s_consoleMutex);
 		while( start != end ) {
 			WriteConsole(m_console, prefixCStr, wcslen(prefixCStr), NULL, NULL);
 			msgCStr = start->c_str();
@@ -299,4 +589,796 @@ HRESULT Logger::logMsgToConsole(std::list<wstring>::const_iterator start,
 		}
 	}
 	return ERROR_SUCCESS;
+}
+
+HRESULT Logger::setAppendMode(const AppendMode appendMode,
+	const size_t bufferSize, const DWORD flushInterval) {
+	if( m_queue != 0 || (m_rotationThread != 0 && appendMode == AppendMode::SHARED) ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WRONG_STATE);
+	}
+	if( appendMode == AppendMode::SHARED ) {
+		removeFromFlushThread();
+	}
+
+	// The background thread may be writing buffered messages
+	std::lock_guard<std::mutex> lock(m_outputMutex);
+	HRESULT result = flushFile();
+	if( appendMode == AppendMode::SHARED ) {
+		if( !m_holdAndReplaceFile && m_logfile.is_open() ) {
+			m_logfile.close();
+		}
+		HRESULT closeResult = closeSecondaryFiles();
+		if( SUCCEEDED(result) ) {
+			result = closeResult;
+		}
+	}
+	m_appendMode = appendMode;
+	m_fileBufferSize = bufferSize;
+	m_fileFlushInterval = flushInterval;
+	return result;
+}
+
+void Logger::setFlightRecorder(FlightRecorder* const recorder) {
+	m_flightRecorder = recorder;
+}
+
+HRESULT Logger::setRotation(const ULONGLONG maxSize, const DWORD interval,
+	const unsigned int nSegments) {
+	if( !m_defaultLogFileOpen || m_holdAndReplaceFile ||
+		m_appendMode != AppendMode::BUFFERED ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WRONG_STATE);
+	}
+
+	/* Time-based rotation should not wait for the next message
+	   (the background thread of asynchronous mode checks periodically)
+	 */
+	if( interval > 0 && m_queue == 0 ) {
+		addToFlushThread();
+	}
+
+	/* A background thread may be writing buffered messages
+	   (in asynchronous mode, the thread which outputs queued records)
+	 */
+	std::lock_guard<std::mutex> lock(m_outputMutex);
+	HRESULT result = flushFile();
+	HRESULT tempResult = stopRotation();
+	if( SUCCEEDED(result) ) {
+		result = tempResult;
+	}
+	if( maxSize == 0 && interval == 0 ) {
+		return result;
+	}
+
+	m_rotationSize = maxSize;
+	m_rotationInterval = interval;
+	m_nRotationSegments = nSegments;
+
+	/* Write to the file through a handle, which can be exchanged
+	   for the handle of the next file without any file system operations
+	 */
+	if( m_logfile.is_open() ) {
+		m_logfile.close();
+	}
+	m_segmentHandle = CreateFile(m_filename.c_str(), FILE_APPEND_DATA,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if( m_segmentHandle == INVALID_HANDLE_VALUE ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FILE_NOT_FOUND);
+	}
+	LARGE_INTEGER size;
+	if( GetFileSizeEx(m_segmentHandle, &size) ) {
+		m_segmentSize = static_cast<ULONGLONG>(size.QuadPart);
+	} else {
+		m_segmentSize = 0;
+	}
+	m_segmentStart = GetTickCount();
+
+	/* Delete a next file left by a Logger which was not destroyed,
+	   as the background thread will not replace an existing file
+	 */
+	m_spareFilename = segmentFilename(m_filename, L"next");
+	DeleteFile(m_spareFilename.c_str());
+	m_retiredHandle = INVALID_HANDLE_VALUE;
+	m_archivePending = false;
+	m_spareNeeded = true;
+	m_rotationStop = false;
+	m_rotationResult = ERROR_SUCCESS;
+
+	try {
+		m_rotationThread = new std::thread(&Logger::archive, this);
+	} catch( ... ) {
+		m_rotationThread = 0;
+		CloseHandle(m_segmentHandle);
+		m_segmentHandle = INVALID_HANDLE_VALUE;
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_LIBRARY_CALL);
+	}
+	return result;
+}
+
+HRESULT Logger::startAsync(const size_t capacity, const OverflowPolicy overflowPolicy) {
+	if( m_queue != 0 ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WRONG_STATE);
+	} else if( capacity == 0 ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_INPUT);
+	}
+
+	// The background thread will take over the file buffer
+	removeFromFlushThread();
+	storeAsyncResult(flushFile());
+
+	// Round up to a power of two, so that positions can be masked
+	size_t nSlots = 1;
+	while( nSlots < capacity ) {
+		nSlots <<= 1;
+	}
+
+	m_queue = new Slot[nSlots];
+	for( size_t i = 0; i < nSlots; ++i ) {
+		m_queue[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	m_queueMask = nSlots - 1;
+	m_overflowPolicy = overflowPolicy;
+	m_enqueuePos.store(0);
+	m_dequeuePos.store(0);
+	m_nDroppedUnreported.store(0);
+	m_asyncResult.store(ERROR_SUCCESS);
+	m_stopRequested.store(false);
+	m_flushRequested.store(false);
+	m_flushedPos = 0;
+	m_consumerWaiting.store(false);
+	m_batch.reserve(nSlots);
+
+	try {
+		m_thread = new std::thread(&Logger::consume, this);
+	} catch( ... ) {
+		m_thread = 0;
+		delete[] m_queue;
+		m_queue = 0;
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_LIBRARY_CALL);
+	}
+	return ERROR_SUCCESS;
+}
+
+HRESULT Logger::stopAsync(void) {
+	if( m_queue == 0 ) {
+		return ERROR_SUCCESS;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_asyncMutex);
+		m_stopRequested.store(true);
+	}
+	m_wakeConsumer.notify_one();
+	m_thread->join();
+	delete m_thread;
+	m_thread = 0;
+
+	delete[] m_queue;
+	m_queue = 0;
+	m_batch.clear();
+	m_batch.shrink_to_fit();
+	return m_asyncResult.exchange(ERROR_SUCCESS);
+}
+
+HRESULT Logger::flush(void) {
+	if( m_queue == 0 ) {
+		HRESULT result = ERROR_SUCCESS;
+		{
+			std::lock_guard<std::mutex> lock(m_outputMutex);
+			result = flushFile();
+		}
+		// Failures from the background thread which writes buffered messages
+		const HRESULT threadResult = m_asyncResult.exchange(ERROR_SUCCESS);
+		return FAILED(result) ? result : threadResult;
+	}
+
+	/* All records queued before this point occupy positions before 'target'.
+	   The background thread outputs records in order, so they have all
+	   been output, and written to the file, once it has flushed the file
+	   at or after position 'target'. The request is repeated in case the
+	   background thread handles it before reaching 'target'.
+	 */
+	const size_t target = m_enqueuePos.load();
+	{
+		std::unique_lock<std::mutex> lock(m_asyncMutex);
+		while( m_flushedPos < target ) {
+			m_flushRequested.store(true);
+			m_wakeConsumer.notify_one();
+			m_batchDone.wait(lock);
+		}
+	}
+	return m_asyncResult.exchange(ERROR_SUCCESS);
+}
+
+size_t Logger::getDroppedCount(void) const {
+	return m_nDropped.load();
+}
+
+HRESULT Logger::enqueue(Record& record) {
+	size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+	Slot* slot = 0;
+	size_t sequence = 0;
+	std::ptrdiff_t difference = 0;
+
+	// Claim a free slot
+	while( true ) {
+		slot = m_queue + (pos & m_queueMask);
+		sequence = slot->sequence.load(std::memory_order_acquire);
+		difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+		if( difference == 0 ) {
+			// The slot is free
+			if( m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed) ) {
+				break;
+			}
+		} else if( difference < 0 ) {
+			// The queue is full
+			if( m_overflowPolicy == OverflowPolicy::BLOCK ) {
+				std::this_thread::yield();
+				pos = m_enqueuePos.load(std::memory_order_relaxed);
+			} else {
+				if( m_overflowPolicy == OverflowPolicy::DROP_AND_COUNT ) {
+					m_nDropped.fetch_add(1);
+					m_nDroppedUnreported.fetch_add(1);
+				}
+				return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+			}
+		} else {
+			// Another producer claimed the slot
+			pos = m_enqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	// Publish the record
+	std::swap(slot->record, record);
+	slot->sequence.store(pos + 1);
+
+	// Wake the background thread if it is waiting for records
+	if( m_consumerWaiting.load() ) {
+		std::lock_guard<std::mutex> lock(m_asyncMutex);
+		m_wakeConsumer.notify_one();
+	}
+	return ERROR_SUCCESS;
+}
+
+void Logger::consume(void) {
+	size_t pos = m_dequeuePos.load();
+	size_t end = pos;
+	const size_t maxBatchSize = m_queueMask + 1;
+
+	while( true ) {
+
+		// Find the published records
+		end = pos;
+		while( (end - pos) < maxBatchSize &&
+			m_queue[end & m_queueMask].sequence.load(std::memory_order_acquire) == (end + 1) ) {
+			++end;
+		}
+
+		if( end != pos ) {
+			writeBatch(pos, end);
+			pos = end;
+			{
+				std::lock_guard<std::mutex> lock(m_asyncMutex);
+				m_dequeuePos.store(pos);
+			}
+			m_batchDone.notify_all();
+
+		} else if( m_stopRequested.load() ) {
+			/* Exit once all claimed slots have been published and output
+			   (stopAsync() should not be called while other threads are logging,
+			   but this avoids losing records if it is)
+			 */
+			if( m_enqueuePos.load() == pos ) {
+				break;
+			}
+			std::this_thread::yield();
+
+		} else {
+			std::unique_lock<std::mutex> lock(m_asyncMutex);
+			m_consumerWaiting.store(true);
+			/* Check again, in case a producer published a record
+			   before seeing that 'm_consumerWaiting' was set
+			 */
+			if( m_queue[pos & m_queueMask].sequence.load() != (pos + 1) &&
+				!m_stopRequested.load() && !m_flushRequested.load() ) {
+				m_wakeConsumer.wait_for(lock, std::chrono::milliseconds(LOGGER_ASYNC_WAIT_MS));
+			}
+			m_consumerWaiting.store(false);
+		}
+
+		/* Write buffered messages to the primary log file
+		   (holding the output lock, as setRotation() can be called in asynchronous mode)
+		 */
+		if( m_flushRequested.exchange(false) ) {
+			{
+				std::lock_guard<std::mutex> outputLock(m_outputMutex);
+				storeAsyncResult(flushFile());
+			}
+			{
+				std::lock_guard<std::mutex> lock(m_asyncMutex);
+				m_flushedPos = pos;
+			}
+			m_batchDone.notify_all();
+		} else {
+			std::lock_guard<std::mutex> outputLock(m_outputMutex);
+			storeAsyncResult(flushFileIfDue());
+		}
+	}
+
+	std::lock_guard<std::mutex> outputLock(m_outputMutex);
+	storeAsyncResult(flushFile());
+}
+
+void Logger::writeBatch(const size_t start, const size_t end) {
+
+	// Move the records out of the queue, so that producers can reuse the slots
+	Slot* slot = 0;
+	for( size_t pos = start; pos != end; ++pos ) {
+		slot = m_queue + (pos & m_queueMask);
+		m_batch.push_back(Record());
+		std::swap(m_batch.back(), slot->record);
+		slot->sequence.store(pos + m_queueMask + 1, std::memory_order_release);
+	}
+
+	// Open the primary log file once for the whole batch, in the SHARED append mode
+	bool opened = false;
+	if( m_defaultLogFileOpen && !m_logfile.is_open() &&
+		!m_holdAndReplaceFile && m_appendMode == AppendMode::SHARED ) {
+		m_logfile.open(m_filename, std::ios::app);
+		opened = m_logfile.is_open();
+	}
+
+	HRESULT result = ERROR_SUCCESS;
+	for( std::vector<Record>::const_iterator it = m_batch.cbegin(); it != m_batch.cend(); ++it ) {
+		if( it->bulk ) {
+			result = formatAndOutput(it->time, it->timestampEnabled,
+				it->msgs.cbegin(), it->msgs.cend(), it->msg,
+				it->toConsole, it->toFile, it->filename);
+		} else {
+			result = formatAndOutput(it->time, it->timestampEnabled, 0, it->msg,
+				it->toConsole, it->toFile, it->filename);
+		}
+		storeAsyncResult(result);
+	}
+	m_batch.clear();
+
+	const size_t nDropped = m_nDroppedUnreported.exchange(0);
+	if( nDropped > 0 ) {
+		result = formatAndOutput(Timestamper::now(), m_timestampEnabled, 0,
+			L"Logger: " + std::to_wstring(nDropped) +
+			L" message(s) discarded because the asynchronous logging queue was full.",
+			true, true, L"");
+		storeAsyncResult(result);
+	}
+
+	if( opened ) {
+		m_logfile.close();
+	}
+}
+
+void Logger::storeAsyncResult(const HRESULT result) {
+	if( FAILED(result) ) {
+		HRESULT expected = ERROR_SUCCESS;
+		m_asyncResult.compare_exchange_strong(expected, result);
+	}
+}
+
+HRESULT Logger::flushFile(void) {
+	m_lastFileFlush = GetTickCount();
+
+	HRESULT result = ERROR_SUCCESS;
+	std::list<SecondaryFile>::iterator end = m_secondaryFiles.end();
+	for( std::list<SecondaryFile>::iterator it = m_secondaryFiles.begin(); it != end; ++it ) {
+		HRESULT tempResult = flushSecondaryFile(*it);
+		if( FAILED(tempResult) ) {
+			result = tempResult;
+		}
+	}
+
+	if( m_rotationThread != 0 ) {
+		// Convert the messages first, so that the size limit is compared with a number of bytes
+		narrowForFile(m_narrowBuffer, m_fileBuffer, m_logfile.getloc());
+		m_fileBuffer.clear();
+
+		// Rotate before writing, if the messages would take the file past the size limit
+		if( m_segmentSize > 0 &&
+			((m_rotationSize > 0 && (m_segmentSize + m_narrowBuffer.size()) > m_rotationSize) ||
+			(m_rotationInterval > 0 && (GetTickCount() - m_segmentStart) >= m_rotationInterval)) ) {
+			rotateFile();
+		}
+
+		if( !m_narrowBuffer.empty() ) {
+			DWORD nWritten = 0;
+			if( m_segmentHandle == INVALID_HANDLE_VALUE ||
+				!WriteFile(m_segmentHandle, m_narrowBuffer.data(), static_cast<DWORD>(m_narrowBuffer.size()), &nWritten, NULL) ) {
+				result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WINDOWS_CALL);
+			}
+			m_segmentSize += nWritten;
+			m_narrowBuffer.clear();
+		}
+
+		// Report failures from the background thread
+		std::lock_guard<std::mutex> lock(m_rotationMutex);
+		if( FAILED(m_rotationResult) ) {
+			result = m_rotationResult;
+			m_rotationResult = ERROR_SUCCESS;
+		}
+		return result;
+	}
+
+	if( !m_fileBuffer.empty() ) {
+		if( !m_logfile.is_open() ) {
+			m_logfile.open(m_filename, std::ios::app);
+			if( !m_logfile.is_open() ) {
+				// Discard the messages, rather than letting the buffer grow without bound
+				m_fileBuffer.clear();
+				return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FILE_NOT_FOUND);
+			}
+		}
+		m_logfile << m_fileBuffer;
+		m_fileBuffer.clear();
+	}
+	if( m_logfile.is_open() ) {
+		m_logfile.flush();
+	}
+	return result;
+}
+
+HRESULT Logger::getSecondaryFileBuffer(wstring*& buffer, const wstring& filename) {
+	std::list<SecondaryFile>::iterator end = m_secondaryFiles.end();
+	for( std::list<SecondaryFile>::iterator it = m_secondaryFiles.begin(); it != end; ++it ) {
+		if( it->filename == filename ) {
+			if( it != m_secondaryFiles.begin() ) {
+				m_secondaryFiles.splice(m_secondaryFiles.begin(), m_secondaryFiles, it);
+			}
+			buffer = &m_secondaryFiles.front().buffer;
+			return ERROR_SUCCESS;
+		}
+	}
+
+	// Close the least recently used file to make room
+	HRESULT result = ERROR_SUCCESS;
+	if( m_secondaryFiles.size() >= LOGGER_SECONDARY_FILE_CACHE_SIZE ) {
+		result = flushSecondaryFile(m_secondaryFiles.back());
+		m_secondaryFiles.pop_back();
+	}
+
+	m_secondaryFiles.emplace_front();
+	SecondaryFile& file = m_secondaryFiles.front();
+	file.file.open(filename, std::ios::app);
+	if( !file.file.is_open() ) {
+		m_secondaryFiles.pop_front();
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FILE_NOT_FOUND);
+	}
+	file.filename = filename;
+	buffer = &file.buffer;
+	return result;
+}
+
+HRESULT Logger::flushSecondaryFile(SecondaryFile& file) {
+	if( !file.buffer.empty() ) {
+		file.file << file.buffer;
+		file.buffer.clear();
+	}
+	file.file.flush();
+	if( !file.file.good() ) {
+		file.file.clear();
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	return ERROR_SUCCESS;
+}
+
+HRESULT Logger::closeSecondaryFiles(void) {
+	HRESULT result = ERROR_SUCCESS;
+	while( !m_secondaryFiles.empty() ) {
+		HRESULT tempResult = flushSecondaryFile(m_secondaryFiles.front());
+		if( FAILED(tempResult) ) {
+			result = tempResult;
+		}
+		m_secondaryFiles.pop_front();
+	}
+	return result;
+}
+
+HRESULT Logger::flushFileIfDue(void) {
+	if( m_fileBuffer.size() >= m_fileBufferSize ||
+		(GetTickCount() - m_lastFileFlush) >= m_fileFlushInterval ||
+		isRotationDue() ||
+		(m_fileShared.load() && !m_fileBuffer.empty()) ) {
+		return flushFile();
+	}
+	return ERROR_SUCCESS;
+}
+
+void Logger::flushPeriodically(void) {
+	std::unique_lock<std::mutex> lock(s_flushMutex);
+	while( !s_flushStop ) {
+		s_flushWork.wait_for(lock, std::chrono::milliseconds(LOGGER_FLUSH_CHECK_MS));
+		if( s_flushStop ) {
+			break;
+		}
+
+		/* Loggers cannot be removed from the list while it is locked,
+		   and their output locks are always acquired after the list's lock
+		 */
+		std::list<Logger*>::iterator end = s_flushLoggers.end();
+		for( std::list<Logger*>::iterator it = s_flushLoggers.begin(); it != end; ++it ) {
+			std::lock_guard<std::mutex> outputLock((*it)->m_outputMutex);
+			(*it)->storeAsyncResult((*it)->flushFileIfDue());
+		}
+	}
+}
+
+void Logger::addToFlushThread(void) {
+	std::lock_guard<std::mutex> threadLock(s_flushThreadMutex);
+	if( m_flushRegistered.load() ) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(s_flushMutex);
+		s_flushLoggers.push_back(this);
+		s_flushStop = false;
+	}
+	m_flushRegistered.store(true);
+
+	if( s_flushThread == 0 ) {
+		try {
+			s_flushThread = new std::thread(&Logger::flushPeriodically);
+		} catch( ... ) {
+			// Messages will still be written when later messages are logged
+			s_flushThread = 0;
+		}
+	}
+}
+
+void Logger::removeFromFlushThread(void) {
+	std::lock_guard<std::mutex> threadLock(s_flushThreadMutex);
+	if( !m_flushRegistered.load() ) {
+		return;
+	}
+	bool stop = false;
+	{
+		std::lock_guard<std::mutex> lock(s_flushMutex);
+		s_flushLoggers.remove(this);
+		stop = s_flushLoggers.empty();
+		s_flushStop = stop;
+	}
+	m_flushRegistered.store(false);
+
+	if( stop && s_flushThread != 0 ) {
+		s_flushWork.notify_one();
+		s_flushThread->join();
+		delete s_flushThread;
+		s_flushThread = 0;
+	}
+}
+
+void Logger::addFileUser(void) {
+	if( FAILED(fileUtil::fullPath(m_fileKey, m_filename)) ) {
+		m_fileKey = m_filename;
+	}
+	std::transform(m_fileKey.begin(), m_fileKey.end(), m_fileKey.begin(), towlower);
+
+	std::lock_guard<std::mutex> lock(s_fileUsersMutex);
+	std::list<Logger*>& users = s_fileUsers[m_fileKey];
+	users.push_back(this);
+	if( users.size() > 1 ) {
+		std::list<Logger*>::iterator end = users.end();
+		for( std::list<Logger*>::iterator it = users.begin(); it != end; ++it ) {
+			(*it)->m_fileShared.store(true);
+		}
+	}
+}
+
+void Logger::removeFileUser(void) {
+	if( m_fileKey.empty() ) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(s_fileUsersMutex);
+	std::map<wstring, std::list<Logger*> >::iterator users = s_fileUsers.find(m_fileKey);
+	if( users != s_fileUsers.end() ) {
+		users->second.remove(this);
+		if( users->second.empty() ) {
+			s_fileUsers.erase(users);
+		} else if( users->second.size() == 1 ) {
+			users->second.front()->m_fileShared.store(false);
+		}
+	}
+	m_fileKey.clear();
+}
+
+bool Logger::isRotationDue(void) const {
+	if( m_rotationThread == 0 ) {
+		return false;
+	}
+	const ULONGLONG size = m_segmentSize + m_fileBuffer.size();
+	if( m_segmentSize == 0 || size == 0 ) {
+		// The messages will be written to the file, regardless of its size
+		return false;
+	}
+	return (m_rotationSize > 0 && size > m_rotationSize) ||
+		(m_rotationInterval > 0 && (GetTickCount() - m_segmentStart) >= m_rotationInterval);
+}
+
+void Logger::rotateFile(void) {
+	{
+		std::lock_guard<std::mutex> lock(m_rotationMutex);
+		if( m_archivePending || m_spareHandle == INVALID_HANDLE_VALUE ) {
+			// Postpone rotation, rather than waiting for the background thread
+			return;
+		}
+		m_retiredHandle = m_segmentHandle;
+		m_segmentHandle = m_spareHandle;
+		m_spareHandle = INVALID_HANDLE_VALUE;
+		m_archivePending = true;
+		m_spareNeeded = true;
+	}
+	m_segmentSize = 0;
+	m_segmentStart = GetTickCount();
+	m_rotationWork.notify_one();
+}
+
+void Logger::archive(void) {
+	bool archivePending = false;
+	bool spareNeeded = false;
+	bool stop = false;
+	HANDLE retired = INVALID_HANDLE_VALUE;
+	HANDLE spare = INVALID_HANDLE_VALUE;
+	HRESULT result = ERROR_SUCCESS;
+
+	/* True if the current file still has the temporary name of the next file,
+	   because the previous file could not be archived
+	 */
+	bool renamePending = false;
+
+	while( !stop ) {
+		{
+			std::unique_lock<std::mutex> lock(m_rotationMutex);
+			while( !m_archivePending && !m_spareNeeded && !m_rotationStop ) {
+				if( m_spareHandle == INVALID_HANDLE_VALUE ) {
+					// Try again to prepare the next file, after a failure
+					if( m_rotationWork.wait_for(lock, std::chrono::milliseconds(LOGGER_ROTATION_RETRY_MS)) ==
+						std::cv_status::timeout ) {
+						m_spareNeeded = true;
+					}
+				} else {
+					m_rotationWork.wait(lock);
+				}
+			}
+			archivePending = m_archivePending;
+			retired = m_retiredHandle;
+			m_retiredHandle = INVALID_HANDLE_VALUE;
+			spareNeeded = m_spareNeeded && !m_rotationStop;
+			m_spareNeeded = false;
+			stop = m_rotationStop;
+		}
+
+		// File system operations are performed without holding the lock
+		result = ERROR_SUCCESS;
+		if( archivePending ) {
+			if( retired != INVALID_HANDLE_VALUE ) {
+				CloseHandle(retired);
+			}
+			renamePending = true;
+		}
+
+		/* Until the current file has been renamed, it occupies the name of the next file,
+		   so no next file is prepared, and the loop above wakes periodically to try again
+		 */
+		if( renamePending ) {
+			bool renamed = false;
+			result = archiveSegment(renamed);
+			renamePending = !renamed;
+		}
+		spare = INVALID_HANDLE_VALUE;
+		if( spareNeeded && !renamePending ) {
+			spare = createSpareFile();
+			if( spare == INVALID_HANDLE_VALUE && SUCCEEDED(result) ) {
+				result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WINDOWS_CALL);
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_rotationMutex);
+			if( archivePending ) {
+				m_archivePending = false;
+			}
+			if( spare != INVALID_HANDLE_VALUE ) {
+				m_spareHandle = spare;
+			}
+			if( FAILED(result) && SUCCEEDED(m_rotationResult) ) {
+				m_rotationResult = result;
+			}
+		}
+	}
+}
+
+HRESULT Logger::archiveSegment(bool& renamed) {
+	renamed = false;
+	HRESULT result = ERROR_SUCCESS;
+	if( GetFileAttributes(m_filename.c_str()) == INVALID_FILE_ATTRIBUTES ) {
+		// Archived by an earlier call, which failed to rename the next file
+	} else if( m_nRotationSegments == 0 ) {
+		if( !DeleteFile(m_filename.c_str()) ) {
+			return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WINDOWS_CALL);
+		}
+	} else {
+		// Shift the existing segments (some of which may not exist) to make room
+		wstring older = segmentFilename(m_filename, std::to_wstring(m_nRotationSegments));
+		wstring newer;
+		DeleteFile(older.c_str());
+		for( unsigned int i = m_nRotationSegments - 1; i > 0; --i ) {
+			newer = segmentFilename(m_filename, std::to_wstring(i));
+			if( !MoveFileEx(newer.c_str(), older.c_str(), MOVEFILE_REPLACE_EXISTING) &&
+				GetLastError() != ERROR_FILE_NOT_FOUND ) {
+				result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WINDOWS_CALL);
+			}
+			older.swap(newer);
+		}
+
+		// 'older' is now the name of the most recent segment
+		if( !MoveFileEx(m_filename.c_str(), older.c_str(), MOVEFILE_REPLACE_EXISTING) ) {
+			// The next file keeps its temporary name until a later call succeeds
+			return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WINDOWS_CALL);
+		}
+	}
+
+	// (The next file was opened with FILE_SHARE_DELETE, so it can be renamed while it is being written)
+	if( !MoveFileEx(m_spareFilename.c_str(), m_filename.c_str(), 0) ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WINDOWS_CALL);
+	}
+	renamed = true;
+	return result;
+}
+
+HANDLE Logger::createSpareFile(void) {
+	// The sharing mode allows the file to be renamed while the handle is open
+	HANDLE file = CreateFile(m_spareFilename.c_str(), GENERIC_WRITE,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		NULL, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
+	if( file == INVALID_HANDLE_VALUE || m_rotationSize == 0 ) {
+		return file;
+	}
+
+	/* Reserve disk space without changing the end of the file.
+	   Failure (e.g. if the file system does not support it) is ignored,
+	   as the file can still be appended to.
+	 */
+	FILE_ALLOCATION_INFO allocation;
+	allocation.AllocationSize.QuadPart = static_cast<LONGLONG>(m_rotationSize);
+	SetFileInformationByHandle(file, FileAllocationInfo, &allocation, sizeof(allocation));
+	return file;
+}
+
+HRESULT Logger::stopRotation(void) {
+	if( m_rotationThread == 0 ) {
+		return ERROR_SUCCESS;
+	}
+
+	// The background thread archives any pending segment before exiting
+	{
+		std::lock_guard<std::mutex> lock(m_rotationMutex);
+		m_rotationStop = true;
+	}
+	m_rotationWork.notify_one();
+	m_rotationThread->join();
+	delete m_rotationThread;
+	m_rotationThread = 0;
+
+	if( m_spareHandle != INVALID_HANDLE_VALUE ) {
+		CloseHandle(m_spareHandle);
+		m_spareHandle = INVALID_HANDLE_VALUE;
+		DeleteFile(m_spareFilename.c_str());
+	}
+	if( m_segmentHandle != INVALID_HANDLE_VALUE ) {
+		CloseHandle(m_segmentHandle);
+		m_segmentHandle = INVALID_HANDLE_VALUE;
+	}
+	m_spareNeeded = false;
+	m_narrowBuffer.clear();
+	m_narrowBuffer.shrink_to_fit();
+
+	const HRESULT result = m_rotationResult;
+	m_rotationResult = ERROR_SUCCESS;
+	return result;
 }
\ No newline at end of file
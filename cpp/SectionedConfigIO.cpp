@@ -0,0 +1,492 @@
+/*
+SectionedConfigIO.cpp
+---------------------
+
+Created for: Spring 2014 Direct3D 11 Learning
+By: Bernard Llanos
+August 16, 2014
+
+Primary basis: FlatAtomicConfigIO.cpp
+Other references: None
+
+Development environment: Visual Studio 2013 running on Windows 7, 64-bit
+  -Note that the "Character Set" project property (Configuration Properties > General)
+   should be set to Unicode for all configurations, when using Visual Studio.
+
+Description
+  -Implementation of the SectionedConfigIO class
+*/
+
+#include "SectionedConfigIO.h"
+#include "textProcessing.h"
+#include "defs.h"
+#include "globals.h"
+#include "fileUtil.h"
+#include <fstream>
+#include <cstring>
+
+using std::to_wstring;
+using std::string;
+using std::wstring;
+using namespace textProcessing;
+
+SectionedConfigIO::SectionedConfigIO(void) :
+LogUser(true, L"SectionedConfigIO >"), m_outputContext(true),
+m_sectionScope(), m_sectionType(0), m_sectionValid(true),
+m_field(), m_parseMsg(), m_valueBuffer(), m_typeCounts()
+{}
+
+SectionedConfigIO::~SectionedConfigIO(void) {}
+
+bool SectionedConfigIO::toggleContextOutput(const bool outputContext) {
+	bool previousState = m_outputContext;
+	m_outputContext = outputContext;
+	return previousState;
+}
+
+HRESULT SectionedConfigIO::read(const wstring& filename, Config& config) {
+
+	setMsgPrefix(L"SectionedConfigIO reading " + filename + L" >");
+
+	HANDLE fileHandle = INVALID_HANDLE_VALUE;
+	HANDLE mappingHandle = NULL;
+	const char* data = 0;
+	size_t size = 0;
+	HRESULT result = fileUtil::mapFile(filename, fileHandle, mappingHandle, data, size);
+	if( FAILED(result) ) {
+		LOGUSER_ERROR(L"Unable to open or map the file.");
+		return result;
+	}
+
+	// Lines before the first section header belong to the empty scope
+	m_sectionScope.clear();
+	m_sectionType = 0;
+	m_sectionValid = true;
+
+	char line[SECTIONEDCONFIGIO_LINE_BUFFER_LENGTH];
+	const char* current = data;
+	const char* const dataEnd = data + size;
+	const char* lineEnd = 0;
+	size_t length = 0;
+	size_t lineNumber = 0;
+	HRESULT lineResult = ERROR_SUCCESS;
+
+	while( current < dataEnd ) {
+		++lineNumber;
+		lineEnd = static_cast<const char*>(memchr(current, SECTIONEDCONFIGIO_LINE_SEP, dataEnd - current));
+		if( lineEnd == 0 ) {
+			lineEnd = dataEnd;
+		}
+		length = lineEnd - current;
+
+		// Catch line length violations
+		if( length >= SECTIONEDCONFIGIO_LINE_BUFFER_LENGTH - 1 ) {
+			m_msgStore.emplace_back(L"Line " + to_wstring(lineNumber) +
+				L": line exceeds the maximum line length of " +
+				to_wstring(SECTIONEDCONFIGIO_MAX_LINE_LENGTH) + L" characters. Aborting read operation.");
+			result = MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+			break;
+		}
+		memcpy(line, current, length);
+		line[length] = '\0';
+
+		lineResult = readLine(config, line, lineNumber);
+		if( FAILED(lineResult) ) {
+			LOGUSER_ERROR(L"readLine() returned a failure code - Aborting read operation.");
+			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+			break;
+		} else if( HRESULT_CODE(lineResult) == ERROR_DATA_INCOMPLETE ) {
+			result = lineResult;
+		}
+		current = lineEnd + 1;
+	}
+
+	if( FAILED(fileUtil::unmapFile(fileHandle, mappingHandle, data)) ) {
+		LOGUSER_ERROR(L"Failed to unmap the file.");
+		result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+
+	if( m_msgStore.empty() ) {
+		LOGUSER_INFO(L"File reading complete - No invalid or unsupported data.");
+	} else {
+		LOGUSER_WARNING(L"File reading complete - Problems encountered:");
+		logMsgStore(LOG_LEVEL_WARNING);
+	}
+	return result;
+}
+
+HRESULT SectionedConfigIO::readLine(Config& config, char* const str, const size_t lineNumber) {
+
+	/* This prefix will be part of error/warning messages that are stored in the message list.
+	   (It is only created when needed, as most lines are read without problems.)
+	 */
+#define READLINE_PREFIX (L"Line " + to_wstring(lineNumber) + L": ")
+
+	// Strip whitespace and control characters
+	char ignoreInStrLiteral[] = { ' ' }; // Characters to be preserved between matching double quotes
+	if( FAILED(remove_ASCII_controlAndWhitespace(str, 0, 0, QUOTES, ignoreInStrLiteral, sizeof(ignoreInStrLiteral) / sizeof(char))) ) {
+		m_msgStore.emplace_back(READLINE_PREFIX + L"remove_ASCII_controlAndWhitespace() failed.");
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+
+	// Check for blank and comment lines
+	if( *str == '\0' || hasPrefix(str, SECTIONEDCONFIGIO_COMMENT_SEP) ) {
+		return ERROR_SUCCESS;
+	}
+
+	size_t index = 0;
+
+	// Parse a section header
+	// ----------------------
+	if( hasPrefix(str, SECTIONEDCONFIGIO_SECTION_START) ) {
+		m_sectionValid = false;
+		if( !hasSubstr(str, SECTIONEDCONFIGIO_SECTION_END, index) ) {
+			m_msgStore.emplace_back(READLINE_PREFIX +
+				L"no separator found to mark the end of the section scope. Lines in the section will be ignored.");
+			return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+
+		// The default datatype, if any, follows the end of the scope
+		const char* const typeName = str + index + strlen(SECTIONEDCONFIGIO_SECTION_END);
+		m_sectionType = 0;
+		if( *typeName != '\0' ) {
+			m_sectionType = Config::getDataTypeInfo(typeName, strlen(typeName));
+			if( m_sectionType == 0 ) {
+				m_msgStore.emplace_back(READLINE_PREFIX +
+					L"no datatype found that corresponds to the default datatype of the section."
+					L" Lines in the section will be ignored.");
+				return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+			}
+		}
+
+		str[index] = '\0';
+		if( FAILED(toWString(m_sectionScope, str + strlen(SECTIONEDCONFIGIO_SECTION_START))) ) {
+			m_msgStore.emplace_back(READLINE_PREFIX + L"failed to convert the section scope to a wide-character string.");
+			return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+		}
+		m_sectionValid = true;
+		return ERROR_SUCCESS;
+	}
+
+	if( !m_sectionValid ) {
+		m_msgStore.emplace_back(READLINE_PREFIX + L"line ignored, as it belongs to an invalid section.");
+		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	// At this point, the line must be either a data line or garbage
+	// -------------------------------------------------------------
+
+	// Separate the key from the value
+	size_t valueIndex = 0;
+	if( !hasSubstr(str, SECTIONEDCONFIGIO_VALUE_SEP, valueIndex) ) {
+		m_msgStore.emplace_back(READLINE_PREFIX + L"no separator found to mark the end of the key field.");
+		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+	str[valueIndex] = '\0';
+	const char* const valueStr = str + valueIndex + strlen(SECTIONEDCONFIGIO_VALUE_SEP);
+
+	// Parse an explicit datatype (without copying the specifier), or use the section's default
+	const Config::DataTypeInfo* info = m_sectionType;
+	const char* field = str;
+	if( hasSubstr(str, SECTIONEDCONFIGIO_TYPE_SEP, index) ) {
+		info = Config::getDataTypeInfo(str, index);
+		if( info == 0 ) {
+			m_msgStore.emplace_back(READLINE_PREFIX + L"no datatype found that corresponds to the datatype specifier.");
+			return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+		field += index + strlen(SECTIONEDCONFIGIO_TYPE_SEP);
+	} else if( info == 0 ) {
+		m_msgStore.emplace_back(READLINE_PREFIX +
+			L"no datatype specifier found, and the section does not have a default datatype.");
+		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	if( *field == '\0' ) {
+		m_msgStore.emplace_back(READLINE_PREFIX + L"empty key field.");
+		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+	/* Whitespace stripping leaves only printable ASCII characters outside of
+	   double quotes, so the field can be widened character-by-character
+	 */
+	m_field.assign(field, field + strlen(field));
+
+	// Parse the value
+	const void* value = 0;
+	size_t parsedLength = 0;
+	m_parseMsg.clear();
+	HRESULT parseResult = info->parse(valueStr, value, parsedLength, m_parseMsg);
+	if( FAILED(parseResult) ) {
+		m_msgStore.emplace_back(READLINE_PREFIX +
+			L"the function for parsing the data value returned a failure result.");
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	} else if( HRESULT_CODE(parseResult) == ERROR_DATA_INCOMPLETE ) {
+		m_msgStore.emplace_back(READLINE_PREFIX + L"no valid " + info->wName +
+			L" data value found. The parsing function reported \"" + m_parseMsg + L"\"");
+		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	// Insert the data, sharing the scope string of the section
+	Config::Value* valueObject = new Config::Value(info->type, value);
+	HRESULT insertResult = config.insert(m_sectionScope, m_field, valueObject);
+	if( insertResult != ERROR_SUCCESS ) {
+		delete valueObject;
+	}
+
+	if( !m_parseMsg.empty() ) {
+		m_msgStore.emplace_back(READLINE_PREFIX +
+			L"the function for parsing the " + info->wName + L" data value reported \"" +
+			m_parseMsg + L"\"");
+	}
+
+	if( HRESULT_CODE(insertResult) == ERROR_ALREADY_ASSIGNED ) {
+		m_msgStore.emplace_back(READLINE_PREFIX +
+			L"There is already a value stored in the Config object under the given key scope and field."
+			L" Either this key was repeated in the file,"
+			L" or was already present in the Config object before this file was read.");
+		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	} else if( FAILED(insertResult) ) {
+		m_msgStore.emplace_back(READLINE_PREFIX +
+			L"a serious error occured when attempting to insert the key-data value pair into the Config object.");
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+
+		// Check if the entire line was parsed
+	} else if( valueStr[parsedLength] != '\0' ) {
+		m_msgStore.emplace_back(READLINE_PREFIX +
+			L"the function for parsing the data value section of the line did not convert the entire rest of the line into a data value.");
+		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	return ERROR_SUCCESS;
+
+#undef READLINE_PREFIX
+}
+
+HRESULT SectionedConfigIO::write(const wstring& filename, const Config& config, const bool overwrite) {
+
+	setMsgPrefix(L"SectionedConfigIO writing to " + filename + L" >");
+
+	// Initialization of the data stream
+	std::map<Config::Key, Config::Value*>::const_iterator currentPair = config.cbegin();
+	std::map<Config::Key, Config::Value*>::const_iterator end = config.cend();
+	if( currentPair == end ) {
+		LOGUSER_WARNING(L"Config object is empty - Nothing to write.");
+		return ERROR_SUCCESS;
+	}
+
+	// Output is encoded as UTF-8 by this object (see FlatAtomicConfigIO::write())
+	std::ofstream file;
+	if( overwrite ) {
+		file.open(filename, std::ofstream::out);
+	} else {
+		file.open(filename, std::ofstream::app);
+	}
+	if( !file.is_open() ) {
+		LOGUSER_ERROR(L"Unable to open the file.");
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FILE_NOT_FOUND);
+	}
+
+	// Lines are formatted into 'line', and then encoded into 'buffer'
+	wstring line;
+	line.reserve(SECTIONEDCONFIGIO_LINE_BUFFER_LENGTH);
+	std::string buffer;
+	buffer.reserve(SECTIONEDCONFIGIO_WRITE_BUFFER_LENGTH + SECTIONEDCONFIGIO_LINE_BUFFER_LENGTH * 4);
+
+	// Begin output
+	wstring time;
+	if( FAILED(Logger::getDateAndTime(time)) ) {
+		time = L"Failed to get time ";
+	}
+	line = SECTIONEDCONFIGIO_COMMENT_SEP_WSTR L" " SECTIONEDCONFIGIO_START_OUTPUT
+		L" SectionedConfigIO instance Config output ( ";
+	line += time;
+	line += L")" SECTIONEDCONFIGIO_LINE_SEP_WSTR;
+	textProcessing::appendUTF8(buffer, line.c_str(), line.length());
+
+	HRESULT result = ERROR_SUCCESS;
+	HRESULT lineResult = ERROR_SUCCESS;
+	bool notGood = false;
+	std::map<Config::Key, Config::Value*>::const_iterator sectionEnd;
+	const Config::DataTypeInfo* defaultType = 0;
+
+	// Process each scope
+	while( currentPair != end && !notGood ) {
+		defaultType = scanSection(currentPair, end, sectionEnd);
+		const wstring& scope = currentPair->first.getScope();
+
+		if( scope.find(SECTIONEDCONFIGIO_SECTION_END_WSTR) != wstring::npos ) {
+			m_msgStore.emplace_back(L"Scope \"" + scope +
+				L"\" contains the section header terminator, and cannot be written.");
+			result = MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+			currentPair = sectionEnd;
+			continue;
+		}
+
+		buffer += SECTIONEDCONFIGIO_LINE_SEP;
+		writeSectionHeader(line, scope, defaultType);
+		textProcessing::appendUTF8(buffer, line.c_str(), line.length());
+		buffer += SECTIONEDCONFIGIO_LINE_SEP;
+
+		while( currentPair != sectionEnd ) {
+			lineResult = writeDataLine(line, currentPair, defaultType);
+			if( FAILED(lineResult) ) {
+				LOGUSER_ERROR(L"writeDataLine() returned a failure code - Aborting write operation.");
+				result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+				notGood = true;
+				break;
+			} else if( HRESULT_CODE(lineResult) == ERROR_DATA_INCOMPLETE ) {
+				result = lineResult;
+			} else {
+				textProcessing::appendUTF8(buffer, line.c_str(), line.length());
+				buffer += SECTIONEDCONFIGIO_LINE_SEP;
+			}
+			++currentPair;
+
+			if( buffer.length() >= SECTIONEDCONFIGIO_WRITE_BUFFER_LENGTH ) {
+				file.write(buffer.c_str(), buffer.length());
+				buffer.clear();
+				if( !file.good() ) {
+					notGood = true;
+					LOGUSER_ERROR(L"File stream good() function returned false - Aborting write operation.");
+					result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+					break;
+				}
+			}
+		}
+	}
+
+	if( !notGood ) {
+		// Write the configuration format to the file for reference
+		if( m_outputContext ) {
+			buffer += SECTIONEDCONFIGIO_LINE_SEP;
+			line = SECTIONEDCONFIGIO_DATA_FORMATSPEC;
+			textProcessing::appendUTF8(buffer, line.c_str(), line.length());
+			buffer += SECTIONEDCONFIGIO_LINE_SEP;
+		}
+
+		// End the output
+		line = SECTIONEDCONFIGIO_COMMENT_SEP_WSTR L" " SECTIONEDCONFIGIO_END_OUTPUT
+			L" SectionedConfigIO instance Config output ( ";
+		line += time;
+		line += L")";
+		textProcessing::appendUTF8(buffer, line.c_str(), line.length());
+
+		file.write(buffer.c_str(), buffer.length());
+		if( !file.good() ) {
+			LOGUSER_ERROR(L"File stream good() function returned false when ending the configuration output.");
+			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+		}
+	}
+
+	file.close();
+
+	if( m_msgStore.empty() ) {
+		LOGUSER_INFO(L"Config object writing complete - No invalid or unsupported data.");
+	} else {
+		LOGUSER_WARNING(L"Config object writing complete - Problems encountered:");
+		logMsgStore(LOG_LEVEL_WARNING);
+	}
+	return result;
+}
+
+void SectionedConfigIO::writeSectionHeader(wstring& str, const wstring& scope,
+	const Config::DataTypeInfo* const defaultType) const {
+
+	str = SECTIONEDCONFIGIO_SECTION_START_WSTR;
+	str += scope;
+	str += SECTIONEDCONFIGIO_SECTION_END_WSTR;
+	if( defaultType != 0 ) {
+		str += SECTIONEDCONFIGIO_WHITESPACE_SEP;
+		str.append(defaultType->wName, defaultType->nameLength);
+	}
+}
+
+HRESULT SectionedConfigIO::writeDataLine(wstring& str,
+	const std::map<Config::Key, Config::Value*>::const_iterator& data,
+	const Config::DataTypeInfo* const defaultType) {
+
+	// An empty string will be output in case of errors
+	str.clear();
+
+	const Config::DataType dataType = data->second->getDataType();
+	const wstring& field = data->first.getField();
+	const void* const value = data->second->getValue(dataType);
+
+#define WRITEDATALINE_PREFIX (L"Key (scope, field) = (" + data->first.getScope() + L", " + field + L"): ")
+
+	// Check for values which could not be decoded (see Config::Value)
+	if( value == 0 ) {
+		m_msgStore.emplace_back(WRITEDATALINE_PREFIX + L"invalid data value: " + data->second->getDecodeMessage());
+		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	// Check for fields which would be misinterpreted when read
+	if( field.empty() || field.compare(0, 1, SECTIONEDCONFIGIO_SECTION_START_WSTR) == 0 ||
+		field.find(SECTIONEDCONFIGIO_TYPE_SEP_WSTR) != wstring::npos ||
+		field.find(SECTIONEDCONFIGIO_VALUE_SEP_WSTR) != wstring::npos ) {
+		m_msgStore.emplace_back(WRITEDATALINE_PREFIX + L"the field cannot be represented in this file format.");
+		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	const Config::DataTypeInfo* const info = Config::getDataTypeInfo(dataType);
+	if( info == 0 ) {
+		wstring msg = WRITEDATALINE_PREFIX +
+			L"no descriptor was found for the data type. Code is broken.";
+		m_msgStore.emplace_back(msg);
+		LOGUSER_ERROR(msg);
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_BROKEN_CODE);
+	}
+
+	// The datatype is omitted if it is the default datatype of the section
+	if( info != defaultType ) {
+		str.append(info->wName, info->nameLength);
+		str += SECTIONEDCONFIGIO_TYPE_SEP_WSTR;
+	}
+	str += field;
+	str += SECTIONEDCONFIGIO_WHITESPACE_SEP SECTIONEDCONFIGIO_VALUE_SEP_WSTR SECTIONEDCONFIGIO_WHITESPACE_SEP;
+
+	if( FAILED(info->format(str, value, m_valueBuffer)) ) {
+		str.clear();
+		m_msgStore.emplace_back(WRITEDATALINE_PREFIX +
+			L"the function for serializing the data value to a string returned a failure result.");
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+
+	// Catch line length violations
+	if( str.length() > SECTIONEDCONFIGIO_MAX_LINE_LENGTH ) {
+		m_msgStore.emplace_back(WRITEDATALINE_PREFIX + L"line length is too long to be read by this class's file parser.");
+		str.clear();
+		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+	return ERROR_SUCCESS;
+
+#undef WRITEDATALINE_PREFIX
+}
+
+const Config::DataTypeInfo* SectionedConfigIO::scanSection(
+	const std::map<Config::Key, Config::Value*>::const_iterator& start,
+	const std::map<Config::Key, Config::Value*>::const_iterator& end,
+	std::map<Config::Key, Config::Value*>::const_iterator& sectionEnd) {
+
+	m_typeCounts.assign(m_typeCounts.size(), 0);
+	const wstring& scope = start->first.getScope();
+	size_t index = 0;
+	size_t maxCount = 0;
+	Config::DataType maxType = Config::DataType::WSTRING;
+
+	// Keys are ordered by scope, so the values in the scope are contiguous
+	for( sectionEnd = start; sectionEnd != end && sectionEnd->first.getScope() == scope; ++sectionEnd ) {
+		index = static_cast<size_t>(sectionEnd->second->getDataType());
+		if( index >= m_typeCounts.size() ) {
+			m_typeCounts.resize(index + 1, 0);
+		}
+		if( ++m_typeCounts[index] > maxCount ) {
+			maxCount = m_typeCounts[index];
+			maxType = sectionEnd->second->getDataType();
+		}
+	}
+
+	if( maxCount == 0 ) {
+		return 0;
+	}
+	return Config::getDataTypeInfo(maxType);
+}
\ No newline at end of file
@@ -0,0 +1,252 @@
+/*
+Timestamper.cpp
+---------------
+
+Created for: Spring 2014 Direct3D 11 Learning
+By: Bernard Llanos
+August 18, 2014
+
+Primary basis: None
+Other references: None
+
+Development environment: Visual Studio 2013 running on Windows 7, 64-bit
+  -Note that the "Character Set" project property (Configuration Properties > General)
+   should be set to Unicode for all configurations, when using Visual Studio.
+
+Description
+  -Implementation of the Timestamper class
+*/
+
+#include "Timestamper.h"
+#include "defs.h"
+
+using std::wstring;
+
+// Number of 100-nanosecond intervals (FILETIME units) per second
+#define TIMESTAMPER_TICKS_PER_SECOND 10000000LL
+
+// Time, in seconds, after which the anchor is renewed
+#define TIMESTAMPER_ANCHOR_INTERVAL 60
+
+static const wchar_t* const s_dayNames[] = {
+	L"Sun", L"Mon", L"Tue", L"Wed", L"Thu", L"Fri", L"Sat"
+};
+
+static const wchar_t* const s_monthNames[] = {
+	L"Jan", L"Feb", L"Mar", L"Apr", L"May", L"Jun",
+	L"Jul", L"Aug", L"Sep", L"Oct", L"Nov", L"Dec"
+};
+
+/* Writes the value as 'nDigits' decimal digits, with leading zeros
+   (or leading spaces, if 'pad' is a space)
+ */
+static void writeDigits(wchar_t* const out, unsigned int value, const unsigned int nDigits,
+	const wchar_t pad = L'0') {
+	unsigned int i = nDigits;
+	while( i > 0 ) {
+		--i;
+		out[i] = L'0' + static_cast<wchar_t>(value % 10);
+		value /= 10;
+		if( value == 0 ) {
+			break;
+		}
+	}
+	while( i > 0 ) {
+		--i;
+		out[i] = pad;
+	}
+}
+
+static void appendDigits(wstring& out, const unsigned int value, const unsigned int nDigits,
+	const wchar_t pad = L'0') {
+	wchar_t buffer[Timestamper::s_maxSubsecondDigits];
+	writeDigits(buffer, value, nDigits, pad);
+	out.append(buffer, nDigits);
+}
+
+Timestamper::Timestamper(const Format format, const unsigned int subsecondDigits) :
+m_format(Format::ASCTIME), m_subsecondDigits(0), m_subsecondUnits(1),
+m_subsecondFactor(0), m_subsecondShift(0),
+m_frequency(1), m_anchorCounter(0), m_anchorTime(0), m_anchorFixed(false), m_lastTime(0),
+m_lastCounter(0), m_cachedStartCounter(0), m_cachedEndCounter(0),
+m_cachedSecond(-1), m_cachedText(), m_subsecondPos(0)
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	m_frequency = frequency.QuadPart;
+	anchor();
+
+	if( FAILED(setFormat(format, subsecondDigits)) ) {
+		setFormat(format, s_maxSubsecondDigits);
+	}
+}
+
+Timestamper::~Timestamper(void) {}
+
+LONGLONG Timestamper::now(void) {
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return counter.QuadPart;
+}
+
+void Timestamper::append(wstring& out, const LONGLONG counter) {
+	LONGLONG clampedCounter = counter;
+	if( clampedCounter < m_lastCounter ) {
+		clampedCounter = m_lastCounter;
+	} else {
+		m_lastCounter = clampedCounter;
+	}
+
+	if( clampedCounter < m_cachedStartCounter || clampedCounter >= m_cachedEndCounter ) {
+		updateCache(clampedCounter);
+	}
+
+	// (The position is zero if there are no sub-second digits, or if the time could not be formatted)
+	if( m_subsecondPos > 0 ) {
+		writeSubseconds(clampedCounter);
+	}
+	out += m_cachedText;
+}
+
+HRESULT Timestamper::setFormat(const Format format, const unsigned int subsecondDigits) {
+	if( subsecondDigits > s_maxSubsecondDigits ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_INPUT);
+	}
+	m_format = format;
+	m_subsecondDigits = subsecondDigits;
+	m_subsecondUnits = 1;
+	for( unsigned int i = 0; i < subsecondDigits; ++i ) {
+		m_subsecondUnits *= 10;
+	}
+
+	/* Use as many fractional bits as possible, such that the product of
+	   the factor and a count of up to one second (plus a margin)
+	   fits in 63 bits. (The product is then at most m_subsecondUnits * 2^shift.)
+	 */
+	m_subsecondShift = 62;
+	for( unsigned int units = m_subsecondUnits; units > 1; units >>= 1 ) {
+		--m_subsecondShift;
+	}
+	m_subsecondFactor = (static_cast<ULONGLONG>(m_subsecondUnits) << m_subsecondShift) /
+		static_cast<ULONGLONG>(m_frequency);
+
+	// Reformat on the next call to append()
+	m_cachedSecond = -1;
+	m_cachedStartCounter = 0;
+	m_cachedEndCounter = 0;
+	return ERROR_SUCCESS;
+}
+
+HRESULT Timestamper::setAnchor(const LONGLONG frequency, const LONGLONG counter, const LONGLONG time) {
+	if( frequency <= 0 ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_INPUT);
+	}
+	m_anchorFixed = true;
+	m_anchorCounter = counter;
+	m_anchorTime = time;
+	if( frequency != m_frequency ) {
+		m_frequency = frequency;
+		// Recompute the sub-second conversion factor (cannot fail with the current digits)
+		setFormat(m_format, m_subsecondDigits);
+	} else {
+		m_cachedStartCounter = 0;
+		m_cachedEndCounter = 0;
+	}
+	return ERROR_SUCCESS;
+}
+
+void Timestamper::anchor(void) {
+	FILETIME systemTime;
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	GetSystemTimeAsFileTime(&systemTime);
+	m_anchorCounter = counter.QuadPart;
+	m_anchorTime = (static_cast<LONGLONG>(systemTime.dwHighDateTime) << 32) |
+		static_cast<LONGLONG>(systemTime.dwLowDateTime);
+}
+
+void Timestamper::writeSubseconds(const LONGLONG counter) {
+	ULONGLONG units = (static_cast<ULONGLONG>(counter - m_cachedStartCounter) * m_subsecondFactor) >> m_subsecondShift;
+	if( units >= m_subsecondUnits ) {
+		// Rounding error at the end of the second
+		units = m_subsecondUnits - 1;
+	}
+	writeDigits(&m_cachedText[m_subsecondPos], static_cast<unsigned int>(units), m_subsecondDigits);
+}
+
+void Timestamper::updateCache(const LONGLONG counter) {
+	if( !m_anchorFixed && (counter - m_anchorCounter) > (m_frequency * TIMESTAMPER_ANCHOR_INTERVAL) ) {
+		anchor();
+	}
+
+	// Convert to a system time, avoiding overflow in the multiplication
+	const LONGLONG delta = counter - m_anchorCounter;
+	LONGLONG time = m_anchorTime + (delta / m_frequency) * TIMESTAMPER_TICKS_PER_SECOND +
+		((delta % m_frequency) * TIMESTAMPER_TICKS_PER_SECOND) / m_frequency;
+	if( time < m_lastTime ) {
+		// The system clock was set backwards, or the anchor was renewed
+		time = m_lastTime;
+	} else {
+		m_lastTime = time;
+	}
+
+	/* Range of clock readings in the second, placed relative to this clock reading
+	   (rather than to the anchor), so that it is consistent with the time if
+	   the time was clamped above
+	 */
+	const LONGLONG second = time / TIMESTAMPER_TICKS_PER_SECOND;
+	m_cachedStartCounter = counter -
+		((time % TIMESTAMPER_TICKS_PER_SECOND) * m_frequency) / TIMESTAMPER_TICKS_PER_SECOND;
+	m_cachedEndCounter = m_cachedStartCounter + m_frequency;
+
+	if( second == m_cachedSecond ) {
+		return;
+	}
+	m_cachedSecond = second;
+	m_cachedText.clear();
+	m_subsecondPos = 0;
+
+	const ULONGLONG secondTime = static_cast<ULONGLONG>(second * TIMESTAMPER_TICKS_PER_SECOND);
+	FILETIME systemTime;
+	systemTime.dwLowDateTime = static_cast<DWORD>(secondTime & 0xFFFFFFFF);
+	systemTime.dwHighDateTime = static_cast<DWORD>(secondTime >> 32);
+	FILETIME localTime;
+	SYSTEMTIME fields;
+	if( !FileTimeToLocalFileTime(&systemTime, &localTime) ||
+		!FileTimeToSystemTime(&localTime, &fields) ) {
+		m_cachedText = L"[Cannot get time]";
+		return;
+	}
+
+	if( m_format == Format::ISO8601 ) {
+		appendDigits(m_cachedText, fields.wYear, 4);
+		m_cachedText += L'-';
+		appendDigits(m_cachedText, fields.wMonth, 2);
+		m_cachedText += L'-';
+		appendDigits(m_cachedText, fields.wDay, 2);
+		m_cachedText += L'T';
+	} else {
+		m_cachedText += s_dayNames[fields.wDayOfWeek % 7];
+		m_cachedText += L' ';
+		m_cachedText += s_monthNames[(fields.wMonth + 11) % 12];
+		m_cachedText += L' ';
+		appendDigits(m_cachedText, fields.wDay, 2, L' ');
+		m_cachedText += L' ';
+	}
+	appendDigits(m_cachedText, fields.wHour, 2);
+	m_cachedText += L':';
+	appendDigits(m_cachedText, fields.wMinute, 2);
+	m_cachedText += L':';
+	appendDigits(m_cachedText, fields.wSecond, 2);
+
+	if( m_subsecondDigits > 0 ) {
+		m_cachedText += L'.';
+		m_subsecondPos = m_cachedText.length();
+		m_cachedText.append(m_subsecondDigits, L'0');
+	}
+
+	if( m_format == Format::ASCTIME ) {
+		m_cachedText += L' ';
+		appendDigits(m_cachedText, fields.wYear, 4);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,160 @@
+/*
+embeddedConfig.cpp
+------------------
+
+Created for: Spring 2014 Direct3D 11 Learning
+By: Bernard Llanos
+August 17, 2014
+
+Primary basis: None
+Other references: None
+
+Development environment: Visual Studio 2013 running on Windows 7, 64-bit
+  -Note that the "Character Set" project property (Configuration Properties > General)
+   should be set to Unicode for all configurations, when using Visual Studio.
+
+Description
+  -Implementation of the embeddedConfig namespace functions,
+   and the tables of embedded default configuration data
+*/
+
+#include "embeddedConfig.h"
+#include <type_traits>
+#include <DirectXMath.h>
+
+using std::wstring;
+
+/* An entry in a table of embedded defaults.
+   Each table ends with an entry having a null scope.
+ */
+template<typename T> struct EmbeddedEntry {
+	const wchar_t* scope;
+	const wchar_t* field;
+	T value;
+};
+
+// Table construction
+// ------------------
+
+#define EMBEDDEDCONFIG_ENTRY(scope, field, value) { scope, field, value },
+#define EMBEDDEDCONFIG_FLOAT4_ENTRY(scope, field, ...) { scope, field, { __VA_ARGS__ } },
+#define EMBEDDEDCONFIG_END { 0 }
+
+static const EmbeddedEntry<const wchar_t*> s_wstringDefaults[] = {
+	EMBEDDEDCONFIG_WSTRING(EMBEDDEDCONFIG_ENTRY) EMBEDDEDCONFIG_END };
+static const EmbeddedEntry<bool> s_boolDefaults[] = {
+	EMBEDDEDCONFIG_BOOL(EMBEDDEDCONFIG_ENTRY) EMBEDDEDCONFIG_END };
+static const EmbeddedEntry<int> s_intDefaults[] = {
+	EMBEDDEDCONFIG_INT(EMBEDDEDCONFIG_ENTRY) EMBEDDEDCONFIG_END };
+static const EmbeddedEntry<double> s_doubleDefaults[] = {
+	EMBEDDEDCONFIG_DOUBLE(EMBEDDEDCONFIG_ENTRY) EMBEDDEDCONFIG_END };
+static const EmbeddedEntry<float[4]> s_float4Defaults[] = {
+	EMBEDDEDCONFIG_FLOAT4(EMBEDDEDCONFIG_FLOAT4_ENTRY) EMBEDDEDCONFIG_END };
+static const EmbeddedEntry<float[4]> s_colorDefaults[] = {
+	EMBEDDEDCONFIG_COLOR(EMBEDDEDCONFIG_FLOAT4_ENTRY) EMBEDDEDCONFIG_END };
+static const EmbeddedEntry<const wchar_t*> s_filenameDefaults[] = {
+	EMBEDDEDCONFIG_FILENAME(EMBEDDEDCONFIG_ENTRY) EMBEDDEDCONFIG_END };
+static const EmbeddedEntry<const wchar_t*> s_directoryDefaults[] = {
+	EMBEDDEDCONFIG_DIRECTORY(EMBEDDEDCONFIG_ENTRY) EMBEDDEDCONFIG_END };
+
+#undef EMBEDDEDCONFIG_ENTRY
+#undef EMBEDDEDCONFIG_FLOAT4_ENTRY
+#undef EMBEDDEDCONFIG_END
+
+// Type checking
+// -------------
+
+/* Aggregate initialization would otherwise accept some values of the wrong type
+   (e.g. a string literal for a BOOL value, or an integer for a DOUBLE value)
+ */
+#define EMBEDDEDCONFIG_CHECK(T, scope, field, defaultValue) \
+	static_assert(std::is_same<std::decay<decltype(defaultValue)>::type, T>::value, \
+		"An embedded default value has the wrong type for its list in embeddedConfig.h");
+#define EMBEDDEDCONFIG_CHECK_WSTRING(scope, field, value) EMBEDDEDCONFIG_CHECK(const wchar_t*, scope, field, value)
+#define EMBEDDEDCONFIG_CHECK_BOOL(scope, field, value) EMBEDDEDCONFIG_CHECK(bool, scope, field, value)
+#define EMBEDDEDCONFIG_CHECK_INT(scope, field, value) EMBEDDEDCONFIG_CHECK(int, scope, field, value)
+#define EMBEDDEDCONFIG_CHECK_DOUBLE(scope, field, value) EMBEDDEDCONFIG_CHECK(double, scope, field, value)
+
+EMBEDDEDCONFIG_WSTRING(EMBEDDEDCONFIG_CHECK_WSTRING)
+EMBEDDEDCONFIG_BOOL(EMBEDDEDCONFIG_CHECK_BOOL)
+EMBEDDEDCONFIG_INT(EMBEDDEDCONFIG_CHECK_INT)
+EMBEDDEDCONFIG_DOUBLE(EMBEDDEDCONFIG_CHECK_DOUBLE)
+EMBEDDEDCONFIG_FILENAME(EMBEDDEDCONFIG_CHECK_WSTRING)
+EMBEDDEDCONFIG_DIRECTORY(EMBEDDEDCONFIG_CHECK_WSTRING)
+
+#undef EMBEDDEDCONFIG_CHECK
+#undef EMBEDDEDCONFIG_CHECK_WSTRING
+#undef EMBEDDEDCONFIG_CHECK_BOOL
+#undef EMBEDDEDCONFIG_CHECK_INT
+#undef EMBEDDEDCONFIG_CHECK_DOUBLE
+
+/* Inserts the values in the table under keys which are not present
+   in the Config object. Values of type 'T' are constructed
+   from the table values (of type 'E').
+ */
+template<Config::DataType D, typename T, typename E> static HRESULT insertTable(
+	Config& config, const EmbeddedEntry<E>* const table,
+	std::list<wstring>* const locatorsOut) {
+
+	wstring locators;
+	for( const EmbeddedEntry<E>* entry = table; entry->scope != 0; ++entry ) {
+		const T* value = new T(entry->value);
+		locators.clear();
+		HRESULT result = config.insert<D, T>(entry->scope, entry->field, value,
+			(locatorsOut == 0) ? 0 : &locators);
+		if( FAILED(result) ) {
+			delete value;
+			return result;
+		} else if( HRESULT_CODE(result) == ERROR_ALREADY_ASSIGNED ) {
+			// The key was loaded from a configuration file
+			delete value;
+		} else if( locatorsOut != 0 ) {
+			locatorsOut->push_back(locators);
+		}
+	}
+	return ERROR_SUCCESS;
+}
+
+template<typename E> static size_t tableSize(const EmbeddedEntry<E>* const table) {
+	size_t n = 0;
+	for( const EmbeddedEntry<E>* entry = table; entry->scope != 0; ++entry ) {
+		++n;
+	}
+	return n;
+}
+
+HRESULT embeddedConfig::insertDefaults(Config& config, std::list<wstring>* const locatorsOut) {
+	HRESULT result = insertTable<Config::DataType::WSTRING, wstring>(config, s_wstringDefaults, locatorsOut);
+	if( SUCCEEDED(result) ) {
+		result = insertTable<Config::DataType::BOOL, bool>(config, s_boolDefaults, locatorsOut);
+	}
+	if( SUCCEEDED(result) ) {
+		result = insertTable<Config::DataType::INT, int>(config, s_intDefaults, locatorsOut);
+	}
+	if( SUCCEEDED(result) ) {
+		result = insertTable<Config::DataType::DOUBLE, double>(config, s_doubleDefaults, locatorsOut);
+	}
+	if( SUCCEEDED(result) ) {
+		result = insertTable<Config::DataType::FLOAT4, DirectX::XMFLOAT4>(config, s_float4Defaults, locatorsOut);
+	}
+	if( SUCCEEDED(result) ) {
+		result = insertTable<Config::DataType::COLOR, DirectX::XMFLOAT4>(config, s_colorDefaults, locatorsOut);
+	}
+	if( SUCCEEDED(result) ) {
+		result = insertTable<Config::DataType::FILENAME, wstring>(config, s_filenameDefaults, locatorsOut);
+	}
+	if( SUCCEEDED(result) ) {
+		result = insertTable<Config::DataType::DIRECTORY, wstring>(config, s_directoryDefaults, locatorsOut);
+	}
+	if( FAILED(result) ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	return ERROR_SUCCESS;
+}
+
+size_t embeddedConfig::count(void) {
+	return tableSize(s_wstringDefaults) + tableSize(s_boolDefaults) +
+		tableSize(s_intDefaults) + tableSize(s_doubleDefaults) +
+		tableSize(s_float4Defaults) + tableSize(s_colorDefaults) +
+		tableSize(s_filenameDefaults) + tableSize(s_directoryDefaults);
+}
\ No newline at end of file
@@ -25,6 +25,9 @@ Description
 #include "globals.h"
 #include "fileUtil.h"
 #include "FlatAtomicConfigIO.h"
+#include "ConfigCache.h"
+#include "ConfigWatcher.h"
+#include "embeddedConfig.h"
 #include <windows.h>
 #include <DirectXMath.h>
 #include <string>
@@ -53,6 +56,7 @@ Description
 // Define and initialize global variables
 Logger* g_defaultLogger = 0;
 Config* g_defaultConfig = 0;
+ConfigWatcher* g_configWatcher = 0;
 
 /* Application loop wrapper function
    ---------------------------------
@@ -174,6 +178,7 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine
 			// -------------------------------------------------------------------------
 			g_defaultConfig = new Config;
 			WWINMAIN_CONFIGIO_CLASS configIO;
+			std::wstring configFilename; // Empty if the global configuration file was not loaded
 
 			if( exists && isFile && msg.empty() ) {
 				tempMsgStore.emplace_back(L"Parsing configuration file: " + filename + L", using a " WWINMAIN_CONFIGIO_CLASS_STR L" instance...");
@@ -185,54 +190,33 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine
 					delete g_defaultConfig;
 					g_defaultConfig = new Config;
 				} else if( HRESULT_CODE(error) == ERROR_DATA_INCOMPLETE ) {
+					configFilename = filename;
 					tempMsgStore.emplace_back(L"...Configuration file parsing indicated that the loaded data is incomplete: " + errorStr);
 				} else {
+					configFilename = filename;
 					tempMsgStore.emplace_back(L"...Configuration file parsing succeeded with code: " + errorStr);
 				}
 			}
 
+			// Configuration files loaded by ConfigUser objects are parsed once while unchanged
+			ConfigCache::setEnabled(true);
+
 			// -------------------------------------------------------------------------
-			// Insert critical configuration parameters if they are not present
+			// Insert embedded defaults for configuration parameters which are not present
 			// -------------------------------------------------------------------------
 
-			// Logging output directory
-			const std::wstring* value = new std::wstring(DEFAULT_LOG_PATH);
-			std::wstring locators;
-			error = g_defaultConfig->insert<Config::DataType::DIRECTORY, std::wstring>(DEFAULT_LOG_PATH_SCOPE, DEFAULT_LOG_PATH_FIELD, value, &locators);
+			std::list<std::wstring> defaultLocators;
+			error = embeddedConfig::insertDefaults(*g_defaultConfig, &defaultLocators);
 			if( FAILED(error) ) {
 				finalResult = error;
 				PRINT_HRESULT_NO_ASSIGN
-				delete value;
-				value = 0;
-				tempMsgStore.emplace_back(L"Attempt to insert the logging directory into the global Config instance failed: " + errorStr);
-			} else if( HRESULT_CODE(error) == ERROR_ALREADY_ASSIGNED ) {
-				// The configuration object already has a value for this key
-				delete value;
-				value = 0;
-			} else {
-				// The pointer was inserted and is now owned by the global Config object
-				tempMsgStore.emplace_back(L"Note that the default logging folder can be configured under the key: " + locators);
+				tempMsgStore.emplace_back(L"Attempt to insert the embedded defaults into the global Config instance failed: " + errorStr);
 			}
-			locators.clear();
-
-			// Default log filename
-			value = new std::wstring(DEFAULT_LOG_FILENAME);
-			error = g_defaultConfig->insert<Config::DataType::FILENAME, std::wstring>(DEFAULT_LOG_FILENAME_SCOPE, DEFAULT_LOG_FILENAME_FIELD, value, &locators);
-			if( FAILED(error) ) {
-				finalResult = error;
-				PRINT_HRESULT_NO_ASSIGN
-				delete value;
-				value = 0;
-				tempMsgStore.emplace_back(L"Attempt to insert the default log filename into the global Config instance failed: " + errorStr);
-			} else if( HRESULT_CODE(error) == ERROR_ALREADY_ASSIGNED ) {
-				// The configuration object already has a value for this key
-				delete value;
-				value = 0;
-			} else {
-				// The pointer was inserted and is now owned by the global Config object
-				tempMsgStore.emplace_back(L"Note that the name of the default log file can be configured under the key: " + locators);
+			for( std::list<std::wstring>::const_iterator it = defaultLocators.cbegin(); it != defaultLocators.cend(); ++it ) {
+				tempMsgStore.emplace_back(L"Note that the embedded default value was used for the key: " + *it);
 			}
-			locators.clear();
+			const std::wstring* value = 0;
+			std::wstring locators;
 
 			// -------------------------------------------------------------------------
 			// Retrieve parameters for setting up the globally-visible Logger
@@ -318,6 +302,22 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine
 				return 0;
 			}
 
+			// -------------------------------------------------------------------------
+			// Set up reloading of configuration files when they are modified
+			// -------------------------------------------------------------------------
+			try {
+				g_configWatcher = new ConfigWatcher;
+			} catch( ... ) {
+				g_defaultLogger->logMessage(WWINMAIN_LOG_MSG(Failed to create the global ConfigWatcher. Configuration files will not be reloaded when modified.));
+			}
+			if( g_configWatcher != 0 && !configFilename.empty() ) {
+				error = g_configWatcher->watch<WWINMAIN_CONFIGIO_CLASS>(configFilename, *g_defaultConfig);
+				if( FAILED(error) ) {
+					PRINT_HRESULT_NO_ASSIGN
+					g_defaultLogger->logMessage(WWINMAIN_LOG_MSG(Failed to watch the global configuration file for modifications:) + errorStr);
+				}
+			}
+
 			/* The application loop goes here, as well as more task-specific
 			 * initialization and shutdown
 			 */
@@ -433,6 +433,15 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine
 			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
 		}
 
+		if( g_configWatcher != 0 ) {
+			g_defaultLogger->logMessage(WWINMAIN_LOG_MSG(Deleting the global ConfigWatcher.));
+			delete g_configWatcher;
+			g_configWatcher = 0;
+		}
+
+		g_defaultLogger->logMessage(WWINMAIN_LOG_MSG(Clearing the configuration file cache.));
+		ConfigCache::clear();
+
 		g_defaultLogger->logMessage(WWINMAIN_LOG_MSG(Deleting the global Config instance.));
 		delete g_defaultConfig;
 		g_defaultConfig = 0;
@@ -462,6 +471,8 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine
 #include "testLogger_LogUser.h"
 #include "testTextProcessing.h"
 #include "testFileUtil.h"
+#include "benchmarkConfigIO.h"
+#include "benchmarkLogger.h"
 
 /*
  * Run the application,
@@ -472,6 +483,17 @@ HRESULT applicationLoop(WPARAM& quit_wParam) {
 	// testBasicWindow::openNWindows(3, 3, quit_wParam);
 	// testBasicWindow::testGlobalBasicWindowConfig(quit_wParam);
 	// testBasicWindow::testSharedBasicWindowConfig(quit_wParam);
+	// benchmarkConfigIO::runSuite(5);
+	// testLogger_LogUser::testAsyncLogging(4);
+	// testLogger_LogUser::testAppendModes();
+	// testLogger_LogUser::testTimestamper();
+	// testLogger_LogUser::testLogLevels();
+	// testLogger_LogUser::testBinaryLogging(100000);
+	// testLogger_LogUser::testSecondaryFiles();
+	// testLogger_LogUser::testLogRotation();
+	// testLogger_LogUser::testFlightRecorder();
+	// testLogger_LogUser::testLogSuppression();
+	// benchmarkLogger::runSuite(100000, 3);
 	return testBasicWindow::testPrivateBasicWindowConfig(quit_wParam);
 	// return ERROR_SUCCESS;
 }
\ No newline at end of file
@@ -229,4 +229,103 @@ HRESULT fileUtil::combineAsPath(std::wstring& out, const std::wstring& seg1, con
 	tempOut += seg2;
 	out = tempOut;
 	return ERROR_SUCCESS;
+}
+
+HRESULT fileUtil::mapFile(const std::wstring& filename, HANDLE& file, HANDLE& mapping,
+	const char*& view, size_t& size) {
+
+	file = INVALID_HANDLE_VALUE;
+	mapping = NULL;
+	view = 0;
+	size = 0;
+
+	// See http://msdn.microsoft.com/en-us/library/windows/desktop/aa366556%28v=vs.85%29.aspx
+	file = CreateFile(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if( file == INVALID_HANDLE_VALUE ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FILE_NOT_FOUND);
+	}
+
+	LARGE_INTEGER fileSize;
+	if( !GetFileSizeEx(file, &fileSize) ) {
+		CloseHandle(file);
+		file = INVALID_HANDLE_VALUE;
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WINDOWS_CALL);
+	} else if( fileSize.QuadPart == 0 ) {
+		// CreateFileMapping() fails for empty files
+		return ERROR_SUCCESS;
+	}
+
+	mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if( mapping == NULL ) {
+		CloseHandle(file);
+		file = INVALID_HANDLE_VALUE;
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WINDOWS_CALL);
+	}
+
+	view = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if( view == 0 ) {
+		CloseHandle(mapping);
+		mapping = NULL;
+		CloseHandle(file);
+		file = INVALID_HANDLE_VALUE;
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WINDOWS_CALL);
+	}
+
+	size = static_cast<size_t>(fileSize.QuadPart);
+	return ERROR_SUCCESS;
+}
+
+HRESULT fileUtil::unmapFile(HANDLE& file, HANDLE& mapping, const char*& view) {
+	HRESULT result = ERROR_SUCCESS;
+	if( view != 0 ) {
+		if( !UnmapViewOfFile(view) ) {
+			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WINDOWS_CALL);
+		}
+		view = 0;
+	}
+	if( mapping != NULL ) {
+		CloseHandle(mapping);
+		mapping = NULL;
+	}
+	if( file != INVALID_HANDLE_VALUE ) {
+		CloseHandle(file);
+		file = INVALID_HANDLE_VALUE;
+	}
+	return result;
+}
+
+HRESULT fileUtil::getFileStamp(const std::wstring& filename,
+	uint64_t& size, uint64_t& writeTime) {
+
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if( !GetFileAttributesEx(filename.c_str(), GetFileExInfoStandard, &attributes) ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WINDOWS_CALL);
+	}
+	size = (static_cast<uint64_t>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+	writeTime = (static_cast<uint64_t>(attributes.ftLastWriteTime.dwHighDateTime) << 32) |
+		attributes.ftLastWriteTime.dwLowDateTime;
+	return ERROR_SUCCESS;
+}
+
+HRESULT fileUtil::fullPath(std::wstring& out, const std::wstring& name,
+	const std::wstring& directory) {
+
+	if( name.empty() ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_INPUT);
+	}
+
+	wstring combined = name;
+	if( !directory.empty() && PathIsRelative(name.c_str()) ) {
+		combineAsPath(combined, directory, name);
+	}
+
+	// See http://msdn.microsoft.com/en-us/library/windows/desktop/aa364963%28v=vs.85%29.aspx
+	wchar_t buffer[MAX_PATH];
+	DWORD length = GetFullPathName(combined.c_str(), MAX_PATH, buffer, NULL);
+	if( length == 0 || length >= MAX_PATH ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_WINDOWS_CALL);
+	}
+	out = buffer;
+	return ERROR_SUCCESS;
 }
\ No newline at end of file
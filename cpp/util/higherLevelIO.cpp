@@ -74,6 +74,21 @@ HRESULT higherLevelIO::XMFLOAT4ToWString(wstring& out, const XMFLOAT4& in) {
 	}
 }
 
+HRESULT higherLevelIO::appendXMFLOAT4(wstring& out, const XMFLOAT4& in) {
+	const float inAsArray[] = { in.x, in.y, in.z, in.w };
+	out += START_CH_W;
+	for( size_t i = 0; i < FLOAT4_SIZE; ++i ) {
+		if( FAILED(textProcessing::appendNumber(out, inAsArray[i])) ) {
+			return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+		}
+		if( i < (FLOAT4_SIZE - 1) ) {
+			out += TEXTPROCESSING_COMMA_SEP;
+		}
+	}
+	out += END_CH_W;
+	return ERROR_SUCCESS;
+}
+
 HRESULT higherLevelIO::strToColorRGBA(XMFLOAT4& out, const char* const in, size_t& index) {
 
 	// Error checking
@@ -130,4 +145,30 @@ HRESULT higherLevelIO::colorRGBAToWString(wstring& out, const XMFLOAT4& in) {
 		out = tempOut;
 		return ERROR_SUCCESS;
 	}
+}
+
+HRESULT higherLevelIO::appendColorRGBA(wstring& out, const XMFLOAT4& in) {
+
+	// See colorRGBAToWString()
+	XMVECTOR vectorIn = DirectX::XMLoadFloat4(&in);
+	DirectX::PackedVector::XMCOLOR scaledIn;
+	DirectX::PackedVector::XMStoreColor(&scaledIn, vectorIn);
+	const int arrayOut[] = {
+		scaledIn.r,
+		scaledIn.g,
+		scaledIn.b,
+		scaledIn.a
+	};
+
+	out += START_CH_W;
+	for( size_t i = 0; i < FLOAT4_SIZE; ++i ) {
+		if( FAILED(textProcessing::appendNumber(out, arrayOut[i])) ) {
+			return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+		}
+		if( i < (FLOAT4_SIZE - 1) ) {
+			out += TEXTPROCESSING_COMMA_SEP;
+		}
+	}
+	out += END_CH_W;
+	return ERROR_SUCCESS;
 }
\ No newline at end of file
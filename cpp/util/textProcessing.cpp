@@ -24,6 +24,7 @@ Description
 #include "globals.h"
 #include <exception>
 #include <cstring>
+#include <cwchar>
 
 using std::wstring;
 
@@ -525,4 +526,85 @@ HRESULT textProcessing::fileOrDirNameToWString(std::wstring& out, const std::wst
 	out += in;
 	out += W_QUOTES;
 	return ERROR_SUCCESS;
+}
+
+/* Number of characters needed for the longest possible output
+   of appendNumber(), including the null terminator
+ */
+#define TEXTPROCESSING_NUMBER_BUFFER_LENGTH 32
+
+HRESULT textProcessing::appendNumber(std::wstring& out, const int in) {
+	wchar_t buffer[TEXTPROCESSING_NUMBER_BUFFER_LENGTH];
+	int length = swprintf(buffer, TEXTPROCESSING_NUMBER_BUFFER_LENGTH, L"%d", in);
+	if( length < 0 ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_LIBRARY_CALL);
+	}
+	out.append(buffer, static_cast<size_t>(length));
+	return ERROR_SUCCESS;
+}
+
+HRESULT textProcessing::appendNumber(std::wstring& out, const float in) {
+	// A float is output by a stream in the same way as a double
+	return appendNumber(out, static_cast<double>(in));
+}
+
+HRESULT textProcessing::appendNumber(std::wstring& out, const double in) {
+	/* Matches the precision and scientific format flag
+	   used by numberToWString() for non-integer types
+	 */
+	wchar_t buffer[TEXTPROCESSING_NUMBER_BUFFER_LENGTH];
+	int length = swprintf(buffer, TEXTPROCESSING_NUMBER_BUFFER_LENGTH, L"%.16e", in);
+	if( length < 0 ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_LIBRARY_CALL);
+	}
+	out.append(buffer, static_cast<size_t>(length));
+	return ERROR_SUCCESS;
+}
+
+HRESULT textProcessing::appendUTF8(std::string& out, const wchar_t* const in, const size_t length) {
+
+	// Error checking
+	if( in == 0 && length != 0 ) {
+		return 	MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NULL_INPUT);
+	}
+
+	for( size_t i = 0; i < length; ++i ) {
+		unsigned long codePoint = static_cast<unsigned long>(in[i]);
+
+		// Fast path for ASCII characters
+		if( codePoint < 0x80 ) {
+			out += static_cast<char>(codePoint);
+			continue;
+		}
+
+		// Surrogate pairs
+		if( codePoint >= 0xD800 && codePoint <= 0xDBFF ) {
+			if( (i + 1) < length &&
+				static_cast<unsigned long>(in[i + 1]) >= 0xDC00 &&
+				static_cast<unsigned long>(in[i + 1]) <= 0xDFFF ) {
+				codePoint = 0x10000 + ((codePoint - 0xD800) << 10) +
+					(static_cast<unsigned long>(in[i + 1]) - 0xDC00);
+				++i;
+			} else {
+				codePoint = 0xFFFD;
+			}
+		} else if( codePoint >= 0xDC00 && codePoint <= 0xDFFF ) {
+			codePoint = 0xFFFD;
+		}
+
+		if( codePoint < 0x800 ) {
+			out += static_cast<char>(0xC0 | (codePoint >> 6));
+			out += static_cast<char>(0x80 | (codePoint & 0x3F));
+		} else if( codePoint < 0x10000 ) {
+			out += static_cast<char>(0xE0 | (codePoint >> 12));
+			out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+			out += static_cast<char>(0x80 | (codePoint & 0x3F));
+		} else {
+			out += static_cast<char>(0xF0 | (codePoint >> 18));
+			out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+			out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+			out += static_cast<char>(0x80 | (codePoint & 0x3F));
+		}
+	}
+	return ERROR_SUCCESS;
 }
\ No newline at end of file
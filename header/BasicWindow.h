@@ -194,6 +194,9 @@ public:
 
 	This function will close all windows if the application must terminate.
 	(Note that "all windows" refers to all windows created by this class.)
+
+	This function also applies modifications to configuration files,
+	using the global ConfigWatcher (if it exists).
 	*/
 	static HRESULT updateAll(bool& quit, WPARAM& msg_wParam);
 
@@ -0,0 +1,311 @@
+/*
+BinaryLogger.h
+--------------
+
+Created for: Spring 2014 Direct3D 11 Learning
+By: Bernard Llanos
+August 19, 2014
+
+Primary basis: None
+Other references: None
+
+Development environment: Visual Studio 2013 running on Windows 7, 64-bit
+  -Note that the "Character Set" project property (Configuration Properties > General)
+   should be set to Unicode for all configurations, when using Visual Studio.
+
+Description
+  -A class for logging messages to a compact binary file, in which
+   messages are not formatted when they are logged. Instead, each call site
+   registers a format string once, and then logs only the format's
+   identifier, a timestamp, and the raw values of the format's arguments.
+  -decode() converts a binary log file to a text file with the same
+   line format as the Logger class ("timestamp | message").
+
+Usage Notes
+  -Format strings contain one "{}" placeholder per argument.
+   The argument types are given as template arguments when the format
+   is registered, for example:
+     BinaryLogger::FormatID id;
+     binaryLogger.registerFormat<unsigned int, double>(id, L"Frame {} took {} ms");
+     ...
+     binaryLogger.log(id, frameIndex, milliseconds);
+   Supported argument types are the built-in integer types (int and larger),
+   float, double, bool, std::wstring, null-terminated wide-character strings
+   (which are copied into the file), and BinaryLogger::StaticString.
+  -A StaticString wraps a pointer to a string with static storage duration
+   (e.g. a string literal). The string is written to the file the first time
+   that its pointer is logged, and is then referred to by an identifier.
+   Different strings must therefore not be passed through the same
+   pointer value.
+  -Encoded messages are collected in a buffer, which is written to the file
+   when its size reaches a threshold, when a message is logged after
+   a time interval has elapsed since the last write, when flush() is called,
+   and on destruction. Messages in the buffer are lost if the application
+   terminates abnormally.
+  -This class is not thread-safe.
+
+Binary file format
+  -Header (see the BinaryLogger::FileHeader structure), followed by records.
+   The file is not portable between machines of different endianness,
+   or between builds with different sizes of 'wchar_t'.
+  -"Varint" below refers to an unsigned integer stored in groups of 7 bits,
+   least significant group first, with the high bit of each byte set
+   if another byte follows. Signed integers are "zigzag" encoded as
+   unsigned integers first ((n << 1) ^ (n >> 63)), so that small
+   negative values are also short.
+  -Records start with a RecordType byte:
+    -FORMAT: Varint format identifier, varint number of arguments,
+     one ArgType byte per argument, varint length (in characters)
+     of the format string, and the characters of the format string
+    -ANCHOR: Readings of the monotonic clock (QueryPerformanceCounter())
+     and of the system clock (as a FILETIME value), taken together,
+     as two signed 64-bit integers. Timestamps are converted to times using
+     the latest anchor. An anchor is written at the start of the file,
+     and whenever a message is logged more than BINARYLOGGER_ANCHOR_INTERVAL
+     seconds after the latest anchor.
+    -MESSAGE: Varint format identifier, signed varint difference between
+     the message's clock reading and the previous clock reading
+     (or the clock reading of the latest anchor, if it is more recent),
+     and the arguments:
+      -INT and UINT: Signed and unsigned varints
+      -DOUBLE: 8 bytes
+      -BOOL: 1 byte
+      -WSTRING: Varint length (in characters), followed by the characters
+      -STATIC_WSTRING: Varint (n << 1) | d, where 'n' is the string's
+       identifier, and where 'd' is 1 if this is the first time that
+       the string is logged, in which case a varint length and the characters
+       of the string follow
+*/
+
+#pragma once
+
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <fstream>
+#include <cstdint>
+
+// Suggested extension for binary log files
+#define BINARYLOGGER_EXTENSION L".blog"
+
+// Identifies binary log files ("BLOG" in little-endian byte order)
+#define BINARYLOGGER_MAGIC 0x474F4C42
+// To be incremented whenever the binary file format changes
+#define BINARYLOGGER_VERSION 1
+
+// Default size of the buffer of encoded messages, in bytes
+#define BINARYLOGGER_BUFFER_SIZE 65536
+
+// Default maximum time between writes to the file, in milliseconds
+#define BINARYLOGGER_FLUSH_INTERVAL_MS 1000
+
+// Time, in seconds, after which a new clock anchor is written
+#define BINARYLOGGER_ANCHOR_INTERVAL 60
+
+// Placeholder for an argument in a format string
+#define BINARYLOGGER_PLACEHOLDER L"{}"
+
+/* Maps a C++ type to a BinaryLogger::ArgType constant.
+   Unsupported argument types will cause compilation errors.
+   (Specializations are defined below the BinaryLogger class.)
+ */
+template<typename T> struct BinaryLoggerArg;
+
+class BinaryLogger
+{
+public:
+	typedef uint32_t FormatID;
+
+	enum class ArgType : uint8_t {
+		INT = 1,
+		UINT,
+		DOUBLE,
+		BOOL,
+		WSTRING,
+		STATIC_WSTRING
+	};
+
+	// Wrapper for a string with static storage duration (see above)
+	struct StaticString {
+		const wchar_t* str;
+		explicit StaticString(const wchar_t* const s) : str(s) {}
+	};
+
+protected:
+	enum class RecordType : uint8_t {
+		FORMAT = 1,
+		ANCHOR,
+		MESSAGE
+	};
+
+	struct FileHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t charSize; // sizeof(wchar_t)
+		uint32_t timestampEnabled; // Nonzero if messages should be decoded with timestamps
+		int64_t frequency; // Frequency of the monotonic clock, in counts per second
+	};
+
+	// Data members
+private:
+	std::ofstream m_file;
+
+	// Encoded records which have not yet been written to the file
+	std::string m_buffer;
+
+	// Buffer size at which the buffer is written to the file
+	size_t m_bufferSize;
+
+	// Maximum time between writes to the file, in milliseconds
+	DWORD m_flushInterval;
+
+	// Time of the last write to the file, from GetTickCount()
+	DWORD m_lastFlush;
+
+	// Argument types of the registered formats, indexed by format identifier
+	std::vector<std::vector<ArgType>> m_formats;
+
+	// Identifiers of the static strings which have been written to the file
+	std::unordered_map<const wchar_t*, uint32_t> m_staticStrings;
+
+	bool m_timestampEnabled;
+
+	LONGLONG m_frequency;
+
+	// Clock reading of the latest anchor written
+	LONGLONG m_anchorCounter;
+
+	// Previous clock reading written
+	LONGLONG m_lastCounter;
+
+public:
+	/* Creates or replaces the file, and writes the file header.
+	   'bufferSize' and 'flushInterval' are described in the usage notes above.
+	   If 'timestampEnabled' is false, the clock is not read when messages
+	   are logged, and messages are decoded without timestamps.
+
+	   Throws an exception of type std::exception if the file cannot be opened.
+	 */
+	BinaryLogger(const std::wstring filename, bool timestampEnabled = true,
+		const size_t bufferSize = BINARYLOGGER_BUFFER_SIZE,
+		const DWORD flushInterval = BINARYLOGGER_FLUSH_INTERVAL_MS);
+
+	// Writes any buffered messages to the file
+	~BinaryLogger(void);
+
+	/* Registers a format string, with the argument types given
+	   as template arguments, and writes it to the file.
+	   'id' is output, for use in calls to log().
+
+	   Returns a failure result, and does not modify 'id', if the number
+	   of placeholders in the format string does not match the number
+	   of argument types.
+	 */
+	template<typename... Args>
+	HRESULT registerFormat(FormatID& id, const std::wstring& format);
+
+	/* Logs a message with the given format and arguments.
+	   Returns a failure result, and logs nothing, if the format identifier
+	   is invalid, or if the types of the arguments do not match
+	   the types registered with the format. Also returns a failure result
+	   if the buffer needed to be written to the file, and the write failed.
+	 */
+	template<typename... Args>
+	HRESULT log(const FormatID id, const Args&... args);
+
+	// Writes any buffered messages to the file
+	HRESULT flush(void);
+
+	/* Converts a binary log file to a text file, overwriting the text file.
+	   Messages are output in the format used by the Logger class,
+	   with timestamps in the Logger's default format.
+
+	   Returns a failure result if either file cannot be opened,
+	   or if the binary file is not a valid binary log file.
+	   If the binary file ends with an incomplete record (e.g. if the
+	   application that was writing it terminated abnormally),
+	   the complete records are decoded, and a success result
+	   with the ERROR_DATA_INCOMPLETE code is returned.
+	 */
+	static HRESULT decode(const std::wstring& binaryFilename, const std::wstring& textFilename);
+
+private:
+	HRESULT registerFormat(FormatID& id, const std::wstring& format,
+		const ArgType* const types, const size_t nArgs);
+
+	/* Validates the argument types, and writes the start of a message record.
+	   (Not inlined, as it is not specific to the argument types.)
+	 */
+	HRESULT beginMessage(const FormatID id, const ArgType* const types, const size_t nArgs);
+
+	// Writes the buffer to the file if it is time to do so
+	HRESULT endMessage(void);
+
+	// Takes and writes new readings of the monotonic clock and the system clock
+	void writeAnchor(void);
+
+	void writeUnsigned(ULONGLONG value);
+	void writeSigned(const LONGLONG value);
+	void writeString(const wchar_t* const str, const size_t length);
+
+	void encodeArgs(void) {}
+
+	template<typename T, typename... Rest>
+	void encodeArgs(const T& arg, const Rest&... rest) {
+		encodeArg(arg);
+		encodeArgs(rest...);
+	}
+
+	void encodeArg(const int value);
+	void encodeArg(const long value);
+	void encodeArg(const long long value);
+	void encodeArg(const unsigned int value);
+	void encodeArg(const unsigned long value);
+	void encodeArg(const unsigned long long value);
+	void encodeArg(const float value);
+	void encodeArg(const double value);
+	void encodeArg(const bool value);
+	void encodeArg(const std::wstring& value);
+	void encodeArg(const wchar_t* const value);
+	void encodeArg(const StaticString& value);
+
+	// Currently not implemented - will cause linker errors if called
+private:
+	BinaryLogger(const BinaryLogger& other);
+	BinaryLogger& operator=(const BinaryLogger& other);
+};
+
+template<> struct BinaryLoggerArg<int> { static const BinaryLogger::ArgType type = BinaryLogger::ArgType::INT; };
+template<> struct BinaryLoggerArg<long> { static const BinaryLogger::ArgType type = BinaryLogger::ArgType::INT; };
+template<> struct BinaryLoggerArg<long long> { static const BinaryLogger::ArgType type = BinaryLogger::ArgType::INT; };
+template<> struct BinaryLoggerArg<unsigned int> { static const BinaryLogger::ArgType type = BinaryLogger::ArgType::UINT; };
+template<> struct BinaryLoggerArg<unsigned long> { static const BinaryLogger::ArgType type = BinaryLogger::ArgType::UINT; };
+template<> struct BinaryLoggerArg<unsigned long long> { static const BinaryLogger::ArgType type = BinaryLogger::ArgType::UINT; };
+template<> struct BinaryLoggerArg<float> { static const BinaryLogger::ArgType type = BinaryLogger::ArgType::DOUBLE; };
+template<> struct BinaryLoggerArg<double> { static const BinaryLogger::ArgType type = BinaryLogger::ArgType::DOUBLE; };
+template<> struct BinaryLoggerArg<bool> { static const BinaryLogger::ArgType type = BinaryLogger::ArgType::BOOL; };
+template<> struct BinaryLoggerArg<std::wstring> { static const BinaryLogger::ArgType type = BinaryLogger::ArgType::WSTRING; };
+template<> struct BinaryLoggerArg<const wchar_t*> { static const BinaryLogger::ArgType type = BinaryLogger::ArgType::WSTRING; };
+template<> struct BinaryLoggerArg<wchar_t*> { static const BinaryLogger::ArgType type = BinaryLogger::ArgType::WSTRING; };
+template<size_t N> struct BinaryLoggerArg<wchar_t[N]> { static const BinaryLogger::ArgType type = BinaryLogger::ArgType::WSTRING; };
+template<> struct BinaryLoggerArg<BinaryLogger::StaticString> { static const BinaryLogger::ArgType type = BinaryLogger::ArgType::STATIC_WSTRING; };
+
+template<typename... Args>
+HRESULT BinaryLogger::registerFormat(FormatID& id, const std::wstring& format) {
+	// (The last element allows for formats without arguments)
+	const ArgType types[sizeof...(Args)+1] = { BinaryLoggerArg<Args>::type..., ArgType::INT };
+	return registerFormat(id, format, types, sizeof...(Args));
+}
+
+template<typename... Args>
+HRESULT BinaryLogger::log(const FormatID id, const Args&... args) {
+	// (The last element allows for messages without arguments)
+	const ArgType types[sizeof...(Args)+1] = { BinaryLoggerArg<Args>::type..., ArgType::INT };
+	HRESULT result = beginMessage(id, types, sizeof...(Args));
+	if( FAILED(result) ) {
+		return result;
+	}
+	encodeArgs(args...);
+	return endMessage();
+}
\ No newline at end of file
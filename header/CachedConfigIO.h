@@ -0,0 +1,228 @@
+/*
+CachedConfigIO.h
+----------------
+
+Created for: Spring 2014 Direct3D 11 Learning
+By: Bernard Llanos
+August 10, 2014
+
+Primary basis: None
+Other references: None
+
+Development environment: Visual Studio 2013 running on Windows 7, 64-bit
+  -Note that the "Character Set" project property (Configuration Properties > General)
+   should be set to Unicode for all configurations, when using Visual Studio.
+
+Description
+  -A class which inherits from the IConfigIO interface, and which
+   wraps another IConfigIO object that handles a text configuration file format.
+  -When reading a configuration file, a compact binary image of the data
+   in the file is stored in a cache file next to the text file.
+   Subsequent read operations load the binary image instead of
+   parsing the text file, provided that the text file, and any other files
+   from which the wrapped object loaded data (e.g. included files,
+   see IConfigIO::getIncludedFiles()), have not been modified
+   since the binary image was created.
+
+Usage Notes
+  -The cache file has the same name and path as the text file,
+   but with its extension replaced by CACHEDCONFIGIO_CACHE_EXTENSION.
+  -The binary image is not portable between machines of different
+   endianness, or between builds with different sizes of 'wchar_t'
+   (and will be treated as stale in these cases).
+  -A cache file is not created if any of the included files cannot be found.
+  -Writing operations are passed directly to the wrapped object.
+   The cache will be updated by the next read operation,
+   since the modification time of the text file will have changed.
+
+Binary image format
+  -All integers are unsigned 32-bit values, except for file
+   sizes and modification times, which are unsigned 64-bit values.
+  -Header (see the CachedConfigIO::CacheHeader structure)
+  -Entry index: One CachedConfigIO::CacheEntry structure per key-value pair,
+   in the order in which the keys are sorted within Config objects
+  -Include table: One CachedConfigIO::CacheInclude structure per included file
+  -Key table: Wide-character strings (without null terminators) for the
+   names of included files, and for key scopes and fields, referred to
+   by offset and length (in characters) from the entry index and include table
+  -Value table: Wide-character strings for the values of string-valued
+   data types, referred to in the same way from the entry index
+  -The checksum in the header covers the entry index, the include table
+   and the key table, which are needed to insert the keys into a Config object.
+   Each string value has its own checksum, which is verified
+   when the value is first retrieved.
+
+Loading
+  -Values are not created when the cache file is loaded. Instead, the bytes
+   of each value are stored in an undecoded Config::Value object
+   (see Config::Value), and the value is created, and its checksum
+   verified, when it is first retrieved, so the time taken to load
+   the cache file does not depend on the sizes of the string values.
+   (The keys must be inserted into the Config object, and so are
+   loaded in full.)
+*/
+
+#pragma once
+
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "LogUser.h"
+#include "Config.h"
+#include "IConfigIO.h"
+
+#define CACHEDCONFIGIO_CACHE_EXTENSION L".bcfg"
+
+// Identifies binary image files ("BLCC" in little-endian byte order)
+#define CACHEDCONFIGIO_MAGIC 0x43434C42
+// To be incremented whenever the binary image format changes
+#define CACHEDCONFIGIO_VERSION 3
+
+class CachedConfigIO : public IConfigIO, public LogUser {
+
+protected:
+	struct CacheHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t charSize; // sizeof(wchar_t)
+		uint32_t nEntries;
+		uint64_t sourceSize; // Size of the text file, in bytes
+		uint64_t sourceWriteTime; // Last modification time of the text file, as a FILETIME
+		uint32_t keyTableLength; // In characters
+		uint32_t checksum;
+		uint32_t nIncludes;
+		uint32_t valueTableLength; // In characters
+	};
+
+	struct CacheEntry {
+		uint32_t scopeOffset;
+		uint32_t scopeLength;
+		uint32_t fieldOffset;
+		uint32_t fieldLength;
+		uint32_t dataType;
+
+		/* For string-valued data types, the first three elements are
+		   the offset and length of the string in the value table,
+		   and the checksum of the characters of the string.
+		   Otherwise, the bytes of the value are stored directly.
+		 */
+		uint32_t value[4];
+	};
+
+	// An included file, whose full path is stored in the key table
+	struct CacheInclude {
+		uint32_t nameOffset;
+		uint32_t nameLength;
+		uint64_t size;
+		uint64_t writeTime;
+	};
+
+	// The full path, size and modification time of an included file
+	struct IncludeStamp {
+		std::wstring filename;
+		uint64_t size;
+		uint64_t writeTime;
+	};
+
+private:
+	// The object used to read and write text files. Not owned by this object.
+	IConfigIO* m_textIO;
+
+	// Files included by the file read by the last call to read()
+	std::vector<std::wstring> m_includedFiles;
+
+public:
+	/* The 'textIO' parameter must remain valid for the lifetime
+	   of this object.
+	   Throws an exception of type std::invalid_argument if 'textIO' is null.
+	 */
+	CachedConfigIO(IConfigIO* const textIO);
+	virtual ~CachedConfigIO(void);
+
+public:
+	/* Read configuration data from a file
+	(See IConfigIO.h for details)
+
+	If the cache file corresponding to the text file is present,
+	undamaged, and records the current size and modification time
+	of the text file, the data is loaded from the cache file.
+	Otherwise, the text file is read by the wrapped IConfigIO object,
+	and the cache file is regenerated.
+
+	Failure to create or load a cache file is not considered
+	an error, as the text file can still be read. In this case,
+	the return value is that of the wrapped IConfigIO object's read() function.
+	*/
+	virtual HRESULT read(const std::wstring& filename,
+		Config& config) override;
+
+	/* Write configuration data to a file
+	   using the wrapped IConfigIO object
+	   (See IConfigIO.h for details)
+	 */
+	virtual HRESULT write(const std::wstring& filename,
+		const Config& config, const bool overwrite) override;
+
+	// Calls the corresponding function of the wrapped IConfigIO object
+	virtual bool toggleContextOutput(const bool outputContext) override;
+
+	/* Outputs the files from which the wrapped IConfigIO object loaded data,
+	   or which were recorded in the cache file, during the last call to read()
+	   (See IConfigIO.h for details)
+	 */
+	virtual void getIncludedFiles(std::vector<std::wstring>& filenames) const override;
+
+	// Calls the corresponding function of the wrapped IConfigIO object
+	virtual HRESULT listIncludedFiles(const std::wstring& filename,
+		std::vector<std::wstring>& filenames) const override;
+
+	// Calls the corresponding function of the wrapped IConfigIO object
+	virtual bool toggleReportOutput(const bool outputReports) override;
+
+	/* Outputs the name of the cache file corresponding to
+	   a text configuration file
+	 */
+	static HRESULT cacheFilename(std::wstring& out, const std::wstring& filename);
+
+protected:
+	/* Loads the binary image from the cache file into the Config object,
+	   if the cache file is fresh with respect to the given size
+	   and modification time of the text file, and to the current sizes
+	   and modification times of the included files recorded in it.
+	   'includedFiles' is output as the included files recorded in the cache file.
+
+	   Returns a success result with the ERROR_DATA_NOT_FOUND
+	   error code if the cache file is missing or stale,
+	   and a failure result if the cache file is damaged.
+	   The Config object is modified only if a success result is returned
+	   without an error code. (Damage to string values is detected
+	   when the values are retrieved, as they are decoded lazily.)
+	 */
+	HRESULT loadCache(const std::wstring& filename, Config& config,
+		const uint64_t sourceSize, const uint64_t sourceWriteTime,
+		std::vector<std::wstring>& includedFiles);
+
+	/* Decoding function for values loaded from cache files
+	   (a Config::Value::Decoder). For string-valued data types,
+	   'raw' is the checksum of the string, followed by its characters.
+	   Otherwise, 'raw' contains the bytes of the value.
+	 */
+	static HRESULT decodeValue(const Config::DataType type, const std::string& raw,
+		const void*& value, std::wstring& msg);
+
+	/* Creates the binary image of the Config object
+	   and writes it to the cache file.
+	 */
+	HRESULT saveCache(const std::wstring& filename, const Config& config,
+		const uint64_t sourceSize, const uint64_t sourceWriteTime,
+		const std::vector<IncludeStamp>& includes);
+
+	// FNV-1a hash function
+	static uint32_t checksum(const char* const data, const size_t length);
+
+	// Currently not implemented - will cause linker errors if called
+private:
+	CachedConfigIO(const CachedConfigIO& other);
+	CachedConfigIO& operator=(const CachedConfigIO& other);
+};
\ No newline at end of file
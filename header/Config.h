@@ -29,9 +29,15 @@ Usage Notes
      to be modified to be suitable for inheritance (e.g. so that it has
      virtual destructors).
 
+  -Values can be inserted in an undecoded (text) form, together with
+     a function for decoding them (see the Value class). Such values
+     are decoded when they are first retrieved, and the decoded values
+     are kept for later retrieval operations.
+
 Issues
   -Objects of this class are not safe for access by multiple threads
-   (unless all threads are performing const operations).
+   (unless all threads are performing const operations, and there are
+    no undecoded values stored in the object).
 */
 
 #pragma once
@@ -39,10 +45,14 @@ Issues
 #include "defs.h"
 #include <windows.h>
 #include <map>
+#include <list>
 #include <iterator>
 #include <string>
 #include <DirectXMath.h>
 
+// Separates scope prefixes from scopes (see Config::joinScopes())
+#define CONFIG_SCOPE_PREFIX_SEP L"."
+
 class Config {
 
 public:
@@ -71,12 +81,70 @@ public:
 		DIRECTORY
 	};
 	/* When adding new data types to this enumeration, also do the following:
-	- Update the 's_dataTypesNames' and 's_dataTypesInOrder' static members
-	- Update the Value class destructor
+	- Add an entry for the new data type to the 's_dataTypeInfo' static member,
+	    and check that the name of the new data type does not collide
+		with other names in the data type name hash table
+		(see CONFIG_DATATYPE_HASH_SIZE in Config.cpp)
 	- Add public retrieval and insertion member functions for values of the
 	    new data type
 	*/
 
+	/* Properties of a data type, and the operations on its values
+	which are needed by code that handles values of all data types.
+	There is one descriptor for each DataType constant,
+	so that support for a data type is defined in a single table entry,
+	rather than in 'switch' statements scattered throughout the code.
+	 */
+	struct DataTypeInfo {
+		DataType type;
+
+		// The name of the DataType constant, in narrow and wide character forms
+		const char* name;
+		const wchar_t* wName;
+		size_t nameLength;
+
+		// The size of a value object (e.g. sizeof(int) for DataType::INT)
+		size_t size;
+
+		// True if values are std::wstring objects
+		bool isString;
+
+		// Deletes a dynamically-allocated value
+		void(*destroy)(const void* const value);
+
+		// Returns a dynamically-allocated copy of the value
+		const void* (*copy)(const void* const value);
+
+		// Returns true if the two values are equal
+		bool(*equals)(const void* const a, const void* const b);
+
+		/* Parses a value from the beginning of the null-terminated string 'str'
+		   (using the textProcessing and higherLevelIO namespace functions),
+		   outputting a dynamically-allocated value.
+		   'index' is output as the number of characters consumed.
+		   Returns a success result, but with the ERROR_DATA_INCOMPLETE code,
+		   if no value was found, in which case 'value' is null.
+		   'msg' receives any messages from the parsing function
+		   (which do not necessarily indicate errors).
+		 */
+		HRESULT(*parse)(const char* const str, const void*& value,
+			size_t& index, std::wstring& msg);
+
+		/* Checks for a value at the beginning of 'str', with the same results
+		   as 'parse', but without outputting the value. No value object is
+		   allocated: strings are parsed into 'buffer', which can be reused
+		   between calls to avoid allocations.
+		 */
+		HRESULT(*check)(const char* const str, size_t& index,
+			std::wstring& msg, std::wstring& buffer);
+
+		/* Appends the text representation of the value to 'out',
+		   in the form read by 'parse'. 'buffer' is used for intermediate
+		   results, and can be reused between calls to avoid allocations.
+		 */
+		HRESULT(*format)(std::wstring& out, const void* const value, std::wstring& buffer);
+	};
+
 	/* Outputs the DataType constant name that has the same form
 	as the input string (case-sensitive).
 	Returns a failure code if there is no corresponding DataType constant.
@@ -93,18 +161,47 @@ public:
 	*/
 	static HRESULT dataTypeToWString(std::wstring& out, const DataType& in);
 
+	/* Returns the descriptor of the data type,
+	or null if 'type' is not a valid DataType constant
+	*/
+	static const DataTypeInfo* getDataTypeInfo(const DataType type);
+
+	/* Returns the descriptor of the data type whose name
+	is the first 'length' characters of 'name' (case-sensitive),
+	or null if there is no such data type.
+
+	Names are looked up in a perfect hash table, such that at most one
+	string comparison is performed, and no memory is allocated.
+	*/
+	static const DataTypeInfo* getDataTypeInfo(const char* const name, const size_t length);
+	static const DataTypeInfo* getDataTypeInfo(const wchar_t* const name, const size_t length);
+
 private:
 	/* Number of constants in the DataType enumeration,
-	which also corresponds to the length of the following
-	two arrays
+	which also corresponds to the length of the following array
 	*/
 	static const size_t s_nDataTypes;
 
-	// Names of data type constants as string literals, in order of declaration
-	static const std::wstring s_dataTypesNames[];
+	// Descriptors of data types, in order of declaration of the DataType constants
+	static const DataTypeInfo s_dataTypeInfo[];
+
+	/* Slots of the data type name hash table, holding indices
+	into 's_dataTypeInfo' plus one (zero for empty slots)
+	*/
+	static unsigned char s_dataTypeSlots[];
+
+	/* True if all data type names have distinct slots
+	in the hash table (see buildDataTypeSlots()). If not,
+	data type name lookups fall back to a linear search.
+	*/
+	static const bool s_dataTypeSlotsPerfect;
+
+	// Fills 's_dataTypeSlots', and returns false if any slots collide
+	static bool buildDataTypeSlots(void);
 
-	// DataType constants in order of declaration
-	static const DataType s_dataTypesInOrder[];
+	// Generic implementation of the name-based getDataTypeInfo() functions
+	template<typename C> static const DataTypeInfo* lookupDataTypeName(
+		const C* const name, const size_t length);
 
 	// Nested classes
 public:
@@ -114,24 +211,65 @@ public:
 	 */
 	class Value {
 
+	public:
+		/* A function which converts the text form of a value ('raw')
+		to a dynamically-allocated value of the given data type ('value').
+
+		Returns ERROR_SUCCESS only if a value was produced.
+		'msg' is used to output a description of any problems
+		(which may be present even if a value was produced).
+		*/
+		typedef HRESULT (*Decoder)(const DataType type, const std::string& raw,
+			const void*& value, std::wstring& msg);
+
 	private:
 		const DataType m_type;
-		const void* const m_value;
+
+		// Null if the value is undecoded, or could not be decoded
+		mutable const void* m_value;
+
+		// Text form of the value. Null if the value has been decoded.
+		mutable std::string* m_raw;
+		Decoder m_decoder;
+
+		// Results of decoding the value
+		mutable bool m_decodeFailed;
+		mutable std::wstring m_decodeMsg;
 
 	public:
 		/* The Value object gets ownership of the 'value' pointer,
 		meaning that it will delete the pointer on destruction.
 		*/
 		Value(const DataType type, const void* const value);
+
+		/* Creates an undecoded value, which will be decoded
+		by the 'decoder' function when it is first retrieved.
+		Throws an exception of type std::invalid_argument if 'decoder' is null.
+		*/
+		Value(const DataType type, const std::string& raw, Decoder decoder);
+
 		~Value(void);
 
 	public:
 		DataType getDataType(void) const;
 		/* Returns the value stored in this object,
-		or null, if the value is not of the input data type.
+		or null, if the value is not of the input data type
+		or could not be decoded.
 		*/
 		const void* const getValue(const DataType type) const;
 
+		/* Decodes the value, if it is undecoded.
+		Returns a success result, with the ERROR_INVALID_DATA code,
+		if the value could not be decoded (now, or by an earlier call).
+		*/
+		HRESULT decode(void) const;
+
+		/* Returns the message output by the decoding function, if any
+		(An empty string for values which did not need decoding,
+		or have not been decoded yet)
+		*/
+		const std::wstring& getDecodeMessage(void) const;
+
 		// Currently not implemented - will cause linker errors if called
 	private:
 		Value(const Value& other);
@@ -199,7 +337,7 @@ private:
 	or if a value exists for the key, but with a data type other than 'type'.
 	*/
 	const void* retrieve(const std::wstring& scope, const std::wstring& field,
-		const DataType type) const;
+		const DataType type, bool* const invalidOut = 0) const;
 
 	/* Formats the three input parameters into a single string,
 	which is appended to 'out':
@@ -243,6 +381,11 @@ public:
 
 	Retrieval functions will return failure results for internal errors.
 
+	If the value corresponding to the key parameters has the given type,
+	but could not be decoded (see the Value class), retrieval functions
+	return a success result, but with the ERROR_INVALID_DATA error code.
+	The reason can be obtained using getDecodeMessage().
+
 	Insertion functions will return a success result, but with the
 	ERROR_ALREADY_ASSIGNED error code if the Config
 	object already has a value stored with the given key parameters.
@@ -277,6 +420,71 @@ public:
 	template<DataType D, typename T> HRESULT retrieve(
 		const std::wstring& scope, const std::wstring& field, const T*& value,
 		std::wstring* locatorsOut = 0) const;
+
+	/* Inserts a data type-value pair that has already been wrapped
+	in a Value object (e.g. by a parser which produces values
+	before deciding where to store them).
+
+	The Config object takes ownership of the 'value' pointer only if
+	this function returns ERROR_SUCCESS. Otherwise, this function
+	behaves like the insertion function template above,
+	with the data type being taken from the Value object.
+	*/
+	HRESULT insert(const std::wstring& scope, const std::wstring& field,
+		Value* const value, std::wstring* locatorsOut = 0);
+
+	/* Outputs the message produced when decoding the value
+	stored under the given key (see the Value class).
+	Returns a success result, but with the ERROR_DATA_NOT_FOUND error code,
+	if there is no value stored under the key.
+	*/
+	HRESULT getDecodeMessage(std::wstring& out,
+		const std::wstring& scope, const std::wstring& field) const;
+
+	/* Decodes all undecoded values.
+
+	If 'msgs' is not null, messages for all values which
+	could not be decoded, or for which the decoding function
+	reported problems, are appended to it, labelled with
+	the key and data type of the value.
+
+	Returns a success result, but with the ERROR_DATA_INCOMPLETE
+	error code, if some values could not be decoded.
+	*/
+	HRESULT validateAll(std::list<std::wstring>* const msgs = 0) const;
+
+	/* Inserts copies of all values in the 'src' Config object
+	that are not already present in this object.
+	Values which cannot be decoded are not copied.
+
+	If 'scopePrefix' is not empty, the copies are inserted
+	under the scopes produced by joinScopes('scopePrefix', original scope).
+
+	Returns a failure result in case of internal errors.
+	*/
+	HRESULT insertCopies(const Config& src, const std::wstring& scopePrefix = L"");
+
+	/* Makes this object's values equal to the values in the 'src' Config object:
+	Values stored under keys which are not present in this object are copied,
+	and values which differ from the values stored under the same keys
+	in this object (in data type or value) replace the values in this object.
+	Keys which are not present in 'src' are not modified.
+	Values which cannot be decoded are not copied.
+
+	If 'changed' is not null, the keys of values which were copied
+	are appended to it.
+
+	Note that pointers to replaced values, which were obtained
+	from retrieval functions, become invalid.
+
+	Returns a failure result in case of internal errors.
+	*/
+	HRESULT assignChanges(const Config& src, std::list<Key>* const changed = 0);
+
+	/* Returns 'scope' qualified by 'prefix', separated by CONFIG_SCOPE_PREFIX_SEP.
+	If either string is empty, the other string is returned.
+	*/
+	static std::wstring joinScopes(const std::wstring& prefix, const std::wstring& scope);
 };
 
 template<Config::DataType D, typename T> HRESULT Config::insert(
@@ -302,8 +510,11 @@ template<Config::DataType D, typename T> HRESULT Config::retrieve(
 		}
 	}
 
-	value = static_cast<const T*>(retrieve(scope, field, D));
-	if( value == 0 ) {
+	bool invalid = false;
+	value = static_cast<const T*>(retrieve(scope, field, D, &invalid));
+	if( invalid ) {
+		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_INVALID_DATA);
+	} else if( value == 0 ) {
 		return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_BL_ENGINE, ERROR_DATA_NOT_FOUND);
 	} else {
 		return ERROR_SUCCESS;
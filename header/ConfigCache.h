@@ -0,0 +1,180 @@
+/*
+ConfigCache.h
+-------------
+
+Created for: Spring 2014 Direct3D 11 Learning
+By: Bernard Llanos
+August 14, 2014
+
+Primary basis: None
+Other references: None
+
+Development environment: Visual Studio 2013 running on Windows 7, 64-bit
+  -Note that the "Character Set" project property (Configuration Properties > General)
+   should be set to Unicode for all configurations, when using Visual Studio.
+
+Description
+  -A process-wide cache of parsed configuration files, which allows a file
+   to be parsed only once while it is unchanged, even when it is
+   loaded by many objects (e.g. ConfigUser objects).
+  -Cached data is handed out as copies inserted into the caller's Config
+   objects (see Config::insertCopies()), because Config objects are
+   owned, and modified, by the objects that use them.
+
+Usage Notes
+  -Entries are keyed by the full path of the file (case-insensitive),
+   and by the class of the IConfigIO object used to read it,
+   as different IConfigIO classes can interpret the same file differently.
+   Settings of IConfigIO objects (e.g. FlatAtomicConfigIO::toggleLazyParsing())
+   are not taken into account.
+  -An entry is used while the file has the same identity (the volume serial
+   number and file index reported by GetFileInformationByHandle()), size,
+   and last modification time as after it was read. (These are recorded after
+   the file is read, because IConfigIO objects may append reports to the files
+   that they read.)
+  -Files from which the IConfigIO object loaded data in addition to the file
+   itself (e.g. files included by the file, see IConfigIO::getIncludedFiles())
+   are recorded in the entry in the same way, and the entry is used only
+   while all of them are unchanged. The results of read operations for which
+   any of these files cannot be found are not cached.
+  -Optionally, a hash of the contents of the file is also compared,
+   to detect modifications which do not change the size or modification time
+   of the file, at the cost of reading the file to validate the entry.
+  -Only read operations which return success results are cached.
+   The result (e.g. ERROR_DATA_INCOMPLETE) is returned again for each use
+   of the cached data.
+  -The cache is disabled by default (see setEnabled()).
+  -All functions are safe to call from multiple threads. If several threads
+   request the same file at once, one thread reads the file,
+   and the others wait for the result. Cached data is validated
+   and copied without holding the cache's lock, so threads requesting
+   different files do not wait for each other's file operations or copies.
+*/
+
+#pragma once
+
+#include <windows.h>
+#include <string>
+#include <map>
+#include <vector>
+#include <utility>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include "Config.h"
+#include "IConfigIO.h"
+
+class ConfigCache {
+
+private:
+	// Properties used to detect changes to a file
+	struct FileIdentity {
+		uint32_t volumeSerial;
+		uint64_t fileIndex;
+		uint64_t size;
+		uint64_t writeTime; // As a FILETIME
+		uint64_t contentHash; // Zero if not computed
+	};
+
+	/* Entries are not modified after they are completed (when 'config'
+	   is set), so a completed entry can be used without holding the mutex,
+	   through a shared pointer which keeps it alive if it is removed
+	   from the cache in the meantime.
+	 */
+	struct Entry {
+		FileIdentity identity;
+
+		// Full paths and identities of the other files from which data was loaded
+		std::vector<std::pair<std::wstring, FileIdentity> > includes;
+
+		// Null while the file is being read
+		Config* config;
+
+		// The return value of the read operation
+		HRESULT result;
+
+		Entry(void);
+		~Entry(void);
+
+		// Currently not implemented - will cause linker errors if called
+	private:
+		Entry(const Entry& other);
+		Entry& operator=(const Entry& other);
+	};
+
+	// Entries keyed by IConfigIO class name and lowercase full path
+	typedef std::pair<std::string, std::wstring> EntryKey;
+
+private:
+	static std::map<EntryKey, std::shared_ptr<Entry> > s_entries;
+
+	// Guards all of the static members
+	static std::mutex s_mutex;
+
+	// Signalled when a file has been read
+	static std::condition_variable s_readComplete;
+
+	// Set by setEnabled()
+	static bool s_enabled;
+
+	// Set by setContentHashing()
+	static bool s_hashContents;
+
+public:
+	/* Enables (true) or disables (false) the cache.
+	   When the cache is disabled, read() passes calls directly
+	   to the IConfigIO object, and all cached data is discarded.
+	   Returns the previous state of this setting.
+	 */
+	static bool setEnabled(const bool enabled);
+
+	/* Enables (true) or disables (false) the comparison of
+	   hashes of file contents when validating cache entries.
+	   Returns the previous state of this setting.
+	   Content hashing is disabled by default.
+	 */
+	static bool setContentHashing(const bool hashContents);
+
+	/* Inserts the data from the file into the Config object,
+	   using cached data if available and up to date, and otherwise
+	   reading the file using the 'configIO' object and caching the result.
+
+	   As for IConfigIO::read(), data is not inserted under keys
+	   which are already present in the Config object.
+
+	   Returns the return value of the read operation
+	   which produced the data, or a failure result
+	   if the data could not be copied into the Config object.
+	 */
+	static HRESULT read(IConfigIO& configIO, const std::wstring& filename,
+		Config& config);
+
+	// Discards all cached data, except for files which are currently being read
+	static void clear(void);
+
+private:
+	/* Outputs the identity of the file, and a hash of its contents
+	   if 'hashContents' is true. Returns a failure result
+	   if the file cannot be opened.
+	 */
+	static HRESULT getFileIdentity(const std::wstring& filename,
+		FileIdentity& out, const bool hashContents);
+
+	/* Returns true if the file which was read has the identity 'identity',
+	   and all of the other files recorded in the entry still have
+	   the recorded identities. Called without holding the mutex,
+	   as it may open and hash files.
+	 */
+	static bool entryValid(const Entry& entry, const FileIdentity& identity,
+		const bool hashContents);
+
+	// 64-bit FNV-1a hash function
+	static uint64_t hash(const char* const data, const size_t length);
+
+	// Currently not implemented - will cause linker errors if called
+private:
+	ConfigCache(void);
+	ConfigCache(const ConfigCache& other);
+	ConfigCache& operator=(const ConfigCache& other);
+};
\ No newline at end of file
@@ -56,6 +56,8 @@ Notes
 #include "LogUser.h"
 #include "Config.h"
 #include "IConfigIO.h"
+#include "ConfigCache.h"
+#include "ConfigWatcher.h"
 
 /* Suggested configuration data keys to be used by derived classes
    to retrieve ConfigUser-related parameter values.
@@ -396,6 +398,14 @@ private:
 	   have been augmented (if 'overwrite' is false), or will have been replaced
 	   with a Config instance that is missing some data (if 'overwrite' is true).
 	   In this case, this function will also return ERROR_DATA_INCOMPLETE.
+
+	   Data is read through ConfigCache::read(), so that a file loaded
+	   by several objects is parsed only once while it is unchanged
+	   (if the cache is enabled).
+
+	   If the global ConfigWatcher exists, the file is watched, and changes
+	   to it will be applied to this object's Config instance
+	   by the application loop (see ConfigWatcher).
 	 */
 	template<typename ConfigIOClass> HRESULT setPrivateConfig(
 		ConfigIOClass* const optionalLoader,
@@ -750,7 +760,8 @@ template<typename ConfigIOClass> HRESULT ConfigUser::setPrivateConfig(
 	}
 	Config* config = (overwrite || (m_config == 0)) ? new Config : m_config;
 
-	HRESULT error = configIO->read(filenameAndPath, *config);
+	// The file is parsed only if it is not in the cache (when the cache is enabled)
+	HRESULT error = ConfigCache::read(*configIO, filenameAndPath, *config);
 	if( FAILED(error) ) {
 		std::wstring errorStr;
 		if( FAILED(prettyPrintHRESULT(errorStr, error)) ) {
@@ -774,6 +785,9 @@ template<typename ConfigIOClass> HRESULT ConfigUser::setPrivateConfig(
 		if( config != m_config ) {
 			if( m_config != 0 ) {
 				CONFIGUSER_LOGMESSAGE(L"setPrivateConfig() base function: This object's Config instance was overwritten.")
+				if( g_configWatcher != 0 ) {
+					g_configWatcher->unwatch(*m_config);
+				}
 				delete m_config;
 			} else {
 				CONFIGUSER_LOGMESSAGE(L"setPrivateConfig() base function: Config instance was (re-)initialized.")
@@ -782,6 +796,11 @@ template<typename ConfigIOClass> HRESULT ConfigUser::setPrivateConfig(
 		} else {
 			CONFIGUSER_LOGMESSAGE(L"setPrivateConfig() base function: Config instance was augmented (assuming the loaded data was non-empty and at least some keys were new).")
 		}
+
+		// Changes to the file will be applied to the Config instance
+		if( g_configWatcher != 0 && FAILED(g_configWatcher->watch<ConfigIOClass>(filenameAndPath, *m_config)) ) {
+			CONFIGUSER_LOGMESSAGE(L"setPrivateConfig() base function: Failed to watch the configuration file for modifications.")
+		}
 	}
 
 	// Cleanup
@@ -847,6 +866,10 @@ template<Config::DataType D, typename T> bool ConfigUser::retrieve(
 			CONFIGUSER_LOGMESSAGE(L"retrieve() using the key " + locators + L" failed with error: " + errorStr)
 		} else if( HRESULT_CODE(error) == ERROR_DATA_NOT_FOUND ) {
 			CONFIGUSER_LOGMESSAGE(L"retrieve() using the key " + locators + L" returned no data.")
+		} else if( HRESULT_CODE(error) == ERROR_INVALID_DATA ) {
+			std::wstring decodeMsg;
+			config->getDecodeMessage(decodeMsg, scope, field);
+			CONFIGUSER_LOGMESSAGE(L"retrieve() using the key " + locators + L" found an invalid value: " + decodeMsg)
 		} else {
 			result = true;
 		}
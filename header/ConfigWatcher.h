@@ -0,0 +1,281 @@
+/*
+ConfigWatcher.h
+---------------
+
+Created for: Spring 2014 Direct3D 11 Learning
+By: Bernard Llanos
+August 15, 2014
+
+Primary basis: None
+Other references:
+  -Obtaining directory change notifications:
+   http://msdn.microsoft.com/en-us/library/windows/desktop/aa365261%28v=vs.85%29.aspx
+
+Development environment: Visual Studio 2013 running on Windows 7, 64-bit
+  -Note that the "Character Set" project property (Configuration Properties > General)
+   should be set to Unicode for all configurations, when using Visual Studio.
+
+Description
+  -Reloads configuration files when they are modified, so that changes
+   to configuration data take effect without restarting the program.
+  -A background thread waits for change notifications on the directories
+   containing the watched files (see FindFirstChangeNotification()).
+   If notifications are unavailable for a directory, the thread
+   polls the sizes and modification times of the files instead.
+  -Files included by a watched file (see IConfigIO::getIncludedFiles())
+   are also watched, and a modification to an included file
+   causes the file which includes it to be reparsed.
+   The list of included files is refreshed whenever the file is reparsed.
+  -Bursts of writes to a file are combined: a file is reparsed once it
+   has been unchanged for CONFIGWATCHER_DEBOUNCE_MS milliseconds.
+  -Files are reparsed by the background thread, but the new data
+   is only applied to the watched Config objects when applyChanges()
+   is called, which should be done by the application loop, at a point
+   where no other code is using the Config objects.
+  -Only values which differ from the current values are applied
+   (see Config::assignChanges()).
+
+Usage Notes
+  -Applying changes replaces the affected values in the Config objects,
+   so pointers to those values that were retrieved earlier become invalid.
+   Keys which are removed from a file keep their last values.
+  -Each watched file is parsed by an IConfigIO object owned by the
+   ConfigWatcher, which is used only by the background thread
+   (after it is used by watch() to find the included files).
+   If several Config objects watch the same file using the same
+   IConfigIO class, the file is parsed once per modification.
+  -Watched files are never modified: report output is disabled for the
+   IConfigIO objects (see IConfigIO::toggleReportOutput()), so problems
+   found when reparsing a file are logged instead.
+  -The Config objects must be unregistered (see unwatch()) before they
+   are deleted, or the ConfigWatcher must be destroyed first.
+  -Messages from the background thread are logged
+   when applyChanges() is called.
+  -watch(), unwatch() and applyChanges() must be called
+   from the same thread (e.g. the thread running the application loop).
+  -The latency from a file's modification time to the new data
+   being applied is measured for each reload, and a message is logged
+   if it exceeds CONFIGWATCHER_LATENCY_TARGET_MS milliseconds.
+   (Note that the latency includes the time until applyChanges()
+   is called by the application loop.)
+*/
+
+#pragma once
+
+#include <windows.h>
+#include <string>
+#include <list>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <typeinfo>
+#include <cstdint>
+#include "LogUser.h"
+#include "Config.h"
+#include "IConfigIO.h"
+#include "fileUtil.h"
+
+/* Time for which a file must be unchanged before it is reparsed,
+   in milliseconds
+ */
+#define CONFIGWATCHER_DEBOUNCE_MS 10
+
+/* Interval at which the sizes and modification times of files are
+   checked when change notifications are not available, in milliseconds
+ */
+#define CONFIGWATCHER_POLL_MS 20
+
+/* Target latency, from the modification of a file to the application
+   of the new data, in milliseconds
+ */
+#define CONFIGWATCHER_LATENCY_TARGET_MS 50.0
+
+class ConfigWatcher : public LogUser {
+
+private:
+	// A file included by a watched file
+	struct SourceFile {
+		// Full path of the file, and of the directory containing it
+		std::wstring filename;
+		std::wstring directory;
+
+		// Properties of the file when it was last checked (zero if it was not found)
+		uint64_t size;
+		uint64_t writeTime;
+
+		SourceFile(void);
+	};
+
+	struct WatchedFile {
+		// Full path of the file, and of the directory containing it
+		std::wstring filename;
+		std::wstring directory;
+
+		// Name of the class of the IConfigIO object
+		std::string ioClassName;
+		IConfigIO* configIO;
+
+		// Config objects to receive the data (not owned). Empty when no longer watched.
+		std::list<Config*> targets;
+
+		// Properties of the file when it was last checked or read
+		uint64_t size;
+		uint64_t writeTime;
+
+		// Files included by the file when it was last read
+		std::vector<SourceFile> includes;
+
+		// True if the file has changed since it was last read
+		bool pending;
+
+		// Time of the last change detected (from GetTickCount())
+		DWORD changeTick;
+
+		WatchedFile(void);
+		~WatchedFile(void);
+
+		// Currently not implemented - will cause linker errors if called
+	private:
+		WatchedFile(const WatchedFile& other);
+		WatchedFile& operator=(const WatchedFile& other);
+	};
+
+	// Data parsed by the background thread, waiting to be applied
+	struct Reload {
+		std::wstring filename;
+		Config* target; // Not owned
+		Config* data;
+		uint64_t writeTime; // As a FILETIME
+
+		Reload(void);
+		~Reload(void);
+
+		// Currently not implemented - will cause linker errors if called
+	private:
+		Reload(const Reload& other);
+		Reload& operator=(const Reload& other);
+	};
+
+private:
+	// Guards all data members shared with the background thread
+	std::mutex m_mutex;
+
+	std::list<WatchedFile*> m_files;
+
+	/* Files which are no longer watched, to be deleted
+	   by the background thread (which may be using them)
+	 */
+	std::list<WatchedFile*> m_retired;
+
+	std::list<Reload*> m_reloads;
+
+	// Messages from the background thread
+	std::list<std::wstring> m_threadMsgs;
+
+	// True if the set of watched directories has changed
+	bool m_filesChanged;
+
+	// True if the background thread must exit
+	bool m_quit;
+
+	// True if polling is used for all files (see forcePolling())
+	bool m_forcePolling;
+
+	// Wakes the background thread
+	HANDLE m_wakeEvent;
+
+	std::thread m_thread;
+
+	// Reload latencies, in milliseconds (used only by the calling thread)
+	double m_lastLatency;
+	double m_maxLatency;
+
+public:
+	/* Starts the background thread.
+	   Throws an exception of type std::exception if the thread
+	   or its synchronization objects cannot be created.
+	 */
+	ConfigWatcher(void);
+
+	// Stops the background thread
+	virtual ~ConfigWatcher(void);
+
+public:
+	/* Watches the file for modifications, and applies
+	   changes to its data to the 'config' object.
+	   The file is parsed using an object of class 'ConfigIOClass',
+	   which must have a zero-parameter constructor.
+
+	   The current modification time of the file is recorded,
+	   so this function should be called after the file has been read
+	   into the 'config' object.
+
+	   Returns a failure result if the file does not exist.
+	 */
+	template<typename ConfigIOClass> HRESULT watch(const std::wstring& filename,
+		Config& config);
+
+	/* Stops applying changes to the 'config' object,
+	   and discards changes which have not been applied yet.
+	   Files watched only for this object are no longer watched.
+	 */
+	void unwatch(const Config& config);
+
+	/* Applies the changes which have been parsed since the last call
+	   to the watched Config objects, and logs messages from
+	   the background thread.
+
+	   To be called from the application loop. 'nApplied'
+	   is output as the number of reloaded files that were applied.
+
+	   Returns a failure result if changes could not be applied.
+	 */
+	HRESULT applyChanges(unsigned int* const nApplied = 0);
+
+	/* Outputs the latency of the last reload, and the maximum latency
+	   of all reloads, in milliseconds (or zero, if no reloads have occurred).
+	 */
+	void getLatency(double& last, double& max) const;
+
+	/* Toggles whether (true) or not (false) to poll all files,
+	   rather than waiting for change notifications.
+	   Returns the previous state of this setting.
+	 */
+	bool forcePolling(const bool poll);
+
+private:
+	// Registers the file with the given IConfigIO object, which is deleted if not used
+	HRESULT watch(const std::wstring& filename, Config& config,
+		IConfigIO* const configIO, const std::string& ioClassName);
+
+	// The function run by the background thread
+	void watchFiles(void);
+
+	/* Checks the files for modifications, and reparses files
+	   which have been unchanged for long enough.
+	   Outputs the time until the next file would need to be reparsed,
+	   or INFINITE, if no files are waiting to be reparsed.
+	 */
+	void checkFiles(DWORD& timeout);
+
+	// Reparses the file, and queues the data for application
+	void reloadFile(WatchedFile& file);
+
+	/* Outputs the included files named in 'filenames',
+	   together with their current sizes and modification times.
+	   Returns true if the set of filenames differs from 'previous'.
+	 */
+	static bool stampIncludes(std::vector<SourceFile>& includes,
+		const std::vector<std::wstring>& filenames, const std::vector<SourceFile>& previous);
+
+	// Currently not implemented - will cause linker errors if called
+private:
+	ConfigWatcher(const ConfigWatcher& other);
+	ConfigWatcher& operator=(const ConfigWatcher& other);
+};
+
+template<typename ConfigIOClass> HRESULT ConfigWatcher::watch(const std::wstring& filename,
+	Config& config) {
+
+	return watch(filename, config, new ConfigIOClass, typeid(ConfigIOClass).name());
+}
\ No newline at end of file
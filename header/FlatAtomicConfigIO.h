@@ -20,14 +20,22 @@ Description
 	 (e.g. such as a Config object being stored with a given key inside another Config object)
 	-"Atomic" refers to the fact that only single values are stored under each key in the Config
 	 objects handled by this class, rather than lists/arrays/sets of values.
+  -Configuration files can include other configuration files (see read()).
 */
 
 #pragma once
 
 #include <windows.h>
 #include <string>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
 #include <map>
+#include <set>
+#include <list>
+#include <vector>
 #include <iterator>
+#include <istream>
 #include "LogUser.h"
 #include "Config.h"
 #include "IConfigIO.h"
@@ -64,6 +72,13 @@ created from Config objects by instances of this class.
 	L"# \t '='\n"\
 	L"# \t A value\n"\
 	L"#\n"\
+	L"# An include directive is, in the following order,\n"\
+	L"# \t 'INCLUDE'\n"\
+	L"# \t '--'\n"\
+	L"# \t Optionally, a scope prefix for the included data (any characters)\n"\
+	L"# \t '::'\n"\
+	L"# \t A filename, in double quotes, relative to the directory of this file\n"\
+	L"#\n"\
 	L"# Each of the above elements can optionally be separated by whitespace\n"\
 	L"# from the others, but any whitespace within an element\n"\
 	L"# will be stripped during processing, with the exception that\n"\
@@ -92,6 +107,8 @@ created from Config objects by instances of this class.
 #define FLATATOMICCONFIGIO_SEP_3 "="
 #define FLATATOMICCONFIGIO_SEP_3_WSTR L"="
 #define FLATATOMICCONFIGIO_WHITESPACE_SEP L"\t" // To add whitespace during serialization, for readability
+#define FLATATOMICCONFIGIO_INCLUDE "INCLUDE" // Used in place of a datatype name to start an include directive
+#define FLATATOMICCONFIGIO_INCLUDE_WSTR L"INCLUDE"
 
 #define FLATATOMICCONFIGIO_MAX_LINE_LENGTH 255
 /* Used to catch line length violations.
@@ -103,6 +120,39 @@ created from Config objects by instances of this class.
 #define FLATATOMICCONFIGIO_LINE_SEP '\n'
 #define FLATATOMICCONFIGIO_LINE_SEP_WSTR L"\n"
 
+/* When reading files using multiple threads, files are divided
+   into chunks of at least this many bytes (except for the last chunk)
+   so that small files are not split into more pieces than is worthwhile.
+ */
+#define FLATATOMICCONFIGIO_MIN_CHUNK_SIZE 65536
+
+/* Number of chunks per thread used when reading files using multiple threads.
+   Having more chunks than threads balances the load between threads.
+ */
+#define FLATATOMICCONFIGIO_CHUNKS_PER_THREAD 4
+
+/* Size of the buffer used to transfer data from streams and file handles
+   to the incremental parser (see beginParse())
+ */
+#define FLATATOMICCONFIGIO_STREAM_BUFFER_LENGTH 4096
+
+/* Amount of UTF-8-encoded output (in bytes) accumulated by write()
+   before it is written to the file
+ */
+#define FLATATOMICCONFIGIO_WRITE_BUFFER_LENGTH 65536
+
+/* Maximum amount of data, as a percentage of the size of the file,
+   which update() will modify or append when patching a file.
+   If a larger amount of data would be written, the entire file is rewritten.
+ */
+#define FLATATOMICCONFIGIO_MAX_PATCH_PERCENT 25
+
+/* Replaces lines for keys which update() has removed from a file,
+   or has moved to the end of the file. Truncated, or padded with spaces,
+   to the length of the line being replaced.
+ */
+#define FLATATOMICCONFIGIO_DISABLED_LINE "# (Removed or moved by FlatAtomicConfigIO update)"
+
 #define FLATATOMICCONFIGIO_START_OUTPUT L"START"
 #define FLATATOMICCONFIGIO_END_OUTPUT L"END"
 
@@ -113,10 +163,119 @@ private:
 	static const Config::DataType s_supportedDataTypes[];
 	static const size_t s_nSupportedDataTypes;
 
+protected:
+	// The location of a line in a file (see update())
+	struct LineLocation {
+		uint64_t offset; // In bytes, from the start of the file
+		size_t length; // In bytes, excluding the line separator
+	};
+
+	// An include directive (see read())
+	struct Include {
+		std::wstring filename; // Relative to the including file, until resolved
+		std::wstring scopePrefix;
+		size_t lineNumber;
+
+		// Index of the included file in the list of files being composed
+		size_t target;
+	};
+
+	/* A file loaded as a result of an include directive,
+	   or the file which was originally read.
+	   Shared by all directives including the same file.
+	 */
+	struct IncludedFile {
+		std::wstring filename; // Full path
+		Config config; // Data from this file only, without scope prefixes
+		std::list<Include> includes;
+		std::list<std::wstring> msgs; // Parsing problems
+		HRESULT result; // As for the return value of read()
+
+		IncludedFile(void);
+
+		// Currently not implemented - will cause linker errors if called
+	private:
+		IncludedFile(const IncludedFile& other);
+		IncludedFile& operator=(const IncludedFile& other);
+	};
+
 private:
 	// Flag controlled by toggleContextOutput()
 	bool m_outputContext;
 
+	// Flag controlled by toggleReportOutput()
+	bool m_outputReports;
+
+	// Number of threads used by read(), controlled by setReadThreads()
+	unsigned int m_nReadThreads;
+
+	// Flag controlled by toggleLazyParsing()
+	bool m_lazyParsing;
+
+	// Flag controlled by toggleLineIndexing()
+	bool m_lineIndexing;
+
+	// Index of the lines in a file, used by update()
+	// ----------------------------------------------
+
+	// The first line in the file for each key
+	std::map<Config::Key, LineLocation> m_lineIndex;
+
+	// The indexed file, or an empty string if there is no index
+	std::wstring m_lineIndexFilename;
+
+	/* The size and modification time of the file when it was indexed,
+	   used to detect whether the file has since been modified
+	 */
+	uint64_t m_lineIndexFileSize;
+	uint64_t m_lineIndexWriteTime;
+
+	/* Include directives found in the file being read by read(),
+	   in order of appearance
+	 */
+	std::list<Include> m_includes;
+
+	/* Full paths of the files loaded through include directives
+	   by the last call to read() (see getIncludedFiles())
+	 */
+	std::vector<std::wstring> m_includedFiles;
+
+	/* The file most recently read by read(), if it contained include directives,
+	   with its include directives (filenames as written in the file),
+	   and the keys whose values were loaded from the included files.
+	   Used by update(), so that included data is not copied into the including file.
+	 */
+	std::wstring m_includingFilename;
+	std::list<Include> m_fileIncludes;
+	std::set<Config::Key> m_includedKeys;
+
+	/* Reused by writeDataLine() for data values which cannot be
+	   serialized directly into the output line
+	 */
+	std::wstring m_valueBuffer;
+
+	// State of the incremental parser (see beginParse())
+	// --------------------------------------------------
+
+	/* Destination of parsed data,
+	   which is null when the incremental parser is not in use.
+	 */
+	Config* m_parseConfig;
+
+	/* Holds the part of the current line received so far.
+	   Long enough to hold a line of the maximum length,
+	   plus a carriage return and a null terminator.
+	 */
+	char m_parseLine[FLATATOMICCONFIGIO_LINE_BUFFER_LENGTH];
+	size_t m_parseLength; // Number of characters in 'm_parseLine'
+	size_t m_parseLineNumber; // Line number of the current line
+	HRESULT m_parseResult; // Cumulative result of the parsing operation
+
+	/* Set when the parsing operation is aborted,
+	   such that further input is ignored
+	 */
+	bool m_parseStopped;
+
 public:
 	// Returns true if this class can process this data type
 	static bool isSupportedDataType(Config::DataType type);
@@ -155,7 +314,244 @@ public:
 	 */
 	virtual bool toggleContextOutput(const bool outputContext) override;
 
-	/* This class disables external control over its logging output flag.
+	/* Outputs the files loaded through include directives
+	   by the last call to read(), including files which could not be read.
+	   (See IConfigIO.h for details)
+	 */
+	virtual void getIncludedFiles(std::vector<std::wstring>& filenames) const override;
+
+	/* Outputs the files which read() would load through include directives,
+	   in the order in which read() would load them, by scanning the files
+	   for include directives only. Included files which cannot be read
+	   are listed, but not scanned.
+	   (See IConfigIO.h for details)
+
+	   Returns a failure result if 'filename' cannot be read.
+	 */
+	virtual HRESULT listIncludedFiles(const std::wstring& filename,
+		std::vector<std::wstring>& filenames) const override;
+
+	/* Toggles whether read(), write() and update() append reports
+	   of problems to the files. When disabled, the problems are logged instead.
+	   Enabled by default.
+	   (See IConfigIO.h for details)
+	 */
+	virtual bool toggleReportOutput(const bool outputReports) override;
+
+	/* Toggles whether (true) or not (false) data values are parsed
+	   when they are first retrieved from the Config object,
+	   rather than when they are read from the file.
+
+	   When enabled, only the datatypes and keys of lines are parsed
+	   during reading, and the text of each value is stored with
+	   the value in the Config object (see Config::Value).
+	   Invalid values are therefore not reported in the parsing
+	   report appended to the file, but are instead reported
+	   when they are retrieved from the Config object,
+	   or by Config::validateAll().
+
+	   Returns the previous state of this setting.
+	   Lazy parsing is disabled by default.
+	 */
+	bool toggleLazyParsing(const bool lazyParsing);
+
+	/* Sets the number of threads to be used by read().
+
+	   When more than one thread is requested, read() maps the file
+	   into memory, splits it into chunks on line boundaries, and parses
+	   the chunks concurrently. The results are then merged in the order
+	   of the chunks in the file, such that the contents of the Config object,
+	   the return value of read(), and the parsing report appended to the file
+	   are the same as they would be if the file was read by a single thread.
+
+	   A value of zero selects the number of hardware threads
+	   reported by the system. The default is one thread,
+	   in which case the file is read line-by-line as a stream.
+
+	   Returns the previous value of this setting.
+	 */
+	unsigned int setReadThreads(const unsigned int nThreads);
+
+	/* Toggles whether (true) or not (false) read() records the location
+	   of the first line for each key in the file, for use by update().
+	   When enabled, files are always read by mapping them into memory
+	   (as described for setReadThreads()).
+
+	   Only the most recently read file is indexed, and a read
+	   with line indexing disabled discards the index.
+	   Returns the previous state of this setting.
+	   Line indexing is disabled by default.
+	 */
+	bool toggleLineIndexing(const bool lineIndexing);
+
+	/* Saves configuration data to a file, modifying only the lines
+	   for keys whose values have changed.
+
+	   If the file was the last file read by this object with line indexing
+	   enabled (or the last file updated by this object),
+	   and has not been modified since, then
+	     -Lines whose values are equal to the values
+	      in the Config object are left untouched.
+	     -Lines whose new values fit within the existing lines
+	      are overwritten in place (padded with trailing whitespace).
+	     -Lines for keys which are not present in the Config object,
+	      or whose new values do not fit within the existing lines,
+	      are replaced by comments of the same length.
+	     -Keys which are new, or which did not fit within their
+	      existing lines, are appended to the file in a new section.
+	   Comments, formatting, and lines which were not recognized
+	   as configuration data, are preserved.
+
+	   Otherwise, or if more than FLATATOMICCONFIGIO_MAX_PATCH_PERCENT
+	   percent of the file would be modified or appended,
+	   the file is overwritten as by write(), and then indexed.
+
+	   If the file was the last file read by this object, and contained
+	   include directives, keys whose values were loaded from included files
+	   are not written to it (even if their values have changed, as they
+	   belong to the included files), and its include directives
+	   are preserved when it is rewritten.
+
+	   Serialization problems are appended to the file and reported
+	   through the return value as for write().
+	 */
+	HRESULT update(const std::wstring& filename, const Config& config);
+
+	/* Incremental parsing of configuration data from sources other than files
+	   ------------------------------------------------------------------------
+	   Data is passed to parse() in blocks of any size (including blocks
+	   which start or end in the middle of lines) between calls to
+	   beginParse() and endParse(). Each line is parsed and inserted
+	   into the Config object as soon as it is complete.
+	   Memory use is therefore bounded by the maximum line length,
+	   rather than by the total size of the data.
+
+	   The data format, and the treatment of keys already present in the
+	   Config object, are the same as for read().
+	   Since there is no file to append a parsing report to,
+	   parsing problems are logged to this object's Logger by endParse().
+
+	   beginParse() returns a failure result, with the ERROR_WRONG_STATE error code,
+	   if an incremental parsing operation is already in progress.
+	   parse() and endParse() return failure results, with the same error code,
+	   if there is no parsing operation in progress.
+
+	   parse() and endParse() return the cumulative result of the
+	   parsing operation (as defined for the return value of read()).
+	   Once a line longer than the maximum line length, or an internal error,
+	   is encountered, further data passed to parse() is ignored.
+
+	   The 'config' parameter of beginParse() must remain valid
+	   until endParse() has been called.
+
+	   The read() function should not be called during an incremental
+	   parsing operation, as it shares the parsing message list.
+	 */
+	HRESULT beginParse(Config& config);
+	HRESULT parse(const char* const data, const size_t length);
+	HRESULT endParse(void);
+
+	/* Convenience functions which parse all of the data from a source
+	   using the incremental parser.
+
+	   readStream() reads until the end of the stream.
+	   readHandle() reads using ReadFile() until the end of the file
+	   or until the write end of a pipe is closed. It does not close the handle.
+	   readBuffer() parses a block of memory.
+
+	   The return values are the same as those of endParse(),
+	   except that failure results are returned if data
+	   could not be read from the source.
+	 */
+	HRESULT readStream(std::istream& stream, Config& config);
+	HRESULT readHandle(HANDLE handle, Config& config);
+	HRESULT readBuffer(const char* const buffer, const size_t length, Config& config);
+
+	/* Include directives
+	   ------------------
+	   When read() encounters include directives (see the data format
+	   guidelines above), it loads the included files after the
+	   file itself, and inserts their data into the Config object.
+
+	   The data from an included file is inserted under scopes qualified by the
+	   scope prefix given in the include directive (see Config::joinScopes()),
+	   as well as by the scope prefixes which applied to the including file.
+
+	   Keys are resolved in a deterministic order, regardless of the order
+	   in which files finish loading: The data in a file takes precedence
+	   over the data in the files which it includes, and files included
+	   by earlier include directives take precedence over files included
+	   by later directives (and over the files which the later files include).
+	   Keys overridden in this way are not reported as problems.
+
+	   Included files are loaded concurrently, one file per thread,
+	   using the number of threads set by setReadThreads(), or the number
+	   of hardware threads if fewer than two threads have been requested.
+	   Files are loaded in waves, where each wave consists of the new files
+	   included by the files in the previous wave. A file included
+	   by several files is loaded only once per read() operation.
+
+	   Include directives which would cause a file to include itself,
+	   directly or indirectly, are ignored and reported.
+	   Problems in included files are reported in the parsing report
+	   appended to the file which was originally read, labelled with
+	   the names of the included files.
+
+	   Values from included files are copied into the Config object,
+	   and so are decoded during the read() operation even if lazy
+	   parsing is enabled. Values which cannot be decoded are omitted.
+
+	   Include directives are ignored (and reported) by the incremental parser.
+	   Only the file which was originally read is indexed by line indexing.
+	 */
+
+	/* Lint mode
+	   ---------
+	   Checks configuration files against the data format, including
+	   the parsing of data values, without inserting the data into Config objects,
+	   and without appending parsing reports to the files. Data values are
+	   checked without being allocated (see Config::DataTypeInfo::check).
+
+	   The problems reported are those which read() would report,
+	   except that include directives are checked for syntax only:
+	   included files are not loaded, and should be linted separately.
+	   Lazy parsing (see toggleLazyParsing()) does not apply,
+	   so invalid data values are always reported.
+
+	   Files are checked concurrently, one file per thread, using the
+	   number of threads set by setReadThreads() (where a value of zero
+	   selects the number of hardware threads). Each file is mapped into memory.
+	 */
+
+	/* Receives the problems found by lint(). Calls to report() from
+	   different threads are serialized by lint(), but the problems
+	   in different files may be interleaved. The problems in a given file
+	   are reported in order of line number.
+	 */
+	class LintSink {
+	public:
+		/* 'lineNumber' is zero for problems which concern the whole file
+		   (e.g. if the file cannot be opened). 'msg' includes the line number.
+		 */
+		virtual void report(const std::wstring& filename, const size_t lineNumber,
+			const std::wstring& msg) = 0;
+
+		virtual ~LintSink(void) {}
+	};
+
+	/* Checks the files, streaming problems to 'sink'.
+	   If 'results' is not null, it is output with one result per file,
+	   with the same meanings as for the return value of read().
+
+	   Returns a failure result if any file could not be checked,
+	   a success result with the ERROR_DATA_INCOMPLETE error code if problems
+	   were found in any file, and ERROR_SUCCESS otherwise.
+	 */
+	HRESULT lint(const std::vector<std::wstring>& filenames, LintSink& sink,
+		std::vector<HRESULT>* const results = 0) const;
+
+	/* Disabling logging does not affect the reports of problems which
+	   read(), write() and update() append to files (see toggleReportOutput()).
 	   As currently implemented, externally changing this object's Logger instance
 	   using setLogger() or revertLogger() is safe, except during
 	   calls to read() or write().
@@ -164,6 +560,252 @@ public:
 	virtual void disableLogging() override;
 
 protected:
+	/* The result of parsing a single line of a configuration file,
+	   prior to the insertion of its data into a Config object
+	 */
+	struct ParsedLine {
+		size_t lineNumber;
+		std::wstring scope;
+		std::wstring field;
+
+		/* Null if the line did not contain a valid data value.
+		   Owned by this object until it is inserted into a Config object.
+		 */
+		Config::Value* value;
+
+		// True if the value did not occupy the entire rest of the line
+		bool partialValue;
+
+		/* Location of the line in the file
+		   (only set when the file is mapped into memory)
+		 */
+		LineLocation location;
+
+		// True if the line is an include directive
+		bool include;
+
+		/* For include directives, the included file.
+		   (The scope prefix is stored in 'scope'.)
+		 */
+		std::wstring includeFilename;
+
+		/* Message output by the value parsing function (if any),
+		   to be reported when the value is inserted.
+		 */
+		std::wstring parseMsg;
+
+		// Problems encountered while parsing the line
+		std::list<std::wstring> msgs;
+
+		/* Set by the caller to check the line without creating a value,
+		   or converting the key to wide-character strings (see lint())
+		 */
+		bool lint;
+
+		/* In lint mode, the key scope, separator and field,
+		   as they appear in the line, instead of 'scope' and 'field'
+		 */
+		std::string key;
+
+		/* In lint mode, storage for checking string values,
+		   reused between lines (see Config::DataTypeInfo::check)
+		 */
+		std::wstring lintBuffer;
+
+		ParsedLine(void);
+		~ParsedLine(void);
+
+		// Currently not implemented - will cause linker errors if called
+	private:
+		ParsedLine(const ParsedLine& other);
+		ParsedLine& operator=(const ParsedLine& other);
+	};
+
+	/* A section of a memory-mapped file, processed by one thread
+	   when reading a file with multiple threads
+	 */
+	struct ReadChunk {
+		const char* start;
+		const char* end; // One past the last character in the chunk
+		size_t firstLineNumber;
+		uint64_t startOffset; // Offset of the chunk in the file, in bytes
+
+		// Lines which produced data or messages, in order
+		std::list<ParsedLine> lines;
+
+		/* Set to a failure code if parsing stopped early
+		   due to an internal error
+		 */
+		HRESULT result;
+
+		/* Line number at which parsing of the chunk stopped
+		   due to a line exceeding the maximum line length,
+		   or zero if this did not occur.
+		 */
+		size_t tooLongLine;
+
+		ReadChunk(void);
+	};
+
+	/* Parses a data type, key, value line
+	(the 'str' parameter) into the 'out' parameter,
+	whose 'lineNumber' member must be set by the caller.
+
+	The return value has the same meaning as for readDataLine().
+	Error messages are placed in the 'msgs' member of 'out'.
+
+	This function does not modify the object,
+	and so can be called from multiple threads concurrently.
+	*/
+	HRESULT parseDataLine(char* const str, ParsedLine& out) const;
+
+	/* Inserts the value held by the 'line' parameter into the 'config'
+	parameter (transferring ownership of the value if successful),
+	and outputs any problems to the 'msgStore' parameter.
+
+	The return value has the same meaning as for readDataLine().
+	*/
+	HRESULT insertParsedLine(Config& config, ParsedLine& line,
+		std::list<std::wstring>& msgStore) const;
+
+	/* Parses all lines in the chunk. Intended to be called
+	   from worker threads, which take chunks from the 'chunks' array
+	   in turn by incrementing 'nextChunk' until all 'nChunks'
+	   chunks have been processed.
+	 */
+	void readChunks(ReadChunk* const chunks, const size_t nChunks,
+		std::atomic<size_t>* const nextChunk) const;
+
+	/* Checks each file in turn, taking files from the 'filenames' array
+	   by incrementing 'nextFile' until all 'nFiles' files have been checked.
+	   The results are output in the 'results' array.
+	   Intended to be called from worker threads (see lint()).
+	 */
+	void lintFiles(const std::wstring* const filenames, HRESULT* const results,
+		const size_t nFiles, std::atomic<size_t>* const nextFile,
+		LintSink* const sink, std::mutex* const sinkMutex) const;
+
+	/* Checks a single file (helper function for lintFiles()),
+	   reporting problems to 'sink' while holding 'sinkMutex'
+	 */
+	HRESULT lintFile(const std::wstring& filename, LintSink& sink,
+		std::mutex& sinkMutex) const;
+
+	/* Parses the data value in the 'str' parameter, which must be
+	   of the given type, into a new dynamically-allocated object ('value').
+
+	   Returns a failure result if the parsing function failed,
+	   and a success result with the ERROR_DATA_INCOMPLETE code
+	   if no valid data value was found. 'partialValue' is set to true
+	   if the value did not occupy the entire string.
+	   Messages from the parsing functions for filenames and directories
+	   are output in 'parseMsg'.
+	 */
+	static HRESULT parseValue(const Config::DataType type, const char* const str,
+		const void*& value, bool& partialValue, std::wstring& parseMsg);
+
+	/* Behaves like parseValue(), but only checks the data value,
+	   without creating a value object. String values are parsed into 'buffer'.
+	 */
+	static HRESULT checkValue(const Config::DataType type, const char* const str,
+		bool& partialValue, std::wstring& parseMsg, std::wstring& buffer);
+
+	// Decoding function for lazily-parsed values (a Config::Value::Decoder)
+	static HRESULT decodeValue(const Config::DataType type, const std::string& raw,
+		const void*& value, std::wstring& msg);
+
+	/* Helper functions for read(), which differ in the method
+	   used to obtain and process lines from the file.
+
+	   The 'fail' output parameter is set to true if the file could not
+	   be read in its entirety due to problems with file access.
+	 */
+	HRESULT readSequential(const std::wstring& filename, Config& config, bool& fail);
+	HRESULT readParallel(const std::wstring& filename, Config& config, bool& fail);
+
+	/* Appends the messages in this object's message store to the file
+	   as comment lines, between header and footer lines
+	   naming the report ('title'), and clears the message store.
+
+	   The report is formatted in memory and written to the file
+	   using a single output operation.
+
+	   If report output is disabled (see toggleReportOutput()),
+	   the messages are logged instead, and the file is not modified.
+	 */
+	HRESULT appendReport(const std::wstring& filename, const std::wstring& title);
+
+	/* Loads and composes the files included by the file being read
+	   (see the description of include directives above).
+	   The include directives of the file are taken from 'm_includes'.
+	   Problems are added to this object's message store.
+
+	   Returns a failure result in case of internal errors,
+	   and a success result with the ERROR_DATA_INCOMPLETE error code
+	   if there were problems with the included files.
+	 */
+	HRESULT readIncludes(const std::wstring& filename, Config& config);
+
+	/* Loads each file in turn, taking files from the 'files' array
+	   by incrementing 'nextFile' until all 'nFiles' files have been loaded.
+	   Intended to be called from worker threads.
+	 */
+	void readIncludedFiles(IncludedFile** const files, const size_t nFiles,
+		std::atomic<size_t>* const nextFile) const;
+
+	/* Parses an included file into the 'config' member of the 'file' parameter
+	   (helper function for readIncludedFiles())
+	 */
+	void readIncludedFile(IncludedFile& file) const;
+
+	/* Outputs the filenames in the include directives of a file,
+	   as they appear in the file, without parsing any other lines
+	   (helper function for listIncludedFiles())
+	 */
+	HRESULT scanIncludes(const std::wstring& filename, std::list<std::wstring>& includes) const;
+
+	/* Inserts the data from the files included by the file at index 'fileIndex'
+	   in the 'files' array, recursively, using the given scope prefix.
+	   'onPath' marks the files which are currently being merged,
+	   and is used to detect circular inclusion.
+	 */
+	HRESULT mergeIncludes(Config& config, const std::vector<IncludedFile*>& files,
+		const size_t fileIndex, const std::wstring& scopePrefix,
+		std::vector<bool>& onPath);
+
+	// Adds the include directive parsed from a line to the list
+	static void addInclude(std::list<Include>& includes, const ParsedLine& line);
+
+	/* Implementation of write(). If 'includes' is not null, its include
+	   directives are written before the data, and if 'excludedKeys'
+	   is not null, values stored under those keys are not written.
+	 */
+	HRESULT writeFile(const std::wstring& filename, const Config& config, const bool overwrite,
+		const std::list<Include>* const includes, const std::set<Config::Key>* const excludedKeys);
+
+	/* Helper function for update(), which patches the file
+	   in place using the line index. The file is not modified,
+	   and 'rewrite' is set to true, if the file should
+	   be rewritten instead.
+	 */
+	HRESULT patchFile(const std::wstring& filename, const Config& config, bool& rewrite);
+
+	/* Builds the line index for the file (see toggleLineIndexing()),
+	   by reading the file with lazy parsing enabled
+	 */
+	HRESULT indexFile(const std::wstring& filename);
+
+	/* Returns true if the line (not null-terminated) contains a value
+	   equal to the 'value' parameter. Helper function for patchFile().
+	 */
+	bool lineHasValue(const char* const line, const size_t length,
+		const Config::Value& value) const;
+
+	/* Parses the line stored in 'm_parseLine' (helper function for the
+	   incremental parser) and prepares for the next line
+	 */
+	void parseStoredLine(void);
+
 	/* Processes a data type, key, value line
 	(the 'str' parameter). If successful, adds the data to the
 	Config object passed as the 'config' parameter.
@@ -192,6 +834,8 @@ protected:
 
 	The 'str' output parameter will set to an empty string if there
 	are errors or if there is no suitable data to output.
+	Its capacity is retained, so that the same string can be reused
+	efficiently for many lines.
 	*/
 	HRESULT writeDataLine(std::wstring& str, const std::map<Config::Key, Config::Value*>::const_iterator& data);
 
@@ -0,0 +1,195 @@
+/*
+FlightRecorder.h
+----------------
+
+Created for: Spring 2014 Direct3D 11 Learning
+By: Bernard Llanos
+August 21, 2014
+
+Primary basis: None
+Other references: None
+
+Development environment: Visual Studio 2013 running on Windows 7, 64-bit
+  -Note that the "Character Set" project property (Configuration Properties > General)
+   should be set to Unicode for all configurations, when using Visual Studio.
+
+Description
+  -A class which records messages in a fixed-size "ring" file, mapped into
+   the address space of the process, such that the file always holds
+   the most recent messages. Recording a message consists of reserving
+   space with an atomic increment, and copying the message into the mapped
+   view. There are no system calls, and no buffers to be written,
+   so the messages survive the abnormal termination of the process,
+   as the operating system writes the modified pages of the view to the file
+   regardless. (Messages are not safe from a crash of the operating system,
+   unless flush() is called.)
+  -decode() reconstructs the most recent messages in a ring file, in the order
+   in which they were recorded, and outputs them to a text file with the same
+   line format as the Logger class ("timestamp | message").
+  -A Logger can pass all of its messages to a FlightRecorder
+   (see Logger::setFlightRecorder()).
+
+Usage Notes
+  -record() can be called concurrently by multiple threads.
+   Other member functions are not thread-safe.
+   Only one FlightRecorder, in one process, should use a given file at a time.
+  -decode() can be called on a file which is in use by a FlightRecorder
+   (including one in another process). It decodes a copy of the file's
+   contents, so messages recorded while it is running may not be output.
+  -If the file exists, and is a ring file with the same capacity,
+   new messages are recorded after the messages already in the file
+   (e.g. those recorded before the application terminated abnormally).
+   Otherwise, the file is replaced.
+  -Messages longer than a quarter of the capacity of the ring are truncated.
+  -Times are computed from the monotonic clock, using readings of
+   the monotonic clock and the system clock taken when the object
+   is constructed, so they can drift from the system clock
+   if the object is used for a long time.
+
+Ring file format
+  -Header (see the FlightRecorder::FileHeader structure), followed by
+   the ring, whose size (the "capacity") is a power of two.
+  -Each record starts at a multiple of 8 bytes, and occupies a multiple
+   of 8 bytes, with a RecordHeader structure followed by the characters of
+   the message. Records can wrap around from the end of the ring to its start.
+  -The 'position' field of a record is the total number of bytes reserved
+   before the record since the ring was created, and is written last,
+   so a record is complete if its position corresponds to its location
+   in the ring. Records which were overwritten in part by newer records,
+   or which were being written when the application terminated, are detected
+   by their checksums, and are skipped by decode().
+   The file is not portable between machines of different endianness,
+   or between builds with different sizes of 'wchar_t'.
+*/
+
+#pragma once
+
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+// Suggested extension for ring files
+#define FLIGHTRECORDER_EXTENSION L".ring"
+
+// Identifies ring files ("BLFR" in little-endian byte order)
+#define FLIGHTRECORDER_MAGIC 0x52464C42
+// To be incremented whenever the ring file format changes
+#define FLIGHTRECORDER_VERSION 1
+
+// Default capacity of the ring, in bytes
+#define FLIGHTRECORDER_CAPACITY (1 << 20)
+
+class FlightRecorder
+{
+protected:
+	struct FileHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t charSize; // sizeof(wchar_t)
+		uint32_t reserved;
+		uint64_t capacity; // Size of the ring, in bytes
+	};
+
+	struct RecordHeader {
+		uint64_t position; // See above
+		int64_t time; // System time (as a FILETIME value) when the message was recorded
+		uint32_t size; // Size of the record, in bytes, including this header and padding
+		uint32_t length; // Length of the message, in characters
+		uint32_t checksum; // Of the other fields and the message
+		uint32_t reserved;
+	};
+
+	// Data members
+private:
+	HANDLE m_file;
+	HANDLE m_mapping;
+	char* m_view;
+
+	// Start of the ring in the mapped view
+	char* m_ring;
+
+	// Capacity of the ring, minus one
+	uint64_t m_mask;
+
+	// Maximum length of a message, in characters
+	uint32_t m_maxLength;
+
+	// Position at which the next record will be written
+	std::atomic<uint64_t> m_writePos;
+
+	// Readings of the monotonic and system clocks, for converting message times
+	LONGLONG m_anchorCounter;
+	LONGLONG m_anchorTime;
+
+	// Number of system time units per monotonic clock count
+	double m_timeScale;
+
+public:
+	/* Opens or creates the ring file, with a capacity of at least 'capacity'
+	   bytes (rounded up to a power of two), and maps it into memory.
+
+	   Throws an exception of type std::exception if the file cannot be
+	   opened or mapped.
+	 */
+	FlightRecorder(const std::wstring filename, const size_t capacity = FLIGHTRECORDER_CAPACITY);
+
+	// Unmaps and closes the file
+	~FlightRecorder(void);
+
+	/* Records a message, which was logged at the given reading of the
+	   monotonic clock (from Timestamper::now()).
+	   If 'prefix' is not null, it is recorded before 'msg', separated by a space.
+	 */
+	void record(const LONGLONG counter, const std::wstring* const prefix, const std::wstring& msg);
+
+	/* Writes the modified pages of the mapped view to the file,
+	   so that the recorded messages survive a crash of the operating system.
+	   (Not needed for the messages to survive the termination of the process.)
+	 */
+	HRESULT flush(void);
+
+	/* Outputs the last 'nRecords' complete messages in a ring file
+	   (or all complete messages, if 'nRecords' is zero) to a text file,
+	   overwriting the text file, in the order in which they were recorded.
+	   Messages are output in the format used by the Logger class,
+	   with timestamps in the Logger's default format.
+
+	   Returns a failure result if either file cannot be opened,
+	   or if the ring file is not a valid ring file.
+	   If messages between the oldest and newest messages output
+	   were lost (e.g. if they were being recorded when the application
+	   terminated abnormally), a success result with the ERROR_DATA_INCOMPLETE
+	   code is returned.
+	 */
+	static HRESULT decode(const std::wstring& ringFilename, const std::wstring& textFilename,
+		const size_t nRecords = 0);
+
+private:
+	// Copies data into the ring, wrapping around from the end to the start
+	void copyIn(const uint64_t position, const void* const data, const size_t size);
+
+	/* Copies characters into the ring at 'position', and advances 'position'
+	   past them, updating the checksum 'hash'
+	 */
+	void writeText(uint64_t& position, uint32_t& hash, const wchar_t* const text, const size_t length);
+
+	/* Outputs the header and message of the record at the given offset in the ring,
+	   and returns true, if there is a complete record at the offset
+	 */
+	static bool readRecord(RecordHeader& header, std::wstring& text,
+		const char* const ring, const uint64_t capacity, const uint64_t offset);
+
+	/* Outputs the headers of the complete records in the ring which were not
+	   overwritten in part by newer records, in the order in which they
+	   were recorded. Returns the position following the newest record
+	   (or zero, if there are no records).
+	 */
+	static uint64_t scan(std::vector<RecordHeader>& records, const char* const ring, const uint64_t capacity);
+
+	// Currently not implemented - will cause linker errors if called
+private:
+	FlightRecorder(const FlightRecorder& other);
+	FlightRecorder& operator=(const FlightRecorder& other);
+};
@@ -18,6 +18,8 @@ Description
   -Allows for logging to be turned on or off
   -Allows for the logging endpoint to be changed
   -Allows for logging output messages to have a common prefix added
+  -Allows for messages to be filtered by severity level, at compile time
+     (LOG_MIN_LEVEL, in Logger.h) and at runtime (per object)
 
 Notes
   -The globally-visible Logger object is initialized and destroyed in main.cpp,
@@ -28,6 +30,37 @@ Notes
   -Note that the use of the globally-visible Logger is likely problematic in
 	 multithreaded code. There are similar concerns with the use of a console
 	 window for logging output, as described in the Logger class header file.
+  -Derived classes should log messages having a severity level using
+     the LOGUSER_DEBUG(), LOGUSER_INFO(), LOGUSER_WARNING() and LOGUSER_ERROR()
+	 macros defined below. The message expression passed to a macro is not
+	 evaluated if the level is below the object's runtime threshold,
+	 and the entire statement is removed by the preprocessor if the level
+	 is below LOG_MIN_LEVEL.
+  -Messages logged without a level (using logMessage() directly)
+     are not filtered by level. Lists of messages (e.g. parsing problems
+	 collected while reading a file) which follow a message logged
+	 at some level should be logged at the same level, using the
+	 overload of logMessage() with a 'level' parameter, or logMsgStore(),
+	 so that the list is not output when the message preceding it is discarded.
+  -Messages logged using the level macros can be suppressed to avoid
+     flooding the output when they are logged repeatedly (e.g. every frame):
+     -Repeat suppression (setRepeatSuppression()) discards messages
+        which have the same call site and the same text as the previous message
+        logged using the macros, and logs "Last message repeated N times."
+        when a different message is logged (and periodically,
+        while the repeats continue).
+     -Rate limiting (setRateLimit()) allows at most a given number of
+        messages from each call site per interval, and logs the number
+        of messages discarded once the interval has ended.
+     Call sites are identified by the addresses of their '__FILE__'
+     string literals and their line numbers (see LOGUSER_CALL_SITE).
+     Message text is only compared when the call site matches that of
+     the previous message. Both forms of suppression are off by default.
+     Counts of the messages discarded are available from getSuppressionStats().
+  -Summaries of discarded messages are logged when other messages are logged
+     using the macros, when flushSuppressionSummaries() is called
+     (e.g. once per frame), and by the destructor.
+  -LogUser objects are not thread-safe.
 */
 
 #pragma once
@@ -50,6 +83,13 @@ Notes
 #define LOGUSER_PRIMARYFILE_OVERWRITE_FLAG_FIELD	LCHAR_STRINGIFY(overwriteFile)
 #define LOGUSER_CONSOLE_FLAG_FIELD					LCHAR_STRINGIFY(allocConsole)
 #define LOGUSER_TIMESTAMP_FLAG_FIELD				LCHAR_STRINGIFY(timestampEnable)
+#define LOGUSER_LOG_LEVEL_FIELD						LCHAR_STRINGIFY(logLevel)
+#define LOGUSER_ROTATION_SIZE_FIELD					LCHAR_STRINGIFY(logRotationKilobytes)
+#define LOGUSER_ROTATION_INTERVAL_FIELD				LCHAR_STRINGIFY(logRotationSeconds)
+#define LOGUSER_ROTATION_SEGMENTS_FIELD				LCHAR_STRINGIFY(logRotationSegments)
+#define LOGUSER_SUPPRESS_REPEATS_FLAG_FIELD			LCHAR_STRINGIFY(logSuppressRepeats)
+#define LOGUSER_RATE_LIMIT_FIELD					LCHAR_STRINGIFY(logRateLimit)
+#define LOGUSER_RATE_INTERVAL_FIELD					LCHAR_STRINGIFY(logRateIntervalMilliseconds)
 
 /* Default argument values, which can be used when configuration
    data is missing
@@ -60,9 +100,81 @@ Notes
 #define LOGUSER_PRIMARYFILE_OVERWRITE_FLAG			false
 #define LOGUSER_CONSOLE_FLAG						false
 #define LOGUSER_TIMESTAMP_FLAG						true
+#define LOGUSER_LOG_LEVEL							LOG_LEVEL_DEBUG
+#define LOGUSER_ROTATION_SIZE						0 // No size limit
+#define LOGUSER_ROTATION_INTERVAL					0 // No time limit
+#define LOGUSER_ROTATION_SEGMENTS					LOGGER_ROTATION_N_SEGMENTS
+#define LOGUSER_SUPPRESS_REPEATS_FLAG				false
+#define LOGUSER_RATE_LIMIT							0 // No limit
+#define LOGUSER_RATE_INTERVAL						1000
+
+/* Interval, in milliseconds, at which a summary of suppressed repeats
+   is logged while the repeats continue
+ */
+#define LOGUSER_REPEAT_SUMMARY_INTERVAL				5000
+
+/* Number of call sites whose rate limits are tracked at once by each LogUser.
+   When all are in use, the call site whose interval started first is replaced.
+ */
+#define LOGUSER_N_CALL_SITES						64
+
+/* Identifies the call site of a logging macro without string operations,
+   as the address of the file name string literal combined with the line number
+ */
+#define LOGUSER_CALL_SITE \
+	((static_cast<ULONGLONG>(reinterpret_cast<ULONG_PTR>(__FILE__)) << 16) ^ static_cast<ULONGLONG>(__LINE__))
+
+/* Level-specific logging from within member functions of LogUser-derived classes,
+   e.g. LOGUSER_DEBUG(L"Value: " + std::to_wstring(value));
+ */
+#define LOGUSER_LOG_AT_LEVEL(level, msg) \
+	do { if( isLoggable(level) ) { logSiteMessage(level, LOGUSER_CALL_SITE, msg); } } while( 0 )
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_DEBUG
+#define LOGUSER_DEBUG(msg) LOGUSER_LOG_AT_LEVEL(LOG_LEVEL_DEBUG, msg)
+#else
+#define LOGUSER_DEBUG(msg) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_INFO
+#define LOGUSER_INFO(msg) LOGUSER_LOG_AT_LEVEL(LOG_LEVEL_INFO, msg)
+#else
+#define LOGUSER_INFO(msg) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_WARNING
+#define LOGUSER_WARNING(msg) LOGUSER_LOG_AT_LEVEL(LOG_LEVEL_WARNING, msg)
+#else
+#define LOGUSER_WARNING(msg) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_ERROR
+#define LOGUSER_ERROR(msg) LOGUSER_LOG_AT_LEVEL(LOG_LEVEL_ERROR, msg)
+#else
+#define LOGUSER_ERROR(msg) ((void)0)
+#endif
 
 class LogUser
 {
+public:
+	// Counts of messages discarded by repeat suppression and rate limiting
+	struct SuppressionStats {
+		size_t nRepeats; // Discarded as repeats of the previous message
+		size_t nRateLimited; // Discarded by rate limits
+		size_t nSummaries; // Summaries logged in place of discarded messages
+
+		SuppressionStats(void);
+	};
+
+private:
+	// Rate limiting state of a call site
+	struct CallSite {
+		ULONGLONG id; // LOGUSER_CALL_SITE value (zero if the slot is unused)
+		DWORD windowStart; // Start of the current interval, from GetTickCount()
+		unsigned int nInWindow; // Messages logged in the current interval
+		size_t nSuppressed; // Messages discarded in the current interval
+	};
+
 	// Data members
 private:
 	bool m_loggingEnabled; // Switch for turning logging on or off
@@ -74,6 +186,26 @@ private:
 	Logger* m_pastLogger;
 	std::wstring m_msgPrefix; // All logging messages will be prefixed with this string
 
+	// Messages with severity levels below this level are not logged
+	unsigned int m_logLevel;
+
+	// Repeat suppression
+	bool m_suppressRepeats;
+	DWORD m_repeatSummaryInterval; // Zero if summaries are only logged when the repeats end
+	ULONGLONG m_lastSite; // Call site of the last message logged (zero if there is none)
+	ULONGLONG m_lastMsgHash; // Hash of the text of the last message logged (see logSiteMessage())
+	std::wstring m_lastMsg; // Text of the last message logged, compared only if the hash and length match
+	size_t m_nRepeats; // Repeats discarded since the last summary
+	DWORD m_repeatStart; // Time of the last summary, or of the repeated message, from GetTickCount()
+
+	// Rate limiting
+	unsigned int m_rateLimit; // Zero if there is no limit
+	DWORD m_rateInterval;
+	CallSite m_callSites[LOGUSER_N_CALL_SITES]; // Open addressing, with linear probing
+	size_t m_nPendingSites; // Call sites with discarded messages which have not been reported
+
+	SuppressionStats m_suppressionStats;
+
 protected:
 	/* Used by derived classes to store messages for logging
 	at a later time.
@@ -125,6 +257,53 @@ public:
 	virtual void enableLogging();
 	virtual void disableLogging();
 
+	/* Sets the minimum severity level (one of the LOG_LEVEL_* constants
+	   defined in Logger.h) of messages logged with a level.
+	   Returns a failure result, and makes no changes, if the level is invalid.
+
+	   Note that messages with levels below LOG_MIN_LEVEL are not logged,
+	   regardless of this setting.
+	 */
+	HRESULT setLogLevel(const unsigned int level);
+	unsigned int getLogLevel(void) const;
+
+	/* Converts a level name ("debug", "info", "warning" or "error",
+	   case-insensitive) to a LOG_LEVEL_* constant.
+	   Returns a failure result, and does not modify 'level',
+	   if the name is not recognized.
+	 */
+	static HRESULT logLevelFromString(unsigned int& level, const std::wstring& str);
+
+	/* Turns repeat suppression (see the top of this file) on or off.
+	   While repeats continue, a summary is logged every 'summaryInterval'
+	   milliseconds, unless 'summaryInterval' is zero.
+	   When turning repeat suppression off, any pending summary is logged first,
+	   and the return value indicates whether it was logged successfully.
+	 */
+	HRESULT setRepeatSuppression(const bool enable,
+		const DWORD summaryInterval = LOGUSER_REPEAT_SUMMARY_INTERVAL);
+
+	/* Allows at most 'maxMessages' messages from each call site every
+	   'interval' milliseconds, or removes the limit if 'maxMessages' is zero.
+	   Rate limiting state (including counts of discarded messages
+	   which have not been reported) is reset.
+	   Returns a failure result, and makes no changes, if 'maxMessages'
+	   is not zero, but 'interval' is zero.
+	 */
+	HRESULT setRateLimit(const unsigned int maxMessages, const DWORD interval = LOGUSER_RATE_INTERVAL);
+	void getRateLimit(unsigned int& maxMessages, DWORD& interval) const;
+
+	/* Logs summaries of messages discarded by rate limits whose intervals
+	   have ended, and the summary of repeats, if one is due.
+	   Can be called periodically so that summaries are not delayed
+	   until the next message is logged.
+	 */
+	HRESULT flushSuppressionSummaries(void);
+
+	// Outputs the counts of messages discarded since this object was created, or since the last reset
+	void getSuppressionStats(SuppressionStats& stats) const;
+	void resetSuppressionStats(void);
+
 protected:
 	void setMsgPrefix(const std::wstring& prefix);
 
@@ -148,12 +327,63 @@ protected:
 	*/
 	bool toggleTimestamp(bool newState);
 
+	/* Proxy for Logger::setRotation(), which, like toggleTimestamp(),
+	affects the global Logger if this object does not own a Logger.
+	The rotation settings are not carried forward to a new Logger
+	set using setLogger().
+
+	Returns a failure result if this object does not own a Logger,
+	and if the global Logger pointer is null.
+	*/
+	HRESULT setLogRotation(const ULONGLONG maxSize, const DWORD interval,
+		const unsigned int nSegments = LOGGER_ROTATION_N_SEGMENTS);
+
+	/* Returns true if messages at the given severity level would be logged
+	   (i.e. if logging is enabled, and the level is at least the threshold
+	   set by setLogLevel()).
+	   Used by the LOGUSER_* macros to avoid constructing messages
+	   that would be discarded.
+	 */
+	bool isLoggable(const unsigned int level) const;
+
 	// Logging functions
 protected:
 	// Arguments are forwarded to the Logger member function of the same name
 	HRESULT logMessage(const std::wstring& msg,
 		bool toConsole = true, bool toFile = true, const std::wstring filename = L"");
 
+	/* As above, but the message is discarded if its severity level
+	   is below the threshold set by setLogLevel().
+	   (The LOGUSER_* macros should be used instead of calling this function
+	    directly, so that the message is not constructed when it is discarded.)
+	 */
+	HRESULT logMessage(const unsigned int level, const std::wstring& msg,
+		bool toConsole = true, bool toFile = true, const std::wstring filename = L"");
+
+	/* As above, but the message is also subject to repeat suppression
+	   and rate limiting, using 'site' (from LOGUSER_CALL_SITE) to identify
+	   the call site. Used by the LOGUSER_* macros.
+	 */
+	HRESULT logSiteMessage(const unsigned int level, const ULONGLONG site, const std::wstring& msg);
+
+	/* Logs a summary of the repeats discarded since the last summary,
+	   if there are any. Called when the repeats end, and by the destructor.
+	 */
+	HRESULT logRepeatSummary(void);
+
+	/* Logs summaries of the messages discarded by rate limits,
+	   for call sites whose intervals have ended, or for all call sites
+	   with discarded messages, if 'all' is true.
+	 */
+	HRESULT logRateLimitSummaries(const DWORD now, const bool all);
+
+private:
+	/* Returns the rate limiting state of the call site,
+	   replacing the state of another call site if there is no free slot
+	 */
+	CallSite& findCallSite(const ULONGLONG site, const DWORD now);
+
+protected:
 	/* Arguments are forwarded to the Logger member function of the same name.
 	Note that this function maps to the Logger function with an additional 'prefix'
 	parameter. The prefix parameter is supplied by this class, and so is not passed
@@ -166,15 +396,27 @@ protected:
 		std::list<std::wstring>::const_iterator end,
 		bool toConsole = true, bool toFile = true, const std::wstring filename = L"");
 
-	/* Logs this object's internal message list (m_msgStore) using the above function.
-	The first parameter indicates whether to always clear the list (true),
+	/* As above, but the messages are discarded if their severity level
+	   is below the threshold set by setLogLevel(), or below LOG_MIN_LEVEL
+	   (i.e. if a message logged at the same level using the LOGUSER_* macros
+	    would be discarded).
+	 */
+	HRESULT logMessage(const unsigned int level,
+		std::list<std::wstring>::const_iterator start,
+		std::list<std::wstring>::const_iterator end,
+		bool toConsole = true, bool toFile = true, const std::wstring filename = L"");
+
+	/* Logs this object's internal message list (m_msgStore) using the above function,
+	at the given severity level (normally the level of the message introducing the list).
+	The second parameter indicates whether to always clear the list (true),
 	or to only clear the list if the logging operation succeeds (false).
+	(Discarding the list, because of its level, counts as a success.)
 
 	The return value indicates the success of the logging operation.
 	(The list clear operation does not return an error code.)
 	*/
-	HRESULT logMsgStore(bool alwaysClearStore = true, bool toConsole = true, bool toFile = true,
-		const std::wstring filename = L"");
+	HRESULT logMsgStore(const unsigned int level, bool alwaysClearStore = true,
+		bool toConsole = true, bool toFile = true, const std::wstring filename = L"");
 
 	// Currently not implemented - will cause linker errors if called
 private:
@@ -182,3 +424,7 @@ private:
 	LogUser& operator=(const LogUser& other);
 };
 
+inline bool LogUser::isLoggable(const unsigned int level) const {
+	return m_loggingEnabled && (level >= m_logLevel);
+}
+
@@ -22,6 +22,10 @@ Issues
   -Currently, the log file may not receive all logging messages if the application
    terminates in an abnormal way. Perhaps the output file stream could be flushed after
    each message to eliminate this issue, but there might be a performance cost?
+   (In the BUFFERED append mode, described below, the messages lost will be those
+    logged since the last flush of the file buffer.)
+   A FlightRecorder (see setFlightRecorder()) retains the most recent messages
+   through abnormal termination, at the cost of copying each message to memory.
 
   -The constructor has a parameter, 'holdAndReplaceFile', which indicates whether
    the Logger will open the file once and replace its contents with messages,
@@ -32,9 +36,110 @@ Issues
    (For example, the LockFile function,
    http://msdn.microsoft.com/en-ca/library/windows/desktop/aa365202%28v=vs.85%29.aspx)
 
-  -The use of a static data member, 's_nConsoleWriters',
-   to keep track of the use of a console window means that multiple threads
-   should not create Loggers which output to a console.
+  -Loggers which output to a console share the process's console,
+   which is allocated by the first such Logger, and freed by the last.
+   (The number of these Loggers is counted by 's_nConsoleWriters'.)
+
+Append modes
+  -When the 'holdAndReplaceFile' constructor parameter is false,
+   the Logger appends to the primary log file in one of two modes,
+   selected using setAppendMode():
+    -BUFFERED (default): The file is opened on the first output, and kept
+     open until the Logger is destroyed. Messages are collected in a buffer,
+     which is written to the file when its size reaches a threshold,
+     when a time interval has elapsed since the last write,
+     when flush() is called, and on destruction.
+     The time interval is checked by a background thread, so messages
+     are written even if no further messages are logged. In synchronous mode,
+     one background thread is shared by all Loggers in the process.
+     It is started when the first Logger outputs buffered messages,
+     and stopped when no Loggers are using it. In asynchronous mode,
+     the thread which outputs the queued records checks the interval
+     while it waits for records.
+     If two or more Loggers in the process have the same primary log file,
+     their buffers are written after each message, so that the messages
+     of different Loggers are not reordered in the file.
+     (Files shared with other processes, and secondary log files,
+      are not detected - Use the SHARED mode for such files.)
+    -SHARED: The file is opened for appending, written to, and closed
+     each time messages are output, so that other Loggers and processes
+     can append to the same file between messages.
+  -Messages sent to files other than the primary log file ("secondary" files,
+   passed as the 'filename' parameter of logMessage()) are always appended.
+   In the BUFFERED mode, the most recently used secondary files are kept open,
+   up to LOGGER_SECONDARY_FILE_CACHE_SIZE files, each with its own buffer.
+   Buffers are written to their files under the same conditions as
+   the primary log file's buffer, and when a file is closed to make room
+   for another file (the least recently used file is closed).
+   In the SHARED mode, secondary files are opened and closed for each output.
+
+Rotation
+  -In the BUFFERED append mode, the primary log file can be rotated
+   when it reaches a size limit, and/or after a time interval
+   (see setRotation()). The file is renamed to an archived "segment",
+   and a new file is started under the original name. For a primary log file
+   named "log.txt", segments are named "log.1.txt" (most recent),
+   "log.2.txt", and so on, up to the number of retained segments.
+   Older segments are deleted.
+  -While rotation is enabled, the primary log file is written through
+   a file handle. A background thread prepares the next file in advance
+   ("log.next.txt"), preallocating disk space for it, up to the size limit,
+   so that appending to it does not fragment the file.
+   (Preallocation does not change the file's end, and unused space
+    is released when the file is closed.)
+   Rotation only exchanges the handle of the current file for the handle
+   of the next file, so threads logging messages never wait for file
+   system operations. The background thread then closes the previous file,
+   shifts the archived segments, and renames the previous file
+   and the next file to "log.1.txt" and "log.txt", respectively.
+  -If the background thread has not finished archiving the previous segment,
+   or preparing the next file, when rotation is due, rotation is postponed,
+   and the current file continues to grow. Rotation never occurs in the middle
+   of a message, so a file can exceed the size limit by up to one buffer of messages.
+  -If the previous file cannot be archived (e.g. if another process has opened it
+   without allowing it to be renamed), the failure is returned by the next call
+   to flush() (or to setRotation(), or by the output functions in synchronous mode),
+   and the current file keeps the name "log.next.txt". The background thread
+   tries again to archive the previous file and rename the current file
+   at intervals, and rotation is postponed until it succeeds.
+  -The size of the file is the number of bytes written to it, after the messages
+   are converted to bytes in the same way as by the primary log file stream.
+  -Time-based rotation is checked by the background thread which writes
+   buffered messages (see above), so it occurs even when no messages are logged,
+   unless the file is empty.
+
+Asynchronous mode
+  -After a call to startAsync(), logMessage() does not format or output
+   messages. It copies each message, with the current time, into a record
+   in a bounded lock-free queue, which can be written to by multiple threads.
+   A background thread removes records from the queue in batches,
+   formats them, and outputs them to the console and files.
+  -The queue is an array of slots with per-slot sequence numbers,
+   following Dmitry Vyukov's bounded MPMC queue
+   (http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue),
+   with only one consumer.
+  -The OverflowPolicy passed to startAsync() determines what happens
+   when a message is logged while the queue is full.
+  -Errors from output operations cannot be returned by logMessage()
+   in asynchronous mode. They are instead returned by flush().
+
+Thread safety
+  -In both synchronous and asynchronous modes, the logMessage() functions,
+   logPrefixedMessage() and flush() can be called concurrently
+   by multiple threads, and Loggers can be created and destroyed
+   concurrently by multiple threads.
+   Other member functions must not be called concurrently with
+   any member functions of the same Logger.
+  -Each message (or list of messages) is output as a unit, so lines output
+   by different threads are never interleaved, in the files or in the console.
+   (Lines output by different Loggers to the console are not interleaved either.)
+  -In synchronous mode, messages are formatted in one of LOGGER_N_STAGING_BUFFERS
+   staging buffers, selected by a hash of the ID of the calling thread, each with
+   its own lock and Timestamper. The staging lock is released before
+   the formatted message is output, so only the output of formatted messages
+   is serialized, using a lock for each Logger (and a global lock for
+   the console). Messages from different threads may therefore be output
+   slightly out of order with respect to their timestamps.
 */
 
 #pragma once
@@ -44,12 +149,183 @@ Issues
 #include <list>
 #include <iterator>
 #include <fstream>
+#include "Timestamper.h"
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <map>
+
+/* Message severity levels, in increasing order of severity
+   (Preprocessor constants, rather than an enumeration, so that
+    they can be compared with LOG_MIN_LEVEL in '#if' directives.
+    They start at one, so that no level is a null pointer constant.)
+ */
+#define LOG_LEVEL_DEBUG		1
+#define LOG_LEVEL_INFO		2
+#define LOG_LEVEL_WARNING	3
+#define LOG_LEVEL_ERROR		4
+
+/* Compile-time minimum severity level. Messages logged at lower levels
+   using the level-specific macros (e.g. LOGGER_DEBUG() below, and LOGUSER_DEBUG()
+   in LogUser.h) are removed by the preprocessor, along with the
+   expressions producing them. Can be overridden in the project's
+   preprocessor definitions.
+ */
+#ifndef LOG_MIN_LEVEL
+#ifdef _DEBUG
+#define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#else
+#define LOG_MIN_LEVEL LOG_LEVEL_INFO
+#endif
+#endif
+
+/* Level-specific logging through a Logger pointer, e.g.
+     LOGGER_DEBUG(g_defaultLogger, L"Value: " + std::to_wstring(value));
+   The message expression is only evaluated if the level is at least LOG_MIN_LEVEL,
+   and the pointer is not null.
+ */
+#define LOGGER_LOG_AT_LEVEL(logger, msg) \
+	do { if( (logger) != 0 ) { (logger)->logMessage(msg); } } while( 0 )
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_DEBUG
+#define LOGGER_DEBUG(logger, msg) LOGGER_LOG_AT_LEVEL(logger, msg)
+#else
+#define LOGGER_DEBUG(logger, msg) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_INFO
+#define LOGGER_INFO(logger, msg) LOGGER_LOG_AT_LEVEL(logger, msg)
+#else
+#define LOGGER_INFO(logger, msg) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_WARNING
+#define LOGGER_WARNING(logger, msg) LOGGER_LOG_AT_LEVEL(logger, msg)
+#else
+#define LOGGER_WARNING(logger, msg) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_ERROR
+#define LOGGER_ERROR(logger, msg) LOGGER_LOG_AT_LEVEL(logger, msg)
+#else
+#define LOGGER_ERROR(logger, msg) ((void)0)
+#endif
+
+// Default size of the primary log file buffer in the BUFFERED append mode, in characters
+#define LOGGER_FILE_BUFFER_SIZE 65536
+
+/* Default maximum time, in milliseconds, between writes of buffered messages
+   to the primary log file in the BUFFERED append mode
+ */
+#define LOGGER_FILE_FLUSH_INTERVAL_MS 1000
+
+// Maximum number of secondary log files kept open in the BUFFERED append mode
+#define LOGGER_SECONDARY_FILE_CACHE_SIZE 8
+
+// Number of buffers in which messages are formatted before output (see above)
+#define LOGGER_N_STAGING_BUFFERS 16
+
+// Default number of archived segments of the primary log file retained by rotation
+#define LOGGER_ROTATION_N_SEGMENTS 5
+
+class FlightRecorder;
 
 class Logger
 {
+public:
+	// Ways of appending to the primary log file (see the top of this file)
+	enum class AppendMode : unsigned int {
+		BUFFERED,
+		SHARED
+	};
+
+	/* Behaviour of logMessage() in asynchronous mode
+	   when the message queue is full
+	 */
+	enum class OverflowPolicy : unsigned int {
+		BLOCK, // Wait until the background thread frees space in the queue
+		DROP, // Discard the message silently
+		DROP_AND_COUNT // Discard the message, and report the number of discarded messages
+	};
+
+private:
+	/* A message (or list of messages) waiting to be output
+	   by the background thread in asynchronous mode
+	 */
+	struct Record {
+		LONGLONG time; // Timestamper::now() when the message was logged
+		bool timestampEnabled; // Value of 'm_timestampEnabled' when the message was logged
+		bool bulk; // True if 'msgs' is used instead of 'msg'
+		bool toConsole;
+		bool toFile;
+		std::wstring msg; // The message, or the prefix of the messages in 'msgs'
+		std::list<std::wstring> msgs;
+		std::wstring filename;
+	};
+
+	// Formats messages before they are output, for the threads that use it
+	struct Staging {
+		std::mutex mutex;
+		Timestamper timestamper;
+
+		/* Memory for formatting messages (or prefixes of lists of messages),
+		   which is taken by a thread while formatting and outputting a message
+		 */
+		std::wstring line;
+	};
+
+	// An element of the message queue
+	struct Slot {
+		/* Equal to the slot's position in the queue if the slot is free,
+		   or to the slot's position + 1 if the slot contains a record
+		 */
+		std::atomic<size_t> sequence;
+		Record record;
+	};
+
 private:
 	// Counts the number of instances of this class using the console
-	static unsigned int s_nConsoleWriters;
+	static std::atomic<unsigned int> s_nConsoleWriters;
+
+	/* Held while allocating or freeing the console,
+	   and while writing to the console
+	 */
+	static std::mutex s_consoleMutex;
+
+	/* Loggers whose buffered messages are written by the shared background
+	   thread in synchronous mode (see flushPeriodically())
+	 */
+	static std::list<Logger*> s_flushLoggers;
+
+	/* Held while accessing 's_flushLoggers' and 's_flushStop',
+	   and while the shared background thread writes buffered messages.
+	   Must not be acquired while holding the output lock of a Logger.
+	 */
+	static std::mutex s_flushMutex;
+
+	// Signalled when the shared background thread should exit
+	static std::condition_variable s_flushWork;
+
+	// True if the shared background thread should exit
+	static bool s_flushStop;
+
+	// The shared background thread (null if it is not running)
+	static std::thread* s_flushThread;
+
+	/* Held while starting or stopping the shared background thread
+	   (acquired before 's_flushMutex')
+	 */
+	static std::mutex s_flushThreadMutex;
+
+	/* Loggers with primary log files, grouped by file
+	   (keyed by the lowercase full path of the file)
+	 */
+	static std::map<std::wstring, std::list<Logger*> > s_fileUsers;
+
+	// Held while accessing 's_fileUsers'
+	static std::mutex s_fileUsersMutex;
 
 	// Data members
 private:
@@ -70,6 +346,180 @@ private:
 
 	bool m_timestampEnabled; // Determines whether logged messages are prefixed with the current time
 
+	// Staging buffers, indexed by a hash of the thread ID (see getStaging())
+	Staging m_staging[LOGGER_N_STAGING_BUFFERS];
+
+	/* Held while outputting messages, and while accessing the file buffers
+	   and file streams in synchronous mode.
+	   (In asynchronous mode, only the background thread outputs messages.)
+	 */
+	std::mutex m_outputMutex;
+
+	// Append modes
+	// ------------
+
+	AppendMode m_appendMode;
+
+	// Messages waiting to be written to the primary log file, in the BUFFERED append mode
+	std::wstring m_fileBuffer;
+
+	// Buffer size at which the buffer is written to the file
+	size_t m_fileBufferSize;
+
+	// Maximum time between writes of buffered messages, in milliseconds
+	DWORD m_fileFlushInterval;
+
+	// Time of the last write of buffered messages, from GetTickCount()
+	DWORD m_lastFileFlush;
+
+	// An open secondary log file, in the BUFFERED append mode
+	struct SecondaryFile {
+		std::wstring filename;
+		std::basic_ofstream<wchar_t> file;
+
+		// Messages waiting to be written to the file
+		std::wstring buffer;
+	};
+
+	// Open secondary log files, in order from most to least recently used
+	std::list<SecondaryFile> m_secondaryFiles;
+
+	// True if this Logger is in 's_flushLoggers'
+	std::atomic<bool> m_flushRegistered;
+
+	// Key of this Logger's primary log file in 's_fileUsers' (empty if not registered)
+	std::wstring m_fileKey;
+
+	/* True if another Logger in the process has the same primary log file,
+	   in which case buffered messages are written after each message
+	 */
+	std::atomic<bool> m_fileShared;
+
+	// Rotation
+	// --------
+
+	/* Size, in bytes, and age, in milliseconds, of the primary log file
+	   at which it is rotated (zero if there is no limit)
+	 */
+	ULONGLONG m_rotationSize;
+	DWORD m_rotationInterval;
+
+	unsigned int m_nRotationSegments; // Number of archived segments retained
+
+	// Number of bytes written to the primary log file, excluding buffered messages
+	ULONGLONG m_segmentSize;
+
+	// Time at which the primary log file was started, from GetTickCount()
+	DWORD m_segmentStart;
+
+	/* Handle through which the primary log file is written while rotation
+	   is enabled (INVALID_HANDLE_VALUE if the file could not be opened)
+	 */
+	HANDLE m_segmentHandle;
+
+	// Buffered messages converted to bytes, to be written through 'm_segmentHandle'
+	std::string m_narrowBuffer;
+
+	// Name of the next file prepared by the background thread
+	std::wstring m_spareFilename;
+
+	// Background thread that archives segments (null if rotation is disabled)
+	std::thread* m_rotationThread;
+
+	// Held while accessing the following data members
+	std::mutex m_rotationMutex;
+
+	// Signalled when there is work for the background thread
+	std::condition_variable m_rotationWork;
+
+	/* Handle of the previous primary log file, to be closed and archived
+	   by the background thread (INVALID_HANDLE_VALUE if there is none)
+	 */
+	HANDLE m_retiredHandle;
+
+	// True if the segment held by 'm_retiredHandle' has not been archived yet
+	bool m_archivePending;
+
+	// True if the background thread should prepare a new file
+	bool m_spareNeeded;
+
+	/* Handle to the file prepared by the background thread
+	   (INVALID_HANDLE_VALUE if it is not ready)
+	 */
+	HANDLE m_spareHandle;
+
+	// True if the background thread should exit
+	bool m_rotationStop;
+
+	/* First failure result from the background thread since the last time
+	   the primary log file was flushed
+	 */
+	HRESULT m_rotationResult;
+
+	// Flight recorder
+	// ---------------
+
+	/* Receives all messages, regardless of their destinations
+	   (null if there is none). Not owned by this object.
+	 */
+	FlightRecorder* m_flightRecorder;
+
+	// Asynchronous mode
+	// -----------------
+
+	Slot* m_queue; // Null if asynchronous mode is off
+
+	size_t m_queueMask; // Number of slots in the queue, minus one
+
+	OverflowPolicy m_overflowPolicy;
+
+	std::thread* m_thread; // Background thread that outputs queued records
+
+	// Position of the next slot to be written to by a producer
+	std::atomic<size_t> m_enqueuePos;
+
+	/* Position of the next slot to be read by the background thread.
+	   All records at earlier positions have been output.
+	 */
+	std::atomic<size_t> m_dequeuePos;
+
+	// Total number of messages discarded due to overflow
+	std::atomic<size_t> m_nDropped;
+
+	// Number of discarded messages not yet reported in the log
+	std::atomic<size_t> m_nDroppedUnreported;
+
+	// First failure result from an output operation since the last call to flush()
+	std::atomic<HRESULT> m_asyncResult;
+
+	// True if the background thread should exit once the queue is empty
+	std::atomic<bool> m_stopRequested;
+
+	// True if flush() is waiting for the background thread to flush the primary log file
+	std::atomic<bool> m_flushRequested;
+
+	/* Dequeue position at the time the background thread last flushed
+	   the primary log file
+	 */
+	size_t m_flushedPos;
+
+	// True if the background thread may be waiting on 'm_wakeConsumer'
+	std::atomic<bool> m_consumerWaiting;
+
+	// Used with both condition variables
+	std::mutex m_asyncMutex;
+
+	// Signalled when records are added to an empty queue
+	std::condition_variable m_wakeConsumer;
+
+	/* Signalled when the background thread has output a batch of records,
+	   or has flushed the primary log file
+	 */
+	std::condition_variable m_batchDone;
+
+	// Records removed from the queue by the background thread, to be output
+	std::vector<Record> m_batch;
+
 public:
 	/*
 	If 'allocLogConsole' is true, a console window will be created.
@@ -82,9 +532,9 @@ public:
 	  by the destructor. The previous contents of the file are overwritten.
 	  If the logging file or console cannot be opened, an exception will be thrown.
 	otherwise:
-	  The primary log file is opened and appended to only when messages
-	  are being written to it. The original contents of the file are added to,
-	  not overwritten.
+	  The primary log file is appended to, in the BUFFERED append mode
+	  (see the top of this file, and setAppendMode()).
+	  The original contents of the file are added to, not overwritten.
 
 	  To try and ensure that logging will be possible, the function
 	  fileUtil::inspectFileOrDirNameAndPath() is called on the 'filename' parameter.
@@ -127,6 +577,13 @@ public:
 	HRESULT logMessage(const std::wstring& msg,
 		bool toConsole = true, bool toFile = true, const std::wstring filename = L"");
 
+	/* Equivalent to logMessage(prefix + L" " + msg, toConsole, toFile, filename),
+	   but the concatenated string is not constructed
+	   (except when it is queued, in asynchronous mode).
+	 */
+	HRESULT logPrefixedMessage(const std::wstring& prefix, const std::wstring& msg,
+		bool toConsole = true, bool toFile = true, const std::wstring filename = L"");
+
 	/* This function is intended for bulk logging operations,
 	 and will be more efficient than calling the version for single messages
 	 repeatedly. Otherwise, the two functions behave similarly except as follows:
@@ -147,11 +604,245 @@ public:
 	*/
 	bool toggleTimestamp(const bool newState);
 
-	// Retrieves the current local time
+	/* Sets the format of message timestamps (see Timestamper.h).
+	   By default, timestamps are in the format of the C library's
+	   asctime() function, with millisecond digits added.
+	   Returns a failure result if asynchronous mode is on,
+	   or if the format is invalid.
+	 */
+	HRESULT setTimestampFormat(const Timestamper::Format format,
+		const unsigned int subsecondDigits);
+
+	/* Retrieves the current local time, in the format output by
+	   the C library's asctime() function, with a trailing space
+	   in place of the newline character
+	 */
 	static HRESULT getDateAndTime(std::wstring& timeStr);
 
+	/* Sets the mode used to append to the primary log file, when the
+	   'holdAndReplaceFile' constructor parameter was false.
+	   In the BUFFERED mode, buffered messages are written to the file
+	   when there are at least 'bufferSize' characters in the buffer,
+	   or at least 'flushInterval' milliseconds after the last write
+	   (whether or not further messages are logged).
+	   The buffer size and time interval are ignored in the SHARED mode.
+
+	   Any buffered messages are written to the files before the mode is changed,
+	   and open secondary log files are closed when switching to the SHARED mode.
+	   Returns a failure result if asynchronous mode is on,
+	   if switching to the SHARED mode while rotation is enabled,
+	   or if the buffered messages could not be written.
+	 */
+	HRESULT setAppendMode(const AppendMode appendMode,
+		const size_t bufferSize = LOGGER_FILE_BUFFER_SIZE,
+		const DWORD flushInterval = LOGGER_FILE_FLUSH_INTERVAL_MS);
+
+	/* Enables rotation of the primary log file (see the top of this file)
+	   once it reaches 'maxSize' bytes, or 'interval' milliseconds after
+	   it was started (or after this function was called, for an existing file),
+	   retaining 'nSegments' archived segments. Either limit can be zero,
+	   meaning that there is no limit of that kind. Rotation is disabled
+	   if both limits are zero.
+
+	   Any buffered messages are written to the primary log file first.
+	   Can be called in asynchronous mode, but not while other threads
+	   are logging messages.
+	   Returns a failure result if there is no primary log file, if the 'holdAndReplaceFile'
+	   constructor parameter was true, if the append mode is not BUFFERED,
+	   if the primary log file could not be opened,
+	   or if the background thread could not be started.
+	 */
+	HRESULT setRotation(const ULONGLONG maxSize, const DWORD interval,
+		const unsigned int nSegments = LOGGER_ROTATION_N_SEGMENTS);
+
+	/* Passes all subsequent messages, with their prefixes, to the FlightRecorder
+	   as they are logged (before they are queued or written), or stops doing so
+	   if 'recorder' is null. The FlightRecorder is not owned by this object,
+	   and must not be destroyed while it is in use.
+	   Not safe to call while other threads are logging messages.
+	 */
+	void setFlightRecorder(FlightRecorder* const recorder);
+
+	/* Switches to asynchronous mode, with a queue that can hold
+	   at least 'capacity' records. (The capacity is rounded up
+	   to a power of two.)
+	   Returns a failure result if asynchronous mode is already on,
+	   or if 'capacity' is zero.
+	 */
+	HRESULT startAsync(const size_t capacity = 1024,
+		const OverflowPolicy overflowPolicy = OverflowPolicy::BLOCK);
+
+	/* Outputs all queued records, and then switches back to synchronous mode.
+	   Returns the same value as flush().
+	   Called by the destructor.
+	   Does nothing if asynchronous mode is off.
+	 */
+	HRESULT stopAsync(void);
+
+	/* Writes any buffered messages to the primary log file and to
+	   the open secondary log files, and flushes the file streams, so that all messages logged
+	   before the call have been passed to the operating system.
+
+	   In asynchronous mode, blocks until all records which were
+	   queued before this function was called have been output,
+	   and the background thread has then flushed the log files.
+	   (Records queued by other threads during the call may also be output.)
+
+	   In asynchronous mode, returns the first failure result from
+	   an output operation since the previous call to this function,
+	   or a success result if there were no failures.
+	   In synchronous mode, failures from writes of buffered messages
+	   by the background thread since the previous call are also returned.
+	 */
+	HRESULT flush(void);
+
+	/* Returns the total number of messages discarded
+	   because the queue was full, under the DROP_AND_COUNT overflow policy
+	 */
+	size_t getDroppedCount(void) const;
+
 private:
 
+	/* Adds a record to the queue, or discards it,
+	   according to the overflow policy.
+	   Returns a success result with the code ERROR_DATA_INCOMPLETE
+	   if the record was discarded.
+	 */
+	HRESULT enqueue(Record& record);
+
+	// Background thread function
+	void consume(void);
+
+	/* Removes the records from 'start' (inclusive) to 'end' (exclusive)
+	   from the queue, and outputs them in the order they were queued.
+	   If there are unreported discarded messages, a message
+	   stating their number is output afterwards.
+	 */
+	void writeBatch(const size_t start, const size_t end);
+
+	/* Implementation of logMessage() and logPrefixedMessage()
+	   ('prefix' is null for logMessage())
+	 */
+	HRESULT logSingleMessage(const std::wstring* const prefix, const std::wstring& msg,
+		bool toConsole, bool toFile, const std::wstring& filename);
+
+	// Returns the staging buffer used by the calling thread
+	Staging& getStaging(void);
+
+	/* Returns the memory of a formatted line to the staging buffer
+	   it was taken from, unless the buffer already has a larger line
+	 */
+	static void returnStagingLine(Staging& staging, std::wstring& line);
+
+	/* Output functions shared by the synchronous and asynchronous modes,
+	   which timestamp messages with the given time (from Timestamper::now()),
+	   if 'timestampEnabled' is true.
+	   If 'prefix' is not null, it is output before 'msg', separated by a space.
+	   Thread-safe.
+	 */
+	HRESULT formatAndOutput(const LONGLONG time, const bool timestampEnabled,
+		const std::wstring* const prefix, const std::wstring& msg,
+		bool toConsole, bool toFile, const std::wstring& filename);
+
+	HRESULT formatAndOutput(const LONGLONG time, const bool timestampEnabled,
+		std::list<std::wstring>::const_iterator start,
+		std::list<std::wstring>::const_iterator end, const std::wstring& prefix,
+		bool toConsole, bool toFile, const std::wstring& filename);
+
+	// Records the result of an output operation, to be returned by flush()
+	void storeAsyncResult(const HRESULT result);
+
+	/* Writes any buffered messages to the primary log file
+	   (opening it if necessary) and to the open secondary log files,
+	   and flushes the file streams
+	 */
+	HRESULT flushFile(void);
+
+	/* Outputs the buffer for the given secondary log file in the
+	   BUFFERED append mode, opening the file if it is not open,
+	   and closing the least recently used file if the maximum number
+	   of files are open. The file is marked as the most recently used file.
+	   Returns a failure result if the file cannot be opened,
+	   or if the least recently used file could not be written.
+	 */
+	HRESULT getSecondaryFileBuffer(std::wstring*& buffer, const std::wstring& filename);
+
+	// Writes the buffer of a secondary log file to the file
+	HRESULT flushSecondaryFile(SecondaryFile& file);
+
+	// Writes and closes all open secondary log files
+	HRESULT closeSecondaryFiles(void);
+
+	/* Calls flushFile() if the buffer size or time threshold
+	   of the BUFFERED append mode has been reached,
+	   if the primary log file is due to be rotated,
+	   or if the primary log file is shared with another Logger.
+	 */
+	HRESULT flushFileIfDue(void);
+
+	/* Function of the background thread shared by all Loggers,
+	   which writes buffered messages in synchronous mode
+	 */
+	static void flushPeriodically(void);
+
+	/* Adds this Logger to the Loggers served by the shared background thread,
+	   starting the thread if it is not running. Does nothing if this Logger
+	   has already been added. Must not be called while holding the output lock.
+	 */
+	void addToFlushThread(void);
+
+	/* Removes this Logger from the Loggers served by the shared background thread,
+	   stopping the thread if no other Loggers are using it.
+	   Must not be called while holding the output lock.
+	 */
+	void removeFromFlushThread(void);
+
+	/* Records that this Logger writes to its primary log file,
+	   and marks it, and any other Loggers which write to the same file, as sharing the file
+	 */
+	void addFileUser(void);
+
+	// Reverses addFileUser()
+	void removeFileUser(void);
+
+	// Returns true if the primary log file, with the buffered messages, should be rotated
+	bool isRotationDue(void) const;
+
+	/* Replaces the handle of the primary log file with the handle of the file
+	   prepared by the background thread, and passes the previous handle
+	   to the background thread to be archived. Does nothing if the background
+	   thread has not finished archiving the previous segment,
+	   or preparing the next file.
+	 */
+	void rotateFile(void);
+
+	// Rotation background thread function
+	void archive(void);
+
+	/* Renames the existing segments, deletes the oldest segment,
+	   renames the previous primary log file (which must be closed)
+	   to the most recent segment, and renames the next file prepared
+	   by the background thread to the name of the primary log file.
+	   If the previous primary log file no longer exists
+	   (i.e. it was archived by an earlier call), only the next file is renamed.
+	   'renamed' is set to true if the next file now has the name of the primary
+	   log file, or to false if it still has its temporary name, in which case
+	   this function must be called again before another next file is created.
+	   Called by the background thread.
+	 */
+	HRESULT archiveSegment(bool& renamed);
+
+	/* Creates the next primary log file, and preallocates disk space for it.
+	   Returns INVALID_HANDLE_VALUE on failure, including if the file exists.
+	   Called by the background thread.
+	 */
+	HANDLE createSpareFile(void);
+
+	/* Stops the rotation background thread, after it has archived
+	   any pending segment, and deletes the file it prepared.
+	 */
+	HRESULT stopRotation(void);
+
 	// Outputs a message to a file
 	HRESULT logMsgToFile(const std::wstring& msg,
 		const std::wstring filename = L"");
@@ -0,0 +1,237 @@
+/*
+SectionedConfigIO.h
+-------------------
+
+Created for: Spring 2014 Direct3D 11 Learning
+By: Bernard Llanos
+August 16, 2014
+
+Primary basis: FlatAtomicConfigIO.h
+Other references: None
+
+Development environment: Visual Studio 2013 running on Windows 7, 64-bit
+  -Note that the "Character Set" project property (Configuration Properties > General)
+   should be set to Unicode for all configurations, when using Visual Studio.
+
+Description
+  -A class which inherits from the IConfigIO interface
+  -See below for the data format accepted by this configuration read/write class
+  -Like FlatAtomicConfigIO, this class handles Config objects
+   containing single values under each key, but the file format
+   groups keys by scope under section headers, rather than repeating
+   the scope on every line. Sections can also declare a default
+   datatype, which is then omitted from the lines using it.
+   Files are therefore smaller, and faster to parse, than
+   equivalent files produced by FlatAtomicConfigIO.
+
+Usage Notes
+  -Problems encountered while reading or writing are logged,
+   rather than appended to the file.
+  -The scope of a section is converted to a wide-character string once,
+   when the section header is parsed, and is shared by all lines
+   in the section, rather than being converted for each line.
+*/
+
+#pragma once
+
+#include <windows.h>
+#include <string>
+#include <map>
+#include <vector>
+#include "LogUser.h"
+#include "Config.h"
+#include "IConfigIO.h"
+
+/* This guide will be written to configuration files
+created from Config objects by instances of this class.
+*/
+#define SECTIONEDCONFIGIO_DATA_FORMATSPEC \
+	L"# ----------------------------------------------------------------------------\n"\
+	L"# The SectionedConfigIO class, used to generate this output \n"\
+	L"# defines the following file format:\n"\
+	L"#\n"\
+	L"# ASCII encoding is expected.\n"\
+	L"#\n"\
+	L"# Lines are either\n"\
+	L"# \t-Blank, or only whitespace\n"\
+	L"# \t-Comments, starting with optional whitespace,\n"\
+	L"# \t\t followed by '#', optional whitespace, and then the comment text\n"\
+	L"# \t-Section headers\n"\
+	L"# \t-Configuration key-value pairs\n"\
+	L"#\n"\
+	L"# Lines cannot be longer than 255 characters, or they will not be fully read.\n"\
+	L"#\n"\
+	L"# 'Whitespace' is one or more characters, selected from the following:\n"\
+	L"# Characters other than '\\n', with ASCII decimal values\n"\
+	L"# from 1 (inclusive) to 32 (inclusive), or 127 and greater.\n"\
+	L"# (Therefore, whitespace includes tabs and spaces.)\n"\
+	L"#\n"\
+	L"# A section header is, in the following order,\n"\
+	L"# \t '['\n"\
+	L"# \t Optionally, a key scope string (any characters other than ']')\n"\
+	L"# \t ']'\n"\
+	L"# \t Optionally, a default datatype name for the section\n"\
+	L"#\n"\
+	L"# A configuration key value pair is, in the following order,\n"\
+	L"# \t Optionally, a datatype name followed by '--'\n"\
+	L"# \t\t (required if the section has no default datatype)\n"\
+	L"# \t A key field parameter (any characters, but not starting with '['\n"\
+	L"# \t\t and not containing '--' or '=')\n"\
+	L"# \t '='\n"\
+	L"# \t A value\n"\
+	L"#\n"\
+	L"# Key-value pairs belong to the scope of the closest preceding section header,\n"\
+	L"# or to the empty scope, if there is no preceding section header.\n"\
+	L"#\n"\
+	L"# Each of the above elements can optionally be separated by whitespace\n"\
+	L"# from the others, but any whitespace within an element\n"\
+	L"# will be stripped during processing, with the exception that\n"\
+	L"# spaces will not be stripped within matched double quotes (\" \").\n"\
+	L"#\n"\
+	L"# Datatypes must match one of the 'DataType' enumeration constant names\n"\
+	L"# found in Config.h. The matching is case-sensitive,\n"\
+	L"# and is implemented in the Config::getDataTypeInfo() function.\n"\
+	L"#\n"\
+	L"# Values are similar to C++ literals corresponding to the datatypes\n"\
+	L"# of the key-value pairs.\n"\
+	L"# Refer to the functions in the textProcessing and higherLevelIO\n"\
+	L"# namespaces for details.\n"\
+	L"# (These functions are used for parsing and serializing data values.)\n"\
+	L"# ----------------------------------------------------------------------------"
+
+// Formatting components identified in the above guidelines
+#define SECTIONEDCONFIGIO_COMMENT_SEP "#"
+#define SECTIONEDCONFIGIO_COMMENT_SEP_WSTR L"#" // For message logging
+#define SECTIONEDCONFIGIO_SECTION_START "["
+#define SECTIONEDCONFIGIO_SECTION_START_WSTR L"["
+#define SECTIONEDCONFIGIO_SECTION_END "]"
+#define SECTIONEDCONFIGIO_SECTION_END_WSTR L"]"
+#define SECTIONEDCONFIGIO_TYPE_SEP "--"
+#define SECTIONEDCONFIGIO_TYPE_SEP_WSTR L"--"
+#define SECTIONEDCONFIGIO_VALUE_SEP "="
+#define SECTIONEDCONFIGIO_VALUE_SEP_WSTR L"="
+#define SECTIONEDCONFIGIO_WHITESPACE_SEP L" " // To add whitespace during serialization, for readability
+
+#define SECTIONEDCONFIGIO_MAX_LINE_LENGTH 255
+
+/* Used to catch line length violations.
+   Must be two greater than the maximum allowed line length
+   (because it compensates for the null terminating character)
+*/
+#define SECTIONEDCONFIGIO_LINE_BUFFER_LENGTH 257
+
+#define SECTIONEDCONFIGIO_LINE_SEP '\n'
+#define SECTIONEDCONFIGIO_LINE_SEP_WSTR L"\n"
+
+/* Amount of UTF-8-encoded output (in bytes) accumulated by write()
+   before it is written to the file
+ */
+#define SECTIONEDCONFIGIO_WRITE_BUFFER_LENGTH 65536
+
+#define SECTIONEDCONFIGIO_START_OUTPUT L"START"
+#define SECTIONEDCONFIGIO_END_OUTPUT L"END"
+
+class SectionedConfigIO : public IConfigIO, public LogUser {
+
+private:
+	// Flag controlled by toggleContextOutput()
+	bool m_outputContext;
+
+	// State of the parser, for the current section
+	// --------------------------------------------
+
+	// Scope of the current section, shared by all of its lines
+	std::wstring m_sectionScope;
+
+	// Default datatype of the current section, or null if there is none
+	const Config::DataTypeInfo* m_sectionType;
+
+	/* False if the current section header could not be parsed,
+	   in which case the lines in the section are skipped
+	 */
+	bool m_sectionValid;
+
+	// Reused for the field of each line
+	std::wstring m_field;
+
+	// Reused for the message output by each data value parsing function
+	std::wstring m_parseMsg;
+
+	/* Reused by writeDataLine() for data values which cannot be
+	   serialized directly into the output line
+	 */
+	std::wstring m_valueBuffer;
+
+	// Reused by scanSection() to count values of each datatype
+	std::vector<size_t> m_typeCounts;
+
+public:
+	SectionedConfigIO(void);
+
+	virtual ~SectionedConfigIO(void);
+
+public:
+	/* Read configuration data from a file
+	   (See IConfigIO.h for details)
+	   The file is memory-mapped, rather than read using a stream.
+	 */
+	virtual HRESULT read(const std::wstring& filename,
+		Config& config) override;
+
+	/* Write configuration data to a file.
+	   (See IConfigIO.h for details)
+	   One section is written per scope. The default datatype of each section
+	   is the datatype of the largest number of values in the scope.
+	 */
+	virtual HRESULT write(const std::wstring& filename,
+		const Config& config, const bool overwrite) override;
+
+	/* Toggles the output of configuration data formatting guidelines
+	   as part of the write() operation.
+	   (See IConfigIO.h for details)
+	 */
+	virtual bool toggleContextOutput(const bool outputContext) override;
+
+protected:
+	/* Parses a single line (null-terminated and modified in the process),
+	   updating the current section, or inserting data into the Config object.
+
+	   Returns a success result, but with the ERROR_DATA_INCOMPLETE error code,
+	   if the line is invalid, or a failure result in case of a serious error.
+	   Messages are added to the message list (m_msgStore).
+	 */
+	HRESULT readLine(Config& config, char* const str, const size_t lineNumber);
+
+	/* Formats a section header for the given scope and default datatype
+	   (which can be null) into 'str', without a line separator
+	 */
+	void writeSectionHeader(std::wstring& str, const std::wstring& scope,
+		const Config::DataTypeInfo* const defaultType) const;
+
+	/* Formats the key-value pair into 'str', without a line separator,
+	   omitting the scope, and omitting the datatype if it is 'defaultType'.
+
+	   Outputs an empty string, and returns a success result with
+	   the ERROR_DATA_INCOMPLETE error code, if the data cannot be serialized
+	   (with a message added to the message list).
+	   Returns a failure result in case of a serious error.
+	 */
+	HRESULT writeDataLine(std::wstring& str,
+		const std::map<Config::Key, Config::Value*>::const_iterator& data,
+		const Config::DataTypeInfo* const defaultType);
+
+	/* Outputs the end of the range of values, starting from 'start',
+	   which have the same scope, and returns the datatype shared
+	   by the largest number of these values (or null, if the range
+	   contains no valid values).
+	 */
+	const Config::DataTypeInfo* scanSection(
+		const std::map<Config::Key, Config::Value*>::const_iterator& start,
+		const std::map<Config::Key, Config::Value*>::const_iterator& end,
+		std::map<Config::Key, Config::Value*>::const_iterator& sectionEnd);
+
+	// Currently not implemented - will cause linker errors if called
+private:
+	SectionedConfigIO(const SectionedConfigIO& other);
+	SectionedConfigIO& operator=(const SectionedConfigIO& other);
+};
\ No newline at end of file
@@ -0,0 +1,149 @@
+/*
+Timestamper.h
+-------------
+
+Created for: Spring 2014 Direct3D 11 Learning
+By: Bernard Llanos
+August 18, 2014
+
+Primary basis: None
+Other references: None
+
+Development environment: Visual Studio 2013 running on Windows 7, 64-bit
+  -Note that the "Character Set" project property (Configuration Properties > General)
+   should be set to Unicode for all configurations, when using Visual Studio.
+
+Description
+  -A class for converting readings of the monotonic clock
+   (QueryPerformanceCounter()) to local date and time strings,
+   used by the Logger class to timestamp messages.
+  -Clock readings are converted to times using an "anchor": a pair of readings
+   of the monotonic clock and the system clock (GetSystemTimeAsFileTime())
+   taken at the same moment. The anchor is renewed periodically,
+   so that the times follow adjustments to the system clock.
+  -The formatted date and time, to the second, is cached, along with
+   the range of clock readings within the second, so conversion to local time
+   and formatting only occur once per second. Otherwise, formatting a time
+   consists of writing sub-second digits into the cached string,
+   computed from the clock reading with a fixed-point multiplication
+   (no division), and appending the cached string to the output.
+
+Usage Notes
+  -now() is thread-safe. Other member functions are not.
+  -setAnchor() allows clock readings taken by another process
+   (e.g. readings stored in a file by BinaryLogger) to be converted,
+   using anchors recorded by that process.
+  -Times output by an object never decrease, even if the system clock
+   is set backwards, or if append() is called with clock readings
+   out of order. (Earlier times are replaced by the latest time output.)
+*/
+
+#pragma once
+
+#include <windows.h>
+#include <string>
+
+class Timestamper
+{
+public:
+	enum class Format : unsigned int {
+		ASCTIME, // "Www Mmm dd hh:mm:ss[.fff] yyyy", the format of the C library's asctime() function
+		ISO8601 // "yyyy-mm-ddThh:mm:ss[.fff]" (local time)
+	};
+
+	// Maximum number of sub-second digits (the resolution of FILETIME values)
+	static const unsigned int s_maxSubsecondDigits = 7;
+
+	// Data members
+private:
+	Format m_format;
+
+	unsigned int m_subsecondDigits;
+
+	// 10 to the power of 'm_subsecondDigits'
+	unsigned int m_subsecondUnits;
+
+	/* Fixed-point factor converting clock counts to units of the last sub-second digit,
+	   with 'm_subsecondShift' fractional bits
+	 */
+	ULONGLONG m_subsecondFactor;
+	unsigned int m_subsecondShift;
+
+	// Frequency of the monotonic clock, in counts per second
+	LONGLONG m_frequency;
+
+	// Monotonic clock reading of the anchor
+	LONGLONG m_anchorCounter;
+
+	// System time of the anchor (100-nanosecond intervals since January 1, 1601, UTC)
+	LONGLONG m_anchorTime;
+
+	// If true, the anchor was set using setAnchor(), and is not renewed automatically
+	bool m_anchorFixed;
+
+	// Latest time output
+	LONGLONG m_lastTime;
+
+	// Latest clock reading output
+	LONGLONG m_lastCounter;
+
+	// Clock readings at the start (inclusive) and end (exclusive) of the cached second
+	LONGLONG m_cachedStartCounter;
+	LONGLONG m_cachedEndCounter;
+
+	// Second (in the units of 'm_anchorTime', divided by 10^7) described by the cached strings
+	LONGLONG m_cachedSecond;
+
+	// Formatted time, in which the sub-second digits are overwritten for each output
+	std::wstring m_cachedText;
+
+	// Position of the sub-second digits in 'm_cachedText', or zero if there are none
+	size_t m_subsecondPos;
+
+public:
+	/* 'subsecondDigits' is the number of digits output after the seconds
+	   (from 0 to s_maxSubsecondDigits). No decimal point is output
+	   when it is zero.
+	 */
+	Timestamper(const Format format = Format::ASCTIME, const unsigned int subsecondDigits = 3);
+
+	~Timestamper(void);
+
+	// Returns the current reading of the monotonic clock
+	static LONGLONG now(void);
+
+	// Appends the local time corresponding to a value returned by now()
+	void append(std::wstring& out, const LONGLONG counter);
+
+	/* Changes the format of subsequent output.
+	   Returns a failure result, and makes no changes,
+	   if 'subsecondDigits' is greater than s_maxSubsecondDigits.
+	 */
+	HRESULT setFormat(const Format format, const unsigned int subsecondDigits);
+
+	/* Replaces the anchor with readings of a monotonic clock with
+	   the given frequency (in counts per second) and of the system clock
+	   (as a FILETIME value), such as readings taken by another process.
+	   The anchor is no longer renewed automatically after this call,
+	   but can be replaced by subsequent calls.
+	   Returns a failure result, and makes no changes, if the frequency is not positive.
+	 */
+	HRESULT setAnchor(const LONGLONG frequency, const LONGLONG counter, const LONGLONG time);
+
+private:
+	// Takes new readings of the monotonic clock and the system clock
+	void anchor(void);
+
+	/* Formats the cached strings for the second containing the clock reading,
+	   and updates the cached range of clock readings
+	 */
+	void updateCache(const LONGLONG counter);
+
+	// Writes the sub-second digits corresponding to the clock reading into 'm_cachedText'
+	void writeSubseconds(const LONGLONG counter);
+
+	// Currently not implemented - will cause linker errors if called
+private:
+	Timestamper(const Timestamper& other);
+	Timestamper& operator=(const Timestamper& other);
+};
\ No newline at end of file
@@ -0,0 +1,88 @@
+/*
+embeddedConfig.h
+----------------
+
+Created for: Spring 2014 Direct3D 11 Learning
+By: Bernard Llanos
+August 17, 2014
+
+Primary basis: None
+Other references: None
+
+Development environment: Visual Studio 2013 running on Windows 7, 64-bit
+  -Note that the "Character Set" project property (Configuration Properties > General)
+   should be set to Unicode for all configurations, when using Visual Studio.
+
+Description
+  -Default configuration data which is compiled into the program,
+   to be used as the lowest layer of the global Config object,
+   beneath the data loaded from the global configuration file.
+  -The defaults are listed below, one list per data type,
+   in the order (scope, field, value) used by FlatAtomicConfigIO lines.
+   Each list is compiled into a static read-only table of values of the
+   corresponding C++ type, so no text is parsed at runtime, and values
+   of the wrong type cause compilation errors.
+    -Strings, filenames and directories are wide-character string literals.
+    -FLOAT4 and COLOR values are four comma-separated float literals.
+
+Usage Notes
+  -Visual Studio 2013 does not support constexpr functions,
+   so the defaults cannot be written as configuration file text
+   validated during compilation. They are instead written as
+   initializers of typed tables (see embeddedConfig.cpp).
+  -Keys should not be listed more than once.
+   Only the first value listed for a key is used.
+*/
+
+#pragma once
+
+#include <windows.h>
+#include <string>
+#include <list>
+#include "Config.h"
+#include "defs.h"
+
+// -------------------------------------------------------------------------
+// Embedded defaults (X-macro lists, with one 'X(scope, field, value)' per entry)
+// -------------------------------------------------------------------------
+
+#define EMBEDDEDCONFIG_WSTRING(X)
+
+#define EMBEDDEDCONFIG_BOOL(X) \
+	X(OUTPUT_DEFAULT_CONFIG_SCOPE, OUTPUT_DEFAULT_CONFIG_FIELD, OUTPUT_DEFAULT_CONFIG)
+
+#define EMBEDDEDCONFIG_INT(X)
+
+#define EMBEDDEDCONFIG_DOUBLE(X)
+
+#define EMBEDDEDCONFIG_FLOAT4(X)
+
+#define EMBEDDEDCONFIG_COLOR(X)
+
+#define EMBEDDEDCONFIG_FILENAME(X) \
+	X(DEFAULT_LOG_FILENAME_SCOPE, DEFAULT_LOG_FILENAME_FIELD, DEFAULT_LOG_FILENAME) \
+	X(DEFAULT_CONFIG_FILENAME_WRITE_SCOPE, DEFAULT_CONFIG_FILENAME_WRITE_FIELD, DEFAULT_CONFIG_FILENAME_WRITE)
+
+#define EMBEDDEDCONFIG_DIRECTORY(X) \
+	X(DEFAULT_LOG_PATH_SCOPE, DEFAULT_LOG_PATH_FIELD, DEFAULT_LOG_PATH) \
+	X(DEFAULT_CONFIG_PATH_WRITE_SCOPE, DEFAULT_CONFIG_PATH_WRITE_FIELD, DEFAULT_CONFIG_PATH_WRITE)
+
+namespace embeddedConfig {
+
+	/* Inserts the embedded defaults into the Config object,
+	   under keys which are not already present, so that the defaults
+	   act as the lowest layer of configuration data.
+	   (The Config object should therefore be loaded from configuration
+	   files before this function is called.)
+
+	   If 'locatorsOut' is not null, the locator strings
+	   (see Config::insert()) of the keys whose defaults
+	   were inserted are appended to it.
+
+	   Returns a failure result if a value could not be inserted.
+	 */
+	HRESULT insertDefaults(Config& config, std::list<std::wstring>* const locatorsOut = 0);
+
+	// Returns the number of embedded defaults
+	size_t count(void);
+}
\ No newline at end of file
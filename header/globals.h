@@ -58,6 +58,14 @@ extern Logger* g_defaultLogger;
  */
 extern Config* g_defaultConfig;
 
+/* Reloads configuration files loaded by ConfigUser objects
+   and the global Config object when they are modified.
+   Initialized and destroyed in main.cpp, and may be null.
+   Changes are applied by BasicWindow::updateAll().
+ */
+class ConfigWatcher;
+extern ConfigWatcher* g_configWatcher;
+
 // Global functions
 // ----------------
 
@@ -26,6 +26,7 @@ Description
 
 #include <windows.h>
 #include <string>
+#include <vector>
 #include "Config.h"
 
 class IConfigIO {
@@ -78,6 +79,43 @@ public:
 	*/
 	virtual bool toggleContextOutput(const bool outputContext) = 0;
 
+	/* Outputs the full paths of the files, other than the file passed
+	to read(), from which data was loaded by the last call to read()
+	(e.g. files included by the file that was read), so that callers
+	which cache or watch configuration files can account for them.
+
+	This default implementation, for classes which load data
+	from one file at a time, outputs an empty list.
+	*/
+	virtual void getIncludedFiles(std::vector<std::wstring>& filenames) const {
+		filenames.clear();
+	}
+
+	/* Outputs the full paths of the files, other than 'filename',
+	from which read() would load data (as for getIncludedFiles()),
+	without loading any data or modifying any of the files.
+
+	This default implementation, for classes which load data
+	from one file at a time, outputs an empty list.
+	*/
+	virtual HRESULT listIncludedFiles(const std::wstring& filename,
+		std::vector<std::wstring>& filenames) const {
+		filenames.clear();
+		return ERROR_SUCCESS;
+	}
+
+	/* Toggles whether (true) or not (false) read() and write()
+	may append parsing warnings, errors, etc. to configuration files.
+	When disabled, the messages are only logged.
+
+	Returns the previous state of this setting. This default implementation,
+	for classes which never append messages to files, does nothing
+	and returns false.
+	*/
+	virtual bool toggleReportOutput(const bool outputReports) {
+		return false;
+	}
+
 	// Currently not implemented - will cause linker errors if called
 private:
 	IConfigIO(const IConfigIO& other);
@@ -21,6 +21,7 @@ Description
 
 #include <windows.h> // For the HRESULT type
 #include <string>
+#include <cstdint>
 
 #define W_PATH_SEP L'\\'
 
@@ -152,4 +153,50 @@ namespace fileUtil {
 		of the function parameters.
 	 */
 	HRESULT combineAsPath(std::wstring& out, const std::wstring& seg1, const std::wstring& seg2);
+
+	/* Opens an existing file for reading and maps its entire contents
+	   into the address space of the process (read-only).
+
+	   On success, 'view' points to the first byte of the file's contents,
+	   and 'size' is the length of the file in bytes. An empty file
+	   cannot be mapped by Windows, and so results in a success code,
+	   a null 'view' and a zero 'size'.
+
+	   'file' and 'mapping' are output handles which must be passed,
+	   together with 'view', to unmapFile() when the contents of the file
+	   are no longer needed (even in the case of an empty file).
+
+	   Returns a failure result, with the ERROR_FILE_NOT_FOUND code, if the
+	   file cannot be opened, and a failure result with another code
+	   if it cannot be mapped. Nothing needs to be released in these cases.
+	 */
+	HRESULT mapFile(const std::wstring& filename, HANDLE& file, HANDLE& mapping,
+		const char*& view, size_t& size);
+
+	/* Releases the resources acquired by mapFile(),
+	   and resets the parameters to null or invalid values.
+	 */
+	HRESULT unmapFile(HANDLE& file, HANDLE& mapping, const char*& view);
+
+	/* Outputs the size (in bytes) and last modification time
+	   (as a FILETIME value) of a file, which together are used
+	   to detect changes to the file.
+	   Returns a failure result if the file's attributes cannot be retrieved.
+	 */
+	HRESULT getFileStamp(const std::wstring& filename,
+		uint64_t& size, uint64_t& writeTime);
+
+	/* Outputs the absolute, normalized form of a file or directory name
+	   (optionally qualified with a path). A relative name is interpreted
+	   relative to the 'directory' parameter if it is not empty,
+	   or relative to the current working directory otherwise.
+
+	   The output can be used to determine whether two names refer
+	   to the same file, after conversion to a common case
+	   (as Windows filenames are case-insensitive).
+
+	   Returns a failure result if the name cannot be converted.
+	 */
+	HRESULT fullPath(std::wstring& out, const std::wstring& name,
+		const std::wstring& directory = L"");
 }
\ No newline at end of file
@@ -47,6 +47,11 @@ namespace higherLevelIO {
 	/* Essentially the inverse of strToXMFLOAT4() */
 	HRESULT XMFLOAT4ToWString(std::wstring& out, const DirectX::XMFLOAT4& in);
 
+	/* A version of XMFLOAT4ToWString() which appends to 'out'
+	   using textProcessing::appendNumber()
+	 */
+	HRESULT appendXMFLOAT4(std::wstring& out, const DirectX::XMFLOAT4& in);
+
 	/* Similar to strToXMFLOAT4() except that the
 	   data literal must contain only components
 	   in the range of 0.0-255.0.
@@ -67,4 +72,9 @@ namespace higherLevelIO {
 	   and converted to integers before being output.
 	 */
 	HRESULT colorRGBAToWString(std::wstring& out, const DirectX::XMFLOAT4& in);
+
+	/* A version of colorRGBAToWString() which appends to 'out'
+	   using textProcessing::appendNumber()
+	 */
+	HRESULT appendColorRGBA(std::wstring& out, const DirectX::XMFLOAT4& in);
 }
\ No newline at end of file
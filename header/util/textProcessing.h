@@ -212,6 +212,25 @@ namespace textProcessing {
 		}
 	}
 
+	/* Versions of numberToWString() which append the number to 'out'
+	   (producing the same text as numberToWString()),
+	   rather than assigning to 'out'. No intermediate string
+	   or stream objects are created, so these functions are suitable
+	   for formatting large amounts of output into a reusable buffer.
+	 */
+	HRESULT appendNumber(std::wstring& out, const int in);
+	HRESULT appendNumber(std::wstring& out, const float in);
+	HRESULT appendNumber(std::wstring& out, const double in);
+
+	/* Appends the UTF-8 encoding of the 'length' wide characters
+	   starting at 'in' to 'out'. (ASCII characters are therefore output unchanged.)
+
+	   Wide characters are interpreted as UTF-16 code units,
+	   unless they are larger than 16 bits. Unpaired surrogates
+	   are encoded as the Unicode replacement character (U+FFFD).
+	 */
+	HRESULT appendUTF8(std::string& out, const wchar_t* const in, const size_t length);
+
 	/* An array form of strToNumber() which parses an array
 	   of 'n' comma-separated values from a string.
 	   Whitespace must have been stripped previously, if necessary.
@@ -0,0 +1,469 @@
+/*
+benchmarkConfigIO.cpp
+---------------------
+
+Created for: Spring 2014 Direct3D 11 Learning
+By: Bernard Llanos
+August 17, 2014
+
+Primary basis: None
+
+Other references: None
+
+Development environment: Visual Studio 2013 running on Windows 7, 64-bit
+  -Note that the "Character Set" project property (Configuration Properties > General)
+   should be set to Unicode for all configurations, when using Visual Studio.
+
+Description
+  -Implementation of the benchmarkConfigIO namespace functions
+*/
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <algorithm>
+#include <DirectXMath.h>
+#include "benchmarkConfigIO.h"
+#include "defs.h"
+#include "globals.h"
+#include "Config.h"
+#include "Logger.h"
+#include "fileUtil.h"
+#include "textProcessing.h"
+#include "FlatAtomicConfigIO.h"
+
+using std::wstring;
+using std::string;
+
+static_assert(static_cast<unsigned int>(Config::DataType::DIRECTORY) + 1 == BENCHMARKCONFIGIO_N_DATATYPES,
+	"BENCHMARKCONFIGIO_N_DATATYPES must equal the number of Config::DataType constants");
+
+// Times recorded for one phase of the benchmark, in seconds
+struct PhaseTimes {
+	double min;
+	double max;
+	double total;
+	unsigned int n;
+
+	PhaseTimes(void) : min(0.0), max(0.0), total(0.0), n(0) {}
+
+	void add(const LARGE_INTEGER& start, const LARGE_INTEGER& end, const LARGE_INTEGER& frequency) {
+		const double seconds = static_cast<double>(end.QuadPart - start.QuadPart)
+			/ static_cast<double>(frequency.QuadPart);
+		if( n == 0 || seconds < min ) {
+			min = seconds;
+		}
+		if( n == 0 || seconds > max ) {
+			max = seconds;
+		}
+		total += seconds;
+		++n;
+	}
+};
+
+// A key, and the data type of its value, for the lookup phase
+struct LookupKey {
+	wstring scope;
+	wstring field;
+	Config::DataType type;
+};
+
+/* Returns true if the two Config objects have the same keys and data types
+   (as for the helper function of the same name in testConfig_IConfigManager.cpp)
+ */
+static bool sameKeysAndTypes(const Config& config1, const Config& config2) {
+	std::map<Config::Key, Config::Value*>::const_iterator it1 = config1.cbegin();
+	std::map<Config::Key, Config::Value*>::const_iterator it2 = config2.cbegin();
+	for( ; it1 != config1.cend() && it2 != config2.cend(); ++it1, ++it2 ) {
+		if( it1->first.getScope() != it2->first.getScope() ||
+			it1->first.getField() != it2->first.getField() ||
+			it1->second->getDataType() != it2->second->getDataType() ) {
+			return false;
+		}
+	}
+	return it1 == config1.cend() && it2 == config2.cend();
+}
+
+// Retrieves the value stored under the key, returning true if it was found
+static bool lookup(const Config& config, const LookupKey& key) {
+	switch( key.type ) {
+	case Config::DataType::WSTRING:
+	{
+		const wstring* value = 0;
+		config.retrieve<Config::DataType::WSTRING, wstring>(key.scope, key.field, value);
+		return value != 0;
+	}
+	case Config::DataType::BOOL:
+	{
+		const bool* value = 0;
+		config.retrieve<Config::DataType::BOOL, bool>(key.scope, key.field, value);
+		return value != 0;
+	}
+	case Config::DataType::INT:
+	{
+		const int* value = 0;
+		config.retrieve<Config::DataType::INT, int>(key.scope, key.field, value);
+		return value != 0;
+	}
+	case Config::DataType::DOUBLE:
+	{
+		const double* value = 0;
+		config.retrieve<Config::DataType::DOUBLE, double>(key.scope, key.field, value);
+		return value != 0;
+	}
+	case Config::DataType::FLOAT4:
+	{
+		const DirectX::XMFLOAT4* value = 0;
+		config.retrieve<Config::DataType::FLOAT4, DirectX::XMFLOAT4>(key.scope, key.field, value);
+		return value != 0;
+	}
+	case Config::DataType::COLOR:
+	{
+		const DirectX::XMFLOAT4* value = 0;
+		config.retrieve<Config::DataType::COLOR, DirectX::XMFLOAT4>(key.scope, key.field, value);
+		return value != 0;
+	}
+	case Config::DataType::FILENAME:
+	{
+		const wstring* value = 0;
+		config.retrieve<Config::DataType::FILENAME, wstring>(key.scope, key.field, value);
+		return value != 0;
+	}
+	case Config::DataType::DIRECTORY:
+	{
+		const wstring* value = 0;
+		config.retrieve<Config::DataType::DIRECTORY, wstring>(key.scope, key.field, value);
+		return value != 0;
+	}
+	default:
+		return false;
+	}
+}
+
+// Appends a JSON object describing the phase
+static void appendPhase(std::ostringstream& out, const char* const name,
+	const PhaseTimes& times, const unsigned int nValues, const bool last) {
+	const double mean = (times.n == 0) ? 0.0 : (times.total / times.n);
+	out << "\t\t\"" << name << "\": { \"minSeconds\": " << times.min
+		<< ", \"meanSeconds\": " << mean
+		<< ", \"maxSeconds\": " << times.max
+		<< ", \"valuesPerSecond\": " << ((times.min > 0.0) ? (nValues / times.min) : 0.0)
+		<< " }" << (last ? "\n" : ",\n");
+}
+
+// Escapes a string for output as a JSON string value
+static string jsonEscape(const string& in) {
+	string out;
+	for( string::const_iterator it = in.cbegin(); it != in.cend(); ++it ) {
+		if( *it == '"' || *it == '\\' ) {
+			out += '\\';
+		}
+		out += *it;
+	}
+	return out;
+}
+
+benchmarkConfigIO::Workload::Workload(void) :
+nValues(10000), nScopes(64), stringLength(16), errorRate(0.0), seed(1), label("default")
+{
+	for( size_t i = 0; i < BENCHMARKCONFIGIO_N_DATATYPES; ++i ) {
+		typeWeights[i] = 1;
+	}
+}
+
+HRESULT benchmarkConfigIO::generate(string& out, const Workload& workload) {
+
+	out.clear();
+	if( workload.nValues == 0 ) {
+		return ERROR_SUCCESS;
+	}
+
+	std::mt19937 generator(workload.seed);
+	std::discrete_distribution<unsigned int> typeDistribution(workload.typeWeights,
+		workload.typeWeights + BENCHMARKCONFIGIO_N_DATATYPES);
+	std::bernoulli_distribution errorDistribution(std::min(std::max(workload.errorRate, 0.0), 1.0));
+	std::uniform_int_distribution<int> intDistribution(-1000000, 1000000);
+	std::uniform_real_distribution<double> realDistribution(-1000.0, 1000.0);
+	std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+	std::uniform_int_distribution<int> letterDistribution(0, 25);
+	std::uniform_int_distribution<int> errorKindDistribution(0, 3);
+	const unsigned int nScopes = (workload.nScopes == 0) ? 1 : workload.nScopes;
+
+	wstring line;
+	wstring buffer;
+	wstring text;
+	DirectX::XMFLOAT4 float4;
+	for( unsigned int i = 0; i < workload.nValues; ++i ) {
+		const Config::DataType type = static_cast<Config::DataType>(typeDistribution(generator));
+		const Config::DataTypeInfo* const info = Config::getDataTypeInfo(type);
+		if( info == 0 ) {
+			return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_BROKEN_CODE);
+		}
+
+		// Generate a value of the data type
+		const void* value = 0;
+		bool boolValue = false;
+		int intValue = 0;
+		double doubleValue = 0.0;
+		text.clear();
+		for( unsigned int j = 0; j < workload.stringLength; ++j ) {
+			text += static_cast<wchar_t>(L'a' + letterDistribution(generator));
+		}
+		switch( type ) {
+		case Config::DataType::BOOL:
+			boolValue = (intDistribution(generator) % 2) == 0;
+			value = &boolValue;
+			break;
+		case Config::DataType::INT:
+			intValue = intDistribution(generator);
+			value = &intValue;
+			break;
+		case Config::DataType::DOUBLE:
+			doubleValue = realDistribution(generator);
+			value = &doubleValue;
+			break;
+		case Config::DataType::FLOAT4:
+			float4 = DirectX::XMFLOAT4(static_cast<float>(realDistribution(generator)),
+				static_cast<float>(realDistribution(generator)),
+				static_cast<float>(realDistribution(generator)),
+				static_cast<float>(realDistribution(generator)));
+			value = &float4;
+			break;
+		case Config::DataType::COLOR:
+			float4 = DirectX::XMFLOAT4(unitDistribution(generator), unitDistribution(generator),
+				unitDistribution(generator), unitDistribution(generator));
+			value = &float4;
+			break;
+		case Config::DataType::FILENAME:
+			text += L".txt";
+			value = &text;
+			break;
+		default:
+			// WSTRING and DIRECTORY
+			value = &text;
+			break;
+		}
+
+		// Format the line
+		line.assign(info->wName, info->nameLength);
+		line += L" -- scope" + std::to_wstring(i % nScopes) + L"::field" + std::to_wstring(i) + L" = ";
+		if( FAILED(info->format(line, value, buffer)) ) {
+			return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+		}
+
+		// Damage the line
+		if( errorDistribution(generator) ) {
+			switch( errorKindDistribution(generator) ) {
+			case 0:
+				// Missing value separator
+				line.erase(line.find(L'='), 1);
+				break;
+			case 1:
+				// Unknown data type
+				line.insert(0, L"UNKNOWN");
+				break;
+			case 2:
+				// Missing scope separator
+				line.erase(line.find(L"::"), 2);
+				break;
+			default:
+				// Invalid value
+				line.erase(line.find(L'=') + 1);
+				line += L" (not a value";
+				break;
+			}
+		}
+
+		if( FAILED(textProcessing::appendUTF8(out, line.c_str(), line.length())) ) {
+			return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+		}
+		out += '\n';
+	}
+	return ERROR_SUCCESS;
+}
+
+HRESULT benchmarkConfigIO::run(const Workload& workload, const unsigned int nRepetitions,
+	const wstring& jsonFilename) {
+
+	// Parsing reports are logged here, rather than to the global log
+	wstring logFilename;
+	fileUtil::combineAsPath(logFilename, DEFAULT_LOG_PATH_TEST, L"benchmarkConfigIO.txt");
+	FlatAtomicConfigIO configIO;
+	HRESULT result = configIO.setLogger(true, logFilename, false, false);
+	if( FAILED(result) ) {
+		return result;
+	}
+
+	string text;
+	result = generate(text, workload);
+	if( FAILED(result) ) {
+		return result;
+	}
+
+	wstring inputFilename;
+	wstring outputFilename;
+	fileUtil::combineAsPath(inputFilename, DEFAULT_CONFIG_PATH_TEST_WRITE, L"benchmarkConfigIO_input.txt");
+	fileUtil::combineAsPath(outputFilename, DEFAULT_CONFIG_PATH_TEST_WRITE, L"benchmarkConfigIO_output.txt");
+
+	PhaseTimes readTimes, writeTimes, roundTripTimes, lookupTimes, destructionTimes;
+	LARGE_INTEGER frequency, start, end;
+	QueryPerformanceFrequency(&frequency);
+	size_t nLoaded = 0;
+	uint64_t writtenSize = 0;
+	bool roundTripMatches = true;
+	std::vector<LookupKey> keys;
+
+	for( unsigned int i = 0; i < nRepetitions && SUCCEEDED(result); ++i ) {
+		{
+			std::ofstream file(inputFilename, std::ofstream::out | std::ofstream::binary);
+			file.write(text.c_str(), text.length());
+			if( !file.good() ) {
+				return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+			}
+		}
+
+		// Read
+		Config* config = new Config;
+		QueryPerformanceCounter(&start);
+		result = configIO.read(inputFilename, *config);
+		QueryPerformanceCounter(&end);
+		readTimes.add(start, end, frequency);
+		if( FAILED(result) ) {
+			delete config;
+			break;
+		}
+		nLoaded = static_cast<size_t>(std::distance(config->cbegin(), config->cend()));
+
+		// Write
+		QueryPerformanceCounter(&start);
+		result = configIO.write(outputFilename, *config, true);
+		QueryPerformanceCounter(&end);
+		writeTimes.add(start, end, frequency);
+		if( FAILED(result) ) {
+			delete config;
+			break;
+		}
+		uint64_t writeTime = 0;
+		fileUtil::getFileStamp(outputFilename, writtenSize, writeTime);
+
+		// Round trip
+		Config roundTrip;
+		QueryPerformanceCounter(&start);
+		result = configIO.read(outputFilename, roundTrip);
+		QueryPerformanceCounter(&end);
+		roundTripTimes.add(start, end, frequency);
+		if( FAILED(result) || !sameKeysAndTypes(*config, roundTrip) ) {
+			roundTripMatches = false;
+			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+
+		// Lookup
+		keys.clear();
+		keys.reserve(nLoaded);
+		std::map<Config::Key, Config::Value*>::const_iterator configEnd = config->cend();
+		for( std::map<Config::Key, Config::Value*>::const_iterator it = config->cbegin(); it != configEnd; ++it ) {
+			LookupKey key = { it->first.getScope(), it->first.getField(), it->second->getDataType() };
+			keys.push_back(key);
+		}
+		size_t nFound = 0;
+		QueryPerformanceCounter(&start);
+		for( std::vector<LookupKey>::const_iterator it = keys.cbegin(); it != keys.cend(); ++it ) {
+			if( lookup(*config, *it) ) {
+				++nFound;
+			}
+		}
+		QueryPerformanceCounter(&end);
+		lookupTimes.add(start, end, frequency);
+		if( nFound != nLoaded ) {
+			result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_NOT_FOUND);
+		}
+
+		// Destruction
+		QueryPerformanceCounter(&start);
+		delete config;
+		QueryPerformanceCounter(&end);
+		destructionTimes.add(start, end, frequency);
+	}
+
+	// Output the results
+	wstring wTime;
+	string time;
+	if( FAILED(Logger::getDateAndTime(wTime)) || FAILED(toString(time, wTime)) ) {
+		time = "unknown";
+	}
+	std::ostringstream json;
+	json << "{\n"
+		<< "\t\"label\": \"" << jsonEscape(workload.label) << "\",\n"
+		<< "\t\"time\": \"" << jsonEscape(time) << "\",\n"
+		<< "\t\"succeeded\": " << (SUCCEEDED(result) ? "true" : "false") << ",\n"
+		<< "\t\"repetitions\": " << nRepetitions << ",\n"
+		<< "\t\"workload\": {\n"
+		<< "\t\t\"nValues\": " << workload.nValues << ",\n"
+		<< "\t\t\"nScopes\": " << workload.nScopes << ",\n"
+		<< "\t\t\"typeWeights\": {";
+	for( unsigned int i = 0; i < BENCHMARKCONFIGIO_N_DATATYPES; ++i ) {
+		const Config::DataTypeInfo* const info = Config::getDataTypeInfo(static_cast<Config::DataType>(i));
+		json << ((i == 0) ? " \"" : ", \"") << ((info == 0) ? "?" : info->name) << "\": " << workload.typeWeights[i];
+	}
+	json << " },\n"
+		<< "\t\t\"stringLength\": " << workload.stringLength << ",\n"
+		<< "\t\t\"errorRate\": " << workload.errorRate << ",\n"
+		<< "\t\t\"seed\": " << workload.seed << "\n"
+		<< "\t},\n"
+		<< "\t\"inputBytes\": " << text.length() << ",\n"
+		<< "\t\"outputBytes\": " << writtenSize << ",\n"
+		<< "\t\"valuesLoaded\": " << nLoaded << ",\n"
+		<< "\t\"roundTripMatches\": " << (roundTripMatches ? "true" : "false") << ",\n"
+		<< "\t\"phases\": {\n";
+	appendPhase(json, "read", readTimes, workload.nValues, false);
+	appendPhase(json, "write", writeTimes, static_cast<unsigned int>(nLoaded), false);
+	appendPhase(json, "roundTrip", roundTripTimes, static_cast<unsigned int>(nLoaded), false);
+	appendPhase(json, "lookup", lookupTimes, static_cast<unsigned int>(nLoaded), false);
+	appendPhase(json, "destruction", destructionTimes, static_cast<unsigned int>(nLoaded), true);
+	json << "\t}\n}\n";
+
+	std::ofstream jsonFile(jsonFilename, std::ofstream::out);
+	jsonFile << json.str();
+	if( !jsonFile.good() ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	return result;
+}
+
+HRESULT benchmarkConfigIO::runSuite(const unsigned int nRepetitions) {
+
+	std::vector<Workload> workloads(8);
+	workloads[1].label = "large";
+	workloads[1].nValues = 100000;
+	workloads[2].label = "fewScopes";
+	workloads[2].nScopes = 1;
+	workloads[3].label = "manyScopes";
+	workloads[3].nScopes = workloads[3].nValues;
+	workloads[4].label = "numeric";
+	std::fill(workloads[4].typeWeights, workloads[4].typeWeights + BENCHMARKCONFIGIO_N_DATATYPES, 0);
+	workloads[4].typeWeights[static_cast<size_t>(Config::DataType::INT)] = 1;
+	workloads[4].typeWeights[static_cast<size_t>(Config::DataType::DOUBLE)] = 1;
+	workloads[5].label = "strings";
+	std::fill(workloads[5].typeWeights, workloads[5].typeWeights + BENCHMARKCONFIGIO_N_DATATYPES, 0);
+	workloads[5].typeWeights[static_cast<size_t>(Config::DataType::WSTRING)] = 1;
+	workloads[6].label = "longStrings";
+	workloads[6].stringLength = 128;
+	workloads[7].label = "errors";
+	workloads[7].errorRate = 0.1;
+
+	HRESULT finalResult = ERROR_SUCCESS;
+	wstring label;
+	wstring jsonFilename;
+	for( std::vector<Workload>::const_iterator it = workloads.cbegin(); it != workloads.cend(); ++it ) {
+		toWString(label, it->label);
+		fileUtil::combineAsPath(jsonFilename, DEFAULT_LOG_PATH_TEST, L"benchmarkConfigIO_" + label + L".json");
+		HRESULT result = run(*it, nRepetitions, jsonFilename);
+		if( FAILED(result) ) {
+			finalResult = result;
+		}
+	}
+	return finalResult;
+}
\ No newline at end of file
@@ -0,0 +1,268 @@
+/*
+benchmarkLogger.cpp
+-------------------
+
+Created for: Spring 2014 Direct3D 11 Learning
+By: Bernard Llanos
+August 20, 2014
+
+Primary basis: None
+
+Other references: None
+
+Development environment: Visual Studio 2013 running on Windows 7, 64-bit
+  -Note that the "Character Set" project property (Configuration Properties > General)
+   should be set to Unicode for all configurations, when using Visual Studio.
+
+Description
+  -Implementation of the benchmarkLogger namespace functions
+*/
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include "benchmarkLogger.h"
+#include "defs.h"
+#include "globals.h"
+#include "Logger.h"
+#include "fileUtil.h"
+
+using std::wstring;
+using std::string;
+
+// Largest number of threads used by runSuite()
+#define BENCHMARKLOGGER_MAX_THREADS 32
+
+// Times recorded for one configuration of the benchmark, in seconds
+struct PhaseTimes {
+	double min;
+	double max;
+	double total;
+	unsigned int n;
+
+	PhaseTimes(void) : min(0.0), max(0.0), total(0.0), n(0) {}
+
+	void add(const double seconds) {
+		if( n == 0 || seconds < min ) {
+			min = seconds;
+		}
+		if( n == 0 || seconds > max ) {
+			max = seconds;
+		}
+		total += seconds;
+		++n;
+	}
+};
+
+// Appends a JSON object describing the configuration
+static void appendPhase(std::ostringstream& out, const char* const mode,
+	const unsigned int nThreads, const PhaseTimes& times,
+	const unsigned int nMessages, const bool intact, const bool last) {
+	const double mean = (times.n == 0) ? 0.0 : (times.total / times.n);
+	out << "\t\t{ \"mode\": \"" << mode << "\", \"threads\": " << nThreads
+		<< ", \"minSeconds\": " << times.min
+		<< ", \"meanSeconds\": " << mean
+		<< ", \"maxSeconds\": " << times.max
+		<< ", \"messagesPerSecond\": " << ((times.min > 0.0) ? (nMessages / times.min) : 0.0)
+		<< ", \"intact\": " << (intact ? "true" : "false")
+		<< " }" << (last ? "\n" : ",\n");
+}
+
+// Escapes a string for output as a JSON string value
+static string jsonEscape(const string& in) {
+	string out;
+	for( string::const_iterator it = in.cbegin(); it != in.cend(); ++it ) {
+		if( *it == '"' || *it == '\\' ) {
+			out += '\\';
+		}
+		out += *it;
+	}
+	return out;
+}
+
+/* Checks that the file contains 'nMessagesPerThread' lines of the form
+   "<timestamp> | thread <thread index> <message index>" from each thread,
+   in order for each thread. 'nLines' is set to the number of such lines.
+ */
+static bool checkOutput(size_t& nLines, const wstring& filename,
+	const unsigned int nThreads, const unsigned int nMessagesPerThread) {
+
+	nLines = 0;
+	std::basic_ifstream<wchar_t> file(filename);
+	if( !file.is_open() ) {
+		return false;
+	}
+
+	std::vector<int> lastIndex(nThreads, -1);
+	wstring line;
+	wstring word;
+	unsigned int t = 0;
+	int i = 0;
+	bool intact = true;
+	while( std::getline(file, line) ) {
+		const size_t separator = line.find(L" | ");
+		std::wistringstream lineStream((separator == wstring::npos) ? line : line.substr(separator + 3));
+		if( !(lineStream >> word) || word != L"thread" ||
+			!(lineStream >> t >> i) || t >= nThreads || i != (lastIndex[t] + 1) ) {
+			intact = false;
+			continue;
+		}
+		// There should be nothing after the message index
+		if( lineStream >> word ) {
+			intact = false;
+			continue;
+		}
+		lastIndex[t] = i;
+		++nLines;
+	}
+
+	for( unsigned int t = 0; t < nThreads; ++t ) {
+		if( lastIndex[t] != static_cast<int>(nMessagesPerThread) - 1 ) {
+			intact = false;
+		}
+	}
+	return intact;
+}
+
+benchmarkLogger::Result::Result(void) :
+seconds(0.0), nLines(0), intact(false)
+{}
+
+HRESULT benchmarkLogger::run(Result& result, const Mode mode, const unsigned int nThreads,
+	const unsigned int nMessages, const wstring& outputFilename) {
+
+	result = Result();
+	if( nThreads == 0 ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_INVALID_INPUT);
+	}
+	const unsigned int nMessagesPerThread = nMessages / nThreads;
+
+	Logger* logger = 0;
+	try {
+		logger = new Logger(true, outputFilename, true, false);
+	} catch( ... ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+
+	HRESULT finalResult = ERROR_SUCCESS;
+	if( mode == Mode::ASYNC ) {
+		finalResult = logger->startAsync((nMessages == 0) ? 1 : nMessages, Logger::OverflowPolicy::BLOCK);
+		if( FAILED(finalResult) ) {
+			delete logger;
+			return finalResult;
+		}
+	}
+
+	// Messages are formatted before the threads start logging
+	std::vector<std::vector<wstring> > messages(nThreads);
+	for( unsigned int t = 0; t < nThreads; ++t ) {
+		messages[t].reserve(nMessagesPerThread);
+		for( unsigned int i = 0; i < nMessagesPerThread; ++i ) {
+			messages[t].push_back(L"thread " + std::to_wstring(t) + L" " + std::to_wstring(i));
+		}
+	}
+
+	// Threads wait until all threads have been created before logging
+	std::atomic<bool> start(false);
+	std::atomic<bool> logFailed(false);
+	std::thread* threads = new std::thread[nThreads];
+	for( unsigned int t = 0; t < nThreads; ++t ) {
+		threads[t] = std::thread([logger, &messages, &start, &logFailed, t]() {
+			while( !start.load() ) {
+				std::this_thread::yield();
+			}
+			const std::vector<wstring>::const_iterator end = messages[t].cend();
+			for( std::vector<wstring>::const_iterator it = messages[t].cbegin(); it != end; ++it ) {
+				if( FAILED(logger->logMessage(*it)) ) {
+					logFailed.store(true);
+				}
+			}
+		});
+	}
+
+	LARGE_INTEGER frequency, startTime, endTime;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&startTime);
+	start.store(true);
+	for( unsigned int t = 0; t < nThreads; ++t ) {
+		threads[t].join();
+	}
+	if( FAILED(logger->flush()) ) {
+		logFailed.store(true);
+	}
+	QueryPerformanceCounter(&endTime);
+	delete[] threads;
+
+	result.seconds = static_cast<double>(endTime.QuadPart - startTime.QuadPart)
+		/ static_cast<double>(frequency.QuadPart);
+
+	if( FAILED(logger->stopAsync()) ) {
+		logFailed.store(true);
+	}
+	delete logger;
+
+	if( logFailed.load() ) {
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+
+	result.intact = checkOutput(result.nLines, outputFilename, nThreads, nMessagesPerThread);
+	if( !result.intact && SUCCEEDED(finalResult) ) {
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+	return finalResult;
+}
+
+HRESULT benchmarkLogger::runSuite(const unsigned int nMessages, const unsigned int nRepetitions) {
+
+	wstring outputFilename;
+	wstring jsonFilename;
+	fileUtil::combineAsPath(outputFilename, DEFAULT_LOG_PATH_TEST, L"benchmarkLogger_output.txt");
+	fileUtil::combineAsPath(jsonFilename, DEFAULT_LOG_PATH_TEST, L"benchmarkLogger.json");
+
+	wstring wTime;
+	string time;
+	if( FAILED(Logger::getDateAndTime(wTime)) || FAILED(toString(time, wTime)) ) {
+		time = "unknown";
+	}
+	std::ostringstream json;
+	json << "{\n"
+		<< "\t\"time\": \"" << jsonEscape(time) << "\",\n"
+		<< "\t\"messages\": " << nMessages << ",\n"
+		<< "\t\"repetitions\": " << nRepetitions << ",\n"
+		<< "\t\"runs\": [\n";
+
+	HRESULT finalResult = ERROR_SUCCESS;
+	const Mode modes[] = { Mode::SYNC, Mode::ASYNC };
+	const char* const modeNames[] = { "sync", "async" };
+	for( size_t m = 0; m < 2; ++m ) {
+		for( unsigned int nThreads = 1; nThreads <= BENCHMARKLOGGER_MAX_THREADS; nThreads *= 2 ) {
+			PhaseTimes times;
+			bool intact = true;
+			Result result;
+			for( unsigned int i = 0; i < nRepetitions; ++i ) {
+				HRESULT runResult = run(result, modes[m], nThreads, nMessages, outputFilename);
+				if( FAILED(runResult) ) {
+					finalResult = runResult;
+				}
+				times.add(result.seconds);
+				intact = intact && result.intact;
+			}
+			appendPhase(json, modeNames[m], nThreads, times, (nMessages / nThreads) * nThreads, intact,
+				(m == 1) && ((nThreads * 2) > BENCHMARKLOGGER_MAX_THREADS));
+		}
+	}
+
+	json << "\t],\n"
+		<< "\t\"succeeded\": " << (SUCCEEDED(finalResult) ? "true" : "false") << "\n"
+		<< "}\n";
+
+	std::ofstream jsonFile(jsonFilename, std::ofstream::out);
+	jsonFile << json.str();
+	if( !jsonFile.good() ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	return finalResult;
+}
\ No newline at end of file
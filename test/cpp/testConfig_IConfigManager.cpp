@@ -22,6 +22,9 @@ Description
 #include <string>
 #include <iterator>
 #include <map>
+#include <vector>
+#include <fstream>
+#include <sstream>
 #include "testConfig_IConfigManager.h"
 #include "defs.h"
 #include "globals.h"
@@ -29,6 +32,11 @@ Description
 #include "Logger.h"
 #include "fileUtil.h"
 #include "FlatAtomicConfigIO.h"
+#include "CachedConfigIO.h"
+#include "ConfigCache.h"
+#include "ConfigWatcher.h"
+#include "SectionedConfigIO.h"
+#include "embeddedConfig.h"
 
 using std::wstring;
 
@@ -411,5 +419,1594 @@ HRESULT testConfig_IConfigManager::testFlatAtomicConfigIO(void) {
 
 	delete logger;
 
+	return finalResult;
+}
+
+/* Helper function for testParallelFlatAtomicConfigIO(),
+   testIncludeFlatAtomicConfigIO() and testConfigWatcher()
+   Returns the number of lines in the file which start with the given text.
+ */
+static size_t countLinesStartingWith(const wstring& filename, const std::string& start) {
+	std::ifstream file(filename, std::ifstream::in);
+	std::string line;
+	size_t count = 0;
+	while( std::getline(file, line) ) {
+		if( line.compare(0, start.length(), start) == 0 ) {
+			++count;
+		}
+	}
+	return count;
+}
+
+HRESULT testConfig_IConfigManager::testParallelFlatAtomicConfigIO(const unsigned int n) {
+
+	// Create a file for logging the test results
+	Logger* logger = 0;
+	std::wstring logFilename;
+	try {
+		fileUtil::combineAsPath(logFilename, DEFAULT_LOG_PATH_TEST, L"testParallelFlatAtomicConfigIO.txt");
+		logger = new Logger(true, logFilename, false, false);
+	} catch( ... ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+
+	HRESULT result = ERROR_SUCCESS;
+	HRESULT finalResult = ERROR_SUCCESS;
+	wstring errorStr;
+
+	FlatAtomicConfigIO configIO;
+	result = configIO.setLogger(true, logFilename, false, false);
+	if( FAILED(result) ) {
+		logger->logMessage(L"Failed to redirect logging output of the FlatAtomicConfigIO object.");
+		prettyPrintHRESULT(errorStr, result);
+		logger->logMessage(errorStr);
+		finalResult = result;
+	}
+
+	// Generate the configuration file
+	Config sourceConfig;
+	for( unsigned int i = 0; i < n; ++i ) {
+		int* value = new int(static_cast<int>(i));
+		result = sourceConfig.insert<Config::DataType::INT, int>(
+			L"scope" + std::to_wstring(i % 16), L"field" + std::to_wstring(i), value);
+		if( FAILED(result) ) {
+			delete value;
+			logger->logMessage(L"Failed to insert a value into the source Config object.");
+			finalResult = result;
+			break;
+		}
+	}
+
+	std::wstring configFilename;
+	fileUtil::combineAsPath(configFilename, DEFAULT_CONFIG_PATH_TEST_WRITE, L"testParallelFlatAtomicConfigIO.txt");
+	result = configIO.write(configFilename, sourceConfig, true);
+	if( FAILED(result) ) {
+		logger->logMessage(L"Failed to write the configuration file: " + configFilename);
+		prettyPrintHRESULT(errorStr, result);
+		logger->logMessage(errorStr);
+		finalResult = result;
+	}
+
+	// Read the file using different numbers of threads (zero means that the number is chosen automatically)
+	const unsigned int threadCounts[] = { 1, 2, 4, 8, 16, 0 };
+	const size_t nThreadCounts = sizeof(threadCounts) / sizeof(unsigned int);
+	Config* configs = new Config[nThreadCounts];
+	LARGE_INTEGER frequency, start, end;
+	QueryPerformanceFrequency(&frequency);
+
+	for( size_t i = 0; i < nThreadCounts && SUCCEEDED(finalResult); ++i ) {
+		configIO.setReadThreads(threadCounts[i]);
+		QueryPerformanceCounter(&start);
+		result = configIO.read(configFilename, configs[i]);
+		QueryPerformanceCounter(&end);
+		if( FAILED(result) ) {
+			logger->logMessage(L"Failed to read the configuration file using "
+				+ std::to_wstring(threadCounts[i]) + L" thread(s).");
+			prettyPrintHRESULT(errorStr, result);
+			logger->logMessage(errorStr);
+			finalResult = result;
+		} else {
+			double ms = static_cast<double>(end.QuadPart - start.QuadPart) * 1000.0
+				/ static_cast<double>(frequency.QuadPart);
+			logger->logMessage(std::to_wstring(threadCounts[i]) + L" thread(s): "
+				+ std::to_wstring(ms) + L" ms");
+		}
+
+		// Compare with the single-threaded result
+		if( i > 0 && SUCCEEDED(finalResult) ) {
+			std::map<Config::Key, Config::Value*>::const_iterator it0 = configs[0].cbegin();
+			std::map<Config::Key, Config::Value*>::const_iterator it = configs[i].cbegin();
+			std::map<Config::Key, Config::Value*>::const_iterator end0 = configs[0].cend();
+			std::map<Config::Key, Config::Value*>::const_iterator endI = configs[i].cend();
+			for( ; it0 != end0 && it != endI; ++it0, ++it ) {
+				const int* value0 = static_cast<const int*>(it0->second->getValue(Config::DataType::INT));
+				const int* valueI = static_cast<const int*>(it->second->getValue(Config::DataType::INT));
+				if( !(it0->first == it->first) || value0 == 0 || valueI == 0 || *value0 != *valueI ) {
+					break;
+				}
+			}
+			if( it0 != end0 || it != endI ) {
+				logger->logMessage(L"Config object read using " + std::to_wstring(threadCounts[i])
+					+ L" thread(s) does not match the Config object read using one thread.");
+				finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+			}
+		}
+	}
+
+	delete[] configs;
+
+	/* A file spanning several chunks, with a key on its first line which is repeated
+	   in a later chunk, and an invalid line near its end. The first value of the key
+	   should be stored, and the problems should be reported with the line numbers
+	   of the lines in the file, rather than in their chunks.
+	 */
+	std::wstring chunksFilename;
+	fileUtil::combineAsPath(chunksFilename, DEFAULT_CONFIG_PATH_TEST_WRITE, L"testParallelFlatAtomicConfigIO_chunks.txt");
+	const size_t minSize = 4 * FLATATOMICCONFIGIO_MIN_CHUNK_SIZE;
+	size_t size = 0;
+	size_t lineNumber = 0;
+	size_t repeatLineNumber = 0;
+	size_t invalidLineNumber = 0;
+	{
+		std::ofstream file(chunksFilename, std::ofstream::out);
+		std::string line = "INT--repeated::field=1";
+		file << line << '\n';
+		size += line.length() + 1;
+		++lineNumber;
+		for( unsigned int i = 0; size < minSize; ++i ) {
+			line = "INT--filler" + std::to_string(i % 16) + "::field" + std::to_string(i) + "=" + std::to_string(i);
+			file << line << '\n';
+			size += line.length() + 1;
+			++lineNumber;
+			if( repeatLineNumber == 0 && size >= (minSize / 2) ) {
+				line = "INT--repeated::field=2";
+				file << line << '\n';
+				size += line.length() + 1;
+				repeatLineNumber = ++lineNumber;
+			}
+		}
+		file << "INT--invalid::field=notAnInteger\n";
+		invalidLineNumber = ++lineNumber;
+		file << "INT--last::field=0\n";
+		if( !file.good() ) {
+			logger->logMessage(L"Failed to write the configuration file: " + chunksFilename);
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+		}
+	}
+
+	if( SUCCEEDED(finalResult) ) {
+		Config chunksConfig;
+		configIO.setReadThreads(4);
+		result = configIO.read(chunksFilename, chunksConfig);
+		if( FAILED(result) || HRESULT_CODE(result) != ERROR_DATA_INCOMPLETE ) {
+			logger->logMessage(L"Reading a file with problems spanning several chunks did not report ERROR_DATA_INCOMPLETE.");
+			prettyPrintHRESULT(errorStr, result);
+			logger->logMessage(errorStr);
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+
+		const int* value = 0;
+		result = chunksConfig.retrieve<Config::DataType::INT, int>(L"repeated", L"field", value);
+		if( FAILED(result) || HRESULT_CODE(result) == ERROR_DATA_NOT_FOUND || value == 0 || *value != 1 ) {
+			logger->logMessage(L"The first value of a key repeated in a later chunk was not the value stored.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+		result = chunksConfig.retrieve<Config::DataType::INT, int>(L"last", L"field", value);
+		if( FAILED(result) || HRESULT_CODE(result) == ERROR_DATA_NOT_FOUND ) {
+			logger->logMessage(L"The line following an invalid line was not read.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+
+		// The report appended to the file
+		const size_t nRepeatReports = countLinesStartingWith(chunksFilename,
+			"# Line " + std::to_string(repeatLineNumber) + ":");
+		const size_t nInvalidReports = countLinesStartingWith(chunksFilename,
+			"# Line " + std::to_string(invalidLineNumber) + ":");
+		if( nRepeatReports == 0 || nInvalidReports == 0 ) {
+			logger->logMessage(L"The problems on lines " + std::to_wstring(repeatLineNumber) + L" and " +
+				std::to_wstring(invalidLineNumber) + L" were not reported with these line numbers.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+	}
+
+	if( SUCCEEDED(finalResult) ) {
+		logger->logMessage(L"All tests passed.");
+	} else {
+		logger->logMessage(L"Some or all tests failed.");
+	}
+
+	delete logger;
+
+	return finalResult;
+}
+
+/* Helper function for testIncrementalFlatAtomicConfigIO()
+   Returns true if the two Config objects have the same keys and data types.
+ */
+static bool sameKeysAndTypes(const Config& config1, const Config& config2) {
+	std::map<Config::Key, Config::Value*>::const_iterator it1 = config1.cbegin();
+	std::map<Config::Key, Config::Value*>::const_iterator it2 = config2.cbegin();
+	std::map<Config::Key, Config::Value*>::const_iterator end1 = config1.cend();
+	std::map<Config::Key, Config::Value*>::const_iterator end2 = config2.cend();
+	for( ; it1 != end1 && it2 != end2; ++it1, ++it2 ) {
+		if( !(it1->first == it2->first) ||
+			it1->second->getDataType() != it2->second->getDataType() ) {
+			return false;
+		}
+	}
+	return (it1 == end1) && (it2 == end2);
+}
+
+HRESULT testConfig_IConfigManager::testIncrementalFlatAtomicConfigIO(void) {
+
+	// Create a file for logging the test results
+	Logger* logger = 0;
+	std::wstring logFilename;
+	try {
+		fileUtil::combineAsPath(logFilename, DEFAULT_LOG_PATH_TEST, L"testIncrementalFlatAtomicConfigIO.txt");
+		logger = new Logger(true, logFilename, false, false);
+	} catch( ... ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+
+	HRESULT result = ERROR_SUCCESS;
+	HRESULT finalResult = ERROR_SUCCESS;
+	wstring errorStr;
+
+	FlatAtomicConfigIO configIO;
+	result = configIO.setLogger(true, logFilename, false, false);
+	if( FAILED(result) ) {
+		logger->logMessage(L"Failed to redirect logging output of the FlatAtomicConfigIO object.");
+		prettyPrintHRESULT(errorStr, result);
+		logger->logMessage(errorStr);
+		finalResult = result;
+	}
+
+	// Load the file into memory
+	std::wstring configFilename;
+	fileUtil::combineAsPath(configFilename, DEFAULT_CONFIG_PATH_TEST, L"testFlatAtomicConfigIO1.txt");
+	std::ifstream file(configFilename, std::ifstream::in | std::ifstream::binary);
+	if( !file.is_open() ) {
+		logger->logMessage(L"Failed to open the configuration file: " + configFilename);
+		delete logger;
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FILE_NOT_FOUND);
+	}
+	std::ostringstream contentStream;
+	contentStream << file.rdbuf();
+	file.close();
+	const std::string content = contentStream.str();
+
+	// Reference result
+	Config reference;
+	result = configIO.readBuffer(content.c_str(), content.length(), reference);
+	if( FAILED(result) ) {
+		logger->logMessage(L"Failed to parse the configuration data in a single block.");
+		prettyPrintHRESULT(errorStr, result);
+		logger->logMessage(errorStr);
+		finalResult = result;
+	}
+
+	// Parse the data in blocks of various sizes
+	const size_t blockSizes[] = { 1, 2, 7, 64, 300 };
+	const size_t nBlockSizes = sizeof(blockSizes) / sizeof(size_t);
+	std::wstring outFilename;
+	for( size_t i = 0; i < nBlockSizes; ++i ) {
+		Config config;
+		result = configIO.beginParse(config);
+		for( size_t j = 0; j < content.length() && SUCCEEDED(result); j += blockSizes[i] ) {
+			size_t length = content.length() - j;
+			if( length > blockSizes[i] ) {
+				length = blockSizes[i];
+			}
+			result = configIO.parse(content.c_str() + j, length);
+		}
+		result = configIO.endParse();
+		if( FAILED(result) ) {
+			logger->logMessage(L"Failed to parse the configuration data in blocks of size "
+				+ std::to_wstring(blockSizes[i]) + L".");
+			prettyPrintHRESULT(errorStr, result);
+			logger->logMessage(errorStr);
+			finalResult = result;
+		} else if( !sameKeysAndTypes(reference, config) ) {
+			logger->logMessage(L"Parsing the configuration data in blocks of size "
+				+ std::to_wstring(blockSizes[i]) + L" produced a different result.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+
+		fileUtil::combineAsPath(outFilename, DEFAULT_CONFIG_PATH_TEST_WRITE,
+			L"testIncrementalFlatAtomicConfigIO_" + std::to_wstring(blockSizes[i]) + L".txt");
+		result = configIO.write(outFilename, config, true);
+		if( FAILED(result) ) {
+			logger->logMessage(L"Failed to write to the configuration file: " + outFilename);
+			prettyPrintHRESULT(errorStr, result);
+			logger->logMessage(errorStr);
+			finalResult = result;
+		}
+	}
+
+	// Parse the data from a stream
+	std::istringstream stream(content);
+	Config streamConfig;
+	result = configIO.readStream(stream, streamConfig);
+	if( FAILED(result) ) {
+		logger->logMessage(L"Failed to parse the configuration data from a std::istream.");
+		prettyPrintHRESULT(errorStr, result);
+		logger->logMessage(errorStr);
+		finalResult = result;
+	} else if( !sameKeysAndTypes(reference, streamConfig) ) {
+		logger->logMessage(L"Parsing the configuration data from a std::istream produced a different result.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	if( SUCCEEDED(finalResult) ) {
+		logger->logMessage(L"All tests passed.");
+	} else {
+		logger->logMessage(L"Some or all tests failed.");
+	}
+
+	delete logger;
+
+	return finalResult;
+}
+
+HRESULT testConfig_IConfigManager::testCachedConfigIO(void) {
+
+	// Create a file for logging the test results
+	Logger* logger = 0;
+	std::wstring logFilename;
+	try {
+		fileUtil::combineAsPath(logFilename, DEFAULT_LOG_PATH_TEST, L"testCachedConfigIO.txt");
+		logger = new Logger(true, logFilename, false, false);
+	} catch( ... ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+
+	HRESULT result = ERROR_SUCCESS;
+	HRESULT finalResult = ERROR_SUCCESS;
+	wstring errorStr;
+
+	FlatAtomicConfigIO textIO;
+	CachedConfigIO configIO(&textIO);
+	if( FAILED(textIO.setLogger(true, logFilename, false, false)) ||
+		FAILED(configIO.setLogger(true, logFilename, false, false)) ) {
+		logger->logMessage(L"Failed to redirect logging output of the IConfigIO objects.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+
+	// Create the source data
+	Config source;
+	source.insert<Config::DataType::WSTRING, wstring>(L"", L"string", new wstring(L"Some text"));
+	source.insert<Config::DataType::BOOL, bool>(L"scope1", L"bool", new bool(true));
+	source.insert<Config::DataType::INT, int>(L"scope1", L"int", new int(-42));
+	source.insert<Config::DataType::DOUBLE, double>(L"scope2", L"double", new double(3.5));
+	source.insert<Config::DataType::FLOAT4, DirectX::XMFLOAT4>(L"scope2", L"float4",
+		new DirectX::XMFLOAT4(1.0f, 2.0f, 3.0f, 4.0f));
+	source.insert<Config::DataType::COLOR, DirectX::XMFLOAT4>(L"scope3", L"color",
+		new DirectX::XMFLOAT4(0.0f, 0.25f, 0.5f, 1.0f));
+	source.insert<Config::DataType::FILENAME, wstring>(L"scope3", L"filename", new wstring(L"file.txt"));
+	source.insert<Config::DataType::DIRECTORY, wstring>(L"scope3", L"directory", new wstring(L"directory"));
+
+	std::wstring configFilename;
+	fileUtil::combineAsPath(configFilename, DEFAULT_CONFIG_PATH_TEST_WRITE, L"testCachedConfigIO.txt");
+	result = configIO.write(configFilename, source, true);
+	if( FAILED(result) ) {
+		logger->logMessage(L"Failed to write the configuration file: " + configFilename);
+		prettyPrintHRESULT(errorStr, result);
+		logger->logMessage(errorStr);
+		finalResult = result;
+	}
+
+	// The first read creates the cache file, and the second read uses it
+	const std::wstring readNames[] = { L"first", L"second" };
+	for( size_t i = 0; i < 2; ++i ) {
+		Config config;
+		result = configIO.read(configFilename, config);
+		if( FAILED(result) ) {
+			logger->logMessage(L"Failed to read the configuration file in the " + readNames[i] + L" read operation.");
+			prettyPrintHRESULT(errorStr, result);
+			logger->logMessage(errorStr);
+			finalResult = result;
+		} else if( !sameKeysAndTypes(source, config) ) {
+			logger->logMessage(L"The " + readNames[i] + L" read operation produced a Config object"
+				L" which does not match the source Config object.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		} else {
+			const int* intValue = 0;
+			config.retrieve<Config::DataType::INT, int>(L"scope1", L"int", intValue);
+			if( intValue == 0 || *intValue != -42 ) {
+				logger->logMessage(L"The " + readNames[i] + L" read operation produced an incorrect integer value.");
+				finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+			}
+			const wstring* stringValue = 0;
+			config.retrieve<Config::DataType::WSTRING, wstring>(L"", L"string", stringValue);
+			if( stringValue == 0 || *stringValue != L"Some text" ) {
+				logger->logMessage(L"The " + readNames[i] + L" read operation produced an incorrect string value.");
+				finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+			}
+		}
+	}
+
+	if( SUCCEEDED(finalResult) ) {
+		logger->logMessage(L"All tests passed.");
+	} else {
+		logger->logMessage(L"Some or all tests failed.");
+	}
+
+	delete logger;
+
+	return finalResult;
+}
+
+HRESULT testConfig_IConfigManager::testLazyFlatAtomicConfigIO(void) {
+
+	// Create a file for logging the test results
+	Logger* logger = 0;
+	std::wstring logFilename;
+	try {
+		fileUtil::combineAsPath(logFilename, DEFAULT_LOG_PATH_TEST, L"testLazyFlatAtomicConfigIO.txt");
+		logger = new Logger(true, logFilename, false, false);
+	} catch( ... ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+
+	HRESULT result = ERROR_SUCCESS;
+	HRESULT finalResult = ERROR_SUCCESS;
+	wstring errorStr;
+	Config config;
+
+	FlatAtomicConfigIO configIO;
+	configIO.toggleLazyParsing(true);
+	result = configIO.setLogger(true, logFilename, false, false);
+	if( FAILED(result) ) {
+		logger->logMessage(L"Failed to redirect logging output of the FlatAtomicConfigIO object.");
+		prettyPrintHRESULT(errorStr, result);
+		logger->logMessage(errorStr);
+		finalResult = result;
+	}
+
+	// Read in the file
+	std::wstring configFilename1;
+	fileUtil::combineAsPath(configFilename1, DEFAULT_CONFIG_PATH_TEST, L"testFlatAtomicConfigIO1.txt");
+	result = configIO.read(configFilename1, config);
+	if( FAILED(result) ) {
+		logger->logMessage(L"Failed to read the configuration file: " + configFilename1);
+		prettyPrintHRESULT(errorStr, result);
+		logger->logMessage(errorStr);
+		finalResult = result;
+	}
+
+	// Decode all values
+	std::list<wstring> msgs;
+	result = config.validateAll(&msgs);
+	if( FAILED(result) ) {
+		logger->logMessage(L"Config::validateAll() failed.");
+		prettyPrintHRESULT(errorStr, result);
+		logger->logMessage(errorStr);
+		finalResult = result;
+	} else {
+		logger->logMessage(L"Config::validateAll() reported " + std::to_wstring(msgs.size()) + L" message(s):");
+		logger->logMessage(msgs.cbegin(), msgs.cend());
+	}
+
+	// Write to a file
+	std::wstring configFilename2;
+	fileUtil::combineAsPath(configFilename2, DEFAULT_CONFIG_PATH_TEST_WRITE, L"testLazyFlatAtomicConfigIO.txt");
+	result = configIO.write(configFilename2, config, true);
+	if( FAILED(result) ) {
+		logger->logMessage(L"Failed to write to the configuration file: " + configFilename2);
+		prettyPrintHRESULT(errorStr, result);
+		logger->logMessage(errorStr);
+		finalResult = result;
+	}
+
+	if( SUCCEEDED(finalResult) ) {
+		logger->logMessage(L"All tests passed.");
+	} else {
+		logger->logMessage(L"Some or all tests failed.");
+	}
+
+	delete logger;
+
+	return finalResult;
+}
+
+HRESULT testConfig_IConfigManager::testFlatAtomicConfigIOWriteThroughput(const unsigned int n) {
+
+	// Create a file for logging the test results
+	Logger* logger = 0;
+	std::wstring logFilename;
+	try {
+		fileUtil::combineAsPath(logFilename, DEFAULT_LOG_PATH_TEST, L"testFlatAtomicConfigIOWriteThroughput.txt");
+		logger = new Logger(true, logFilename, false, false);
+	} catch( ... ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+
+	HRESULT result = ERROR_SUCCESS;
+	HRESULT finalResult = ERROR_SUCCESS;
+	wstring errorStr;
+
+	FlatAtomicConfigIO configIO;
+	result = configIO.setLogger(true, logFilename, false, false);
+	if( FAILED(result) ) {
+		logger->logMessage(L"Failed to redirect logging output of the FlatAtomicConfigIO object.");
+		prettyPrintHRESULT(errorStr, result);
+		logger->logMessage(errorStr);
+		finalResult = result;
+	}
+
+	// Generate the data
+	Config config;
+	wstring scope;
+	wstring field;
+	for( unsigned int i = 0; i < n; ++i ) {
+		scope = L"scope" + std::to_wstring(i % 64);
+		field = L"field" + std::to_wstring(i);
+		switch( i % 5 ) {
+		case 0:
+			config.insert<Config::DataType::INT, int>(scope, field, new int(static_cast<int>(i)));
+			break;
+		case 1:
+			config.insert<Config::DataType::DOUBLE, double>(scope, field, new double(i * 0.5));
+			break;
+		case 2:
+			config.insert<Config::DataType::BOOL, bool>(scope, field, new bool((i % 2) == 0));
+			break;
+		case 3:
+			config.insert<Config::DataType::WSTRING, wstring>(scope, field, new wstring(L"value " + std::to_wstring(i)));
+			break;
+		default:
+			config.insert<Config::DataType::FLOAT4, DirectX::XMFLOAT4>(scope, field,
+				new DirectX::XMFLOAT4(static_cast<float>(i), 1.0f, 2.0f, 3.0f));
+			break;
+		}
+	}
+
+	// Time the write operation
+	std::wstring configFilename;
+	fileUtil::combineAsPath(configFilename, DEFAULT_CONFIG_PATH_TEST_WRITE, L"testFlatAtomicConfigIOWriteThroughput.txt");
+	LARGE_INTEGER frequency, start, end;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&start);
+	result = configIO.write(configFilename, config, true);
+	QueryPerformanceCounter(&end);
+	if( FAILED(result) ) {
+		logger->logMessage(L"Failed to write the configuration file: " + configFilename);
+		prettyPrintHRESULT(errorStr, result);
+		logger->logMessage(errorStr);
+		finalResult = result;
+	} else {
+		double seconds = static_cast<double>(end.QuadPart - start.QuadPart)
+			/ static_cast<double>(frequency.QuadPart);
+		logger->logMessage(L"Wrote " + std::to_wstring(n) + L" values in "
+			+ std::to_wstring(seconds) + L" s ("
+			+ std::to_wstring((seconds > 0.0) ? (n / seconds) : 0.0) + L" values per second)");
+	}
+
+	// Check the output
+	if( SUCCEEDED(finalResult) ) {
+		Config readConfig;
+		result = configIO.read(configFilename, readConfig);
+		if( FAILED(result) ) {
+			logger->logMessage(L"Failed to read the configuration file: " + configFilename);
+			prettyPrintHRESULT(errorStr, result);
+			logger->logMessage(errorStr);
+			finalResult = result;
+		} else if( !sameKeysAndTypes(config, readConfig) ) {
+			logger->logMessage(L"The configuration file does not contain the data that was written.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+	}
+
+	if( SUCCEEDED(finalResult) ) {
+		logger->logMessage(L"All tests passed.");
+	} else {
+		logger->logMessage(L"Some or all tests failed.");
+	}
+
+	delete logger;
+
+	return finalResult;
+}
+
+HRESULT testConfig_IConfigManager::testUpdateFlatAtomicConfigIO(void) {
+
+	// Create a file for logging the test results
+	Logger* logger = 0;
+	std::wstring logFilename;
+	try {
+		fileUtil::combineAsPath(logFilename, DEFAULT_LOG_PATH_TEST, L"testUpdateFlatAtomicConfigIO.txt");
+		logger = new Logger(true, logFilename, false, false);
+	} catch( ... ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+
+	HRESULT result = ERROR_SUCCESS;
+	HRESULT finalResult = ERROR_SUCCESS;
+	wstring errorStr;
+
+	FlatAtomicConfigIO configIO;
+	configIO.toggleLineIndexing(true);
+	result = configIO.setLogger(true, logFilename, false, false);
+	if( FAILED(result) ) {
+		logger->logMessage(L"Failed to redirect logging output of the FlatAtomicConfigIO object.");
+		prettyPrintHRESULT(errorStr, result);
+		logger->logMessage(errorStr);
+		finalResult = result;
+	}
+
+	// Write the original data
+	Config original;
+	original.insert<Config::DataType::INT, int>(L"test", L"patched", new int(1));
+	original.insert<Config::DataType::DOUBLE, double>(L"test", L"unchanged", new double(2.5));
+	original.insert<Config::DataType::WSTRING, wstring>(L"test", L"moved", new wstring(L"short"));
+	original.insert<Config::DataType::BOOL, bool>(L"test", L"removed", new bool(true));
+
+	std::wstring configFilename;
+	fileUtil::combineAsPath(configFilename, DEFAULT_CONFIG_PATH_TEST_WRITE, L"testUpdateFlatAtomicConfigIO.txt");
+	result = configIO.write(configFilename, original, true);
+	if( FAILED(result) ) {
+		logger->logMessage(L"Failed to write the configuration file: " + configFilename);
+		prettyPrintHRESULT(errorStr, result);
+		logger->logMessage(errorStr);
+		finalResult = result;
+	}
+
+	// Index the file
+	Config readBack;
+	result = configIO.read(configFilename, readBack);
+	if( result != ERROR_SUCCESS ) {
+		logger->logMessage(L"Failed to read the configuration file: " + configFilename);
+		prettyPrintHRESULT(errorStr, result);
+		logger->logMessage(errorStr);
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	// Update the file with modified data
+	Config modified;
+	modified.insert<Config::DataType::INT, int>(L"test", L"patched", new int(7));
+	modified.insert<Config::DataType::DOUBLE, double>(L"test", L"unchanged", new double(2.5));
+	modified.insert<Config::DataType::WSTRING, wstring>(L"test", L"moved",
+		new wstring(L"a string which is much longer than the string it replaces"));
+	modified.insert<Config::DataType::INT, int>(L"test", L"added", new int(5));
+
+	result = configIO.update(configFilename, modified);
+	if( result != ERROR_SUCCESS ) {
+		logger->logMessage(L"Failed to update the configuration file: " + configFilename);
+		prettyPrintHRESULT(errorStr, result);
+		logger->logMessage(errorStr);
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	// Check the updated file
+	FlatAtomicConfigIO checkIO;
+	checkIO.setLogger(true, logFilename, false, false);
+	Config updated;
+	result = checkIO.read(configFilename, updated);
+	if( result != ERROR_SUCCESS ) {
+		logger->logMessage(L"The updated configuration file could not be read without problems.");
+		prettyPrintHRESULT(errorStr, result);
+		logger->logMessage(errorStr);
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	} else if( !sameKeysAndTypes(modified, updated) ) {
+		logger->logMessage(L"The updated configuration file does not contain the expected keys.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	} else {
+		const int* intValue = 0;
+		const wstring* wstringValue = 0;
+		updated.retrieve<Config::DataType::INT, int>(L"test", L"patched", intValue);
+		updated.retrieve<Config::DataType::WSTRING, wstring>(L"test", L"moved", wstringValue);
+		if( intValue == 0 || *intValue != 7 || wstringValue == 0 ||
+			*wstringValue != L"a string which is much longer than the string it replaces" ) {
+			logger->logMessage(L"The updated configuration file does not contain the expected values.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+	}
+
+	// Check that comments were preserved
+	std::ifstream file(configFilename, std::ifstream::in | std::ifstream::binary);
+	std::ostringstream contents;
+	contents << file.rdbuf();
+	file.close();
+	if( contents.str().find("defines the following file format") == std::string::npos ) {
+		logger->logMessage(L"Comments in the configuration file were not preserved.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	// An update without changes should not modify the file
+	uint64_t size = 0;
+	uint64_t writeTime = 0;
+	uint64_t newSize = 0;
+	uint64_t newWriteTime = 0;
+	fileUtil::getFileStamp(configFilename, size, writeTime);
+	result = configIO.update(configFilename, modified);
+	fileUtil::getFileStamp(configFilename, newSize, newWriteTime);
+	if( result != ERROR_SUCCESS || size != newSize || writeTime != newWriteTime ) {
+		logger->logMessage(L"Updating the file without changes to the data modified the file.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	if( SUCCEEDED(finalResult) ) {
+		logger->logMessage(L"All tests passed.");
+	} else {
+		logger->logMessage(L"Some or all tests failed.");
+	}
+
+	delete logger;
+
+	return finalResult;
+}
+
+HRESULT testConfig_IConfigManager::testIncludeFlatAtomicConfigIO(void) {
+
+	// Create a file for logging the test results
+	Logger* logger = 0;
+	std::wstring logFilename;
+	try {
+		fileUtil::combineAsPath(logFilename, DEFAULT_LOG_PATH_TEST, L"testIncludeFlatAtomicConfigIO.txt");
+		logger = new Logger(true, logFilename, false, false);
+	} catch( ... ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+
+	HRESULT result = ERROR_SUCCESS;
+	HRESULT finalResult = ERROR_SUCCESS;
+	wstring errorStr;
+
+	FlatAtomicConfigIO configIO;
+	result = configIO.setLogger(true, logFilename, false, false);
+	if( FAILED(result) ) {
+		logger->logMessage(L"Failed to redirect logging output of the FlatAtomicConfigIO object.");
+		prettyPrintHRESULT(errorStr, result);
+		logger->logMessage(errorStr);
+		finalResult = result;
+	}
+
+	// Create the files
+	const wstring names[] = {
+		L"testIncludeFlatAtomicConfigIO_root.txt",
+		L"testIncludeFlatAtomicConfigIO_a.txt",
+		L"testIncludeFlatAtomicConfigIO_b.txt",
+		L"testIncludeFlatAtomicConfigIO_shared.txt"
+	};
+	const char* const contents[] = {
+		"INT--::x=1\n"
+		"INCLUDE--a::\"testIncludeFlatAtomicConfigIO_a.txt\"\n"
+		"INCLUDE--::\"testIncludeFlatAtomicConfigIO_b.txt\"\n",
+
+		"INT--::x=2\n"
+		"INT--inner::y=3\n"
+		"INCLUDE--s::\"testIncludeFlatAtomicConfigIO_shared.txt\"\n",
+
+		"# Overridden by the root file\n"
+		"INT--::x=4\n"
+		"INT--b::z=5\n"
+		"INCLUDE--s::\"testIncludeFlatAtomicConfigIO_shared.txt\"\n"
+		"# Circular inclusion\n"
+		"INCLUDE--::\"testIncludeFlatAtomicConfigIO_root.txt\"\n",
+
+		"DOUBLE--::w=0.5\n"
+	};
+	wstring filenames[4];
+	for( size_t i = 0; i < 4; ++i ) {
+		fileUtil::combineAsPath(filenames[i], DEFAULT_CONFIG_PATH_TEST_WRITE, names[i]);
+		std::ofstream file(filenames[i], std::ofstream::out);
+		file << contents[i];
+		if( !file.good() ) {
+			logger->logMessage(L"Failed to create the configuration file: " + filenames[i]);
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FILE_NOT_FOUND);
+		}
+	}
+
+	// Read the root file
+	Config config;
+	result = configIO.read(filenames[0], config);
+	if( FAILED(result) || HRESULT_CODE(result) != ERROR_DATA_INCOMPLETE ) {
+		logger->logMessage(L"Reading the root file did not report the circular inclusion.");
+		prettyPrintHRESULT(errorStr, result);
+		logger->logMessage(errorStr);
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	// Check the composed data
+	const wstring intScopes[] = { L"", L"a", L"a.inner", L"b" };
+	const wstring intFields[] = { L"x", L"x", L"y", L"z" };
+	const int intValues[] = { 1, 2, 3, 5 };
+	const int* intValue = 0;
+	for( size_t i = 0; i < 4; ++i ) {
+		config.retrieve<Config::DataType::INT, int>(intScopes[i], intFields[i], intValue);
+		if( intValue == 0 || *intValue != intValues[i] ) {
+			logger->logMessage(L"Missing or incorrect value for the key (scope, field) = (" +
+				intScopes[i] + L", " + intFields[i] + L").");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+	}
+
+	const wstring doubleScopes[] = { L"a.s", L"s" };
+	const double* doubleValue = 0;
+	for( size_t i = 0; i < 2; ++i ) {
+		config.retrieve<Config::DataType::DOUBLE, double>(doubleScopes[i], L"w", doubleValue);
+		if( doubleValue == 0 || *doubleValue != 0.5 ) {
+			logger->logMessage(L"Missing or incorrect value for the key (scope, field) = (" +
+				doubleScopes[i] + L", w).");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+	}
+
+	/* Save a change to the root file, first by patching it using the line index,
+	   and then by rewriting it. The data from the included files must not
+	   be copied into the root file, and its include directives must be kept.
+	 */
+	Config change;
+	change.insert<Config::DataType::INT, int>(L"", L"x", new int(7));
+	for( int pass = 0; pass < 2; ++pass ) {
+		const bool patch = (pass == 0);
+		configIO.toggleLineIndexing(patch); // Without an index, the file is rewritten
+		Config saved;
+		configIO.read(filenames[0], saved);
+		if( FAILED(saved.assignChanges(change)) ) {
+			logger->logMessage(L"Failed to modify the Config object.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+		}
+		result = configIO.update(filenames[0], saved);
+		if( FAILED(result) ) {
+			logger->logMessage(wstring(patch ? L"Patching" : L"Rewriting") + L" the root file failed.");
+			finalResult = result;
+		}
+		if( countLinesStartingWith(filenames[0], "INCLUDE") != 2 ||
+			countLinesStartingWith(filenames[0], "DOUBLE") != 0 ||
+			countLinesStartingWith(filenames[0], "INT\t--\ta") != 0 ||
+			countLinesStartingWith(filenames[0], "INT\t--\tb") != 0 ) {
+			logger->logMessage(wstring(patch ? L"Patching" : L"Rewriting") +
+				L" the root file lost its include directives, or copied data from the included files into it.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+	}
+	configIO.toggleLineIndexing(false);
+
+	Config reread;
+	configIO.read(filenames[0], reread);
+	const int* x = 0;
+	const int* y = 0;
+	reread.retrieve<Config::DataType::INT, int>(L"", L"x", x);
+	reread.retrieve<Config::DataType::INT, int>(L"a.inner", L"y", y);
+	if( x == 0 || *x != 7 || y == 0 || *y != 3 ) {
+		logger->logMessage(L"The saved root file did not produce the expected values when read back in.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	if( SUCCEEDED(finalResult) ) {
+		logger->logMessage(L"All tests passed.");
+	} else {
+		logger->logMessage(L"Some or all tests failed.");
+	}
+
+	delete logger;
+
+	return finalResult;
+}
+
+/* Passes operations to a FlatAtomicConfigIO object,
+   and counts the number of read operations
+ */
+class CountingConfigIO : public IConfigIO {
+public:
+	FlatAtomicConfigIO m_configIO;
+	unsigned int m_nReads;
+
+	CountingConfigIO(void) : m_configIO(), m_nReads(0) {}
+
+	virtual HRESULT read(const std::wstring& filename, Config& config) override {
+		++m_nReads;
+		return m_configIO.read(filename, config);
+	}
+
+	virtual HRESULT write(const std::wstring& filename,
+		const Config& config, const bool overwrite) override {
+		return m_configIO.write(filename, config, overwrite);
+	}
+
+	virtual bool toggleContextOutput(const bool outputContext) override {
+		return m_configIO.toggleContextOutput(outputContext);
+	}
+};
+
+HRESULT testConfig_IConfigManager::testConfigCache(void) {
+
+	// Create a file for logging the test results
+	Logger* logger = 0;
+	std::wstring logFilename;
+	try {
+		fileUtil::combineAsPath(logFilename, DEFAULT_LOG_PATH_TEST, L"testConfigCache.txt");
+		logger = new Logger(true, logFilename, false, false);
+	} catch( ... ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+
+	HRESULT result = ERROR_SUCCESS;
+	HRESULT finalResult = ERROR_SUCCESS;
+	wstring errorStr;
+
+	CountingConfigIO configIO;
+	configIO.m_configIO.setLogger(true, logFilename, false, false);
+
+	// Create the file
+	Config original;
+	original.insert<Config::DataType::INT, int>(L"test", L"a", new int(1));
+	original.insert<Config::DataType::WSTRING, wstring>(L"test", L"b", new wstring(L"value"));
+	std::wstring configFilename;
+	fileUtil::combineAsPath(configFilename, DEFAULT_CONFIG_PATH_TEST_WRITE, L"testConfigCache.txt");
+	result = configIO.write(configFilename, original, true);
+	if( FAILED(result) ) {
+		logger->logMessage(L"Failed to write the configuration file: " + configFilename);
+		prettyPrintHRESULT(errorStr, result);
+		logger->logMessage(errorStr);
+		finalResult = result;
+	}
+
+	const bool wasEnabled = ConfigCache::setEnabled(true);
+	ConfigCache::clear();
+
+	// Load the file several times
+	const unsigned int nLoads = 5;
+	for( unsigned int i = 0; i < nLoads; ++i ) {
+		Config config;
+		result = ConfigCache::read(configIO, configFilename, config);
+		if( result != ERROR_SUCCESS ) {
+			logger->logMessage(L"ConfigCache::read() did not return ERROR_SUCCESS on iteration " + std::to_wstring(i) + L".");
+			prettyPrintHRESULT(errorStr, result);
+			logger->logMessage(errorStr);
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		} else if( !sameKeysAndTypes(original, config) ) {
+			logger->logMessage(L"Incomplete data was loaded on iteration " + std::to_wstring(i) + L".");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+	}
+	if( configIO.m_nReads != 1 ) {
+		logger->logMessage(L"The file was read " + std::to_wstring(configIO.m_nReads) +
+			L" times, rather than once.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	// Modify the file, and check that it is read again
+	original.insert<Config::DataType::BOOL, bool>(L"test", L"c", new bool(true));
+	result = configIO.write(configFilename, original, true);
+	if( FAILED(result) ) {
+		logger->logMessage(L"Failed to rewrite the configuration file: " + configFilename);
+		prettyPrintHRESULT(errorStr, result);
+		logger->logMessage(errorStr);
+		finalResult = result;
+	}
+	Config modified;
+	result = ConfigCache::read(configIO, configFilename, modified);
+	if( result != ERROR_SUCCESS || configIO.m_nReads != 2 || !sameKeysAndTypes(original, modified) ) {
+		logger->logMessage(L"The modified file was not reloaded correctly.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	ConfigCache::setEnabled(wasEnabled);
+
+	if( SUCCEEDED(finalResult) ) {
+		logger->logMessage(L"All tests passed.");
+	} else {
+		logger->logMessage(L"Some or all tests failed.");
+	}
+
+	delete logger;
+
+	return finalResult;
+}
+
+HRESULT testConfig_IConfigManager::testDataTypeInfo(void) {
+
+	// Create a file for logging the test results
+	Logger* logger = 0;
+	std::wstring logFilename;
+	try {
+		fileUtil::combineAsPath(logFilename, DEFAULT_LOG_PATH_TEST, L"testDataTypeInfo.txt");
+		logger = new Logger(true, logFilename, false, false);
+	} catch( ... ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+
+	HRESULT finalResult = ERROR_SUCCESS;
+
+	// Look up all data types
+	unsigned int nDataTypes = 0;
+	const Config::DataTypeInfo* info = 0;
+	while( (info = Config::getDataTypeInfo(static_cast<Config::DataType>(nDataTypes))) != 0 ) {
+		Config::DataType type = Config::DataType::WSTRING;
+		wstring name;
+		if( static_cast<unsigned int>(info->type) != nDataTypes ) {
+			logger->logMessage(L"The descriptor for data type " + std::to_wstring(nDataTypes) + L" is out of order.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		} else if( Config::getDataTypeInfo(info->name, info->nameLength) != info ||
+			Config::getDataTypeInfo(info->wName, info->nameLength) != info ) {
+			logger->logMessage(L"The descriptor for data type " + wstring(info->wName) + L" was not found by name.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		} else if( FAILED(Config::cstrToDataType(type, info->name)) || type != info->type ||
+			FAILED(Config::wstringToDataType(type, info->wName)) || type != info->type ||
+			FAILED(Config::dataTypeToWString(name, info->type)) || name != info->wName ) {
+			logger->logMessage(L"Conversion between data type " + wstring(info->wName) + L" and its name failed.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+		++nDataTypes;
+	}
+	logger->logMessage(L"Number of data types: " + std::to_wstring(nDataTypes));
+
+	// Reject invalid names
+	const char* const invalidNames[] = { "", "I", "IN", "INTS", "int", "Bool", "WSTRINGS", "DIRECTOR", "COLOUR" };
+	const size_t nInvalidNames = sizeof(invalidNames) / sizeof(invalidNames[0]);
+	for( size_t i = 0; i < nInvalidNames; ++i ) {
+		Config::DataType type = Config::DataType::WSTRING;
+		if( Config::getDataTypeInfo(invalidNames[i], strlen(invalidNames[i])) != 0 ||
+			SUCCEEDED(Config::cstrToDataType(type, invalidNames[i])) ) {
+			logger->logMessage(L"The invalid data type name at index " + std::to_wstring(i) + L" was accepted.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+	}
+
+	if( SUCCEEDED(finalResult) ) {
+		logger->logMessage(L"All tests passed.");
+	} else {
+		logger->logMessage(L"Some or all tests failed.");
+	}
+
+	delete logger;
+
+	return finalResult;
+}
+
+HRESULT testConfig_IConfigManager::testConfigWatcher(void) {
+
+	// Create a file for logging the test results
+	Logger* logger = 0;
+	std::wstring logFilename;
+	try {
+		fileUtil::combineAsPath(logFilename, DEFAULT_LOG_PATH_TEST, L"testConfigWatcher.txt");
+		logger = new Logger(true, logFilename, false, false);
+	} catch( ... ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+
+	HRESULT result = ERROR_SUCCESS;
+	HRESULT finalResult = ERROR_SUCCESS;
+	wstring errorStr;
+
+	FlatAtomicConfigIO configIO;
+	configIO.setLogger(true, logFilename, false, false);
+	std::wstring configFilename;
+	fileUtil::combineAsPath(configFilename, DEFAULT_CONFIG_PATH_TEST_WRITE, L"testConfigWatcher.txt");
+
+	const DWORD timeout = 2000; // Milliseconds
+	const bool polling[] = { false, true };
+	for( size_t i = 0; i < sizeof(polling) / sizeof(polling[0]); ++i ) {
+
+		// Create and load the file
+		Config original;
+		original.insert<Config::DataType::INT, int>(L"test", L"changed", new int(1));
+		original.insert<Config::DataType::WSTRING, wstring>(L"test", L"unchanged", new wstring(L"value"));
+		result = configIO.write(configFilename, original, true);
+		if( FAILED(result) ) {
+			logger->logMessage(L"Failed to write the configuration file: " + configFilename);
+			prettyPrintHRESULT(errorStr, result);
+			logger->logMessage(errorStr);
+			finalResult = result;
+			break;
+		}
+		Config config;
+		configIO.read(configFilename, config);
+		const wstring* unchangedBefore = 0;
+		config.retrieve<Config::DataType::WSTRING, wstring>(L"test", L"unchanged", unchangedBefore);
+
+		ConfigWatcher watcher;
+		watcher.setLogger(true, logFilename, false, false);
+		watcher.forcePolling(polling[i]);
+		result = watcher.watch<FlatAtomicConfigIO>(configFilename, config);
+		if( FAILED(result) ) {
+			logger->logMessage(L"ConfigWatcher::watch() failed.");
+			finalResult = result;
+			break;
+		}
+
+		// Modify the file
+		Config modified;
+		modified.insert<Config::DataType::INT, int>(L"test", L"changed", new int(2));
+		modified.insert<Config::DataType::WSTRING, wstring>(L"test", L"unchanged", new wstring(L"value"));
+		configIO.write(configFilename, modified, true);
+
+		// Wait for the change to be applied
+		const DWORD start = GetTickCount();
+		const int* changed = 0;
+		while( GetTickCount() - start < timeout ) {
+			unsigned int nApplied = 0;
+			watcher.applyChanges(&nApplied);
+			if( nApplied > 0 ) {
+				break;
+			}
+			Sleep(1);
+		}
+
+		config.retrieve<Config::DataType::INT, int>(L"test", L"changed", changed);
+		const wstring* unchangedAfter = 0;
+		config.retrieve<Config::DataType::WSTRING, wstring>(L"test", L"unchanged", unchangedAfter);
+		if( changed == 0 || *changed != 2 ) {
+			logger->logMessage(L"The modified value was not applied (polling = " + std::to_wstring(polling[i]) + L").");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		} else if( unchangedAfter == 0 || unchangedAfter != unchangedBefore ) {
+			logger->logMessage(L"The unmodified value was replaced (polling = " + std::to_wstring(polling[i]) + L").");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		} else {
+			double last = 0.0;
+			double max = 0.0;
+			watcher.getLatency(last, max);
+			logger->logMessage(L"Reload latency (polling = " + std::to_wstring(polling[i]) + L"): " +
+				std::to_wstring(last) + L" ms");
+		}
+		watcher.unwatch(config);
+	}
+
+	// Modifications to included files
+	std::wstring includeFilename;
+	fileUtil::combineAsPath(includeFilename, DEFAULT_CONFIG_PATH_TEST_WRITE, L"testConfigWatcher_include.txt");
+	for( size_t i = 0; i < sizeof(polling) / sizeof(polling[0]) && SUCCEEDED(finalResult); ++i ) {
+
+		{
+			std::ofstream root(configFilename, std::ofstream::out);
+			root << "INT--test::unchanged=1\n"
+				"INCLUDE--::\"testConfigWatcher_include.txt\"\n";
+			std::ofstream include(includeFilename, std::ofstream::out);
+			include << "INT--test::changed=1\n";
+			if( !root.good() || !include.good() ) {
+				logger->logMessage(L"Failed to create the configuration files with inclusion.");
+				finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FILE_NOT_FOUND);
+				break;
+			}
+		}
+		Config config;
+		configIO.read(configFilename, config);
+
+		ConfigWatcher watcher;
+		watcher.setLogger(true, logFilename, false, false);
+		watcher.forcePolling(polling[i]);
+		result = watcher.watch<FlatAtomicConfigIO>(configFilename, config);
+		if( FAILED(result) ) {
+			logger->logMessage(L"ConfigWatcher::watch() failed for a file with inclusion.");
+			finalResult = result;
+			break;
+		}
+
+		// Modify only the included file
+		{
+			std::ofstream include(includeFilename, std::ofstream::out);
+			include << "INT--test::changed=2\n"
+				"INT--test::invalid=notAnInteger\n";
+		}
+
+		const DWORD start = GetTickCount();
+		while( GetTickCount() - start < timeout ) {
+			unsigned int nApplied = 0;
+			watcher.applyChanges(&nApplied);
+			if( nApplied > 0 ) {
+				break;
+			}
+			Sleep(1);
+		}
+
+		const int* changed = 0;
+		config.retrieve<Config::DataType::INT, int>(L"test", L"changed", changed);
+		if( changed == 0 || *changed != 2 ) {
+			logger->logMessage(L"The modification to the included file was not applied (polling = " +
+				std::to_wstring(polling[i]) + L").");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+
+		// The invalid line must be logged, not reported in the watched files
+		if( countLinesStartingWith(configFilename, FLATATOMICCONFIGIO_COMMENT_SEP) != 0 ||
+			countLinesStartingWith(includeFilename, FLATATOMICCONFIGIO_COMMENT_SEP) != 0 ) {
+			logger->logMessage(L"The reload appended a report to a watched file (polling = " +
+				std::to_wstring(polling[i]) + L").");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+		watcher.unwatch(config);
+	}
+
+	if( SUCCEEDED(finalResult) ) {
+		logger->logMessage(L"All tests passed.");
+	} else {
+		logger->logMessage(L"Some or all tests failed.");
+	}
+
+	delete logger;
+
+	return finalResult;
+}
+
+HRESULT testConfig_IConfigManager::testSectionedConfigIO(const unsigned int n) {
+
+	// Create a file for logging the test results
+	Logger* logger = 0;
+	std::wstring logFilename;
+	try {
+		fileUtil::combineAsPath(logFilename, DEFAULT_LOG_PATH_TEST, L"testSectionedConfigIO.txt");
+		logger = new Logger(true, logFilename, false, false);
+	} catch( ... ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+
+	HRESULT result = ERROR_SUCCESS;
+	HRESULT finalResult = ERROR_SUCCESS;
+	wstring errorStr;
+
+	FlatAtomicConfigIO flatIO;
+	SectionedConfigIO sectionedIO;
+	IConfigIO* configIOs[] = { &flatIO, &sectionedIO };
+	LogUser* logUsers[] = { &flatIO, &sectionedIO };
+	const wchar_t* names[] = { L"FlatAtomicConfigIO", L"SectionedConfigIO" };
+	const size_t nConfigIOs = sizeof(configIOs) / sizeof(IConfigIO*);
+	for( size_t i = 0; i < nConfigIOs; ++i ) {
+		result = logUsers[i]->setLogger(true, logFilename, false, false);
+		if( FAILED(result) ) {
+			logger->logMessage(L"Failed to redirect logging output of the " + wstring(names[i]) + L" object.");
+			prettyPrintHRESULT(errorStr, result);
+			logger->logMessage(errorStr);
+			finalResult = result;
+		}
+		configIOs[i]->toggleContextOutput(false);
+	}
+
+	// Generate the data
+	Config config;
+	wstring scope;
+	wstring field;
+	for( unsigned int i = 0; i < n; ++i ) {
+		scope = L"scope" + std::to_wstring(i % 64);
+		field = L"field" + std::to_wstring(i);
+		switch( i % 5 ) {
+		case 0:
+			config.insert<Config::DataType::INT, int>(scope, field, new int(static_cast<int>(i)));
+			break;
+		case 1:
+			config.insert<Config::DataType::DOUBLE, double>(scope, field, new double(i * 0.5));
+			break;
+		case 2:
+			config.insert<Config::DataType::BOOL, bool>(scope, field, new bool((i % 2) == 0));
+			break;
+		case 3:
+			config.insert<Config::DataType::WSTRING, wstring>(scope, field, new wstring(L"value " + std::to_wstring(i)));
+			break;
+		default:
+			config.insert<Config::DataType::FLOAT4, DirectX::XMFLOAT4>(scope, field,
+				new DirectX::XMFLOAT4(static_cast<float>(i), 1.0f, 2.0f, 3.0f));
+			break;
+		}
+	}
+
+	// Write, measure and read the data using each class
+	const wchar_t* filenames[] = { L"testSectionedConfigIO_flat.txt", L"testSectionedConfigIO_sectioned.txt" };
+	uint64_t sizes[] = { 0, 0 };
+	uint64_t writeTime = 0;
+	std::wstring configFilename;
+	LARGE_INTEGER frequency, start, end;
+	QueryPerformanceFrequency(&frequency);
+	for( size_t i = 0; i < nConfigIOs; ++i ) {
+		fileUtil::combineAsPath(configFilename, DEFAULT_CONFIG_PATH_TEST_WRITE, filenames[i]);
+		result = configIOs[i]->write(configFilename, config, true);
+		if( FAILED(result) || FAILED(fileUtil::getFileStamp(configFilename, sizes[i], writeTime)) ) {
+			logger->logMessage(L"Failed to write the configuration file: " + configFilename);
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+			continue;
+		}
+
+		Config readConfig;
+		QueryPerformanceCounter(&start);
+		result = configIOs[i]->read(configFilename, readConfig);
+		QueryPerformanceCounter(&end);
+		if( FAILED(result) ) {
+			logger->logMessage(L"Failed to read the configuration file: " + configFilename);
+			prettyPrintHRESULT(errorStr, result);
+			logger->logMessage(errorStr);
+			finalResult = result;
+		} else if( !sameKeysAndTypes(config, readConfig) ) {
+			logger->logMessage(L"The configuration file does not contain the data that was written: " + configFilename);
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		} else {
+			double seconds = static_cast<double>(end.QuadPart - start.QuadPart)
+				/ static_cast<double>(frequency.QuadPart);
+			logger->logMessage(wstring(names[i]) + L": " + std::to_wstring(sizes[i]) + L" bytes, read "
+				+ std::to_wstring(n) + L" values in " + std::to_wstring(seconds) + L" s ("
+				+ std::to_wstring((seconds > 0.0) ? (n / seconds) : 0.0) + L" values per second)");
+		}
+	}
+
+	if( SUCCEEDED(finalResult) && sizes[1] >= sizes[0] ) {
+		logger->logMessage(L"The SectionedConfigIO file is not smaller than the FlatAtomicConfigIO file.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	// Read a hand-written file
+	fileUtil::combineAsPath(configFilename, DEFAULT_CONFIG_PATH_TEST_WRITE, L"testSectionedConfigIO_handWritten.txt");
+	{
+		std::ofstream file(configFilename, std::ofstream::out);
+		file << "# Comment" << std::endl
+			<< "BOOL--topLevel = true" << std::endl
+			<< "[ window ] INT" << std::endl
+			<< "width = 800" << std::endl
+			<< "WSTRING--title = \"Sectioned window\"" << std::endl
+			<< "[invalid] NOTATYPE" << std::endl
+			<< "skipped = 1" << std::endl
+			<< "[untyped]" << std::endl
+			<< "missingType = 1" << std::endl
+			<< "DOUBLE--ratio = 0.5" << std::endl;
+	}
+	Config handWritten;
+	result = sectionedIO.read(configFilename, handWritten);
+	const bool* topLevel = 0;
+	const int* width = 0;
+	const wstring* title = 0;
+	const double* ratio = 0;
+	handWritten.retrieve<Config::DataType::BOOL, bool>(L"", L"topLevel", topLevel);
+	handWritten.retrieve<Config::DataType::INT, int>(L"window", L"width", width);
+	handWritten.retrieve<Config::DataType::WSTRING, wstring>(L"window", L"title", title);
+	handWritten.retrieve<Config::DataType::DOUBLE, double>(L"untyped", L"ratio", ratio);
+	if( FAILED(result) || HRESULT_CODE(result) != ERROR_DATA_INCOMPLETE ) {
+		logger->logMessage(L"Reading the hand-written file did not report the invalid lines.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	} else if( topLevel == 0 || !(*topLevel) || width == 0 || *width != 800 ||
+		title == 0 || *title != L"Sectioned window" || ratio == 0 || *ratio != 0.5 ) {
+		logger->logMessage(L"The hand-written file was not read correctly.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	} else if( std::distance(handWritten.cbegin(), handWritten.cend()) != 4 ) {
+		logger->logMessage(L"Data was read from invalid lines of the hand-written file.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	if( SUCCEEDED(finalResult) ) {
+		logger->logMessage(L"All tests passed.");
+	} else {
+		logger->logMessage(L"Some or all tests failed.");
+	}
+
+	delete logger;
+
+	return finalResult;
+}
+
+/* Helper class for testLintFlatAtomicConfigIO()
+   Counts and logs the problems reported for each file.
+ */
+class TestLintSink : public FlatAtomicConfigIO::LintSink {
+public:
+	std::map<wstring, size_t> counts;
+	Logger* logger;
+
+	TestLintSink(Logger* const logger) : counts(), logger(logger) {}
+
+	virtual void report(const wstring& filename, const size_t lineNumber,
+		const wstring& msg) override {
+		++counts[filename];
+		logger->logMessage(filename + L" > " + msg);
+	}
+};
+
+HRESULT testConfig_IConfigManager::testLintFlatAtomicConfigIO(const unsigned int n) {
+
+	// Create a file for logging the test results
+	Logger* logger = 0;
+	std::wstring logFilename;
+	try {
+		fileUtil::combineAsPath(logFilename, DEFAULT_LOG_PATH_TEST, L"testLintFlatAtomicConfigIO.txt");
+		logger = new Logger(true, logFilename, false, false);
+	} catch( ... ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+
+	HRESULT result = ERROR_SUCCESS;
+	HRESULT finalResult = ERROR_SUCCESS;
+	wstring errorStr;
+
+	FlatAtomicConfigIO configIO;
+	result = configIO.setLogger(true, logFilename, false, false);
+	if( FAILED(result) ) {
+		logger->logMessage(L"Failed to redirect logging output of the FlatAtomicConfigIO object.");
+		prettyPrintHRESULT(errorStr, result);
+		logger->logMessage(errorStr);
+		finalResult = result;
+	}
+	configIO.setReadThreads(0);
+
+	// Generate and write the valid file
+	Config config;
+	for( unsigned int i = 0; i < n; ++i ) {
+		if( i % 2 == 0 ) {
+			config.insert<Config::DataType::INT, int>(L"scope" + std::to_wstring(i % 64),
+				L"field" + std::to_wstring(i), new int(static_cast<int>(i)));
+		} else {
+			config.insert<Config::DataType::WSTRING, wstring>(L"scope" + std::to_wstring(i % 64),
+				L"field" + std::to_wstring(i), new wstring(L"value " + std::to_wstring(i)));
+		}
+	}
+	std::vector<wstring> filenames(2);
+	fileUtil::combineAsPath(filenames[0], DEFAULT_CONFIG_PATH_TEST_WRITE, L"testLintFlatAtomicConfigIO_valid.txt");
+	fileUtil::combineAsPath(filenames[1], DEFAULT_CONFIG_PATH_TEST_WRITE, L"testLintFlatAtomicConfigIO_invalid.txt");
+	result = configIO.write(filenames[0], config, true);
+	if( FAILED(result) ) {
+		logger->logMessage(L"Failed to write the configuration file: " + filenames[0]);
+		finalResult = result;
+	}
+
+	// Write the invalid file, with five problems
+	{
+		std::ofstream file(filenames[1], std::ofstream::out);
+		file << "# Comment" << std::endl
+			<< "INT--scope::valid = 1" << std::endl
+			<< "INT--scope::valid = 2" << std::endl // Repeated key
+			<< "NOTATYPE--scope::field = 1" << std::endl // Unknown datatype
+			<< "BOOL--scope::notBool = maybe" << std::endl // Invalid value
+			<< "WSTRING--scope::partial = \"text\"more" << std::endl // Partial value
+			<< "INT--scope-field = 5" << std::endl; // Missing scope separator
+	}
+	const size_t nExpectedProblems = 5;
+
+	uint64_t sizes[] = { 0, 0 };
+	uint64_t writeTimes[] = { 0, 0 };
+	for( size_t i = 0; i < filenames.size(); ++i ) {
+		fileUtil::getFileStamp(filenames[i], sizes[i], writeTimes[i]);
+	}
+
+	// Lint the files
+	TestLintSink sink(logger);
+	std::vector<HRESULT> results;
+	LARGE_INTEGER frequency, start, end;
+	QueryPerformanceFrequency(&frequency);
+	result = configIO.lint(filenames, sink, &results);
+	if( FAILED(result) || results.size() != filenames.size() ) {
+		logger->logMessage(L"lint() returned a failure result.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	} else {
+		if( results[0] != ERROR_SUCCESS || sink.counts[filenames[0]] != 0 ) {
+			logger->logMessage(L"Problems were reported for the valid file.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+		if( HRESULT_CODE(results[1]) != ERROR_DATA_INCOMPLETE ||
+			sink.counts[filenames[1]] < nExpectedProblems ) {
+			logger->logMessage(L"Not all problems were reported for the invalid file.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+	}
+
+	// Check that the files were not modified
+	uint64_t size = 0;
+	uint64_t writeTime = 0;
+	for( size_t i = 0; i < filenames.size(); ++i ) {
+		fileUtil::getFileStamp(filenames[i], size, writeTime);
+		if( size != sizes[i] || writeTime != writeTimes[i] ) {
+			logger->logMessage(L"lint() modified the file: " + filenames[i]);
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+	}
+
+	/* Compare the time taken to lint and to read the valid file,
+	   using the fastest of several runs of each, to reduce timing noise.
+	   lint() checks each file using a single thread, so read() is also
+	   limited to one thread.
+	 */
+	if( SUCCEEDED(finalResult) ) {
+		configIO.setReadThreads(1);
+		const unsigned int nTimingRuns = 3;
+		std::vector<wstring> validFilename(1, filenames[0]);
+		double lintSeconds = 0.0;
+		double readSeconds = 0.0;
+		double seconds = 0.0;
+		for( unsigned int i = 0; i < nTimingRuns && SUCCEEDED(finalResult); ++i ) {
+			QueryPerformanceCounter(&start);
+			configIO.lint(validFilename, sink);
+			QueryPerformanceCounter(&end);
+			seconds = static_cast<double>(end.QuadPart - start.QuadPart)
+				/ static_cast<double>(frequency.QuadPart);
+			if( i == 0 || seconds < lintSeconds ) {
+				lintSeconds = seconds;
+			}
+
+			Config readConfig;
+			QueryPerformanceCounter(&start);
+			result = configIO.read(filenames[0], readConfig);
+			QueryPerformanceCounter(&end);
+			seconds = static_cast<double>(end.QuadPart - start.QuadPart)
+				/ static_cast<double>(frequency.QuadPart);
+			if( i == 0 || seconds < readSeconds ) {
+				readSeconds = seconds;
+			}
+			if( FAILED(result) ) {
+				logger->logMessage(L"Failed to read the configuration file: " + filenames[0]);
+				finalResult = result;
+			}
+		}
+
+		if( SUCCEEDED(finalResult) ) {
+			const double speedup = (lintSeconds > 0.0) ? (readSeconds / lintSeconds) : 0.0;
+			logger->logMessage(L"Linted " + std::to_wstring(n) + L" values in " + std::to_wstring(lintSeconds)
+				+ L" s, and read them in " + std::to_wstring(readSeconds) + L" s, using one thread (speedup of "
+				+ std::to_wstring(speedup) + L")");
+		}
+	}
+
+	if( SUCCEEDED(finalResult) ) {
+		logger->logMessage(L"All tests passed.");
+	} else {
+		logger->logMessage(L"Some or all tests failed.");
+	}
+
+	delete logger;
+
+	return finalResult;
+}
+
+HRESULT testConfig_IConfigManager::testEmbeddedConfig(void) {
+
+	// Create a file for logging the test results
+	Logger* logger = 0;
+	std::wstring logFilename;
+	try {
+		fileUtil::combineAsPath(logFilename, DEFAULT_LOG_PATH_TEST, L"testEmbeddedConfig.txt");
+		logger = new Logger(true, logFilename, false, false);
+	} catch( ... ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+
+	HRESULT result = ERROR_SUCCESS;
+	HRESULT finalResult = ERROR_SUCCESS;
+	wstring errorStr;
+
+	// Insert the defaults into an empty Config object
+	Config config;
+	std::list<wstring> locators;
+	result = embeddedConfig::insertDefaults(config, &locators);
+	if( FAILED(result) ) {
+		logger->logMessage(L"embeddedConfig::insertDefaults() failed.");
+		prettyPrintHRESULT(errorStr, result);
+		logger->logMessage(errorStr);
+		finalResult = result;
+	} else if( locators.size() != embeddedConfig::count() ||
+		static_cast<size_t>(std::distance(config.cbegin(), config.cend())) != embeddedConfig::count() ) {
+		logger->logMessage(L"Not all of the " + std::to_wstring(embeddedConfig::count()) +
+			L" embedded defaults were inserted into the empty Config object.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	} else {
+		const wstring* logPath = 0;
+		config.retrieve<Config::DataType::DIRECTORY, wstring>(DEFAULT_LOG_PATH_SCOPE, DEFAULT_LOG_PATH_FIELD, logPath);
+		if( logPath == 0 || *logPath != DEFAULT_LOG_PATH ) {
+			logger->logMessage(L"The embedded default logging directory was not inserted correctly.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+	}
+
+	// Insert the defaults beneath an existing value
+	Config layered;
+	layered.insert<Config::DataType::DIRECTORY, wstring>(DEFAULT_LOG_PATH_SCOPE, DEFAULT_LOG_PATH_FIELD,
+		new wstring(L".\\otherLogs"));
+	locators.clear();
+	result = embeddedConfig::insertDefaults(layered, &locators);
+	const wstring* logPath = 0;
+	layered.retrieve<Config::DataType::DIRECTORY, wstring>(DEFAULT_LOG_PATH_SCOPE, DEFAULT_LOG_PATH_FIELD, logPath);
+	if( FAILED(result) ) {
+		logger->logMessage(L"embeddedConfig::insertDefaults() failed for the Config object with an existing value.");
+		finalResult = result;
+	} else if( logPath == 0 || *logPath != L".\\otherLogs" ) {
+		logger->logMessage(L"An embedded default replaced an existing value.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	} else if( locators.size() + 1 != embeddedConfig::count() ) {
+		logger->logMessage(L"The wrong number of embedded defaults was inserted beneath the existing value.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	if( SUCCEEDED(finalResult) ) {
+		logger->logMessage(L"All tests passed.");
+	} else {
+		logger->logMessage(L"Some or all tests failed.");
+	}
+
+	delete logger;
+
 	return finalResult;
 }
\ No newline at end of file
@@ -21,10 +21,17 @@ Description
 #include <string>
 #include <iterator>
 #include <list>
+#include <vector>
+#include <thread>
+#include <fstream>
+#include <sstream>
 #include "testLogger_LogUser.h"
 #include "defs.h"
 #include "globals.h"
 #include "Logger.h"
+#include "Timestamper.h"
+#include "BinaryLogger.h"
+#include "FlightRecorder.h"
 #include "LogUser.h"
 #include "fileUtil.h"
 
@@ -222,4 +229,1556 @@ HRESULT testLogger_LogUser::testAppendMode(void) {
 	delete logger;
 
 	return finalResult;
-}
\ No newline at end of file
+}
+
+/* Helper function for testAsyncLogging().
+   Logs 'nMessages' messages from each of 'nThreads' threads
+   to an asynchronous Logger with the given queue capacity and overflow policy,
+   then checks the output file after flushing the Logger.
+ */
+static HRESULT runAsyncLogging(Logger& resultLogger, const wstring& outputFilename,
+	const unsigned int nThreads, const unsigned int nMessages,
+	const size_t capacity, const Logger::OverflowPolicy overflowPolicy) {
+
+	Logger* logger = 0;
+	try {
+		logger = new Logger(true, outputFilename, true, false);
+	} catch( ... ) {
+		resultLogger.logMessage(L"Failed to create the asynchronous Logger.");
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+	logger->toggleTimestamp(false);
+
+	HRESULT result = logger->startAsync(capacity, overflowPolicy);
+	if( FAILED(result) ) {
+		resultLogger.logMessage(L"Logger::startAsync() failed.");
+		delete logger;
+		return result;
+	}
+	if( SUCCEEDED(logger->startAsync(capacity, overflowPolicy)) ) {
+		resultLogger.logMessage(L"Logger::startAsync() succeeded when asynchronous mode was already on.");
+		delete logger;
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+
+	// Messages have the form "thread <thread index> <message index>"
+	std::thread* threads = new std::thread[nThreads];
+	for( unsigned int t = 0; t < nThreads; ++t ) {
+		threads[t] = std::thread([logger, t, nMessages]() {
+			for( unsigned int i = 0; i < nMessages; ++i ) {
+				logger->logMessage(L"thread " + std::to_wstring(t) + L" " + std::to_wstring(i));
+			}
+		});
+	}
+	for( unsigned int t = 0; t < nThreads; ++t ) {
+		threads[t].join();
+	}
+	delete[] threads;
+
+	HRESULT finalResult = ERROR_SUCCESS;
+	if( FAILED(logger->flush()) ) {
+		resultLogger.logMessage(L"Logger::flush() reported an output failure.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+
+	// Check the output, which should be complete after flushing
+	std::vector<int> lastIndex(nThreads, -1);
+	size_t nLines = 0;
+	std::basic_ifstream<wchar_t> file(outputFilename);
+	if( !file.is_open() ) {
+		resultLogger.logMessage(L"Failed to open the output file: " + outputFilename);
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FILE_NOT_FOUND);
+	} else {
+		wstring line;
+		wstring word;
+		unsigned int t = 0;
+		int i = 0;
+		while( std::getline(file, line) ) {
+			std::wistringstream lineStream(line);
+			if( !(lineStream >> word) || word != L"thread" ) {
+				// A report of discarded messages
+				continue;
+			}
+			if( !(lineStream >> t >> i) || t >= nThreads || i <= lastIndex[t] ) {
+				resultLogger.logMessage(L"Unexpected or out-of-order output line: " + line);
+				finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+				break;
+			}
+			lastIndex[t] = i;
+			++nLines;
+		}
+	}
+
+	const size_t nDropped = logger->getDroppedCount();
+	const size_t nExpected = nThreads * nMessages;
+	if( overflowPolicy == Logger::OverflowPolicy::BLOCK && nLines != nExpected ) {
+		resultLogger.logMessage(L"Expected " + std::to_wstring(nExpected) +
+			L" messages, but " + std::to_wstring(nLines) + L" were output.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	} else if( overflowPolicy == Logger::OverflowPolicy::DROP_AND_COUNT &&
+		(nLines + nDropped) != nExpected ) {
+		resultLogger.logMessage(L"Expected " + std::to_wstring(nExpected) +
+			L" messages, but " + std::to_wstring(nLines) + L" were output and " +
+			std::to_wstring(nDropped) + L" were counted as discarded.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	} else {
+		resultLogger.logMessage(std::to_wstring(nLines) + L" messages output, " +
+			std::to_wstring(nDropped) + L" messages counted as discarded.");
+	}
+
+	if( FAILED(logger->stopAsync()) ) {
+		resultLogger.logMessage(L"Logger::stopAsync() reported an output failure.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	delete logger;
+	return finalResult;
+}
+
+HRESULT testLogger_LogUser::testAsyncLogging(const unsigned int nThreads) {
+
+	// Create a file for logging the test results
+	Logger* logger = 0;
+	std::wstring logFilename;
+	try {
+		fileUtil::combineAsPath(logFilename, DEFAULT_LOG_PATH_TEST, L"testAsyncLogging.txt");
+		logger = new Logger(true, logFilename, false, false);
+	} catch( ... ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+
+	HRESULT finalResult = ERROR_SUCCESS;
+	const unsigned int nMessages = 10000;
+	std::wstring outputFilename;
+
+	logger->logMessage(L"BLOCK overflow policy, with a small queue:");
+	fileUtil::combineAsPath(outputFilename, DEFAULT_LOG_PATH_TEST, L"testAsyncLogging_block.txt");
+	if( FAILED(runAsyncLogging(*logger, outputFilename, nThreads, nMessages,
+		16, Logger::OverflowPolicy::BLOCK)) ) {
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+
+	logger->logMessage(L"DROP_AND_COUNT overflow policy, with a small queue:");
+	fileUtil::combineAsPath(outputFilename, DEFAULT_LOG_PATH_TEST, L"testAsyncLogging_dropAndCount.txt");
+	if( FAILED(runAsyncLogging(*logger, outputFilename, nThreads, nMessages,
+		16, Logger::OverflowPolicy::DROP_AND_COUNT)) ) {
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+
+	logger->logMessage(L"BLOCK overflow policy, with a large queue:");
+	fileUtil::combineAsPath(outputFilename, DEFAULT_LOG_PATH_TEST, L"testAsyncLogging_large.txt");
+	if( FAILED(runAsyncLogging(*logger, outputFilename, nThreads, nMessages,
+		nThreads * nMessages, Logger::OverflowPolicy::BLOCK)) ) {
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+
+	if( SUCCEEDED(finalResult) ) {
+		logger->logMessage(L"All tests passed.");
+	} else {
+		logger->logMessage(L"Some or all tests failed.");
+	}
+
+	delete logger;
+
+	return finalResult;
+}
+
+/* Helper function for testAppendModes(), testLogLevels(), testSecondaryFiles()
+   and testLogRotation().
+   Returns the number of lines in the file which contain 'marker'
+ */
+static size_t countLinesContaining(const wstring& filename, const wstring& marker) {
+	size_t count = 0;
+	std::basic_ifstream<wchar_t> file(filename);
+	wstring line;
+	while( std::getline(file, line) ) {
+		if( line.find(marker) != wstring::npos ) {
+			++count;
+		}
+	}
+	return count;
+}
+
+HRESULT testLogger_LogUser::testAppendModes(void) {
+
+	// Create a file for logging the test results
+	Logger* logger = 0;
+	std::wstring logFilename;
+	try {
+		fileUtil::combineAsPath(logFilename, DEFAULT_LOG_PATH_TEST, L"testAppendModes.txt");
+		logger = new Logger(true, logFilename, true, false);
+	} catch( ... ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+
+	// Logger under test
+	Logger* appendLogger = 0;
+	std::wstring appendFilename;
+	try {
+		fileUtil::combineAsPath(appendFilename, DEFAULT_LOG_PATH_TEST, L"testAppendModes_output.txt");
+		appendLogger = new Logger(true, appendFilename, false, false);
+	} catch( ... ) {
+		logger->logMessage(L"Failed to create the Logger in append mode.");
+		delete logger;
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+	// Output lines will have known lengths
+	appendLogger->toggleTimestamp(false);
+
+	HRESULT finalResult = ERROR_SUCCESS;
+
+	/* Markers identifying the messages logged by this run of the test,
+	   as the output file is appended to
+	 */
+	std::wstring timeStr;
+	Logger::getDateAndTime(timeStr);
+	const wstring bufferedMarker = L"buffered message (" + timeStr + L")";
+	const wstring sharedMarker = L"shared message (" + timeStr + L")";
+	const wstring thresholdMarker = L"threshold message (" + timeStr + L")";
+	const wstring intervalMarker = L"interval message (" + timeStr + L")";
+	const wstring interleavedMarker = L"interleaved message (" + timeStr + L")";
+	const unsigned int nMessages = 10;
+	size_t count = 0;
+
+	// BUFFERED mode, with thresholds that will not be reached
+	appendLogger->setAppendMode(Logger::AppendMode::BUFFERED, LOGGER_FILE_BUFFER_SIZE, INFINITE);
+	for( unsigned int i = 0; i < nMessages; ++i ) {
+		appendLogger->logMessage(bufferedMarker);
+	}
+	count = countLinesContaining(appendFilename, bufferedMarker);
+	if( count != 0 ) {
+		logger->logMessage(L"BUFFERED mode: " + std::to_wstring(count) + L" messages were written before flushing.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+	if( FAILED(appendLogger->flush()) ) {
+		logger->logMessage(L"BUFFERED mode: Logger::flush() failed.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	count = countLinesContaining(appendFilename, bufferedMarker);
+	if( count != nMessages ) {
+		logger->logMessage(L"BUFFERED mode: " + std::to_wstring(count) + L" messages were written after flushing.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	// BUFFERED mode, with a buffer size threshold of three messages
+	appendLogger->setAppendMode(Logger::AppendMode::BUFFERED, 3 * thresholdMarker.length(), INFINITE);
+	for( unsigned int i = 0; i < nMessages; ++i ) {
+		appendLogger->logMessage(thresholdMarker);
+	}
+	count = countLinesContaining(appendFilename, thresholdMarker);
+	if( count == 0 || count == nMessages ) {
+		logger->logMessage(L"BUFFERED mode with a small buffer: " + std::to_wstring(count) +
+			L" messages were written before flushing.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	/* BUFFERED mode, with a short time interval: The message should be written
+	   once the interval has elapsed, without logging another message
+	 */
+	appendLogger->setAppendMode(Logger::AppendMode::BUFFERED, LOGGER_FILE_BUFFER_SIZE, 50);
+	appendLogger->logMessage(intervalMarker);
+	const DWORD timeout = 2000; // Milliseconds
+	const DWORD start = GetTickCount();
+	count = 0;
+	while( count == 0 && (GetTickCount() - start) < timeout ) {
+		Sleep(10);
+		count = countLinesContaining(appendFilename, intervalMarker);
+	}
+	if( count != 1 ) {
+		logger->logMessage(L"BUFFERED mode with a time interval: The message was not written "
+			L"after the interval elapsed.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	// SHARED mode (switching modes writes the buffered messages)
+	appendLogger->setAppendMode(Logger::AppendMode::SHARED);
+	count = countLinesContaining(appendFilename, thresholdMarker);
+	if( count != nMessages ) {
+		logger->logMessage(L"Buffered messages were not written when switching to SHARED mode.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+	for( unsigned int i = 0; i < nMessages; ++i ) {
+		appendLogger->logMessage(sharedMarker);
+		count = countLinesContaining(appendFilename, sharedMarker);
+		if( count != (i + 1) ) {
+			logger->logMessage(L"SHARED mode: A message was not written immediately.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+			break;
+		}
+	}
+
+	/* Two Loggers with the same file, in the BUFFERED mode:
+	   Their messages should be written in the order in which they were logged
+	 */
+	appendLogger->setAppendMode(Logger::AppendMode::BUFFERED, LOGGER_FILE_BUFFER_SIZE, INFINITE);
+	Logger* otherLogger = 0;
+	try {
+		otherLogger = new Logger(true, appendFilename, false, false);
+		otherLogger->toggleTimestamp(false);
+		otherLogger->setAppendMode(Logger::AppendMode::BUFFERED, LOGGER_FILE_BUFFER_SIZE, INFINITE);
+	} catch( ... ) {
+		logger->logMessage(L"Failed to create a second Logger with the same file.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+	if( otherLogger != 0 ) {
+		for( unsigned int i = 0; i < nMessages; ++i ) {
+			Logger* const current = ((i % 2) == 0) ? appendLogger : otherLogger;
+			current->logMessage(interleavedMarker + L" " + std::to_wstring(i));
+		}
+		std::basic_ifstream<wchar_t> file(appendFilename);
+		wstring line;
+		unsigned int i = 0;
+		while( std::getline(file, line) ) {
+			if( line.find(interleavedMarker) != wstring::npos ) {
+				if( line != (interleavedMarker + L" " + std::to_wstring(i)) ) {
+					break;
+				}
+				++i;
+			}
+		}
+		if( i != nMessages ) {
+			logger->logMessage(L"Two Loggers with the same file: Only " + std::to_wstring(i) +
+				L" messages were written immediately, in the order in which they were logged.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+		delete otherLogger;
+	}
+
+	// Buffered messages should be written on destruction
+	appendLogger->logMessage(bufferedMarker);
+	delete appendLogger;
+	count = countLinesContaining(appendFilename, bufferedMarker);
+	if( count != (nMessages + 1) ) {
+		logger->logMessage(L"A buffered message was not written when the Logger was destroyed.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	if( SUCCEEDED(finalResult) ) {
+		logger->logMessage(L"All tests passed.");
+	} else {
+		logger->logMessage(L"Some or all tests failed.");
+	}
+
+	delete logger;
+
+	return finalResult;
+}
+
+HRESULT testLogger_LogUser::testTimestamper(void) {
+
+	// Create a file for logging the test results
+	Logger* logger = 0;
+	std::wstring logFilename;
+	try {
+		fileUtil::combineAsPath(logFilename, DEFAULT_LOG_PATH_TEST, L"testTimestamper.txt");
+		logger = new Logger(true, logFilename, false, false);
+	} catch( ... ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+
+	HRESULT finalResult = ERROR_SUCCESS;
+	Timestamper timestamper(Timestamper::Format::ASCTIME, 0);
+	wstring timeStr;
+	wstring expected;
+
+	/* Compare with the output of the C library's asctime() function,
+	   retrying in case the two times fall in different seconds
+	 */
+	const unsigned int nTries = 3;
+	unsigned int i = 0;
+	for( i = 0; i < nTries; ++i ) {
+		timeStr.clear();
+		timestamper.append(timeStr, Timestamper::now());
+		timeStr += L' ';
+		if( FAILED(Logger::getDateAndTime(expected)) ) {
+			logger->logMessage(L"Logger::getDateAndTime() failed.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+			break;
+		} else if( timeStr == expected ) {
+			break;
+		}
+	}
+	if( i == nTries ) {
+		logger->logMessage(L"ASCTIME output, \"" + timeStr + L"\", does not match asctime() output, \"" + expected + L"\".");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	// Output lengths and separators
+	timestamper.setFormat(Timestamper::Format::ASCTIME, 3);
+	timeStr.clear();
+	timestamper.append(timeStr, Timestamper::now());
+	logger->logMessage(L"ASCTIME, 3 digits: " + timeStr);
+	if( timeStr.length() != 28 || timeStr[19] != L'.' ) {
+		logger->logMessage(L"Unexpected ASCTIME output with 3 sub-second digits.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	timestamper.setFormat(Timestamper::Format::ISO8601, Timestamper::s_maxSubsecondDigits);
+	timeStr.clear();
+	timestamper.append(timeStr, Timestamper::now());
+	logger->logMessage(L"ISO8601, maximum digits: " + timeStr);
+	if( timeStr.length() != (20 + Timestamper::s_maxSubsecondDigits) ||
+		timeStr[4] != L'-' || timeStr[10] != L'T' || timeStr[19] != L'.' ) {
+		logger->logMessage(L"Unexpected ISO8601 output with the maximum number of sub-second digits.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	if( SUCCEEDED(timestamper.setFormat(Timestamper::Format::ISO8601, Timestamper::s_maxSubsecondDigits + 1)) ) {
+		logger->logMessage(L"Timestamper::setFormat() accepted too many sub-second digits.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+
+	// Clock readings out of order should not produce decreasing times
+	const LONGLONG earlier = Timestamper::now();
+	Sleep(10);
+	const LONGLONG later = Timestamper::now();
+	timeStr.clear();
+	timestamper.append(timeStr, later);
+	expected = timeStr;
+	timeStr.clear();
+	timestamper.append(timeStr, earlier);
+	if( timeStr != expected ) {
+		logger->logMessage(L"An earlier clock reading was output as \"" + timeStr +
+			L"\", before the time of a later reading, \"" + expected + L"\".");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	// Timing
+	const unsigned int nTimestamps = 1000000;
+	timestamper.setFormat(Timestamper::Format::ASCTIME, 3);
+	LARGE_INTEGER frequency, start, end;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&start);
+	for( i = 0; i < nTimestamps; ++i ) {
+		timeStr.clear();
+		timestamper.append(timeStr, Timestamper::now());
+	}
+	QueryPerformanceCounter(&end);
+	const double nanoseconds = static_cast<double>(end.QuadPart - start.QuadPart) * 1.0e9 /
+		(static_cast<double>(frequency.QuadPart) * static_cast<double>(nTimestamps));
+	logger->logMessage(L"Average time to read the clock and format a timestamp: " +
+		std::to_wstring(nanoseconds) + L" ns");
+
+	if( SUCCEEDED(finalResult) ) {
+		logger->logMessage(L"All tests passed.");
+	} else {
+		logger->logMessage(L"Some or all tests failed.");
+	}
+
+	delete logger;
+
+	return finalResult;
+}
+
+/* Helper class for testLogLevels(), which logs one message
+   at each severity level, counting how many message expressions
+   are evaluated
+ */
+class LevelTestLogUser : public LogUser {
+public:
+	unsigned int m_nEvaluations;
+
+	LevelTestLogUser(void) :
+	LogUser(true, L"LevelTestLogUser"), m_nEvaluations(0)
+	{}
+
+	wstring makeMsg(const wstring& msg) {
+		++m_nEvaluations;
+		return msg;
+	}
+
+	void logAllLevels(const wstring& marker) {
+		LOGUSER_DEBUG(makeMsg(marker + L" debug"));
+		LOGUSER_INFO(makeMsg(marker + L" info"));
+		LOGUSER_WARNING(makeMsg(marker + L" warning"));
+		LOGUSER_ERROR(makeMsg(marker + L" error"));
+	}
+
+	// Logs a list of messages following a warning, as when reporting parsing problems
+	void logWarningList(const wstring& marker) {
+		LOGUSER_WARNING(marker + L" problems:");
+		m_msgStore.emplace_back(marker + L" first problem");
+		m_msgStore.emplace_back(marker + L" second problem");
+		logMsgStore(LOG_LEVEL_WARNING);
+	}
+
+	// Currently not implemented - will cause linker errors if called
+private:
+	LevelTestLogUser(const LevelTestLogUser& other);
+	LevelTestLogUser& operator=(const LevelTestLogUser& other);
+};
+
+HRESULT testLogger_LogUser::testLogLevels(void) {
+
+	// Create a file for logging the test results
+	Logger* logger = 0;
+	std::wstring logFilename;
+	std::wstring outputFilename;
+	try {
+		fileUtil::combineAsPath(logFilename, DEFAULT_LOG_PATH_TEST, L"testLogLevels.txt");
+		fileUtil::combineAsPath(outputFilename, DEFAULT_LOG_PATH_TEST, L"testLogLevels_output.txt");
+		logger = new Logger(true, logFilename, false, false);
+	} catch( ... ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+
+	HRESULT finalResult = ERROR_SUCCESS;
+
+	// Level name parsing
+	unsigned int level = 0;
+	if( FAILED(LogUser::logLevelFromString(level, L"Warning")) || level != LOG_LEVEL_WARNING ) {
+		logger->logMessage(L"LogUser::logLevelFromString() did not recognize \"Warning\".");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	if( SUCCEEDED(LogUser::logLevelFromString(level, L"verbose")) ) {
+		logger->logMessage(L"LogUser::logLevelFromString() accepted \"verbose\".");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+
+	LevelTestLogUser* logUser = new LevelTestLogUser;
+	if( FAILED(logUser->setLogger(true, outputFilename, true, false)) ) {
+		logger->logMessage(L"LogUser::setLogger() failed.");
+		delete logUser;
+		delete logger;
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+
+	if( SUCCEEDED(logUser->setLogLevel(0)) || SUCCEEDED(logUser->setLogLevel(LOG_LEVEL_ERROR + 1)) ) {
+		logger->logMessage(L"LogUser::setLogLevel() accepted an invalid level.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+
+	/* Each phase logs one message at each level, with the runtime threshold
+	   set to the given level, and should output (and evaluate) only the messages
+	   at or above both the threshold and LOG_MIN_LEVEL
+	 */
+	const unsigned int nPhases = 3;
+	const unsigned int thresholds[nPhases] = { LOG_LEVEL_DEBUG, LOG_LEVEL_WARNING, LOG_LEVEL_ERROR };
+	const wchar_t* const markers[nPhases] = { L"phaseDebug", L"phaseWarning", L"phaseError" };
+	const wchar_t* const listMarkers[nPhases] = { L"listDebug", L"listWarning", L"listError" };
+	unsigned int expected[nPhases];
+	unsigned int evaluations[nPhases];
+	size_t expectedListLines[nPhases];
+	for( unsigned int i = 0; i < nPhases; ++i ) {
+		const unsigned int minLevel = (thresholds[i] > LOG_MIN_LEVEL) ? thresholds[i] : LOG_MIN_LEVEL;
+		expected[i] = LOG_LEVEL_ERROR - minLevel + 1;
+		// The list is output with its heading, or not at all
+		expectedListLines[i] = (LOG_LEVEL_WARNING >= minLevel) ? 3 : 0;
+		logUser->setLogLevel(thresholds[i]);
+		logUser->m_nEvaluations = 0;
+		logUser->logAllLevels(markers[i]);
+		evaluations[i] = logUser->m_nEvaluations;
+		logUser->logWarningList(listMarkers[i]);
+	}
+
+	// Nothing should be evaluated when logging is disabled
+	logUser->disableLogging();
+	logUser->setLogLevel(LOG_LEVEL_DEBUG);
+	logUser->m_nEvaluations = 0;
+	logUser->logAllLevels(L"phaseDisabled");
+	const unsigned int disabledEvaluations = logUser->m_nEvaluations;
+
+	// Output the LogUser's log file
+	delete logUser;
+	logUser = 0;
+
+	for( unsigned int i = 0; i < nPhases; ++i ) {
+		const size_t nLines = countLinesContaining(outputFilename, wstring(L"LevelTestLogUser ") + markers[i]);
+		logger->logMessage(wstring(markers[i]) + L": " + std::to_wstring(evaluations[i]) +
+			L" message(s) evaluated, " + std::to_wstring(nLines) + L" line(s) output, " +
+			std::to_wstring(expected[i]) + L" expected.");
+		if( evaluations[i] != expected[i] || nLines != expected[i] ) {
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+		const size_t nListLines = countLinesContaining(outputFilename, wstring(L"LevelTestLogUser ") + listMarkers[i]);
+		if( nListLines != expectedListLines[i] ) {
+			logger->logMessage(wstring(listMarkers[i]) + L": " + std::to_wstring(nListLines) +
+				L" line(s) of a list of warnings output, " + std::to_wstring(expectedListLines[i]) + L" expected.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+	}
+	if( disabledEvaluations != 0 || countLinesContaining(outputFilename, L"phaseDisabled") != 0 ) {
+		logger->logMessage(L"Messages were evaluated or output while logging was disabled.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	if( SUCCEEDED(finalResult) ) {
+		logger->logMessage(L"All tests passed.");
+	} else {
+		logger->logMessage(L"Some or all tests failed.");
+	}
+
+	delete logger;
+
+	return finalResult;
+}
+
+HRESULT testLogger_LogUser::testBinaryLogging(const unsigned int nMessages) {
+
+	// Create a file for logging the test results
+	Logger* logger = 0;
+	std::wstring logFilename;
+	std::wstring textFilename;
+	std::wstring binaryFilename;
+	std::wstring decodedFilename;
+	try {
+		fileUtil::combineAsPath(logFilename, DEFAULT_LOG_PATH_TEST, L"testBinaryLogging.txt");
+		fileUtil::combineAsPath(textFilename, DEFAULT_LOG_PATH_TEST, L"testBinaryLogging_text.txt");
+		fileUtil::combineAsPath(binaryFilename, DEFAULT_LOG_PATH_TEST, wstring(L"testBinaryLogging_binary") + BINARYLOGGER_EXTENSION);
+		fileUtil::combineAsPath(decodedFilename, DEFAULT_LOG_PATH_TEST, L"testBinaryLogging_decoded.txt");
+		logger = new Logger(true, logFilename, false, false);
+	} catch( ... ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+
+	HRESULT finalResult = ERROR_SUCCESS;
+	HRESULT result = ERROR_SUCCESS;
+	LARGE_INTEGER frequency, start, end;
+	QueryPerformanceFrequency(&frequency);
+	const wchar_t* const objectNames[] = { L"sphere", L"cube", L"plane" };
+	const wstring tag = L"<tag>";
+
+	// Text logging, formatting each message when it is logged
+	Logger* textLogger = 0;
+	try {
+		textLogger = new Logger(true, textFilename, true, false);
+	} catch( ... ) {
+		logger->logMessage(L"Failed to create the Logger for text output.");
+		delete logger;
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+	QueryPerformanceCounter(&start);
+	for( unsigned int i = 0; i < nMessages && SUCCEEDED(result); ++i ) {
+		result = textLogger->logMessage(L"Frame " + std::to_wstring(i) + L" of object " +
+			objectNames[i % 3] + L": " + std::to_wstring(static_cast<double>(i) * 0.25) +
+			L" ms, offset " + std::to_wstring(-static_cast<int>(i % 7)) + L", visible = " +
+			((i % 2 == 0) ? L"true" : L"false") + L", " + tag, false, true);
+	}
+	delete textLogger;
+	QueryPerformanceCounter(&end);
+	const double textSeconds = static_cast<double>(end.QuadPart - start.QuadPart) /
+		static_cast<double>(frequency.QuadPart);
+	if( FAILED(result) ) {
+		logger->logMessage(L"Text logging failed.");
+		finalResult = result;
+	}
+
+	// Binary logging of the same messages
+	BinaryLogger* binaryLogger = 0;
+	try {
+		binaryLogger = new BinaryLogger(binaryFilename);
+	} catch( ... ) {
+		logger->logMessage(L"Failed to create the BinaryLogger.");
+		delete logger;
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+	BinaryLogger::FormatID id = 0;
+	result = binaryLogger->registerFormat<unsigned int, BinaryLogger::StaticString, double, int, bool, wstring>(
+		id, L"Frame {} of object {}: {} ms, offset {}, visible = {}, {}");
+	if( FAILED(result) ) {
+		logger->logMessage(L"BinaryLogger::registerFormat() failed.");
+		finalResult = result;
+	}
+
+	BinaryLogger::FormatID invalidId = 0;
+	if( SUCCEEDED(binaryLogger->registerFormat<int>(invalidId, L"No placeholder")) ) {
+		logger->logMessage(L"BinaryLogger::registerFormat() accepted a format with too few placeholders.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	if( SUCCEEDED(binaryLogger->log(id, 1.0)) ) {
+		logger->logMessage(L"BinaryLogger::log() accepted arguments of the wrong types.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+
+	QueryPerformanceCounter(&start);
+	for( unsigned int i = 0; i < nMessages && SUCCEEDED(result); ++i ) {
+		result = binaryLogger->log(id, i, BinaryLogger::StaticString(objectNames[i % 3]),
+			static_cast<double>(i) * 0.25, -static_cast<int>(i % 7), (i % 2 == 0), tag);
+	}
+	delete binaryLogger;
+	QueryPerformanceCounter(&end);
+	const double binarySeconds = static_cast<double>(end.QuadPart - start.QuadPart) /
+		static_cast<double>(frequency.QuadPart);
+	if( FAILED(result) ) {
+		logger->logMessage(L"Binary logging failed.");
+		finalResult = result;
+	}
+
+	// Decode the binary file
+	result = BinaryLogger::decode(binaryFilename, decodedFilename);
+	if( FAILED(result) || HRESULT_CODE(result) == ERROR_DATA_INCOMPLETE ) {
+		logger->logMessage(L"BinaryLogger::decode() failed, or reported incomplete data.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+
+	/* The decoded file should contain the same messages as the text file
+	   (with different timestamps)
+	 */
+	std::basic_ifstream<wchar_t> textFile(textFilename);
+	std::basic_ifstream<wchar_t> decodedFile(decodedFilename);
+	wstring textLine;
+	wstring decodedLine;
+	unsigned int nLines = 0;
+	unsigned int nMismatches = 0;
+	while( std::getline(textFile, textLine) ) {
+		if( !std::getline(decodedFile, decodedLine) ) {
+			break;
+		}
+		++nLines;
+		const size_t textPos = textLine.find(L" | ");
+		const size_t decodedPos = decodedLine.find(L" | ");
+		if( textPos != decodedPos ||
+			textLine.compare(textPos, wstring::npos, decodedLine, decodedPos, wstring::npos) != 0 ) {
+			if( nMismatches == 0 ) {
+				logger->logMessage(L"First mismatch: \"" + textLine + L"\" (text) and \"" + decodedLine + L"\" (decoded).");
+			}
+			++nMismatches;
+		}
+	}
+	textFile.close();
+	decodedFile.close();
+	if( nLines != nMessages || nMismatches != 0 ) {
+		logger->logMessage(std::to_wstring(nLines) + L" line(s) compared, " + std::to_wstring(nMismatches) +
+			L" mismatch(es), " + std::to_wstring(nMessages) + L" message(s) logged.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	/* A FORMAT record with fewer placeholders than argument types
+	   (created by overwriting a placeholder in a valid file) should be rejected
+	 */
+	std::wstring corruptFilename;
+	fileUtil::combineAsPath(corruptFilename, DEFAULT_LOG_PATH_TEST, wstring(L"testBinaryLogging_corrupt") + BINARYLOGGER_EXTENSION);
+	try {
+		binaryLogger = new BinaryLogger(corruptFilename);
+		result = binaryLogger->registerFormat<int, bool>(id, L"Corrupt format: {}, {}");
+		if( SUCCEEDED(result) ) {
+			result = binaryLogger->log(id, 1, true);
+		}
+		delete binaryLogger;
+	} catch( ... ) {
+		result = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+	bool corrupted = false;
+	if( SUCCEEDED(result) ) {
+		std::ifstream corruptInput(corruptFilename, std::ios::binary);
+		std::string bytes((std::istreambuf_iterator<char>(corruptInput)), std::istreambuf_iterator<char>());
+		corruptInput.close();
+		const std::string placeholder(reinterpret_cast<const char*>(BINARYLOGGER_PLACEHOLDER),
+			wcslen(BINARYLOGGER_PLACEHOLDER) * sizeof(wchar_t));
+		const size_t pos = bytes.rfind(placeholder);
+		if( pos != std::string::npos ) {
+			const wstring replacement(wcslen(BINARYLOGGER_PLACEHOLDER), L'x');
+			bytes.replace(pos, placeholder.size(), reinterpret_cast<const char*>(replacement.c_str()), placeholder.size());
+			std::ofstream corruptOutput(corruptFilename, std::ios::binary | std::ios::trunc);
+			corruptOutput.write(bytes.data(), bytes.size());
+			corrupted = corruptOutput.good();
+		}
+	}
+	if( !corrupted ) {
+		logger->logMessage(L"Failed to create a binary log file with a corrupt format string.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	} else if( SUCCEEDED(BinaryLogger::decode(corruptFilename, decodedFilename)) ) {
+		logger->logMessage(L"BinaryLogger::decode() accepted a format string with too few placeholders.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+
+	// Compare throughput and file sizes
+	uint64_t textSize = 0;
+	uint64_t binarySize = 0;
+	uint64_t writeTime = 0;
+	if( FAILED(fileUtil::getFileStamp(textFilename, textSize, writeTime)) ||
+		FAILED(fileUtil::getFileStamp(binaryFilename, binarySize, writeTime)) ) {
+		logger->logMessage(L"fileUtil::getFileStamp() failed.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	} else if( binarySize >= textSize ) {
+		logger->logMessage(L"The binary log file is not smaller than the text log file.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+	logger->logMessage(L"Text logging: " + std::to_wstring(textSeconds * 1.0e9 / nMessages) +
+		L" ns per message, " + std::to_wstring(textSize) + L" bytes.");
+	logger->logMessage(L"Binary logging: " + std::to_wstring(binarySeconds * 1.0e9 / nMessages) +
+		L" ns per message, " + std::to_wstring(binarySize) + L" bytes.");
+
+	if( SUCCEEDED(finalResult) ) {
+		logger->logMessage(L"All tests passed.");
+	} else {
+		logger->logMessage(L"Some or all tests failed.");
+	}
+
+	delete logger;
+
+	return finalResult;
+}
+
+HRESULT testLogger_LogUser::testSecondaryFiles(void) {
+
+	// Create a file for logging the test results
+	Logger* logger = 0;
+	std::wstring logFilename;
+	try {
+		fileUtil::combineAsPath(logFilename, DEFAULT_LOG_PATH_TEST, L"testSecondaryFiles.txt");
+		logger = new Logger(true, logFilename, true, false);
+	} catch( ... ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+
+	// Logger under test, which has no primary log file
+	Logger* fileLogger = 0;
+	try {
+		fileLogger = new Logger(false, L"", false, false);
+	} catch( ... ) {
+		logger->logMessage(L"Failed to create the Logger under test.");
+		delete logger;
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+	fileLogger->setAppendMode(Logger::AppendMode::BUFFERED, LOGGER_FILE_BUFFER_SIZE, INFINITE);
+
+	// One more file than can be kept open
+	const unsigned int nFiles = LOGGER_SECONDARY_FILE_CACHE_SIZE + 1;
+	std::vector<wstring> filenames(nFiles);
+	for( unsigned int i = 0; i < nFiles; ++i ) {
+		fileUtil::combineAsPath(filenames[i], DEFAULT_LOG_PATH_TEST,
+			L"testSecondaryFiles_output" + std::to_wstring(i) + L".txt");
+	}
+
+	HRESULT finalResult = ERROR_SUCCESS;
+
+	/* Markers identifying the messages logged by this run of the test,
+	   as the output files are appended to
+	 */
+	std::wstring timeStr;
+	Logger::getDateAndTime(timeStr);
+	const wstring marker = L"secondary message (" + timeStr + L")";
+	const wstring bulkMarker = L"secondary bulk message (" + timeStr + L")";
+	const wstring sharedMarker = L"secondary shared message (" + timeStr + L")";
+	size_t count = 0;
+
+	// Messages to a cached file are buffered until flushing
+	fileLogger->logMessage(marker, false, true, filenames[0]);
+	std::list<wstring> msgs(2, bulkMarker);
+	fileLogger->logMessage(msgs.cbegin(), msgs.cend(), L"", false, true, filenames[0]);
+	count = countLinesContaining(filenames[0], marker) + countLinesContaining(filenames[0], bulkMarker);
+	if( count != 0 ) {
+		logger->logMessage(L"BUFFERED mode: " + std::to_wstring(count) + L" messages were written before flushing.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+	if( FAILED(fileLogger->flush()) ) {
+		logger->logMessage(L"BUFFERED mode: Logger::flush() failed.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	count = countLinesContaining(filenames[0], marker);
+	if( count != 1 || countLinesContaining(filenames[0], bulkMarker) != msgs.size() ) {
+		logger->logMessage(L"BUFFERED mode: Messages were lost or duplicated when flushing.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	/* Logging to more files than can be kept open closes the least recently used file,
+	   which is filenames[1] after the second message to filenames[0]
+	 */
+	for( unsigned int i = 0; i < nFiles; ++i ) {
+		fileLogger->logMessage(marker, false, true, filenames[i]);
+		if( i == 1 ) {
+			fileLogger->logMessage(marker, false, true, filenames[0]);
+		}
+	}
+	count = countLinesContaining(filenames[1], marker);
+	if( count != 1 ) {
+		logger->logMessage(L"BUFFERED mode: The least recently used file was not written when it was closed.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+	count = countLinesContaining(filenames[0], marker);
+	if( count != 1 ) {
+		logger->logMessage(L"BUFFERED mode: A file other than the least recently used file was written.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	// Switching to the SHARED mode writes and closes the files
+	fileLogger->setAppendMode(Logger::AppendMode::SHARED);
+	for( unsigned int i = 0; i < nFiles; ++i ) {
+		count = countLinesContaining(filenames[i], marker);
+		if( count != ((i == 0) ? 3 : 1) ) {
+			logger->logMessage(L"Messages to file " + std::to_wstring(i) + L" were lost when switching to the SHARED mode.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+	}
+	fileLogger->logMessage(sharedMarker, false, true, filenames[0]);
+	if( countLinesContaining(filenames[0], sharedMarker) != 1 ) {
+		logger->logMessage(L"SHARED mode: The message was not written immediately.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	// Compare the time taken to log to a secondary file in each mode
+	const unsigned int nTimedMessages = 10000;
+	const Logger::AppendMode modes[] = { Logger::AppendMode::SHARED, Logger::AppendMode::BUFFERED };
+	const wchar_t* const modeNames[] = { L"SHARED", L"BUFFERED" };
+	LARGE_INTEGER frequency, start, end;
+	QueryPerformanceFrequency(&frequency);
+	for( unsigned int i = 0; i < 2; ++i ) {
+		fileLogger->setAppendMode(modes[i]);
+		QueryPerformanceCounter(&start);
+		for( unsigned int j = 0; j < nTimedMessages; ++j ) {
+			fileLogger->logMessage(L"Timed message", false, true, filenames[nFiles - 1]);
+		}
+		fileLogger->flush();
+		QueryPerformanceCounter(&end);
+		logger->logMessage(wstring(modeNames[i]) + L" mode: " +
+			std::to_wstring(static_cast<double>(end.QuadPart - start.QuadPart) * 1.0e9 /
+			(static_cast<double>(frequency.QuadPart) * nTimedMessages)) + L" ns per message.");
+	}
+
+	delete fileLogger;
+
+	if( SUCCEEDED(finalResult) ) {
+		logger->logMessage(L"All tests passed.");
+	} else {
+		logger->logMessage(L"Some or all tests failed.");
+	}
+
+	delete logger;
+
+	return finalResult;
+}
+/* Helper function for testLogRotation().
+   Appends the indices of the lines of the form "rotation <index>" in the file,
+   and returns the number of bytes in the file (zero if the file does not exist).
+ */
+static uint64_t readRotationIndices(std::vector<int>& indices, const wstring& filename) {
+	uint64_t size = 0;
+	uint64_t writeTime = 0;
+	if( FAILED(fileUtil::getFileStamp(filename, size, writeTime)) ) {
+		return 0;
+	}
+	std::basic_ifstream<wchar_t> file(filename);
+	wstring line;
+	wstring word;
+	int i = 0;
+	while( std::getline(file, line) ) {
+		std::wistringstream lineStream(line);
+		if( (lineStream >> word >> i) && word == L"rotation" ) {
+			indices.push_back(i);
+		}
+	}
+	return size;
+}
+
+HRESULT testLogger_LogUser::testLogRotation(void) {
+
+	// Create a file for logging the test results
+	Logger* logger = 0;
+	std::wstring logFilename;
+	try {
+		fileUtil::combineAsPath(logFilename, DEFAULT_LOG_PATH_TEST, L"testLogRotation.txt");
+		logger = new Logger(true, logFilename, true, false);
+	} catch( ... ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+
+	HRESULT finalResult = ERROR_SUCCESS;
+	const ULONGLONG maxSize = 4096;
+	const unsigned int nSegments = 3;
+	const unsigned int nMessages = 2000;
+
+	// Files from previous runs of the test, including one more segment than is retained
+	wstring outputFilename;
+	fileUtil::combineAsPath(outputFilename, DEFAULT_LOG_PATH_TEST, L"testLogRotation_output.txt");
+	std::vector<wstring> filenames(nSegments + 2);
+	filenames[0] = outputFilename;
+	for( unsigned int i = 1; i <= nSegments + 1; ++i ) {
+		fileUtil::combineAsPath(filenames[i], DEFAULT_LOG_PATH_TEST,
+			L"testLogRotation_output." + std::to_wstring(i) + L".txt");
+	}
+	wstring spareFilename;
+	fileUtil::combineAsPath(spareFilename, DEFAULT_LOG_PATH_TEST, L"testLogRotation_output.next.txt");
+	for( std::vector<wstring>::const_iterator it = filenames.cbegin(); it != filenames.cend(); ++it ) {
+		DeleteFile(it->c_str());
+	}
+
+	// Rotation is not possible when the file is overwritten
+	if( SUCCEEDED(logger->setRotation(maxSize, 0, nSegments)) ) {
+		logger->logMessage(L"Logger::setRotation() succeeded for a Logger which overwrites its file.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+
+	// Logger under test
+	Logger* fileLogger = 0;
+	try {
+		fileLogger = new Logger(true, outputFilename, false, false);
+	} catch( ... ) {
+		logger->logMessage(L"Failed to create the Logger under test.");
+		delete logger;
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+	fileLogger->toggleTimestamp(false);
+	fileLogger->setAppendMode(Logger::AppendMode::BUFFERED, 256, INFINITE);
+
+	// Size-based rotation
+	if( FAILED(fileLogger->setRotation(maxSize, 0, nSegments)) ) {
+		logger->logMessage(L"Logger::setRotation() failed.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	if( SUCCEEDED(fileLogger->setAppendMode(Logger::AppendMode::SHARED)) ) {
+		logger->logMessage(L"Logger::setAppendMode() allowed the SHARED mode while rotation was enabled.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	for( unsigned int i = 0; i < nMessages; ++i ) {
+		fileLogger->logMessage(L"rotation " + std::to_wstring(i));
+	}
+	if( FAILED(fileLogger->flush()) ) {
+		logger->logMessage(L"Size-based rotation: Logger::flush() reported a failure.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+
+	// Disabling rotation completes any pending archiving
+	if( FAILED(fileLogger->setRotation(0, 0)) ) {
+		logger->logMessage(L"Logger::setRotation() failed to disable rotation.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+
+	// Read the segments from oldest to newest, and then the current file
+	std::vector<int> indices;
+	for( std::vector<wstring>::const_reverse_iterator it = filenames.crbegin(); it != filenames.crend(); ++it ) {
+		const size_t nIndices = indices.size();
+		const uint64_t size = readRotationIndices(indices, *it);
+		logger->logMessage(L"File \"" + *it + L"\": " + std::to_wstring(size) +
+			L" bytes, " + std::to_wstring(indices.size() - nIndices) + L" messages.");
+		if( it == filenames.crbegin() ) {
+			if( size > 0 ) {
+				logger->logMessage(L"More than the requested number of segments were retained.");
+				finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+			}
+		} else if( indices.size() == nIndices ) {
+			logger->logMessage(L"The file is missing or empty.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+	}
+	if( indices.empty() || indices.back() != static_cast<int>(nMessages) - 1 || indices.front() == 0 ) {
+		logger->logMessage(L"The files do not end with the last message, or no messages were discarded.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+	for( size_t i = 1; i < indices.size(); ++i ) {
+		if( indices[i] != indices[i - 1] + 1 ) {
+			logger->logMessage(L"Messages were lost or reordered between message " +
+				std::to_wstring(indices[i - 1]) + L" and message " + std::to_wstring(indices[i]) + L".");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+			break;
+		}
+	}
+
+	uint64_t size = 0;
+	uint64_t writeTime = 0;
+	if( SUCCEEDED(fileUtil::getFileStamp(spareFilename, size, writeTime)) ) {
+		logger->logMessage(L"Temporary files were left behind after rotation was disabled.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	// Time-based rotation, retaining one segment (older segments are not deleted automatically)
+	for( unsigned int i = 1; i <= nSegments + 1; ++i ) {
+		DeleteFile(filenames[i].c_str());
+	}
+	const wstring firstMarker = L"message before rotation";
+	const wstring secondMarker = L"message after rotation";
+	if( FAILED(fileLogger->setRotation(0, 50, 1)) ) {
+		logger->logMessage(L"Logger::setRotation() failed for time-based rotation.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	fileLogger->logMessage(firstMarker);
+	fileLogger->flush();
+
+	// The file is rotated once the interval has elapsed, without waiting for another message
+	const DWORD waitStart = GetTickCount();
+	while( countLinesContaining(filenames[1], firstMarker) != 1 &&
+		(GetTickCount() - waitStart) < 2000 ) {
+		Sleep(10);
+	}
+	if( countLinesContaining(filenames[1], firstMarker) != 1 ) {
+		logger->logMessage(L"Time-based rotation: The file was not rotated before another message was logged.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+	fileLogger->logMessage(secondMarker);
+	if( FAILED(fileLogger->setRotation(0, 0)) ) {
+		logger->logMessage(L"Time-based rotation: Logger::setRotation() failed to disable rotation.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+
+	if( countLinesContaining(filenames[1], firstMarker) != 1 ||
+		countLinesContaining(filenames[1], secondMarker) != 0 ||
+		countLinesContaining(outputFilename, secondMarker) != 1 ||
+		countLinesContaining(outputFilename, firstMarker) != 0 ) {
+		logger->logMessage(L"Time-based rotation: The messages are not in the expected files.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+	if( SUCCEEDED(fileUtil::getFileStamp(filenames[2], size, writeTime)) ) {
+		logger->logMessage(L"Time-based rotation: More than one segment was retained.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	/* Archiving failure: While the primary log file is held open by another handle
+	   which does not allow it to be renamed, the file cannot be archived.
+	   The failure should be reported, and the file should be archived,
+	   and rotation resumed, once the handle is closed.
+	 */
+	for( std::vector<wstring>::const_iterator it = filenames.cbegin(); it != filenames.cend(); ++it ) {
+		DeleteFile(it->c_str());
+	}
+	if( FAILED(fileLogger->setRotation(maxSize, 0, nSegments)) ) {
+		logger->logMessage(L"Archiving failure: Logger::setRotation() failed.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	HANDLE holder = CreateFile(outputFilename.c_str(), GENERIC_READ,
+		FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if( holder == INVALID_HANDLE_VALUE ) {
+		logger->logMessage(L"Archiving failure: Failed to open the primary log file.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	} else {
+		bool failureReported = false;
+		const DWORD failureStart = GetTickCount();
+		for( unsigned int i = 0; !failureReported && (GetTickCount() - failureStart) < 2000; ++i ) {
+			// The failure is returned by whichever function writes to the file first
+			failureReported = FAILED(fileLogger->logMessage(L"rotation " + std::to_wstring(i)));
+			failureReported = FAILED(fileLogger->flush()) || failureReported;
+		}
+		CloseHandle(holder);
+		if( !failureReported ) {
+			logger->logMessage(L"Archiving failure: The failure to archive the primary log file was not reported.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+
+		// The background thread tries again periodically
+		const DWORD retryStart = GetTickCount();
+		while( FAILED(fileUtil::getFileStamp(filenames[1], size, writeTime)) &&
+			(GetTickCount() - retryStart) < 5000 ) {
+			Sleep(10);
+		}
+		for( unsigned int i = 0; i < nMessages; ++i ) {
+			fileLogger->logMessage(L"rotation " + std::to_wstring(i));
+		}
+		fileLogger->flush();
+		if( countLinesContaining(filenames[1], L"rotation") == 0 ||
+			countLinesContaining(filenames[2], L"rotation") == 0 ) {
+			logger->logMessage(L"Archiving failure: The file was not archived, or rotation did not resume, "
+				L"after the primary log file was released.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+	}
+	if( FAILED(fileLogger->setRotation(0, 0)) ) {
+		logger->logMessage(L"Archiving failure: Logger::setRotation() reported a failure after recovery.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+
+	// Size-based rotation in asynchronous mode
+	for( std::vector<wstring>::const_iterator it = filenames.cbegin(); it != filenames.cend(); ++it ) {
+		DeleteFile(it->c_str());
+	}
+	if( FAILED(fileLogger->startAsync(256, Logger::OverflowPolicy::BLOCK)) ) {
+		logger->logMessage(L"Asynchronous mode: Logger::startAsync() failed.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	if( FAILED(fileLogger->setRotation(maxSize, 0, nSegments)) ) {
+		logger->logMessage(L"Asynchronous mode: Logger::setRotation() failed.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	for( unsigned int i = 0; i < nMessages; ++i ) {
+		fileLogger->logMessage(L"rotation " + std::to_wstring(i));
+	}
+	if( FAILED(fileLogger->flush()) || FAILED(fileLogger->setRotation(0, 0)) ||
+		FAILED(fileLogger->stopAsync()) ) {
+		logger->logMessage(L"Asynchronous mode: Logging with rotation reported a failure.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	delete fileLogger;
+
+	indices.clear();
+	for( std::vector<wstring>::const_reverse_iterator it = filenames.crbegin() + 1; it != filenames.crend(); ++it ) {
+		readRotationIndices(indices, *it);
+	}
+	bool consecutive = !indices.empty() && indices.back() == static_cast<int>(nMessages) - 1;
+	for( size_t i = 1; i < indices.size(); ++i ) {
+		consecutive = consecutive && (indices[i] == indices[i - 1] + 1);
+	}
+	if( !consecutive || countLinesContaining(filenames[1], L"rotation") == 0 ) {
+		logger->logMessage(L"Asynchronous mode: The files were not rotated, or messages were lost or reordered.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	if( SUCCEEDED(finalResult) ) {
+		logger->logMessage(L"All tests passed.");
+	} else {
+		logger->logMessage(L"Some or all tests failed.");
+	}
+
+	delete logger;
+
+	return finalResult;
+}
+
+/* Helper function for testFlightRecorder().
+   Outputs the message of each line in the file (the part after the timestamp).
+ */
+static void readDecodedMessages(std::vector<wstring>& messages, const wstring& filename) {
+	messages.clear();
+	std::basic_ifstream<wchar_t> file(filename);
+	wstring line;
+	while( std::getline(file, line) ) {
+		const size_t separator = line.find(L" | ");
+		messages.push_back((separator == wstring::npos) ? line : line.substr(separator + 3));
+	}
+}
+
+/* Helper function for testFlightRecorder().
+   Returns true if the messages are of the form "<word> <index>",
+   with consecutive indices ending at 'last', and outputs the first index.
+ */
+static bool checkFlightIndices(int& first, const std::vector<wstring>& messages,
+	const wstring& word, const int last) {
+	int expected = -1;
+	first = -1;
+	wstring messageWord;
+	int i = 0;
+	for( std::vector<wstring>::const_iterator it = messages.cbegin(); it != messages.cend(); ++it ) {
+		std::wistringstream lineStream(*it);
+		if( !(lineStream >> messageWord >> i) || messageWord != word ||
+			(expected >= 0 && i != expected) ) {
+			return false;
+		}
+		if( expected < 0 ) {
+			first = i;
+		}
+		expected = i + 1;
+	}
+	return expected == (last + 1);
+}
+
+HRESULT testLogger_LogUser::testFlightRecorder(void) {
+
+	// Create a file for logging the test results
+	Logger* logger = 0;
+	std::wstring logFilename;
+	try {
+		fileUtil::combineAsPath(logFilename, DEFAULT_LOG_PATH_TEST, L"testFlightRecorder.txt");
+		logger = new Logger(true, logFilename, true, false);
+	} catch( ... ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+
+	HRESULT finalResult = ERROR_SUCCESS;
+	HRESULT result = ERROR_SUCCESS;
+	const size_t capacity = 65536;
+	const int nMessages = 5000;
+	const int nRecent = 100;
+	const unsigned int nThreads = 4;
+	const int nThreadMessages = 1000;
+
+	wstring ringFilename;
+	wstring decodedFilename;
+	wstring outputFilename;
+	fileUtil::combineAsPath(ringFilename, DEFAULT_LOG_PATH_TEST, L"testFlightRecorder" FLIGHTRECORDER_EXTENSION);
+	fileUtil::combineAsPath(decodedFilename, DEFAULT_LOG_PATH_TEST, L"testFlightRecorder_decoded.txt");
+	fileUtil::combineAsPath(outputFilename, DEFAULT_LOG_PATH_TEST, L"testFlightRecorder_output.txt");
+	DeleteFile(ringFilename.c_str());
+
+	// Logger under test, and its flight recorder
+	Logger* fileLogger = 0;
+	FlightRecorder* recorder = 0;
+	try {
+		fileLogger = new Logger(true, outputFilename, true, false);
+		recorder = new FlightRecorder(ringFilename, capacity);
+	} catch( ... ) {
+		logger->logMessage(L"Failed to create the Logger or FlightRecorder under test.");
+		delete fileLogger;
+		delete logger;
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	fileLogger->setFlightRecorder(recorder);
+
+	// Enough messages to wrap around the ring several times
+	for( int i = 0; i < nMessages; ++i ) {
+		fileLogger->logMessage(L"flight " + std::to_wstring(i));
+	}
+
+	std::vector<wstring> messages;
+	int first = 0;
+	result = FlightRecorder::decode(ringFilename, decodedFilename, nRecent);
+	readDecodedMessages(messages, decodedFilename);
+	if( result != ERROR_SUCCESS || messages.size() != static_cast<size_t>(nRecent) ||
+		!checkFlightIndices(first, messages, L"flight", nMessages - 1) ) {
+		logger->logMessage(L"Decoding the most recent messages failed, or they are not the last messages in order.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	result = FlightRecorder::decode(ringFilename, decodedFilename);
+	readDecodedMessages(messages, decodedFilename);
+	if( result != ERROR_SUCCESS || !checkFlightIndices(first, messages, L"flight", nMessages - 1) || first == 0 ) {
+		logger->logMessage(L"Decoding all messages failed, the messages are not in order, or the ring did not wrap around.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	} else {
+		logger->logMessage(std::to_wstring(messages.size()) + L" of " + std::to_wstring(nMessages) +
+			L" messages were retained, starting from message " + std::to_wstring(first) + L".");
+	}
+
+	// Reopening the file continues after the previous messages
+	fileLogger->setFlightRecorder(0);
+	delete recorder;
+	recorder = 0;
+	try {
+		recorder = new FlightRecorder(ringFilename, capacity);
+	} catch( ... ) {
+		logger->logMessage(L"Failed to reopen the ring file.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	if( recorder != 0 ) {
+		fileLogger->setFlightRecorder(recorder);
+		fileLogger->logMessage(L"flight " + std::to_wstring(nMessages));
+		result = FlightRecorder::decode(ringFilename, decodedFilename);
+		readDecodedMessages(messages, decodedFilename);
+		if( result != ERROR_SUCCESS || messages.size() < 2 ||
+			!checkFlightIndices(first, messages, L"flight", nMessages) ) {
+			logger->logMessage(L"The message recorded after reopening the ring file does not follow the previous messages.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+		fileLogger->setFlightRecorder(0);
+		delete recorder;
+		recorder = 0;
+	}
+
+	// Multiple threads, starting with a new ring file
+	DeleteFile(ringFilename.c_str());
+	try {
+		recorder = new FlightRecorder(ringFilename, capacity);
+	} catch( ... ) {
+		logger->logMessage(L"Failed to recreate the ring file.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	if( recorder != 0 ) {
+		fileLogger->setFlightRecorder(recorder);
+		std::vector<std::thread> threads;
+		for( unsigned int t = 0; t < nThreads; ++t ) {
+			threads.push_back(std::thread([fileLogger, t, nThreadMessages]() {
+				for( int i = 0; i < nThreadMessages; ++i ) {
+					fileLogger->logMessage(L"thread " + std::to_wstring(t) + L" " + std::to_wstring(i));
+				}
+			}));
+		}
+		for( std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it ) {
+			it->join();
+		}
+		if( FAILED(recorder->flush()) ) {
+			logger->logMessage(L"FlightRecorder::flush() failed.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+		}
+		fileLogger->setFlightRecorder(0);
+		delete recorder;
+
+		result = FlightRecorder::decode(ringFilename, decodedFilename);
+		readDecodedMessages(messages, decodedFilename);
+		if( result != ERROR_SUCCESS || messages.empty() ) {
+			logger->logMessage(L"Decoding the messages from multiple threads failed, or some were incomplete.");
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+
+		// The retained messages from each thread must be the most recent ones, in order
+		std::vector<std::vector<wstring> > threadMessages(nThreads);
+		wstring word;
+		unsigned int t = 0;
+		for( std::vector<wstring>::const_iterator it = messages.cbegin(); it != messages.cend(); ++it ) {
+			std::wistringstream lineStream(*it);
+			if( !(lineStream >> word >> t) || word != L"thread" || t >= nThreads ) {
+				logger->logMessage(L"Malformed message: \"" + *it + L"\"");
+				finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+				continue;
+			}
+			threadMessages[t].push_back(word + it->substr(static_cast<size_t>(lineStream.tellg())));
+		}
+		for( t = 0; t < nThreads; ++t ) {
+			if( !threadMessages[t].empty() &&
+				!checkFlightIndices(first, threadMessages[t], L"thread", nThreadMessages - 1) ) {
+				logger->logMessage(L"The messages from thread " + std::to_wstring(t) +
+					L" are not the most recent ones in order.");
+				finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+			}
+		}
+	}
+
+	delete fileLogger;
+
+	if( SUCCEEDED(finalResult) ) {
+		logger->logMessage(L"All tests passed.");
+	} else {
+		logger->logMessage(L"Some or all tests failed.");
+	}
+
+	delete logger;
+
+	return finalResult;
+}
+
+/* Helper class for testLogSuppression(), which logs messages
+   from two different call sites (at the error level, so that they are
+   not removed by LOG_MIN_LEVEL), and from arbitrary call site identifiers
+ */
+class SuppressionTestLogUser : public LogUser {
+public:
+	SuppressionTestLogUser(void) :
+	LogUser(true, L"SuppressionTestLogUser")
+	{}
+
+	void logFirstSite(const wstring& msg) {
+		LOGUSER_ERROR(msg);
+	}
+
+	void logSecondSite(const wstring& msg) {
+		LOGUSER_ERROR(msg);
+	}
+
+	void logAtSite(const ULONGLONG site, const wstring& msg) {
+		logSiteMessage(LOG_LEVEL_ERROR, site, msg);
+	}
+
+	// Currently not implemented - will cause linker errors if called
+private:
+	SuppressionTestLogUser(const SuppressionTestLogUser& other);
+	SuppressionTestLogUser& operator=(const SuppressionTestLogUser& other);
+};
+
+HRESULT testLogger_LogUser::testLogSuppression(void) {
+
+	// Create a file for logging the test results
+	Logger* logger = 0;
+	std::wstring logFilename;
+	std::wstring outputFilename;
+	try {
+		fileUtil::combineAsPath(logFilename, DEFAULT_LOG_PATH_TEST, L"testLogSuppression.txt");
+		fileUtil::combineAsPath(outputFilename, DEFAULT_LOG_PATH_TEST, L"testLogSuppression_output.txt");
+		logger = new Logger(true, logFilename, true, false);
+	} catch( ... ) {
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_NO_LOGGER);
+	}
+
+	HRESULT finalResult = ERROR_SUCCESS;
+	const unsigned int nRepeats = 100;
+	const unsigned int nDistinct = 10;
+	const unsigned int rateLimit = 5;
+	const unsigned int nBurst = 20;
+
+	SuppressionTestLogUser* logUser = new SuppressionTestLogUser;
+	if( FAILED(logUser->setLogger(true, outputFilename, true, false)) ) {
+		logger->logMessage(L"LogUser::setLogger() failed.");
+		delete logUser;
+		delete logger;
+		return MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+	if( SUCCEEDED(logUser->setRateLimit(1, 0)) ) {
+		logger->logMessage(L"LogUser::setRateLimit() accepted a zero interval.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_FUNCTION_CALL);
+	}
+
+	// Repeats, summarized when a different message is logged
+	logUser->setRepeatSuppression(true, 0);
+	for( unsigned int i = 0; i < nRepeats; ++i ) {
+		logUser->logFirstSite(L"repeatPhase");
+	}
+	// Different messages from the same call site are not repeats
+	for( unsigned int i = 0; i < nDistinct; ++i ) {
+		logUser->logFirstSite(L"distinctPhase " + std::to_wstring(i));
+	}
+	logUser->logSecondSite(L"repeatEnd");
+
+	// Repeats, summarized periodically while they continue
+	logUser->setRepeatSuppression(true, 50);
+	for( unsigned int i = 0; i < 10; ++i ) {
+		logUser->logFirstSite(L"periodicPhase");
+	}
+	Sleep(100);
+	logUser->logFirstSite(L"periodicPhase");
+	logUser->logSecondSite(L"periodicEnd");
+
+	LogUser::SuppressionStats stats;
+	logUser->getSuppressionStats(stats);
+	if( stats.nRepeats != (nRepeats - 1) + 10 || stats.nRateLimited != 0 || stats.nSummaries != 2 ) {
+		logger->logMessage(L"Repeat suppression: Unexpected statistics: " + std::to_wstring(stats.nRepeats) +
+			L" repeats, " + std::to_wstring(stats.nRateLimited) + L" rate-limited, " +
+			std::to_wstring(stats.nSummaries) + L" summaries.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	// Rate limiting, with an interval that does not end during the test
+	logUser->setRepeatSuppression(false);
+	logUser->resetSuppressionStats();
+	logUser->setRateLimit(rateLimit, INFINITE);
+	for( unsigned int i = 0; i < nBurst; ++i ) {
+		logUser->logFirstSite(L"ratePhase " + std::to_wstring(i));
+	}
+	// Call sites have separate limits
+	for( unsigned int i = 0; i < rateLimit; ++i ) {
+		logUser->logSecondSite(L"rateOther");
+	}
+
+	/* Rate limiting, with a summary once the interval ends, without
+	   waiting for another message (changing the settings reports
+	   the messages discarded in the previous phase)
+	 */
+	logUser->setRateLimit(rateLimit, 50);
+	for( unsigned int i = 0; i < nBurst; ++i ) {
+		logUser->logFirstSite(L"intervalPhase " + std::to_wstring(i));
+	}
+	Sleep(100);
+	logUser->flushSuppressionSummaries();
+	logUser->logFirstSite(L"intervalPhase " + std::to_wstring(nBurst));
+
+	/* As many call sites as can be tracked, which must not share state
+	   even if they hash to the same slot. The counts of discarded messages
+	   are reported by the destructor.
+	 */
+	logUser->setRateLimit(1, INFINITE);
+	for( unsigned int j = 0; j < 2; ++j ) {
+		for( ULONGLONG site = 1; site <= LOGUSER_N_CALL_SITES; ++site ) {
+			logUser->logAtSite(site, L"sitePhase");
+		}
+	}
+
+	logUser->getSuppressionStats(stats);
+	if( stats.nRepeats != 0 || stats.nRateLimited != 2 * (nBurst - rateLimit) + LOGUSER_N_CALL_SITES ||
+		stats.nSummaries != 2 ) {
+		logger->logMessage(L"Rate limiting: Unexpected statistics: " + std::to_wstring(stats.nRepeats) +
+			L" repeats, " + std::to_wstring(stats.nRateLimited) + L" rate-limited, " +
+			std::to_wstring(stats.nSummaries) + L" summaries.");
+		finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+	}
+
+	// Output the LogUser's log file
+	delete logUser;
+	logUser = 0;
+
+	const size_t nChecks = 11;
+	const wchar_t* const markers[nChecks] = {
+		L"repeatPhase",
+		L"Last message repeated 99 times.",
+		L"distinctPhase",
+		L"repeatEnd",
+		L"periodicPhase",
+		L"Last message repeated 10 times.",
+		L"ratePhase",
+		L"rateOther",
+		L"intervalPhase",
+		L"Rate limit: 15 messages",
+		L"Rate limit: 1 messages"
+	};
+	const size_t expected[nChecks] = { 1, 1, nDistinct, 1, 1, 1, rateLimit, rateLimit, rateLimit + 1, 2,
+		LOGUSER_N_CALL_SITES };
+	for( size_t i = 0; i < nChecks; ++i ) {
+		const size_t nLines = countLinesContaining(outputFilename, markers[i]);
+		logger->logMessage(L"\"" + wstring(markers[i]) + L"\": " + std::to_wstring(nLines) +
+			L" line(s) output, " + std::to_wstring(expected[i]) + L" expected.");
+		if( nLines != expected[i] ) {
+			finalResult = MAKE_HRESULT(SEVERITY_ERROR, FACILITY_BL_ENGINE, ERROR_DATA_INCOMPLETE);
+		}
+	}
+
+	if( SUCCEEDED(finalResult) ) {
+		logger->logMessage(L"All tests passed.");
+	} else {
+		logger->logMessage(L"Some or all tests failed.");
+	}
+
+	delete logger;
+
+	return finalResult;
+}
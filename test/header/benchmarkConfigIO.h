@@ -0,0 +1,99 @@
+/*
+benchmarkConfigIO.h
+-------------------
+
+Created for: Spring 2014 Direct3D 11 Learning
+By: Bernard Llanos
+August 17, 2014
+
+Primary basis: None
+
+Other references: None
+
+Development environment: Visual Studio 2013 running on Windows 7, 64-bit
+  -Note that the "Character Set" project property (Configuration Properties > General)
+   should be set to Unicode for all configurations, when using Visual Studio.
+
+Description
+  -Throughput benchmarks for FlatAtomicConfigIO, using synthetic
+   configuration files generated according to a Workload description.
+  -Results are written as JSON, so that runs (e.g. before and after
+   changes to the parser) can be compared by other tools.
+  -HRESULT return values indicate success or failure.
+*/
+
+#pragma once
+
+#include <Windows.h>
+#include <string>
+
+// Number of Config::DataType constants (checked in benchmarkConfigIO.cpp)
+#define BENCHMARKCONFIGIO_N_DATATYPES 8
+
+namespace benchmarkConfigIO {
+
+	// Parameters of a synthetic configuration file
+	struct Workload {
+		// Number of data lines, including malformed lines
+		unsigned int nValues;
+
+		// Number of distinct scopes, among which lines are distributed evenly
+		unsigned int nScopes;
+
+		/* Relative frequencies of the data types, indexed by the values
+		   of the Config::DataType constants
+		 */
+		unsigned int typeWeights[BENCHMARKCONFIGIO_N_DATATYPES];
+
+		// Length of the generated string, filename and directory values
+		unsigned int stringLength;
+
+		// Fraction (from 0 to 1) of data lines which are malformed
+		double errorRate;
+
+		// Seed for the random number generator, so that files are reproducible
+		unsigned int seed;
+
+		// Name of the workload, which is included in the JSON output
+		std::string label;
+
+		/* Default workload: 10000 values in 64 scopes, with equal
+		   weights for all data types, 16-character strings, no errors,
+		   and a seed of 1
+		 */
+		Workload(void);
+	};
+
+	/* Outputs the text of a configuration file in the FlatAtomicConfigIO
+	   format, as described by the workload. Valid lines are formatted
+	   using the Config::DataTypeInfo formatting functions.
+	   Malformed lines have missing separators, unknown data types,
+	   or invalid values.
+	 */
+	HRESULT generate(std::string& out, const Workload& workload);
+
+	/* Runs each of the following phases 'nRepetitions' times,
+	   recording the minimum, mean and maximum times:
+	     -read: Parsing the generated file into an empty Config object.
+	      (The file is rewritten before each repetition, without being timed,
+	      as FlatAtomicConfigIO appends parsing reports to the files it reads.)
+	     -write: Serializing the loaded Config object to a file
+	     -roundTrip: Reading the written file, and checking that it contains
+	      the same keys and data types as the loaded Config object
+	     -lookup: Retrieving each loaded value by its key
+	     -destruction: Deleting the loaded Config object
+
+	   Results are written to 'jsonFilename' (which is overwritten).
+	   Returns a failure result if a phase fails, or if the written file
+	   does not contain the loaded data.
+	 */
+	HRESULT run(const Workload& workload, const unsigned int nRepetitions,
+		const std::wstring& jsonFilename);
+
+	/* Runs the default workload, and variations of it in which the size,
+	   scope fan-out, type mix, string length and error rate are changed
+	   individually. Results are written to one JSON file per workload,
+	   named after the workload labels, in DEFAULT_LOG_PATH_TEST.
+	 */
+	HRESULT runSuite(const unsigned int nRepetitions);
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+/*
+benchmarkLogger.h
+-----------------
+
+Created for: Spring 2014 Direct3D 11 Learning
+By: Bernard Llanos
+August 20, 2014
+
+Primary basis: None
+
+Other references: None
+
+Development environment: Visual Studio 2013 running on Windows 7, 64-bit
+  -Note that the "Character Set" project property (Configuration Properties > General)
+   should be set to Unicode for all configurations, when using Visual Studio.
+
+Description
+  -Throughput benchmarks for a Logger shared by multiple threads,
+   in the synchronous and asynchronous modes, which also check
+   that the output is intact (i.e. that no lines are lost, interleaved,
+   or reordered with respect to the threads which logged them).
+  -Results are written as JSON, so that runs (e.g. before and after
+   changes to the Logger class) can be compared by other tools.
+  -HRESULT return values indicate success or failure.
+*/
+
+#pragma once
+
+#include <Windows.h>
+#include <string>
+
+namespace benchmarkLogger {
+
+	enum class Mode : unsigned int {
+		SYNC, // The Logger is used directly by all threads
+		ASYNC // The Logger is in asynchronous mode (see Logger::startAsync())
+	};
+
+	// Measurements from one run
+	struct Result {
+		// Time from the start of logging until all messages were flushed
+		double seconds;
+
+		// Number of well-formed message lines found in the output file
+		size_t nLines;
+
+		/* True if the output contained all messages, with the messages
+		   from each thread in the order in which they were logged
+		 */
+		bool intact;
+
+		Result(void);
+	};
+
+	/* Has 'nThreads' threads log 'nMessages' messages in total (divided evenly
+	   among the threads, rounding down) to the same timestamped Logger,
+	   which outputs to 'outputFilename' (overwriting it) in the BUFFERED append mode.
+	   In asynchronous mode, the queue capacity is the number of messages,
+	   so that none are discarded.
+
+	   Returns a failure result if the Logger could not be created,
+	   if an output operation failed, or if the output is not intact.
+	 */
+	HRESULT run(Result& result, const Mode mode, const unsigned int nThreads,
+		const unsigned int nMessages, const std::wstring& outputFilename);
+
+	/* Runs each mode with 1, 2, 4, 8, 16 and 32 threads, 'nRepetitions' times,
+	   recording the minimum, mean and maximum times.
+	   Results are written to "benchmarkLogger.json" in DEFAULT_LOG_PATH_TEST.
+	 */
+	HRESULT runSuite(const unsigned int nMessages, const unsigned int nRepetitions);
+}
\ No newline at end of file
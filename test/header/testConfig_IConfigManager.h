@@ -51,4 +51,141 @@ namespace testConfig_IConfigManager {
 	   which is written to a third file.
 	 */
 	HRESULT testFlatAtomicConfigIO(void);
+
+	/* Writes a configuration file containing 'n' integer values
+	   and then reads it back with the FlatAtomicConfigIO class
+	   using 1, 2, 4, 8 and 16 threads, and the automatically
+	   chosen number of threads, logging the time taken
+	   by each read operation.
+
+	   The Config objects produced by the multi-threaded reads
+	   are checked against the Config object produced by
+	   the single-threaded read.
+
+	   Also reads a file spanning several chunks, checking that
+	   the first value of a key repeated in a later chunk is stored,
+	   and that problems are reported with their line numbers in the file.
+	 */
+	HRESULT testParallelFlatAtomicConfigIO(const unsigned int n);
+
+	/* Reads the configuration file used by testFlatAtomicConfigIO()
+	   into memory and passes it to the incremental parser
+	   of the FlatAtomicConfigIO class in blocks of several different sizes
+	   (including single characters), then through a std::istream.
+
+	   Each resulting Config object is written to a file,
+	   and its contents are compared with the Config object produced
+	   by FlatAtomicConfigIO::readBuffer() from the whole file at once.
+	 */
+	HRESULT testIncrementalFlatAtomicConfigIO(void);
+
+	/* Writes a Config object containing values of all data types
+	   to a file, and then reads the file twice using a CachedConfigIO object.
+	   The first read operation parses the text file and creates the cache file,
+	   whereas the second read operation loads the cache file.
+
+	   The results of both read operations are compared with the original Config object,
+	   and an integer value and a string value (decoded lazily when loaded
+	   from the cache file) are checked.
+	 */
+	HRESULT testCachedConfigIO(void);
+
+	/* Reads the configuration file used by testFlatAtomicConfigIO()
+	   with lazy parsing enabled in the FlatAtomicConfigIO object,
+	   logs the results of Config::validateAll(),
+	   and then writes the data back to another file.
+	 */
+	HRESULT testLazyFlatAtomicConfigIO(void);
+
+	/* Writes a Config object containing 'n' values (cycling through
+	   the INT, DOUBLE, BOOL, WSTRING and FLOAT4 data types)
+	   to a file using the FlatAtomicConfigIO class, and logs
+	   the time taken and the resulting throughput.
+	   (Intended to be called with 'n' equal to 1000000.)
+
+	   The file is then read back in, to check that all values were written.
+	 */
+	HRESULT testFlatAtomicConfigIOWriteThroughput(const unsigned int n);
+
+	/* Writes a Config object to a file, reads the file back with
+	   line indexing enabled, and then saves a modified Config object
+	   using FlatAtomicConfigIO::update(). The modifications include
+	   a value which fits in its existing line, a value which does not,
+	   an unchanged value, a removed key and a new key.
+
+	   The updated file is read back in and compared with the modified
+	   Config object, and checked for the comments written originally.
+	   A second update with the same Config object must not modify the file.
+	 */
+	HRESULT testUpdateFlatAtomicConfigIO(void);
+
+	/* Creates a set of configuration files which include each other
+	   (including a file which is included by two files under different
+	   scope prefixes, and a circular inclusion), reads the root file,
+	   and checks that the resulting Config object contains the expected
+	   values under the expected scopes, with the root file's values
+	   taking precedence.
+
+	   Then saves a change to the root file using FlatAtomicConfigIO::update(),
+	   by patching it and by rewriting it, and checks that its include
+	   directives are kept, and that no data from the included files
+	   is copied into it.
+	 */
+	HRESULT testIncludeFlatAtomicConfigIO(void);
+
+	/* Writes a configuration file, and then loads it several times
+	   through the ConfigCache class, using an IConfigIO object which
+	   counts the number of times it reads the file. Checks that the file
+	   is read only once while it is unchanged, that the loaded data
+	   is complete each time, and that the file is read again
+	   after it is modified.
+	 */
+	HRESULT testConfigCache(void);
+
+	/* Looks up each data type descriptor by DataType constant,
+	   by narrow name and by wide name, and checks that the results agree.
+	   Also checks that strings which are not data type names
+	   (including prefixes of names and names with the wrong case)
+	   are rejected.
+	 */
+	HRESULT testDataTypeInfo(void);
+
+	/* Writes a configuration file, reads it, and watches it using
+	   a ConfigWatcher. Then modifies one value in the file, and calls
+	   ConfigWatcher::applyChanges() until the change is applied
+	   (or a timeout expires). Checks that the modified value is visible,
+	   that the unmodified value was not replaced, and logs the latency
+	   of the reload. The test is run once with change notifications,
+	   and once with polling.
+	   Then repeats the process for a modification, including an invalid line,
+	   to a file included by the watched file, and checks that no reports
+	   were appended to either file.
+	 */
+	HRESULT testConfigWatcher(void);
+
+	/* Generates 'n' values of mixed data types in 64 scopes,
+	   and writes them using both FlatAtomicConfigIO and SectionedConfigIO.
+	   Logs the sizes of the two files, and the time taken to read each file,
+	   and checks that the SectionedConfigIO file is smaller,
+	   and contains the data that was written.
+	   Also reads a hand-written file exercising section default datatypes,
+	   explicit datatypes, and invalid section headers.
+	 */
+	HRESULT testSectionedConfigIO(const unsigned int n);
+
+	/* Writes 'n' values using FlatAtomicConfigIO, and a hand-written file
+	   containing known problems, and checks them with FlatAtomicConfigIO::lint().
+	   Checks that no problems are reported for the valid file,
+	   that the expected number of problems is reported for the invalid file,
+	   and that neither file is modified. Also logs the time taken
+	   to lint the valid file relative to reading it, using one thread for both.
+	 */
+	HRESULT testLintFlatAtomicConfigIO(const unsigned int n);
+
+	/* Inserts the embedded default configuration data into an empty Config object,
+	   and into a Config object which already has a value for one of the keys.
+	   Checks that all defaults are inserted in the first case,
+	   and that the existing value is not replaced in the second case.
+	 */
+	HRESULT testEmbeddedConfig(void);
 }
\ No newline at end of file
@@ -47,4 +47,79 @@ namespace testLogger_LogUser {
 	constructor to detect invalid filepaths/filenames.
 	*/
 	HRESULT testAppendMode(void);
+
+	/* Tests the asynchronous mode of the Logger class.
+	'nThreads' threads log messages concurrently to a Logger
+	in asynchronous mode. The output file is read after a call
+	to Logger::flush(), to check that no messages were lost
+	(under the BLOCK overflow policy) or that all messages
+	were either output or counted as discarded (under the
+	DROP_AND_COUNT overflow policy), and that the messages
+	from each thread were output in order.
+	*/
+	HRESULT testAsyncLogging(const unsigned int nThreads);
+
+	/* Tests the BUFFERED and SHARED append modes of the Logger class
+	(used when the 'holdAndReplaceFile' constructor parameter is false),
+	by checking whether messages have reached the log file
+	before and after calls to Logger::flush(), and when the
+	buffer size threshold is exceeded. Also checks that the messages
+	of two Loggers with the same file are written in order.
+	*/
+	HRESULT testAppendModes(void);
+
+	/* Tests the Timestamper class used by Logger objects,
+	checking the output formats against Logger::getDateAndTime(),
+	checking that output times never decrease, and measuring
+	the time taken to format a timestamp.
+	*/
+	HRESULT testTimestamper(void);
+
+	/* Tests severity level filtering by LogUser objects,
+	checking that messages below the runtime threshold (LogUser::setLogLevel())
+	or the compile-time minimum level (LOG_MIN_LEVEL) are neither
+	output nor evaluated, and that a list of messages logged at a level
+	is output only if the message introducing it is output.
+	*/
+	HRESULT testLogLevels(void);
+
+	/* Logs 'nMessages' messages with the same content to a text file
+	using the Logger class, and to a binary file using the BinaryLogger class.
+	Checks that the decoded binary file contains the same messages
+	as the text file, and compares the time taken to log the messages
+	and the sizes of the files. Also checks that a binary file
+	with a corrupt format string is rejected.
+	*/
+	HRESULT testBinaryLogging(const unsigned int nMessages);
+
+	/* Tests the caching of open secondary log files (files other than
+	the primary log file) by Logger objects in the BUFFERED append mode.
+	Checks that messages are buffered until flushing, that the least
+	recently used file is written when it is closed, that files are
+	written when switching to the SHARED append mode, and compares
+	the time taken to log to a secondary file in the two modes.
+	*/
+	HRESULT testSecondaryFiles(void);
+
+	/* Tests rotation of the primary log file, by size and by time,
+	   checking that no messages are lost or reordered across segments,
+	   that only the requested number of segments are retained,
+	   and that no temporary files are left behind. Also checks that
+	   a failure to archive the primary log file is reported,
+	   and that rotation resumes once the file can be archived.
+	 */
+	HRESULT testLogRotation(void);
+
+	/* Tests the FlightRecorder class, alone and with multiple threads,
+	   checking that the most recent messages are decoded in order
+	   after the ring has wrapped around, and that a ring file is
+	   added to when it is reopened.
+	 */
+	HRESULT testFlightRecorder(void);
+
+	/* Tests suppression of repeated messages, and rate limiting,
+	   in the LogUser class, checking the summaries logged in place
+	   of discarded messages and the suppression statistics.
+	 */
+	HRESULT testLogSuppression(void);
 }
\ No newline at end of file